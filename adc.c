@@ -3,6 +3,68 @@
 *        fr analoga signaler via strukten adc.
 ********************************************************************************/
 #include "adc.h"
+#include "timer.h"
+#include "filter.h"
+
+/* Makrodefinitioner: */
+#define ADC_RING_MASK (ADC_RING_SIZE - 1) /* Mask fr index i ringbuffertarna. */
+#define ADC_PRESCALER ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0)) /* Prescaler 128 (125 kHz). */
+#define ADC_PRESCALER_FAST ((1 << ADPS2) | (1 << ADPS1))           /* Prescaler 64 (250 kHz). */
+#define ADC_PRESCALER_MAX_HZ 6000 /* Hgsta samplingsfrekvens med prescaler 128, s att minst 736 klockcykler terstr efter omvandlingen. */
+#define ADC_TRIGGER_TIMER0_COMPA ((1 << ADTS1) | (1 << ADTS0)) /* Start vid matchning mot OCR0A. */
+#define ADC_CONVERSION_HALF_CLOCKS 27 /* Omvandlingstid vid automatisk start (13,5 ADC-klockcykler). */
+#define ADC_TRIGGER_MARGIN 4          /* Marginal i steg fr TCNT0 vid kontroll av uteblivna starter. */
+#define ADC_FREE_RUNNING_HZ (F_CPU / (128UL * 13)) /* Samplingsfrekvens utan timerstart (ca 9600 Hz). */
+
+/********************************************************************************
+* adc_ring: Strukt fr en kanals ringbuffert med de senaste resultaten.
+********************************************************************************/
+struct adc_ring
+{
+   volatile uint16_t samples[ADC_RING_SIZE]; /* Lagrade resultat. */
+   volatile uint8_t head;                    /* Index fr nsta resultat som ska lagras. */
+   volatile uint8_t count;                   /* Antal lagrade resultat. */
+   volatile uint8_t unread;                  /* Antal lagrade resultat som inte har lsts. */
+   uint16_t accumulator;                     /* Summa av omvandlingar vid versampling. */
+   uint8_t accumulated;                      /* Antal summerade omvandlingar. */
+   volatile uint8_t oversample_bits;         /* Antal extra bitar via versampling. */
+   struct filter filter;                     /* Filter fr kanalens resultat. */
+};
+
+/* Statiska funktioner: */
+static inline uint8_t adc_get_channel(const uint8_t pin);
+static inline bool adc_filter_fits(const uint8_t type,
+                                   const uint8_t parameter,
+                                   const uint16_t sample_rate_hz);
+static bool adc_filters_fit(const uint8_t mask,
+                            const uint16_t sample_rate_hz);
+static void adc_sampler_reset(const uint8_t mask);
+static inline void adc_ring_store(struct adc_ring* ring,
+                                  const uint16_t sample);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - rings          : Ringbuffertar fr respektive kanal A0 - A5.
+*   - sampler_mask   : Kanaler som omvandlas av samplern, 0 nr samplern r
+*                      stoppad.
+*   - sampler_channel: Kanal vars omvandling pgr.
+*   - sampler_triggered: Indikerar ifall omvandlingarna startas av Timer 0.
+*   - sampler_rate_hz: Samplerns antal omvandlingar per sekund.
+*   - trigger_timer  : Timer 0, som startar omvandlingarna.
+*   - trigger_min_count: Lgsta vrde p TCNT0 nr avbrottsrutinen krs i
+*                        tid vid timerstartad omvandling.
+*   - overruns       : Antal olsta resultat som har skrivits ver samt
+*                      uteblivna timerstartade omvandlingar.
+********************************************************************************/
+static struct adc_ring rings[ADC_CHANNELS];
+static volatile uint8_t sampler_mask = 0;
+static volatile uint8_t sampler_channel = 0;
+static bool sampler_triggered = false;
+static uint16_t sampler_rate_hz = 0;
+static struct timer trigger_timer;
+static uint8_t trigger_min_count = 0;
+static volatile uint32_t overruns = 0;
 
 /********************************************************************************
 * adc_init: Initierar analog pin fr avlsning och AD-omvandling av insignaler,
@@ -15,14 +77,8 @@
 void adc_init(struct adc* self,
               const uint8_t pin)
 {
-   if (pin >= 0 && pin <= 5)
-   {
-      self->pin = pin;
-   }
-   else if (pin >= 14 && pin <= 19)
-   {
-      self->pin = pin - 14;
-   }
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel < ADC_CHANNELS) self->pin = channel;
 
    self->pwm_on_us = 0;
    self->pwm_off_us = 0;
@@ -33,22 +89,65 @@ void adc_init(struct adc* self,
 
 /********************************************************************************
 * adc_read: Lser av en analog insignal och returnerar motsvarande digitala
-*           motsvarighet mellan 0 - 1023.
+*           motsvarighet mellan 0 - 1023. Om samplern r igng returneras
+*           senaste resultatet direkt, s att samplern inte strs. Vid
+*           versampling skiftas resultatet d ned till 10 bitar. Annars
+*           sker en omvandling, vars resultat passerar kanalens filter.
 *
 *           - self: Pekare till analog pin som ska lsas av.
 ********************************************************************************/
 uint16_t adc_read(const struct adc* self)
 {
+   if (sampler_mask) return adc_get_latest(self->pin) >> adc_get_oversampling(self->pin);
+
    ADMUX = (1 << REFS0) | self->pin;
    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
    while ((ADCSRA & (1 << ADIF)) == 0);
    ADCSRA = (1 << ADIF);
-   return ADC;
+
+   const uint8_t channel = adc_get_channel(self->pin);
+   if (channel >= ADC_CHANNELS) return ADC;
+   return filter_put(&rings[channel].filter, ADC);
+}
+
+/********************************************************************************
+* adc_read_mv: Lser av en analog insignal och returnerar motsvarande
+*              inspnning mtt i millivolt. Om samplern r igng anvnds
+*              senaste resultatet med kanalens fulla upplsning.
+*
+*              - self: Pekare till analog pin som ska lsas av.
+********************************************************************************/
+uint16_t adc_read_mv(const struct adc* self)
+{
+   if (sampler_mask)
+   {
+      return adc_sample_to_mv(adc_get_latest(self->pin), adc_get_oversampling(self->pin));
+   }
+   return adc_raw_to_mv(adc_read(self));
+}
+
+/********************************************************************************
+* adc_get_temperature_centi: Returnerar aktuell rumstemperatur i hundradels
+*                            grader Celcius via avlsning av temperatursensor
+*                            TMP36, ansluten till angiven pin. Om samplern r
+*                            igng anvnds senaste resultatet med kanalens
+*                            fulla upplsning.
+*
+*                            - self: Pekare till analog pin som ska lsas av.
+********************************************************************************/
+int32_t adc_get_temperature_centi(const struct adc* self)
+{
+   if (sampler_mask)
+   {
+      return adc_sample_to_centi_celsius(adc_get_latest(self->pin), adc_get_oversampling(self->pin));
+   }
+   return adc_raw_to_centi_celsius(adc_read(self));
 }
 
 /********************************************************************************
 * adc_get_pwm_values: Lser av en analog insignal och berknar on- och off-tid
 *                     fr PWM-generering, avrundat till nrmaste heltal.
+*                     Berkningen sker med heltal, utan flyttal.
 *
 *                     - self         : Pekare till analog pin som ska lsas av.
 *                     - pwm_period_us: PWM-perioden (on-tid + off-tid) mtt i
@@ -58,7 +157,491 @@ void adc_get_pwm_values(struct adc* self,
                         uint16_t pwm_period_us)
 {
    if (!pwm_period_us) pwm_period_us = 10000;
-   self->pwm_on_us = (uint16_t)(adc_duty_cycle(self) * pwm_period_us + 0.5);
+   self->pwm_on_us = (uint16_t)(((uint32_t)adc_read(self) * pwm_period_us + ADC_RAW_MAX / 2) / ADC_RAW_MAX);
    self->pwm_off_us = pwm_period_us - self->pwm_on_us;
    return;
+}
+
+/********************************************************************************
+* adc_sampler_init: Startar kontinuerlig AD-omvandling av angivna kanaler.
+*
+*                   1. Ogiltiga bitar maskeras bort. Om inga kanaler terstr,
+*                      eller om ngon kanal har ett filter som r fr dyrt
+*                      fr ca 9600 omvandlingar per sekund, returneras
+*                      felkod 1.
+*
+*                   2. Pgende sampling stoppas och samtliga ringbuffertar
+*                      tms.
+*
+*                   3. Frsta valda kanalen vljs, varefter AD-omvandlaren
+*                      aktiveras med avbrott och frsta omvandlingen startas.
+*                      Drefter startas varje omvandling av avbrottsrutinen.
+*
+*                   - channel_mask: Kanaler som ska omvandlas (bit n = An).
+********************************************************************************/
+int adc_sampler_init(const uint8_t channel_mask)
+{
+   const uint8_t mask = channel_mask & ((1 << ADC_CHANNELS) - 1);
+   if (mask == 0 || !adc_filters_fit(mask, ADC_FREE_RUNNING_HZ)) return 1;
+
+   adc_sampler_reset(mask);
+   sampler_rate_hz = ADC_FREE_RUNNING_HZ;
+   ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADIE) | ADC_PRESCALER;
+   return 0;
+}
+
+/********************************************************************************
+* adc_sampler_init_triggered: Startar timerstartad AD-omvandling av angivna
+*                             kanaler med angiven samplingsfrekvens.
+*
+*                             1. Kanaler samt samplingsfrekvens kontrolleras,
+*                                liksom att valda kanalers filter ryms vid
+*                                angiven samplingsfrekvens. Vid ogiltiga
+*                                vrden returneras felkod 1.
+*
+*                             2. Pgende sampling stoppas, ringbuffertarna
+*                                tms och frsta valda kanalen vljs.
+*
+*                             3. Timer 0 stlls in i CTC Mode s att matchning
+*                                mot OCR0A sker en gng per sampel, utan
+*                                avbrott. Inom angivet intervall ryms perioden
+*                                alltid i timerkretsen utan upprkning i
+*                                mjukvara.
+*
+*                             4. AD-omvandlaren stlls in att starta varje
+*                                omvandling vid matchning mot OCR0A. Hgsta
+*                                prescaler vars omvandlingstid ryms inom
+*                                perioden anvnds, vilket ger bst
+*                                noggrannhet.
+*
+*                             - channel_mask  : Kanaler som ska omvandlas.
+*                             - sample_rate_hz: Antal omvandlingar per sekund.
+********************************************************************************/
+int adc_sampler_init_triggered(const uint8_t channel_mask,
+                               const uint16_t sample_rate_hz)
+{
+   const uint8_t mask = channel_mask & ((1 << ADC_CHANNELS) - 1);
+   if (mask == 0) return 1;
+   if (sample_rate_hz < ADC_TRIGGER_HZ_MIN || sample_rate_hz > ADC_TRIGGER_HZ_MAX) return 1;
+   if (!adc_filters_fit(mask, sample_rate_hz)) return 1;
+
+   adc_sampler_reset(mask);
+   sampler_triggered = true;
+   sampler_rate_hz = sample_rate_hz;
+   timer_init_us(&trigger_timer, TIMER_SEL_0, (1000000UL + sample_rate_hz / 2) / sample_rate_hz);
+
+   const bool fast = sample_rate_hz > ADC_PRESCALER_MAX_HZ;
+   const uint32_t conversion_cycles = (ADC_CONVERSION_HALF_CLOCKS * (fast ? 64UL : 128UL)) / 2;
+   const uint32_t min_count = conversion_cycles * (OCR0A + 1UL) * sample_rate_hz / F_CPU;
+   trigger_min_count = min_count > ADC_TRIGGER_MARGIN ? (uint8_t)(min_count - ADC_TRIGGER_MARGIN) : 0;
+
+   TIFR0 = (1 << OCF0A);
+   ADCSRB = ADC_TRIGGER_TIMER0_COMPA;
+   ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (fast ? ADC_PRESCALER_FAST : ADC_PRESCALER);
+   return 0;
+}
+
+/********************************************************************************
+* adc_sampler_stop: Stoppar samplern genom att avbrott frn AD-omvandlaren
+*                   samt automatisk start inaktiveras, varefter pgende
+*                   omvandling tillts slutfras innan avbrottsflaggan
+*                   kvitteras. Vid timerstartad omvandling stngs ven
+*                   Timer 0 av. Samtliga filter tms, eftersom efterfljande
+*                   avlsningar via adc_read sker utan versampling.
+********************************************************************************/
+void adc_sampler_stop(void)
+{
+   ADCSRA &= ~((1 << ADIE) | (1 << ADATE));
+   sampler_mask = 0;
+
+   if (sampler_triggered)
+   {
+      timer_clear(&trigger_timer);
+      sampler_triggered = false;
+   }
+
+   while (ADCSRA & (1 << ADSC));
+   ADCSRA |= (1 << ADIF);
+
+   for (uint8_t i = 0; i < ADC_CHANNELS; ++i)
+   {
+      filter_reset(&rings[i].filter);
+   }
+   return;
+}
+
+/********************************************************************************
+* adc_sampler_running: Indikerar ifall samplern r igng.
+********************************************************************************/
+bool adc_sampler_running(void)
+{
+   return sampler_mask != 0;
+}
+
+/********************************************************************************
+* adc_sample_next: Lagrar resultatet av avslutad omvandling och startar nsta.
+*
+*                  1. Resultatet lagras i aktuell kanals ringbuffert. Vid
+*                     versampling med n extra bitar summeras i stllet
+*                     resultatet, dr summan av 4^n omvandlingar skiftas
+*                     n steg med avrundning och lagras. Lagrade resultat
+*                     passerar frst kanalens filter.
+*
+*                  2. Nsta valda kanal vljs i tur och ordning. Eftersom
+*                     nsta omvandling startas efter att ADMUX har
+*                     uppdaterats tillhr varje resultat alltid rtt kanal.
+*
+*                  3. Vid timerstartad omvandling kvitteras Timer 0:s
+*                     avbrottsflagga, eftersom nsta omvandling startas nr
+*                     flaggan ettstlls. Annars startas nsta omvandling
+*                     direkt.
+*
+*                  Vid timerstartad omvandling mste flaggan kvitteras fre
+*                  nsta matchning, dvs. inom periodtiden minus
+*                  omvandlingstiden efter att omvandlingen r klar (736
+*                  klockcykler vid 10 kHz, dr omvandlingen tar 864 av 1600
+*                  klockcykler, vilket r minst fr samtliga
+*                  samplingsfrekvenser eftersom prescaler 128 enbart vljs
+*                  upp till ADC_PRESCALER_MAX_HZ). Annars r flaggan redan
+*                  ettstlld vid
+*                  matchningen, varvid ingen stigande flank uppstr och
+*                  omvandlingen uteblir. Detta upptcks genom att TCNT0 d
+*                  har passerat periodens slut och understiger vrdet vid
+*                  omvandlingens slut, varvid antalet verskridningar rknas
+*                  upp. Latens ver en hel period upptcks inte.
+*
+*                  Funktionen frutstter att avbrott r inaktiverade, vilket
+*                  alltid gller i avbrottsrutinen fr AD-omvandlaren.
+********************************************************************************/
+void adc_sample_next(void)
+{
+   const uint8_t mask = sampler_mask;
+   if (mask == 0) return;
+   if (sampler_triggered && TCNT0 < trigger_min_count) overruns++;
+
+   uint8_t channel = sampler_channel;
+   struct adc_ring* ring = &rings[channel];
+
+   const uint8_t bits = ring->oversample_bits;
+
+   if (bits == 0)
+   {
+      adc_ring_store(ring, ADC);
+   }
+   else
+   {
+      ring->accumulator += ADC;
+
+      if (++ring->accumulated == (uint8_t)(1 << (2 * bits)))
+      {
+         adc_ring_store(ring, (ring->accumulator + (1 << (bits - 1))) >> bits);
+         ring->accumulator = 0;
+         ring->accumulated = 0;
+      }
+   }
+
+   do
+   {
+      if (++channel >= ADC_CHANNELS) channel = 0;
+   } while ((mask & (1 << channel)) == 0);
+
+   sampler_channel = channel;
+   ADMUX = (1 << REFS0) | channel;
+
+   if (sampler_triggered) TIFR0 = (1 << OCF0A);
+   else ADCSRA |= (1 << ADSC);
+   return;
+}
+
+/********************************************************************************
+* adc_set_oversampling: Vljer antalet extra bitar via versampling fr
+*                       angiven pin. Kanalens ringbuffert, summering och
+*                       filter tms med avbrott inaktiverade, s att resultat
+*                       med olika upplsning inte blandas. Vid ogiltiga
+*                       vrden returneras felkod 1, annars 0.
+*
+*                       - pin       : Analog pin 0 - 5 eller A0 - A5.
+*                       - extra_bits: Antal extra bitar (0 = ingen
+*                                     versampling).
+********************************************************************************/
+int adc_set_oversampling(const uint8_t pin,
+                         const uint8_t extra_bits)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS || extra_bits > ADC_OVERSAMPLE_BITS_MAX) return 1;
+
+   struct adc_ring* ring = &rings[channel];
+   const uint8_t sreg = SREG;
+   cli();
+
+   ring->oversample_bits = extra_bits;
+   filter_reset(&ring->filter);
+   ring->accumulator = 0;
+   ring->accumulated = 0;
+   ring->head = 0;
+   ring->count = 0;
+   ring->unread = 0;
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* adc_set_filter: Vljer filter fr angiven pin. Kanalens ringbuffert tms med
+*                 avbrott inaktiverade, s att filtrerade och ofiltrerade
+*                 resultat inte blandas, varefter nsta resultat fyller
+*                 filtret. Vid ogiltig pin eller parameter returneras
+*                 felkod 1, annars 0. Om pinnen omvandlas av samplern
+*                 kontrolleras ven att filtret ryms vid samplerns
+*                 samplingsfrekvens, annars returneras felkod 1.
+*
+*                 - pin      : Analog pin 0 - 5 eller A0 - A5.
+*                 - type     : Valt filter (FILTER_NONE = ingen filtrering).
+*                 - parameter: Antal vrden (glidande medelvrde samt median)
+*                              eller skiftning (EMA).
+********************************************************************************/
+int adc_set_filter(const uint8_t pin,
+                   const enum filter_type type,
+                   const uint8_t parameter)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS) return 1;
+   if ((sampler_mask & (1 << channel)) && !adc_filter_fits(type, parameter, sampler_rate_hz)) return 1;
+
+   struct adc_ring* ring = &rings[channel];
+   const uint8_t sreg = SREG;
+   cli();
+
+   if (filter_init(&ring->filter, type, parameter))
+   {
+      SREG = sreg;
+      return 1;
+   }
+
+   ring->head = 0;
+   ring->count = 0;
+   ring->unread = 0;
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* adc_get_oversampling: Returnerar antalet extra bitar via versampling fr
+*                       angiven pin. Vid ogiltig pin returneras 0.
+*
+*                       - pin: Analog pin 0 - 5 eller A0 - A5.
+********************************************************************************/
+uint8_t adc_get_oversampling(const uint8_t pin)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS) return 0;
+   return rings[channel].oversample_bits;
+}
+
+/********************************************************************************
+* adc_get_latest: Returnerar senaste resultatet frn samplern fr angiven pin.
+*                 Resultatet lses med avbrott inaktiverade, eftersom det
+*                 bestr av tv byte som kan skrivas av avbrottsrutinen.
+*
+*                 - pin: Analog pin 0 - 5 eller A0 - A5.
+********************************************************************************/
+uint16_t adc_get_latest(const uint8_t pin)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS) return 0;
+
+   const struct adc_ring* ring = &rings[channel];
+   uint16_t sample = 0;
+   const uint8_t sreg = SREG;
+   cli();
+
+   if (ring->count) sample = ring->samples[(ring->head - 1) & ADC_RING_MASK];
+
+   SREG = sreg;
+   return sample;
+}
+
+/********************************************************************************
+* adc_read_sample: Hmtar ldsta olsta resultatet fr angiven pin till angiven
+*                  destination. Vid hmtat resultat returneras 0, annars
+*                  returneras 1. Resultatet lses med avbrott inaktiverade,
+*                  s att det inte kan skrivas ver under tiden.
+*
+*                  - pin   : Analog pin 0 - 5 eller A0 - A5.
+*                  - sample: Pekare till destinationen.
+********************************************************************************/
+int adc_read_sample(const uint8_t pin,
+                    uint16_t* sample)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS) return 1;
+
+   struct adc_ring* ring = &rings[channel];
+   const uint8_t sreg = SREG;
+   cli();
+
+   if (ring->unread == 0)
+   {
+      SREG = sreg;
+      return 1;
+   }
+
+   *sample = ring->samples[(ring->head - ring->unread) & ADC_RING_MASK];
+   ring->unread--;
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* adc_get_overruns: Returnerar antalet olsta resultat som har skrivits ver
+*                   sedan samplern startades.
+********************************************************************************/
+uint32_t adc_get_overruns(void)
+{
+   return atomic_read_u32(&overruns);
+}
+
+/********************************************************************************
+* adc_get_samples: Kopierar lagrade resultat fr angiven pin till angiven
+*                  destination, ldsta resultatet frst, och returnerar
+*                  antalet kopierade resultat. Kopieringen sker med avbrott
+*                  inaktiverade, s att samtliga resultat kommer frn samma
+*                  tillflle.
+*
+*                  - pin        : Analog pin 0 - 5 eller A0 - A5.
+*                  - destination: Destination med plats fr ADC_RING_SIZE
+*                                 resultat.
+********************************************************************************/
+uint8_t adc_get_samples(const uint8_t pin,
+                        uint16_t* destination)
+{
+   const uint8_t channel = adc_get_channel(pin);
+   if (channel >= ADC_CHANNELS) return 0;
+
+   const struct adc_ring* ring = &rings[channel];
+   const uint8_t sreg = SREG;
+   cli();
+
+   const uint8_t count = ring->count;
+   uint8_t index = (ring->head - count) & ADC_RING_MASK;
+
+   for (uint8_t i = 0; i < count; ++i)
+   {
+      destination[i] = ring->samples[index];
+      index = (index + 1) & ADC_RING_MASK;
+   }
+
+   SREG = sreg;
+   return count;
+}
+
+/********************************************************************************
+* adc_get_channel: Returnerar kanal 0 - 5 fr angiven pin, som antingen kan
+*                  anges som ett tal mellan 0 - 5 eller via konstanter A0 - A5.
+*                  Vid ogiltig pin returneras ADC_CHANNELS.
+*
+*                  - pin: Analog pin som ska omvandlas till kanal.
+********************************************************************************/
+static inline uint8_t adc_get_channel(const uint8_t pin)
+{
+   if (pin < ADC_CHANNELS) return pin;
+   if (pin >= A0 && pin <= A5) return pin - A0;
+   return ADC_CHANNELS;
+}
+
+/********************************************************************************
+* adc_filter_fits: Indikerar ifall angivet filter fr kras i avbrottsrutinen
+*                  vid angiven samplingsfrekvens. Median sorterar hela
+*                  fnstret fr varje resultat, vilket fr 7 vrden kostar
+*                  uppskattningsvis upp till 500 klockcykler, jmfrt med
+*                  hgst ca 160 klockcykler fr median av 3 vrden samt
+*                  vriga filter (se host/bench/filter_bench). Median av
+*                  fler n ADC_MEDIAN_FAST_MAX vrden begrnsas drfr till
+*                  ADC_MEDIAN_MAX_HZ, vilket ger hgst ca 10 % av
+*                  processortiden fr filtrering, likt vriga filter vid
+*                  10 kHz.
+*
+*                  - type          : Valt filter (enum filter_type).
+*                  - parameter     : Antal vrden eller skiftning (EMA).
+*                  - sample_rate_hz: Samplerns antal omvandlingar per sekund.
+********************************************************************************/
+static inline bool adc_filter_fits(const uint8_t type,
+                                   const uint8_t parameter,
+                                   const uint16_t sample_rate_hz)
+{
+   return type != FILTER_MEDIAN || parameter <= ADC_MEDIAN_FAST_MAX ||
+          sample_rate_hz <= ADC_MEDIAN_MAX_HZ;
+}
+
+/********************************************************************************
+* adc_filters_fit: Indikerar ifall samtliga angivna kanalers filter fr kras
+*                  i avbrottsrutinen vid angiven samplingsfrekvens.
+*
+*                  - mask          : Kanaler som ska omvandlas.
+*                  - sample_rate_hz: Samplerns antal omvandlingar per sekund.
+********************************************************************************/
+static bool adc_filters_fit(const uint8_t mask,
+                            const uint16_t sample_rate_hz)
+{
+   for (uint8_t i = 0; i < ADC_CHANNELS; ++i)
+   {
+      const struct filter* filter = &rings[i].filter;
+      if ((mask & (1 << i)) && !adc_filter_fits(filter->type, filter->length, sample_rate_hz)) return false;
+   }
+   return true;
+}
+
+/********************************************************************************
+* adc_sampler_reset: Stoppar pgende sampling, tmmer samtliga ringbuffertar
+*                    samt summeringar och filter, nollstller antalet
+*                    verskridningar och vljer frsta kanalen i angiven
+*                    mask. Vald versampling samt valt filter fr respektive
+*                    kanal behlls.
+*
+*                    - mask: Kanaler som ska omvandlas (minst en kanal).
+********************************************************************************/
+static void adc_sampler_reset(const uint8_t mask)
+{
+   adc_sampler_stop();
+
+   for (uint8_t i = 0; i < ADC_CHANNELS; ++i)
+   {
+      rings[i].head = 0;
+      rings[i].count = 0;
+      rings[i].unread = 0;
+      rings[i].accumulator = 0;
+      rings[i].accumulated = 0;
+      filter_reset(&rings[i].filter);
+   }
+
+   uint8_t channel = 0;
+   while ((mask & (1 << channel)) == 0) channel++;
+
+   overruns = 0;
+   sampler_channel = channel;
+   sampler_mask = mask;
+   ADMUX = (1 << REFS0) | channel;
+   return;
+}
+
+/********************************************************************************
+* adc_ring_store: Lagrar ett resultat i angiven ringbuffert efter att det har
+*                 passerat kanalens filter, dr ldsta resultatet skrivs
+*                 ver nr bufferten r full. Om det verskrivna resultatet
+*                 inte har lsts via adc_read_sample rknas antalet
+*                 verskridningar upp.
+*
+*                 - ring  : Pekare till ringbufferten.
+*                 - sample: Resultatet som ska lagras.
+********************************************************************************/
+static inline void adc_ring_store(struct adc_ring* ring,
+                                  const uint16_t sample)
+{
+   ring->samples[ring->head] = filter_put(&ring->filter, sample);
+   ring->head = (ring->head + 1) & ADC_RING_MASK;
+   if (ring->count < ADC_RING_SIZE) ring->count++;
+   if (ring->unread < ADC_RING_SIZE) ring->unread++;
+   else overruns++;
+   return;
 }
\ No newline at end of file
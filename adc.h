@@ -12,16 +12,95 @@
 *
 *       dr ADC_result r resultat avlst frn AD-omvandlaren OCH ADC_MAX
 *       utgr hgsta mjliga avlsta vrde, vilket r 1023.0.
+*
+*       Utan flyttal kan rvrden omvandlas till millivolt samt hundradels
+*       grader Celcius via adc_raw_to_mv respektive
+*       adc_raw_to_centi_celsius. Division erstts d av multiplikation med
+*       en konstant med 13 - 16 brkbitar fljt av skiftning, berknad vid
+*       kompilering. Dessa funktioner lser inte av AD-omvandlaren, vilket
+*       gr att ven resultat frn samplern kan omvandlas.
+*
+*       Samplern kan versampla varje kanal fr hgre upplsning, dr 4^n
+*       omvandlingar summeras och skiftas n steg, vilket ger 10 + n bitar
+*       (n = 1 - 3). Detta frutstter att insignalen innehller brus p
+*       minst ett steg, vilket normalt gller. versampling vljs per kanal
+*       via adc_set_oversampling, dr varje resultat i ringbufferten d har
+*       10 + n bitar. Resultaten omvandlas via adc_sample_to_mv samt
+*       adc_sample_to_centi_celsius.
+*
+*       AD-omvandling kan ocks ske kontinuerligt i bakgrunden via en
+*       avbrottsstyrd sampler, som omvandlar valda kanaler A0 - A5 i tur och
+*       ordning. Varje kanal har en egen ringbuffert med de senaste
+*       ADC_RING_SIZE resultaten, dr senaste resultatet kan hmtas direkt
+*       utan vntan. Samplern startas via adc_sampler_init, dr funktionen
+*       adc_sample_next ska anropas i avbrottsrutinen fr AD-omvandlaren:
+*
+*       ISR (ADC_vect)
+*       {
+*          adc_sample_next();
+*          return;
+*       }
+*
+*       Med prescaler 128 tar varje omvandling 104 us, vilket ger ca 9600
+*       omvandlingar per sekund, frdelat lika mellan valda kanaler.
+*
+*       Fr exakt samplingsfrekvens kan samplern i stllet startas via
+*       adc_sampler_init_triggered, dr varje omvandling startas av
+*       hrdvaran vid matchning mot OCR0A fr Timer 0. Omvandlingarna sker
+*       drmed utan jitter, oavsett vad processorn gr fr tillfllet.
+*       Timer 0 anvnds d uteslutande av samplern. Avbrottsrutinen mste
+*       dock hinna kras inom periodtiden minus omvandlingstiden, vilket r
+*       736 klockcykler (46 us) vid 10 kHz. Annars uteblir nsta
+*       omvandling, vilket rknas som en verskridning.
+*
+*       Varje kanal kan ven filtreras via adc_set_filter, med glidande
+*       medelvrde, exponentiellt medelvrde eller median (se filter.h).
+*       Filtret tillmpas p varje resultat innan det lagras, efter
+*       eventuell versampling, samt p avlsningar via adc_read nr
+*       samplern r stoppad. Drmed filtreras ven PWM-styrning och
+*       temperaturmtning som bygger p strukten adc.
+*
+*       Filtret krs i avbrottsrutinen, dr median sorterar hela fnstret
+*       fr varje resultat. Median av 7 vrden kostar uppskattningsvis upp
+*       till 500 klockcykler per resultat (se host/bench/filter_bench),
+*       vilket vid 10 kHz motsvarar nra en tredjedel av processortiden.
+*       Median av fler n ADC_MEDIAN_FAST_MAX vrden tillts drfr enbart
+*       nr samplern r stoppad eller startas via adc_sampler_init_triggered
+*       med hgst ADC_MEDIAN_MAX_HZ. vriga filter kostar hgst ca 160
+*       klockcykler per resultat och tillts vid samtliga frekvenser.
+*
+*       Oavsett lge kan resultat hmtas i ordning via adc_read_sample. Om
+*       ett olst resultat skrivs ver fr att ringbufferten r full rknas
+*       antalet verskridningar upp, vilket kan lsas via adc_get_overruns.
 ********************************************************************************/
 #ifndef ADC_H_
 #define ADC_H_
 
 /* Inkluderingsdirektiv: */
 #include "misc.h"
+#include "filter.h"
 
 /* Makrodefinitioner: */
 #define ADC_MAX 1023.0 /* Hgsta digitala vrde vid AD-omvandling (motsvarar 5 V). */
 #define VCC 5.0        /* 5 V matningsspnning. */
+#define ADC_CHANNELS 6 /* Antal analoga kanaler (A0 - A5). */
+
+#define ADC_RAW_MAX 1023   /* Hgsta rvrde vid AD-omvandling som heltal. */
+#define ADC_VCC_MV 5000UL  /* Matningsspnning mtt i millivolt. */
+#define ADC_TMP36_OFFSET_CENTI 5000 /* Frskjutning fr TMP36 i hundradels grader (500 mV vid 0 grader). */
+
+#define ADC_MV_Q16 ((ADC_VCC_MV * 65536UL * 2 + ADC_RAW_MAX) / (2 * ADC_RAW_MAX))              /* mV per steg (Q16). */
+#define ADC_CENTI_CELSIUS_Q13 ((10 * ADC_VCC_MV * 8192UL * 2 + ADC_RAW_MAX) / (2 * ADC_RAW_MAX)) /* Hundradels grader per steg (Q13). */
+#define ADC_OVERSAMPLE_BITS_MAX 3 /* Hgsta antal extra bitar via versampling (13 bitar totalt). */
+
+#ifndef ADC_RING_SIZE
+#define ADC_RING_SIZE 8 /* Antal resultat i varje kanals ringbuffert (tvpotens). */
+#endif
+
+#define ADC_TRIGGER_HZ_MIN 100   /* Lgsta samplingsfrekvens vid timerstartad omvandling. */
+#define ADC_TRIGGER_HZ_MAX 10000 /* Hgsta samplingsfrekvens vid timerstartad omvandling. */
+#define ADC_MEDIAN_MAX_HZ 3000   /* Hgsta samplingsfrekvens fr median av fler n ADC_MEDIAN_FAST_MAX vrden. */
+#define ADC_MEDIAN_FAST_MAX 3    /* Hgsta antal vrden fr median ver ADC_MEDIAN_MAX_HZ. */
 
 /********************************************************************************
 * adc: Strukt fr implementering av AD-omvandlare, som mjliggr avlsning
@@ -61,12 +140,234 @@ static inline void adc_clear(struct adc* self)
 
 /********************************************************************************
 * adc_read: Lser av en analog insignal och returnerar motsvarande digitala
-*           motsvarighet mellan 0 - 1023.
+*           motsvarighet mellan 0 - 1023. Om samplern r igng returneras
+*           senaste resultatet fr pinnen direkt, dr pinnar som inte ingr i
+*           samplerns kanaler returnerar 0. Vid versampling skiftas
+*           resultatet ned till 10 bitar. Annars sker en omvandling, dr
+*           funktionen vntar tills resultatet r klart, varefter
+*           resultatet passerar kanalens filter.
 *
 *           - self: Pekare till analog pin vars insignal ska AD-omvandlas.
 ********************************************************************************/
 uint16_t adc_read(const struct adc* self);
 
+/********************************************************************************
+* adc_sampler_init: Startar kontinuerlig AD-omvandling av angivna kanaler i tur
+*                   och ordning, dr varje resultat lagras i kanalens
+*                   ringbuffert. Samtliga ringbuffertar tms. Vid lyckad start
+*                   returneras 0. Om inga giltiga kanaler anges, eller om
+*                   ngon vald kanal filtreras med median av fler n
+*                   ADC_MEDIAN_FAST_MAX vrden (ca 9600 omvandlingar per
+*                   sekund verskrider ADC_MEDIAN_MAX_HZ), returneras
+*                   felkod 1.
+*
+*                   - channel_mask: Kanaler som ska omvandlas, dr bit n
+*                                   motsvarar analog pin An, exempelvis
+*                                   (1 << 0) | (1 << 2) fr A0 och A2.
+********************************************************************************/
+int adc_sampler_init(const uint8_t channel_mask);
+
+/********************************************************************************
+* adc_sampler_init_triggered: Startar AD-omvandling av angivna kanaler i tur
+*                             och ordning med angiven samplingsfrekvens, dr
+*                             varje omvandling startas av Timer 0. Varje kanal
+*                             omvandlas drmed sample_rate_hz / antalet kanaler
+*                             gnger per sekund. Vid lyckad start returneras
+*                             0. Om inga giltiga kanaler anges, eller om
+*                             samplingsfrekvensen ligger utanfr
+*                             ADC_TRIGGER_HZ_MIN - ADC_TRIGGER_HZ_MAX,
+*                             returneras felkod 1. Detsamma gller om
+*                             samplingsfrekvensen verskrider
+*                             ADC_MEDIAN_MAX_HZ och ngon vald kanal
+*                             filtreras med median av fler n
+*                             ADC_MEDIAN_FAST_MAX vrden.
+*
+*                             - channel_mask  : Kanaler som ska omvandlas
+*                                               (bit n motsvarar An).
+*                             - sample_rate_hz: Antal omvandlingar per sekund.
+********************************************************************************/
+int adc_sampler_init_triggered(const uint8_t channel_mask,
+                               const uint16_t sample_rate_hz);
+
+/********************************************************************************
+* adc_sampler_stop: Stoppar samplern efter pgende omvandling. Lagrade
+*                   resultat finns kvar i ringbuffertarna.
+********************************************************************************/
+void adc_sampler_stop(void);
+
+/********************************************************************************
+* adc_sampler_running: Indikerar ifall samplern r igng.
+********************************************************************************/
+bool adc_sampler_running(void);
+
+/********************************************************************************
+* adc_sample_next: Lagrar resultatet av avslutad omvandling i aktuell kanals
+*                  ringbuffert och startar omvandling av nsta valda kanal.
+*                  Denna funktion ska anropas i avbrottsrutinen fr
+*                  AD-omvandlaren.
+********************************************************************************/
+void adc_sample_next(void);
+
+/********************************************************************************
+* adc_set_oversampling: Vljer antalet extra bitar via versampling fr
+*                       angiven pin, dr 4^extra_bits omvandlingar summeras
+*                       till varje resultat i ringbufferten. Kanalens
+*                       ringbuffert tms, s att resultat med olika
+*                       upplsning inte blandas. Vid ogiltig pin eller fler
+*                       n ADC_OVERSAMPLE_BITS_MAX extra bitar returneras
+*                       felkod 1, annars 0.
+*
+*                       - pin       : Analog pin 0 - 5 eller A0 - A5.
+*                       - extra_bits: Antal extra bitar (0 = ingen
+*                                     versampling).
+********************************************************************************/
+int adc_set_oversampling(const uint8_t pin,
+                         const uint8_t extra_bits);
+
+/********************************************************************************
+* adc_set_filter: Vljer filter fr angiven pin, vilket anvnds fr bde
+*                 samplerns resultat och avlsningar via adc_read. Kanalens
+*                 ringbuffert tms, varefter nsta resultat fyller filtret.
+*                 Vid ogiltig pin eller parameter returneras felkod 1,
+*                 annars 0. Felkod 1 returneras ven fr median av fler n
+*                 ADC_MEDIAN_FAST_MAX vrden om pinnen omvandlas av
+*                 samplern med en samplingsfrekvens ver ADC_MEDIAN_MAX_HZ.
+*
+*                 - pin      : Analog pin 0 - 5 eller A0 - A5.
+*                 - type     : Valt filter (FILTER_NONE = ingen filtrering).
+*                 - parameter: Antal vrden (glidande medelvrde samt median)
+*                              eller skiftning (EMA), se filter.h.
+********************************************************************************/
+int adc_set_filter(const uint8_t pin,
+                   const enum filter_type type,
+                   const uint8_t parameter);
+
+/********************************************************************************
+* adc_get_oversampling: Returnerar antalet extra bitar via versampling fr
+*                       angiven pin. Vid ogiltig pin returneras 0.
+*
+*                       - pin: Analog pin 0 - 5 eller A0 - A5.
+********************************************************************************/
+uint8_t adc_get_oversampling(const uint8_t pin);
+
+/********************************************************************************
+* adc_get_latest: Returnerar senaste resultatet frn samplern fr angiven
+*                 pin, utan att vnta p ngon omvandling. Resultatet har
+*                 10 + n bitar, dr n r kanalens antal extra bitar via
+*                 versampling. Om inget resultat finns returneras 0.
+*
+*                 - pin: Analog pin 0 - 5 eller A0 - A5.
+********************************************************************************/
+uint16_t adc_get_latest(const uint8_t pin);
+
+/********************************************************************************
+* adc_read_sample: Hmtar ldsta olsta resultatet frn samplern fr angiven
+*                  pin till angiven destination. Vid hmtat resultat
+*                  returneras 0. Om inga olsta resultat finns returneras 1.
+*
+*                  - pin   : Analog pin 0 - 5 eller A0 - A5.
+*                  - sample: Pekare till destinationen.
+********************************************************************************/
+int adc_read_sample(const uint8_t pin,
+                    uint16_t* sample);
+
+/********************************************************************************
+* adc_get_overruns: Returnerar antalet olsta resultat som har skrivits ver
+*                   sedan samplern startades, summerat ver samtliga kanaler.
+********************************************************************************/
+uint32_t adc_get_overruns(void);
+
+/********************************************************************************
+* adc_get_samples: Kopierar lagrade resultat fr angiven pin frn samplerns
+*                  ringbuffert till angiven destination, ldsta resultatet
+*                  frst. Antalet kopierade resultat returneras, vilket r
+*                  hgst ADC_RING_SIZE.
+*
+*                  - pin        : Analog pin 0 - 5 eller A0 - A5.
+*                  - destination: Destination med plats fr ADC_RING_SIZE
+*                                 resultat.
+********************************************************************************/
+uint8_t adc_get_samples(const uint8_t pin,
+                        uint16_t* destination);
+
+/********************************************************************************
+* adc_sample_to_mv: Omvandlar ett resultat med 10 + extra_bits bitar till
+*                   motsvarande inspnning mtt i millivolt, avrundat till
+*                   nrmaste heltal (hgst 1 mV fel).
+*
+*                   - sample    : Resultat frn AD-omvandlaren eller samplern.
+*                   - extra_bits: Antal extra bitar via versampling (0 - 3).
+********************************************************************************/
+static inline uint16_t adc_sample_to_mv(const uint16_t sample,
+                                        const uint8_t extra_bits)
+{
+   return (uint16_t)(((uint32_t)sample * ADC_MV_Q16 + (0x8000UL << extra_bits)) >> (16 + extra_bits));
+}
+
+/********************************************************************************
+* adc_sample_to_centi_celsius: Omvandlar ett resultat med 10 + extra_bits
+*                              bitar frn temperatursensor TMP36 till
+*                              motsvarande temperatur i hundradels grader
+*                              Celcius, dvs. T = 10 * Uin[mV] - 5000.
+*
+*                              - sample    : Resultat frn AD-omvandlaren eller
+*                                            samplern.
+*                              - extra_bits: Antal extra bitar via
+*                                            versampling (0 - 3).
+********************************************************************************/
+static inline int32_t adc_sample_to_centi_celsius(const uint16_t sample,
+                                                  const uint8_t extra_bits)
+{
+   return (int32_t)(((uint32_t)sample * ADC_CENTI_CELSIUS_Q13 + (0x1000UL << extra_bits)) >> (13 + extra_bits)) -
+          ADC_TMP36_OFFSET_CENTI;
+}
+
+/********************************************************************************
+* adc_raw_to_mv: Omvandlar ett rvrde 0 - 1023 till motsvarande inspnning
+*                mtt i millivolt, avrundat till nrmaste heltal (hgst 1 mV
+*                fel). AD-omvandlaren lses inte av.
+*
+*                - raw: Rvrde frn AD-omvandlaren.
+********************************************************************************/
+static inline uint16_t adc_raw_to_mv(const uint16_t raw)
+{
+   return adc_sample_to_mv(raw, 0);
+}
+
+/********************************************************************************
+* adc_raw_to_centi_celsius: Omvandlar ett rvrde 0 - 1023 frn
+*                           temperatursensor TMP36 till motsvarande
+*                           temperatur i hundradels grader Celcius, dvs.
+*                           T = 10 * Uin[mV] - 5000. AD-omvandlaren lses
+*                           inte av.
+*
+*                           - raw: Rvrde frn AD-omvandlaren.
+********************************************************************************/
+static inline int32_t adc_raw_to_centi_celsius(const uint16_t raw)
+{
+   return adc_sample_to_centi_celsius(raw, 0);
+}
+
+/********************************************************************************
+* adc_read_mv: Lser av en analog insignal och returnerar motsvarande
+*              inspnning mtt i millivolt. Om samplern r igng anvnds
+*              senaste resultatet med kanalens fulla upplsning.
+*
+*              - self: Pekare till analog pin som ska lsas av.
+********************************************************************************/
+uint16_t adc_read_mv(const struct adc* self);
+
+/********************************************************************************
+* adc_get_temperature_centi: Returnerar aktuell rumstemperatur i hundradels
+*                            grader Celcius via avlsning av temperatursensor
+*                            TMP36, ansluten till angiven pin. Om samplern r
+*                            igng anvnds senaste resultatet med kanalens
+*                            fulla upplsning.
+*
+*                            - self: Pekare till analog pin som ska lsas av.
+********************************************************************************/
+int32_t adc_get_temperature_centi(const struct adc* self);
+
 /********************************************************************************
 * adc_duty_cycle: Lser av en analog insignal och returnerar motsvarande
 *                 duty cycle som ett flyttal mellan 0 - 1.
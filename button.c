@@ -15,7 +15,7 @@
 void button_init(struct button* self,
                  const uint8_t pin)
 {
-   if (pin >= 0 && pin <= 7)
+   if (pin <= 7)
    {
       self->pin = pin;
       self->pullup = &PORTD;
@@ -82,7 +82,6 @@ void button_clear(struct button* self)
 ********************************************************************************/
 void button_enable_interrupt(struct button* self)
 {
-   asm("SEI");
    PCICR |= (1 << self->pcint);
    *(self->pcmsk) |= (1 << self->pin);
    return;
@@ -0,0 +1,238 @@
+/********************************************************************************
+* command.c: Innehller funktionsdefinitioner fr styrning av
+*            7-segmentsdisplayerna via textkommandon mottagna via seriell
+*            verfring.
+********************************************************************************/
+#include "command.h"
+
+/* Statiska funktioner: */
+static int command_execute(char* line);
+static char* command_next_token(char** cursor);
+static int command_parse_number(const char* s,
+                                uint32_t* value);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - line         : Kommandoraden som tas emot.
+*   - line_length  : Antalet mottagna tecken p aktuell kommandorad.
+*   - line_overflow: Indikerar ifall aktuell kommandorad r fr lng.
+********************************************************************************/
+static char line[COMMAND_LINE_MAX + 1];
+static uint8_t line_length = 0;
+static bool line_overflow = false;
+
+/********************************************************************************
+* command_poll: Hmtar mottagna tecken frn mottagningsbufferten och genomfr
+*               varje fullstndigt mottaget kommando.
+*
+*               1. Mottagna tecken lggs till p aktuell kommandorad. Om
+*                  raden blir fr lng ignoreras resterande tecken och raden
+*                  markeras som felaktig.
+*
+*               2. Vid vagnretur eller nyradstecken avslutas raden. Tomma
+*                  rader ignoreras, vilket gr att bde "\r", "\n" och
+*                  "\r\n" kan anvndas som radslut.
+*
+*               3. Kommandot genomfrs och svaret OK eller ERROR skickas.
+********************************************************************************/
+void command_poll(void)
+{
+   char character;
+
+   while (serial_read_char(&character) == 0)
+   {
+      if (character == '\r' || character == '\n')
+      {
+         if (line_overflow)
+         {
+            serial_print_string("ERROR\n");
+         }
+         else if (line_length > 0)
+         {
+            line[line_length] = '\0';
+            serial_print_string(command_execute(line) ? "ERROR\n" : "OK\n");
+         }
+
+         line_length = 0;
+         line_overflow = false;
+      }
+      else if (line_length < COMMAND_LINE_MAX)
+      {
+         line[line_length++] = character;
+      }
+      else
+      {
+         line_overflow = true;
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* command_execute: Tolkar och genomfr angivet kommando. Vid lyckat kommando
+*                  returneras 0. Vid oknt kommando, felaktiga argument eller
+*                  felaktigt antal argument returneras felkod 1.
+*
+*                  1. Kommandoraden delas upp i namn samt upp till tv
+*                     argument direkt i radbufferten.
+*
+*                  2. Namnet jmfrs mot knda kommandon, varefter
+*                     argumenten tolkas och motsvarande funktion fr
+*                     displayerna anropas.
+*
+*                  - line: Kommandoraden, som delas upp av funktionen.
+********************************************************************************/
+static int command_execute(char* line)
+{
+   char* cursor = line;
+   const char* name = command_next_token(&cursor);
+   const char* argument = command_next_token(&cursor);
+   const char* argument2 = command_next_token(&cursor);
+   uint32_t value;
+
+   if (name == NULL || command_next_token(&cursor)) return 1;
+
+   if (!strcmp(name, "number"))
+   {
+      if (argument == NULL || argument2 || command_parse_number(argument, &value)) return 1;
+      return display_set_number(value);
+   }
+   else if (!strcmp(name, "radix"))
+   {
+      if (argument == NULL || argument2 || command_parse_number(argument, &value)) return 1;
+      if (value > UINT8_MAX) return 1;
+      return display_set_radix((uint8_t)value);
+   }
+   else if (!strcmp(name, "output"))
+   {
+      if (argument == NULL || argument2) return 1;
+      if (!strcmp(argument, "on")) display_enable_output();
+      else if (!strcmp(argument, "off")) display_disable_output();
+      else if (!strcmp(argument, "toggle")) display_toggle_output();
+      else return 1;
+      return 0;
+   }
+   else if (!strcmp(name, "count"))
+   {
+      if (argument == NULL) return 1;
+
+      if (argument2)
+      {
+         enum display_count_direction direction;
+         if (!strcmp(argument, "up")) direction = DISPLAY_COUNT_DIRECTION_UP;
+         else if (!strcmp(argument, "down")) direction = DISPLAY_COUNT_DIRECTION_DOWN;
+         else return 1;
+         if (command_parse_number(argument2, &value) || value == 0 || value > UINT16_MAX) return 1;
+         display_set_count(direction, (uint16_t)value);
+         display_enable_count();
+         return 0;
+      }
+
+      if (!strcmp(argument, "on")) display_enable_count();
+      else if (!strcmp(argument, "off")) display_disable_count();
+      else if (!strcmp(argument, "toggle")) display_toggle_count();
+      else return 1;
+      return 0;
+   }
+   else if (!strcmp(name, "direction"))
+   {
+      if (argument == NULL || argument2) return 1;
+      if (!strcmp(argument, "up")) display_set_count_direction(DISPLAY_COUNT_DIRECTION_UP);
+      else if (!strcmp(argument, "down")) display_set_count_direction(DISPLAY_COUNT_DIRECTION_DOWN);
+      else if (!strcmp(argument, "toggle")) display_toggle_count_direction();
+      else return 1;
+      return 0;
+   }
+   else if (!strcmp(name, "refresh"))
+   {
+      if (argument == NULL || argument2 || command_parse_number(argument, &value)) return 1;
+      if (value > UINT16_MAX) return 1;
+      return display_set_refresh_rate((uint16_t)value);
+   }
+   else if (!strcmp(name, "reset"))
+   {
+      if (argument) return 1;
+      display_reset();
+      return 0;
+   }
+   else if (!strcmp(name, "state"))
+   {
+      if (argument) return 1;
+      display_send_state();
+      return 0;
+   }
+   return 1;
+}
+
+/********************************************************************************
+* command_next_token: Returnerar nsta ord i kommandoraden frn angiven
+*                     position, dr ord separeras med mellanslag eller tab.
+*                     Ordet avslutas med ett nolltecken direkt i radbufferten
+*                     och positionen flyttas till efter ordet, vilket gr att
+*                     inget extra minne behvs. Om inga fler ord finns
+*                     returneras NULL.
+*
+*                     - cursor: Pekare till aktuell position i kommandoraden.
+********************************************************************************/
+static char* command_next_token(char** cursor)
+{
+   char* s = *cursor;
+   while (*s == ' ' || *s == '\t') s++;
+   if (*s == '\0') return NULL;
+
+   char* token = s;
+   while (*s && *s != ' ' && *s != '\t') s++;
+   if (*s) *s++ = '\0';
+
+   *cursor = s;
+   return token;
+}
+
+/********************************************************************************
+* command_parse_number: Tolkar angiven text som ett osignerat 32-bitars tal,
+*                       angivet decimalt, hexadecimalt med prefix 0x eller
+*                       binrt med prefix 0b. Vid lyckad tolkning lagras talet
+*                       p angiven destination och 0 returneras. Vid
+*                       ogiltiga tecken eller fr stort tal returneras
+*                       felkod 1.
+*
+*                       - s    : Texten som ska tolkas.
+*                       - value: Pekare till destinationen fr tolkat tal.
+********************************************************************************/
+static int command_parse_number(const char* s,
+                                uint32_t* value)
+{
+   uint8_t base = 10;
+   uint32_t result = 0;
+
+   if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+   {
+      base = 16;
+      s += 2;
+   }
+   else if (s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+   {
+      base = 2;
+      s += 2;
+   }
+
+   if (*s == '\0') return 1;
+
+   for (; *s; ++s)
+   {
+      uint8_t digit;
+
+      if (*s >= '0' && *s <= '9') digit = *s - '0';
+      else if (*s >= 'a' && *s <= 'f') digit = *s - 'a' + 10;
+      else if (*s >= 'A' && *s <= 'F') digit = *s - 'A' + 10;
+      else return 1;
+
+      if (digit >= base) return 1;
+      if (result > (UINT32_MAX - digit) / base) return 1;
+      result = result * base + digit;
+   }
+
+   *value = result;
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+/********************************************************************************
+* command.h: Innehller funktionalitet fr styrning av 7-segmentsdisplayerna
+*            via textkommandon mottagna via seriell verfring. Varje kommando
+*            skickas som en rad avslutad med vagnretur eller nyradstecken,
+*            dr kommandots namn och argument separeras med mellanslag:
+*
+*            number <tal>               - Stter talet som visas.
+*            radix <2 | 10 | 16>        - Stter talbasen.
+*            output <on | off | toggle> - Stter p eller stnger av displayerna.
+*            count <on | off | toggle>  - Aktiverar eller inaktiverar rkning.
+*            count <up | down> <ms>     - Stter riktning samt hastighet och
+*                                         aktiverar rkning.
+*            direction <up | down | toggle> - Stter rkningsriktning.
+*            refresh <hz>               - Stter uppdateringsfrekvensen per
+*                                         display (60 - 1000 Hz).
+*            reset                      - terstller displayerna.
+*            state                      - Skickar displayernas tillstnd som en
+*                                         binr ram.
+*
+*            Tal kan anges decimalt, hexadecimalt med prefix 0x eller binrt
+*            med prefix 0b. Efter varje kommando skickas svaret OK eller ERROR.
+*
+*            Kommandon tolkas och genomfrs via command_poll, som ska anropas
+*            frn huvudloopen. Avbrottsrutinen fr mottagning lgger enbart
+*            tecken i mottagningsbufferten, vilket gr att multiplexeringen
+*            av displayerna inte frdrjs av kommandohanteringen.
+********************************************************************************/
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+/* Inkluderingsdirektiv: */
+#include "display.h"
+#include "serial.h"
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define COMMAND_LINE_MAX 32 /* Hgsta antal tecken per kommandorad. */
+
+/********************************************************************************
+* command_poll: Hmtar mottagna tecken frn mottagningsbufferten och genomfr
+*               varje fullstndigt mottaget kommando. Ska anropas
+*               kontinuerligt frn huvudloopen.
+********************************************************************************/
+void command_poll(void);
+
+#endif /* COMMAND_H_ */
\ No newline at end of file
@@ -1,24 +1,20 @@
 /********************************************************************************
-* display.h: Innehller drivrutiner fr tv 7-segmentsdisplayer anslutna till
-*            till PORTD0 - PORTD6 (pin 0 - 6), som kan visa tv siffror i binr,
-*            decimal eller hexadecimal form. Matningsspnningen fr respektive
-*            7-segmentsdisplay genereras frn PORTD7 (pin 7) respektive
-*            PORTC3 (pin A3), dr lg signal medfr tnd display, d displayerna
-*            har gemensam katod.
+* display.c: Innehller drivrutiner fr multiplexade 7-segmentsdisplayer
+*            anslutna till PORTD0 - PORTD6 (pin 0 - 6), som kan visa tal i
+*            binr, decimal eller hexadecimal form. Matningsspnningen fr
+*            respektive 7-segmentsdisplay genereras frn en godtycklig pin
+*            angiven vid initiering, dr lg signal medfr tnd display, d
+*            displayerna har gemensam katod.
 ********************************************************************************/
 #include "display.h"
 #include "eeprom.h"
+#include "serial.h"
+#include "event.h"
 
 /********************************************************************************
 * Makrodefinitioner:
 ********************************************************************************/
-#define DISPLAY1_CATHODE PORTD7 /* Katod fr display 1. */
-#define DISPLAY2_CATHODE PORTC3 /* Katod fr display 1. */
-
-#define DISPLAY1_ON  PORTD &= ~(1 << DISPLAY1_CATHODE) /* Tnder display 1. */
-#define DISPLAY2_ON  PORTC &= ~(1 << DISPLAY2_CATHODE) /* Tnder display 2. */
-#define DISPLAY1_OFF PORTD |= (1 << DISPLAY1_CATHODE)  /* Slcker display 1. */
-#define DISPLAY2_OFF PORTC |= (1 << DISPLAY2_CATHODE)  /* Slcker display 1. */
+#define DISPLAY_SEGMENTS 0x7F /* Segment a - g anslutna till PORTD0 - PORTD6. */
 
 #define OFF 0x00   /* Binrkod fr slckning av 7-segmentsdisplay. */
 #define ZERO 0x3F  /* Binrkod fr utskrift av heltalet 0 p 7-segmentsdisplay. */
@@ -38,74 +34,132 @@
 #define E 0x79     /* Binrkod fr utskrift av heltalet 0xE (14) p 7-segmentsdisplay. */
 #define F 0x71     /* Binrkod fr utskrift av heltalet 0xF (15) p 7-segmentsdisplay. */
 
-#define EEPROM_NUMBER 100				// Hr sparas talet p displayerna
-#define EEPROM_OUTPUT_ENABLED 101	// Hr sparas om displayerna r p (1 = p, 0 = av).
-#define EEPROM_COUNT_ENABLED 102		// Hr sparas om rkningen r p eller inte (1 = p, 0 = av).
-#define EEPROM_COUNT_DIRECTION 103	// Hr sparas i vilken riktning som rknaren gr (1 = p, 0 = av).
-#define EEPROM_INITIALIZED 104		// Hr sparas om EEPROM har initierats eller ej (0 = sant, 0xFF = falskt).
+#define EEPROM_STATE 100         // Hr brjar ringbufferten med displayernas tillstnd.
+#define EEPROM_STATE_RECORDS 100 // Antal platser i ringbufferten (nio byte per plats, 100 - 999).
 
 /********************************************************************************
-* display_digit: Enumeration fr selektion av de olika displayerna.
+* display: Strukt fr multiplexade 7-segmentsdisplayer, dr samtliga displayer
+*          delar p segmentpinnarna PORTD0 - PORTD6 och tnds en i taget via
+*          respektive katod. Binrkoden fr varje display berknas nr talet
+*          eller talbasen ndras och lagras i en framebuffer, s att
+*          avbrottsrutinen enbart behver skriva frdiga vrden till porten.
 ********************************************************************************/
-enum display_digit
+struct display
 {
-	DISPLAY_DIGIT1, /* Display 1, som visar tiotal. */
-	DISPLAY_DIGIT2  /* Display 2, som visar ental. */
+	struct led cathodes[DISPLAY_DIGITS_MAX];    /* Katoder, mest signifikanta siffran frst. */
+	volatile uint8_t frame[DISPLAY_DIGITS_MAX]; /* Binrkod fr respektive display. */
+	uint8_t num_digits;                         /* Antalet anslutna displayer. */
+	volatile uint8_t scan_index;                /* Index fr den display som r tnd. */
+};
+
+/********************************************************************************
+* display_state: Strukt innehllande displayernas tillstnd som sparas i
+*                EEPROM, s att programmet kan fortstta frn samma punkt
+*                efter att matningsspnningen har frsvunnit. Strukten lagras
+*                som en post i en ringbuffert med start p adress EEPROM_STATE,
+*                vilket frdelar skrivningarna ver EEPROM_STATE_RECORDS platser.
+********************************************************************************/
+struct display_state
+{
+	uint32_t number;         /* Talet p displayerna. */
+	uint8_t output_enabled;  /* Indikerar om displayerna r p (1 = p, 0 = av). */
+	uint8_t count_enabled;   /* Indikerar om rkningen r p (1 = p, 0 = av). */
+	uint8_t count_direction; /* Upprkningsriktning (1 = uppt, 0 = nedt). */
+	uint8_t initialized;     /* Indikerar om EEPROM har initierats (0 = sant, 0xFF = falskt). */
 };
 
 /********************************************************************************
 * Statiska funktioner:
 ********************************************************************************/
-static inline void display_update_output(const uint8_t digit);
-static inline uint8_t display_get_binary_code(const uint8_t digit);
+static void display_update_frame(void);
+static void display_all_digits_off(void);
+static uint32_t display_get_max_val(const uint8_t radix, const uint8_t num_digits);
+static uint32_t display_get_digit_period_us(const uint16_t refresh_hz, const uint8_t num_digits);
 static inline void check_eeprom_values(void);
 static inline void reset_eeprom_values(void);
+static void display_count_elapsed(void);
+
+/********************************************************************************
+* segment_codes: Binrkoder fr heltal 0 - 15 lagrade i programminnet, dr
+*                index motsvarar siffran som ska skrivas ut.
+********************************************************************************/
+static const uint8_t segment_codes[16] PROGMEM =
+{
+	ZERO, ONE, TWO, THREE, FOUR, FIVE, SIX, SEVEN,
+	EIGHT, NINE, A, B, C, D, E, F
+};
 
 /********************************************************************************
 * Statiska variabler:
 *
+*   - display: Displayerna, deras katoder samt framebuffer.
 *   - number : Talet som skrivs ut p displayerna.
-*   - digit1 : Tiotalet som skrivs ut p display 1.
-*   - digit2 : Entalet som skrivs ut p display 2.
 *   - radix  : Talbas (default = 10, dvs. decimal form).
-*   - max_val: Maxvrde fr tal p 7-segmentsdisplayerna (beror p talbasen).
+*   - max_val: Maxvrde fr tal p 7-segmentsdisplayerna (beror p talbasen
+*              samt antalet displayer).
 *
 *   - count_direction: Indikerar rkningsriktning, dr default r upprkning.
-*   - current_digit  : Indikerar vilken av aktuellt tals siffror som skrivs ut
-*                      p aktiverad 7-segmentsdisplay, dr default r tiotalet
-*                      p display 1.
+*
+*   - state      : Tillstnd som ska sparas i EEPROM. Uppdateras direkt vid
+*                  frndring, ven frn avbrottsrutiner.
+*   - state_saved: Kopia av tillstndet som senast skrevs till EEPROM.
+*   - state_ring : Ringbuffert i EEPROM dr tillstndet sparas.
+*   - state_dirty: Indikerar att state har frndrats sedan senaste skrivning.
+*   - state_flushing: Indikerar att display_flush_state pgr.
 *
 *   - timer_digit      : Timerkrets fr att skifta displayer (Timer 1).
-*   - timer_count_speed: Timerkrets fr upprkning av heltal (Timer 2).
+*   - refresh_hz       : Antal gnger per sekund varje display tnds.
+*   - timer_count_speed: Mjukvarutimer fr upprkning av heltal.
+*   - count_speed_ms   : Upprkningshastighet mtt i ms.
 ********************************************************************************/
-static uint8_t number = 0;
-static uint8_t digit1 = 0;
-static uint8_t digit2 = 0;
+static struct display display;
+static uint32_t number = 0;
 static uint8_t radix = 10;
-static uint8_t max_val = 99;
+static uint32_t max_val = 99;
 
 static enum display_count_direction count_direction = DISPLAY_COUNT_DIRECTION_UP;
-static enum display_digit current_digit = DISPLAY_DIGIT1;
+
+static volatile struct display_state state;
+static struct display_state state_saved;
+static struct eeprom_ring state_ring;
+static volatile bool state_dirty = false;
+static volatile bool state_flushing = false;
 
 static struct timer timer_digit;
-static struct timer timer_count_speed;
+static uint16_t refresh_hz = DISPLAY_REFRESH_HZ;
+static struct timer_soft timer_count_speed;
+static uint16_t count_speed_ms = 1000;
 
 /********************************************************************************
-* display_init: Initierar hrdvara fr 7-segmentsdisplayer.
+* display_init: Initierar hrdvara fr 7-segmentsdisplayer. Vid felaktigt
+*               angivet antal displayer returneras felkod 1, annars 0.
+*
+*               - cathode_pins: Pinnar fr displayernas katoder, dr den
+*                               mest signifikanta siffran anges frst.
+*               - num_digits  : Antalet displayer (1 - DISPLAY_DIGITS_MAX).
 ********************************************************************************/
-void display_init(void)
+int display_init(const uint8_t* cathode_pins, const uint8_t num_digits)
 {
-	DDRD = 0xFF;
-	DDRC |= (1 << DISPLAY2_CATHODE);
-	DISPLAY1_OFF;
-	DISPLAY2_OFF;
+	if (num_digits == 0 || num_digits > DISPLAY_DIGITS_MAX) return 1;
+	DDRD |= DISPLAY_SEGMENTS;
+
+	for (uint8_t i = 0; i < num_digits; ++i)
+	{
+		led_init(&display.cathodes[i], cathode_pins[i]);
+	}
+
+	display.num_digits = num_digits;
+	display.scan_index = 0;
+	display_all_digits_off();
+	max_val = display_get_max_val(radix, num_digits);
+	display_update_frame();
 
-	timer_init(&timer_digit, TIMER_SEL_1, 1); // Skiftar siffra en gng per ms.
-	timer_init(&timer_count_speed, TIMER_SEL_2, 1000);
+	timer_init_us(&timer_digit, TIMER_SEL_1, display_get_digit_period_us(refresh_hz, num_digits));
+	timer_soft_init(&timer_count_speed, display_count_elapsed);
 	
 	check_eeprom_values(); // Vi kollar om det finns gamla vrden sparade i EEPROM och lser i s fall in dem.
 	
-	return;
+	return 0;
 }
 /********************************************************************************
 * display_reset: terstller 7-segmentsdisplayer till startlget.
@@ -113,18 +167,16 @@ void display_init(void)
 void display_reset(void)
 {
 	timer_reset(&timer_digit);
-	timer_reset(&timer_count_speed);
-	DISPLAY1_OFF;
-	DISPLAY2_OFF;
+	timer_soft_stop(&timer_count_speed);
+	display_all_digits_off();
 
 	number = 0;
-	digit1 = 0;
-	digit2 = 0;
 	radix = 10;
-	max_val = 99;
+	max_val = display_get_max_val(radix, display.num_digits);
+	display.scan_index = 0;
+	display_update_frame();
 	
 	count_direction = DISPLAY_COUNT_DIRECTION_UP;
-	current_digit = DISPLAY_DIGIT1;
 	reset_eeprom_values();
 	return;
 }
@@ -135,7 +187,6 @@ void display_reset(void)
 ********************************************************************************/
 bool display_output_enabled(void)
 {
-	eeprom_write_byte(EEPROM_OUTPUT_ENABLED, 1);
 	return timer_interrupt_enabled(&timer_digit);
 }
 
@@ -146,8 +197,27 @@ bool display_output_enabled(void)
 ********************************************************************************/
 bool display_count_enabled(void)
 {
-	eeprom_write_byte(EEPROM_COUNT_ENABLED, 1);
-	return timer_interrupt_enabled(&timer_count_speed);
+	return timer_soft_active(&timer_count_speed);
+}
+
+/********************************************************************************
+* display_send_state: Skickar 7-segmentsdisplayernas tillstnd som en binr
+*                     ram via seriell verfring, se serial_send_frame.
+*                     Talet lses utan att avbrott inaktiveras, eftersom det
+*                     enbart ndras frn huvudloopen: timerhjulets
+*                     avbrottsrutin lgger rkningen i hndelsekn (se
+*                     display_count_elapsed) och vriga ndringar sker via
+*                     kommandon samt tryckknappar som hanteras i huvudloopen.
+********************************************************************************/
+void display_send_state(void)
+{
+	uint8_t flags = 0;
+	if (display_output_enabled()) flags |= SERIAL_DISPLAY_OUTPUT_ENABLED;
+	if (display_count_enabled()) flags |= SERIAL_DISPLAY_COUNT_ENABLED;
+	if (count_direction == DISPLAY_COUNT_DIRECTION_UP) flags |= SERIAL_DISPLAY_COUNT_UP;
+
+	serial_send_display_state(number, radix, flags);
+	return;
 }
 
 /********************************************************************************
@@ -156,8 +226,9 @@ bool display_count_enabled(void)
 void display_enable_output(void)
 {
 	timer_enable_interrupt(&timer_digit);
-	// I EEPROM, sparas att displayerna r p:
-	eeprom_write_byte(EEPROM_OUTPUT_ENABLED, 1);
+	// Sparas till EEPROM vid nsta anrop av display_flush_state:
+	state.output_enabled = 1;
+	state_dirty = true;
 	return;
 }
 
@@ -167,10 +238,10 @@ void display_enable_output(void)
 void display_disable_output(void)
 {
 	timer_reset(&timer_digit);
-	DISPLAY1_OFF;
-	DISPLAY2_OFF;
-	// I EEPROM, sparas att displayerna r av:
-	eeprom_write_byte(EEPROM_OUTPUT_ENABLED, 0);
+	display_all_digits_off();
+	// Sparas till EEPROM vid nsta anrop av display_flush_state:
+	state.output_enabled = 0;
+	state_dirty = true;
 	return;
 }
 
@@ -194,21 +265,21 @@ void display_toggle_output(void)
 /********************************************************************************
 * display_set_number: Stter nytt heltal fr utskrift p 7-segmentsdisplayer.
 *                     Om angivet heltal verstiger maxvrdet som kan skrivas ut
-*                     p tv 7-segmentsdisplayer med aktuell talbas returneras
-*                     felkod 1. Annars returneras heltalet 0 efter att heltalet
-*                     p 7-segmentsdisplayerna har uppdaterats.
+*                     p anslutna 7-segmentsdisplayer med aktuell talbas
+*                     returneras felkod 1. Annars returneras heltalet 0 efter
+*                     att heltalet p 7-segmentsdisplayerna har uppdaterats.
 *
 *                     - new_number: Nytt tal som ska skrivas ut p displayerna.
 ********************************************************************************/
-int display_set_number(const uint8_t new_number)
+int display_set_number(const uint32_t new_number)
 {
 	if (new_number <= max_val)
 	{
 		number = new_number;	
-		digit1 = number / radix; 
-		digit2 = number - (digit1 * radix);
+		display_update_frame();
 		
-		eeprom_write_byte(EEPROM_NUMBER, number);
+		state.number = number;
+		state_dirty = true;
 		return 0;
 	}
 	else 
@@ -219,9 +290,11 @@ int display_set_number(const uint8_t new_number)
 
 /********************************************************************************
 * display_set_radix: Stter ny talbas till 2, 10 eller 16 utskrift av tal p
-*                    7-segmentsdisplayer. Drmed kan tal skrivas ut binrt
-*                    (00 - 11), decimalt (00 - 99) eller hexadecimalt (00 - FF).
-*                    Vid felaktigt angiven talbas returneras felkod 1. Annars
+*                    7-segmentsdisplayer. Drmed kan tal skrivas ut binrt,
+*                    decimalt eller hexadecimalt, exempelvis 00 - 11, 00 - 99
+*                    respektive 00 - FF p tv displayer. Ifall aktuellt tal
+*                    inte ryms med den nya talbasen nollstlls talet. Vid
+*                    felaktigt angiven talbas returneras felkod 1. Annars
 *                    returneras heltalet 0 efter att anvnd talbas har
 *                    uppdaterats.
 *
@@ -229,99 +302,103 @@ int display_set_number(const uint8_t new_number)
 ********************************************************************************/
 int display_set_radix(const uint8_t new_radix)
 {
-	if(new_radix == 2)
-	{
-		max_val = 0b11; // 3
-	}
-	else if(new_radix == 10)
-	{
-		max_val = 99;
-	}
-	else if(new_radix == 16)
-	{
-		max_val = 0xFF; // 255
-	}
-	else
+	if (new_radix != 2 && new_radix != 10 && new_radix != 16)
 	{
 		return 1;
 	}
 	
 	radix = new_radix;
+	max_val = display_get_max_val(radix, display.num_digits);
+	if (number > max_val) number = 0;
+	display_set_number(number);
 	return 0;
 }
 
 /********************************************************************************
-* display_toggle_digit: Skiftar aktiverad 7-segmentsdisplay fr utskrift av
-*                       tiotal och ental, vilket r ndvndigt, d displayerna
-*                       delar p samma pinnar. Enbart en vrdesiffra skrivs
-*                       ut om mjligt, exempelvis 9 i stllet fr 09. Denna
-*                       funktion br anropas en gng per millisekund fr att
-*                       ett givet tvsiffrigt tal ska upplevas skrivas ut
-*                       kontinuerligt.
+* display_toggle_digit: Skiftar tnd 7-segmentsdisplay till nsta display i
+*                       tur, vilket r ndvndigt, d displayerna delar p
+*                       samma pinnar. Binrkoden hmtas direkt frn
+*                       framebuffern, vilket medfr att tiden fr varje
+*                       skifte r densamma oavsett tal och antal displayer.
+*                       Timer 1 genererar avbrott exakt en gng per skifte
+*                       (se display_set_refresh_rate), vilket gr att
+*                       skiftet sker direkt utan upprkning i mjukvara.
 ********************************************************************************/
 void display_toggle_digit(void)
 {
-	timer_count(&timer_digit);
+	uint8_t i = display.scan_index;
+	led_on(&display.cathodes[i]); // Hg katod slcker aktuell display.
+	
+	if (++i >= display.num_digits) i = 0;
+	display.scan_index = i;
 	
-	if (timer_elapsed(&timer_digit))
+	PORTD = (PORTD & ~DISPLAY_SEGMENTS) | display.frame[i];
+	led_off(&display.cathodes[i]); // Lg katod tnder nsta display.
+	return;
+}
+
+/********************************************************************************
+* display_set_refresh_rate: Stter antalet gnger per sekund som varje
+*                           7-segmentsdisplay tnds, dr Timer 1 stlls in
+*                           p motsvarande tid per skifte. Vid frekvens
+*                           utanfr DISPLAY_REFRESH_HZ_MIN -
+*                           DISPLAY_REFRESH_HZ_MAX returneras felkod 1,
+*                           annars returneras 0. Om displayerna nnu inte
+*                           har initierats anvnds frekvensen vid
+*                           initieringen.
+*
+*                           - new_refresh_hz: Ny uppdateringsfrekvens i Hz.
+********************************************************************************/
+int display_set_refresh_rate(const uint16_t new_refresh_hz)
+{
+	if (new_refresh_hz < DISPLAY_REFRESH_HZ_MIN || new_refresh_hz > DISPLAY_REFRESH_HZ_MAX)
 	{
-		current_digit = !current_digit;
-		
-		if (current_digit == DISPLAY_DIGIT1)
-		{
-			DISPLAY2_OFF;
-			
-			if (digit1 == 0) 
-			{
-				DISPLAY1_OFF;
-			}
-			else
-			{
-				display_update_output(digit1);
-				DISPLAY1_ON;	
-			}
-		}
-		else
-		{
-			DISPLAY1_OFF;
-			display_update_output(digit2);
-			DISPLAY2_ON;
-		}
+		return 1;
 	}
-	return;
+
+	refresh_hz = new_refresh_hz;
+
+	if (display.num_digits)
+	{
+		timer_set_new_time_us(&timer_digit, display_get_digit_period_us(refresh_hz, display.num_digits));
+	}
+	return 0;
 }
 
 /********************************************************************************
-* display_count: Rknar upp eller ned tal p 7-segmentsdisplayer.
+* display_get_refresh_rate: Returnerar antalet gnger per sekund som varje
+*                           7-segmentsdisplay tnds.
+********************************************************************************/
+uint16_t display_get_refresh_rate(void)
+{
+	return refresh_hz;
+}
+
+/********************************************************************************
+* display_count: Rknar upp eller ned tal p 7-segmentsdisplayer. Anropas frn
+*               huvudloopen via hndelsekn nr mjukvarutimern
+*               timer_count_speed lper ut.
 *
-*					  1. Rknar upp lpt tid via timern timer_count_speed.
-*					  2. Nr timern lpt ut sker upp/nedrkning
-					  3. Vid upprkning, inkrementera variabeln number upp  till
-					     och med aktuellt maxvrde max_val, annars nollstll.
-					  4. Vid nedrkning dekrementeras variabeln number till 0, 
-						  drefter stts den till max_val.
-					  5. Uppdaterar vrdet med hjlp av display_set_number.
+*					  1. Vid upprkning, inkrementera variabeln number upp  till
+*					     och med aktuellt maxvrde max_val, annars nollstll.
+*					  2. Vid nedrkning dekrementeras variabeln number till 0, 
+*						  drefter stts den till max_val.
+*					  3. Uppdaterar vrdet med hjlp av display_set_number.
 ********************************************************************************/
 void display_count(void)
 {
-	timer_count(&timer_count_speed);
-	
-	if (timer_elapsed(&timer_count_speed))
+	if (count_direction == DISPLAY_COUNT_DIRECTION_UP)
 	{
-		if (count_direction == DISPLAY_COUNT_DIRECTION_UP)
-		{
-			if (number >= max_val) number = 0;
-			else number++;
-		}
-		else
-		{
-			if(number == 0) number = max_val;
-			else number--;
-		}
-		
-		display_set_number(number);
+		if (number >= max_val) number = 0;
+		else number++;
 	}
-
+	else
+	{
+		if(number == 0) number = max_val;
+		else number--;
+	}
+	
+	display_set_number(number);
 	return;
 }
 
@@ -334,7 +411,8 @@ void display_count(void)
 void display_set_count_direction(const enum display_count_direction new_direction)
 {
 	count_direction = new_direction;
-	eeprom_write_byte(EEPROM_COUNT_DIRECTION, (uint8_t)(new_direction));
+	state.count_direction = (uint8_t)(count_direction);
+	state_dirty = true;
 	return;
 }
 
@@ -346,7 +424,8 @@ void display_toggle_count_direction(void)
 {
 	count_direction = !count_direction;
 	// Hr sparass upprkningsriktningen
-	eeprom_write_byte(EEPROM_COUNT_DIRECTION, (uint8_t)(count_direction));
+	state.count_direction = (uint8_t)(count_direction);
+	state_dirty = true;
 	return;
 }
 
@@ -354,13 +433,20 @@ void display_toggle_count_direction(void)
 * display_set_count: Stller in upp- eller nedrkning av tal som skrivs ut p
 *                    7-segmentsdisplayerna med godtycklig upprkningshastighet.
 *
-*                    - direction     : Upprkningsriktning.
-*                    - count_speed_ms: Upprkningshastighet mtt i ms.
+*                    - direction         : Upprkningsriktning.
+*                    - new_count_speed_ms: Upprkningshastighet mtt i ms.
 ********************************************************************************/
-void display_set_count(const enum display_count_direction direction, uint16_t count_speed_ms)
+void display_set_count(const enum display_count_direction direction, uint16_t new_count_speed_ms)
 {
 	count_direction = direction;
-	timer_set_new_time(&timer_count_speed, count_speed_ms);
+	state.count_direction = (uint8_t)(count_direction);
+	state_dirty = true;
+	count_speed_ms = new_count_speed_ms;
+	
+	if (timer_soft_active(&timer_count_speed))
+	{
+		timer_soft_start(&timer_count_speed, count_speed_ms, true);
+	}
 	return;
 }
 
@@ -372,8 +458,9 @@ void display_set_count(const enum display_count_direction direction, uint16_t co
 ********************************************************************************/
 void display_enable_count(void)
 {
-	timer_enable_interrupt(&timer_count_speed);
-	eeprom_write_byte(EEPROM_COUNT_ENABLED, 1);
+	timer_soft_start(&timer_count_speed, count_speed_ms, true);
+	state.count_enabled = 1;
+	state_dirty = true;
 	return;
 }
 
@@ -383,8 +470,9 @@ void display_enable_count(void)
 ********************************************************************************/
 void display_disable_count(void)
 {
-	timer_reset(&timer_count_speed);
-	eeprom_write_byte(EEPROM_COUNT_ENABLED, 0);
+	timer_soft_stop(&timer_count_speed);
+	state.count_enabled = 0;
+	state_dirty = true;
 	return;
 }
 
@@ -407,42 +495,143 @@ void display_toggle_count(void)
 }
 
 /********************************************************************************
-* display_update_output: Skriver ny siffra till aktiverad 7-segmentsdisplay.
+* display_flush_state: Skriver displayernas tillstnd till EEPROM ifall det
+*                      har frndrats sedan fregende skrivning, vilket gr
+*                      att flera frndringar mellan tv anrop medfr hgst
+*                      en skrivning.
+*
+*                      1. Ifall tillstndet inte har frndrats sker ingen
+*                         skrivning.
+*
+*                      2. Tillstndet kopieras med avbrott inaktiverade, s
+*                         att en avbrottsrutin inte kan ndra det under
+*                         kopieringen. Avbrottstillstndet terstlls eftert.
+*                         Samtidigt markeras att skrivningen pgr. Om
+*                         funktionen anropas frn en avbrottsrutin, exempelvis
+*                         fr Watchdog-timern, medan huvudloopen str i en
+*                         pgende skrivning returnerar den direkt, eftersom
+*                         en andra post annars skulle blandas med den halvt
+*                         kade posten i ringbufferten.
+*
+*                      3. Kopian jmfrs byte fr byte med state_saved. Vid
+*                         skillnad lggs kopian i skrivkn som en ny post i
+*                         ringbufferten state_ring, vilket gr att funktionen
+*                         returnerar direkt utan att vnta p EEPROM-minnet.
+*                         Om skrivkn r full grs ett nytt frsk vid nsta
+*                         anrop.
 ********************************************************************************/
-static inline void display_update_output(const uint8_t digit)
+void display_flush_state(void)
 {
-   PORTD &= (1 << DISPLAY1_CATHODE);
-   PORTD |= display_get_binary_code(digit);
-   return;
+	const uint8_t sreg = SREG;
+	cli();
+	
+	if (!state_dirty || state_flushing)
+	{
+		SREG = sreg;
+		return;
+	}
+	
+	const struct display_state copy = state;
+	state_dirty = false;
+	state_flushing = true;
+	SREG = sreg;
+	
+	const uint8_t* data = (const uint8_t*)(&copy);
+	const uint8_t* saved = (const uint8_t*)(&state_saved);
+	
+	for (uint8_t i = 0; i < sizeof(copy); ++i)
+	{
+		if (data[i] != saved[i])
+		{
+			if (eeprom_ring_write(&state_ring, &copy) == 0)
+			{
+				state_saved = copy;
+			}
+			else
+			{
+				state_dirty = true;
+			}
+			break;
+		}
+	}
+	
+	state_flushing = false;
+	return;
 }
 
 /********************************************************************************
-* display_get_binary_code: Returnerar binrkod fr angivet heltal 0 - 15 fr
-*                          utskrift p 7-segmentsdisplayer. Vid felaktigt
-*                          angivet heltal (ver 15) returneras binrkod fr
-*                          slckning av 7-segmentsdisplayer.
+* display_update_frame: Berknar binrkoden fr respektive display utifrn
+*                       aktuellt tal och talbas och lagrar dessa i
+*                       framebuffern. Binrkoderna hmtas frn tabellen
+*                       segment_codes i programminnet. Inledande nollor
+*                       slcks, men den minst signifikanta siffran skrivs
+*                       alltid ut.
+********************************************************************************/
+static void display_update_frame(void)
+{
+	uint32_t remainder = number;
+	
+	for (int8_t i = display.num_digits - 1; i >= 0; --i)
+	{
+		if (remainder || i == display.num_digits - 1)
+		{
+			display.frame[i] = pgm_read_byte(&segment_codes[remainder % radix]);
+			remainder /= radix;
+		}
+		else
+		{
+			display.frame[i] = OFF;
+		}
+	}
+	return;
+}
+
+/********************************************************************************
+* display_all_digits_off: Slcker samtliga displayer genom att stta
+*                         respektive katod hg.
+********************************************************************************/
+static void display_all_digits_off(void)
+{
+	for (uint8_t i = 0; i < display.num_digits; ++i)
+	{
+		led_on(&display.cathodes[i]);
+	}
+	return;
+}
+
+/********************************************************************************
+* display_get_max_val: Returnerar hgsta tal som kan skrivas ut p angivet
+*                      antal displayer med angiven talbas, dvs. radix^n - 1.
+*                      Maxvrdet begrnsas till hgsta 32-bitars tal.
 *
-*                          - digit: Heltal vars binrkod ska returneras.
+*                      - radix     : Talbas.
+*                      - num_digits: Antalet displayer.
 ********************************************************************************/
-static inline uint8_t display_get_binary_code(const uint8_t digit)
+static uint32_t display_get_max_val(const uint8_t radix, const uint8_t num_digits)
 {
-   if (digit == 0)       return ZERO;
-   else if (digit == 1)  return ONE;
-   else if (digit == 2)  return TWO;
-   else if (digit == 3)  return THREE;
-   else if (digit == 4)  return FOUR;
-   else if (digit == 5)  return FIVE;
-   else if (digit == 6)  return SIX;
-   else if (digit == 7)  return SEVEN;
-   else if (digit == 8)  return EIGHT;
-   else if (digit == 9)  return NINE;
-   else if (digit == 10) return A;
-   else if (digit == 11) return B;
-   else if (digit == 12) return C;
-   else if (digit == 13) return D;
-   else if (digit == 14) return E;
-   else if (digit == 15) return F;
-   else                  return OFF;
+	uint32_t max = 1;
+	
+	for (uint8_t i = 0; i < num_digits; ++i)
+	{
+		if (max > UINT32_MAX / radix) return UINT32_MAX;
+		max *= radix;
+	}
+	return max - 1;
+}
+
+/********************************************************************************
+* display_get_digit_period_us: Returnerar tiden mellan tv skiften av tnd
+*                              display mtt i mikrosekunder, avrundat till
+*                              nrmaste heltal, s att varje display tnds
+*                              angivet antal gnger per sekund.
+*
+*                              - refresh_hz: Uppdateringsfrekvens per display.
+*                              - num_digits: Antalet displayer.
+********************************************************************************/
+static uint32_t display_get_digit_period_us(const uint16_t refresh_hz, const uint8_t num_digits)
+{
+	const uint32_t switches_per_s = (uint32_t)refresh_hz * num_digits;
+	return (1000000UL + switches_per_s / 2) / switches_per_s;
 }
 
 /********************************************************************************
@@ -450,13 +639,18 @@ static inline uint8_t display_get_binary_code(const uint8_t digit)
 *							  om det finns, lses dessa in och displayen stts i samma 
 *							  tillstnd som de var i senast programmet krdes.
 *
-*							  1. Vi kollar om EEPROM r initierat. D ligger vrdet 0
-*								  p EEPROM_INITIALIZED, annars ligger startvrdet 0xFF
-*							  2. Om EEPROM r initierat lses vrdena in, annars stts
-*							     addresserna i starttillstndet.
+*							  1. Ringbufferten i EEPROM initieras, varvid den senast
+*								  skrivna posten letas upp. Denna lses in till
+*								  state_saved, som speglar innehllet i EEPROM.
+*							  2. Vi kollar om EEPROM r initierat. D finns en post
+*								  dr fltet initialized r 0.
+*								  Om EEPROM r initierat anvnds de inlsta vrdena,
+*								  annars stts tillstndet till starttillstndet.
 *							  3. Frst lses det senaste talet in och sparas i variabeln
-*								  number. Tiotaklet och entalet sparas i variabler digit1
-*								  och digit2 via anrop av display_set_number.
+*								  number via anrop av display_set_number, som ven
+*								  uppdaterar framebuffern. Om talet inte ryms p
+*								  displayerna, exempelvis vid en korrupt post, stts
+*								  tillstndet i stllet till starttillstndet.
 *							  4. Ls in upprkningsriktningen och spara i variabeln 
 *							     count_direction. Det inlsta talet typomvandlas till
 *								  enum display_count_direction.
@@ -467,16 +661,19 @@ static inline uint8_t display_get_binary_code(const uint8_t digit)
 *********************************************************************************/
 static inline void check_eeprom_values(void)
 {
-	if (eeprom_read_byte(EEPROM_INITIALIZED) == 0)
+	eeprom_ring_init(&state_ring, EEPROM_STATE, sizeof(struct display_state), EEPROM_STATE_RECORDS);
+	
+	if (eeprom_ring_read(&state_ring, &state_saved) == 0 && state_saved.initialized == 0 &&
+	    display_set_number(state_saved.number) == 0)
 	{
-		display_set_number(eeprom_read_byte(EEPROM_NUMBER));
-		count_direction = (enum display_count_direction)(eeprom_read_byte(EEPROM_COUNT_DIRECTION));
+		state = state_saved;
+		count_direction = (enum display_count_direction)(state_saved.count_direction);
 		
-		if (eeprom_read_byte(EEPROM_OUTPUT_ENABLED) == 1)
+		if (state_saved.output_enabled == 1)
 		{
 			display_enable_output();
 		}
-		if (eeprom_read_byte(EEPROM_COUNT_ENABLED) == 1)
+		if (state_saved.count_enabled == 1)
 		{
 			display_enable_count();
 		}
@@ -485,11 +682,15 @@ static inline void check_eeprom_values(void)
 	{
 		reset_eeprom_values();
 	}
+	
+	display_flush_state();
 	return;
 }
 
 /********************************************************************************
-* reset_eeprom_values: Skriver startvrden till EEPROM. 
+* reset_eeprom_values: Stter tillstndet som ska sparas i EEPROM till
+*                      startvrden, som skrivs vid nsta anrop av
+*                      display_flush_state.
 *							  number = 0;
 *							  output_enabled = false
 *							  count_enabled = false
@@ -498,10 +699,24 @@ static inline void check_eeprom_values(void)
 *********************************************************************************/
 static inline void reset_eeprom_values(void)
 {
-	eeprom_write_byte(EEPROM_NUMBER, 0);
-	eeprom_write_byte(EEPROM_OUTPUT_ENABLED, 0);
-	eeprom_write_byte(EEPROM_COUNT_ENABLED, 0);
-	eeprom_write_byte(EEPROM_COUNT_DIRECTION, 1);
-	eeprom_write_byte(EEPROM_INITIALIZED, 0);
+	state.number = 0;
+	state.output_enabled = 0;
+	state.count_enabled = 0;
+	state.count_direction = 1;
+	state.initialized = 0;
+	state_dirty = true;
+	return;
+}
+
+/********************************************************************************
+* display_count_elapsed: Anropas av timerhjulet nr mjukvarutimern
+*                        timer_count_speed lper ut. Sjlva rkningen, dr
+*                        displayernas binrkoder berknas om, lggs i
+*                        hndelsekn s att den sker frn huvudloopen i
+*                        stllet fr i avbrottsrutinen.
+********************************************************************************/
+static void display_count_elapsed(void)
+{
+	event_post(display_count);
 	return;
 }
\ No newline at end of file
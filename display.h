@@ -1,14 +1,21 @@
 /********************************************************************************
-* display.h: Innehller drivrutiner fr tv 7-segmentsdisplayer anslutna till
-*            till PORTD0 - PORTD6 (pin 0 - 6), som kan visa tv siffror i binr,
-*            decimal eller hexadecimal form. Matningsspnningen fr respektive
-*            7-segmentsdisplay genereras frn PORTD7 (pin 7) respektive
-*            PORTC3 (pin A3), dr lg signal medfr tnd display, d displayerna
-*            har gemensam katod.
+* display.h: Innehller drivrutiner fr upp till DISPLAY_DIGITS_MAX
+*            multiplexade 7-segmentsdisplayer anslutna till PORTD0 - PORTD6
+*            (pin 0 - 6), som kan visa tal i binr, decimal eller hexadecimal
+*            form. Matningsspnningen fr respektive 7-segmentsdisplay genereras
+*            frn en godtycklig pin, dr lg signal medfr tnd display, d
+*            displayerna har gemensam katod. Katodernas pinnar anges vid
+*            initiering, exempelvis fr tv displayer med katoder p PORTD7
+*            (pin 7) respektive PORTC3 (pin A3):
 *
-*            Nr displayerna r p skiftas aktiverad display en gng per
-*            millisekund via timerkrets Timer 1. Vid anvndning av
-*            7-segmentsdisplayer, anropa funktionen display_toggle_digit
+*            static const uint8_t cathodes[] = { D7, C3 };
+*            display_init(cathodes, 2);
+*
+*            Nr displayerna r p skiftas aktiverad display via timerkrets
+*            Timer 1, som genererar avbrott exakt en gng per skifte. Varje
+*            display tnds DISPLAY_REFRESH_HZ gnger per sekund som default,
+*            vilket kan ndras via display_set_refresh_rate. Vid anvndning
+*            av 7-segmentsdisplayer, anropa funktionen display_toggle_digit
 *            i avbrottsrutinen fr Timer 1 i CTC Mode ssom visas nedan:
 *
 *            ISR (TIMER1_COMPA_vect)
@@ -18,8 +25,9 @@
 *            }
 *
 *            Upp- eller nedrkning med godtycklig hastighet kan aktiveras via
-*            anrop av funktionen display_set_count, dr timerkrets Timer 2
-*            anvnds fr att generera upprkningshastigheten. Som exempel,
+*            anrop av funktionen display_set_count, dr en mjukvarutimer i
+*            timerhjulet (se timer.h) anvnds fr att generera
+*            upprkningshastigheten. Som exempel,
 *            nedanstende funktionsanrop medfr upprkning av
 *            7-segmentsdisplayerna var 100:e ms:
 *
@@ -31,15 +39,10 @@
 *            display_set_count. Som default anvnds upprkning med 
 *            en hastighet p 1000 ms som default.
 *
-*            Vid upp- eller nedrkning av talet p 7-segmentsdisplayerna,
-*            anropa funktionen display_count i avbrottsrutinen fr Timer 2
-*            i Normal Mode ssom visas nedan:
-*
-*            ISR (TIMER2_OVF_vect)
-*            {
-*               display_count();
-*               return;
-*            }
+*            Timerhjulet mste vara initierat via timer_wheel_init fr att
+*            upp- eller nedrkning ska ske. Rkningen lggs i hndelsekn
+*            (se event.h), vilket krver att event_run anropas frn
+*            huvudloopen.
 *
 ********************************************************************************/
 #ifndef DISPLAY_H_
@@ -50,6 +53,16 @@
 ********************************************************************************/
 #include "misc.h"
 #include "timer.h"
+#include "led.h"
+
+/********************************************************************************
+* Makrodefinitioner:
+********************************************************************************/
+#define DISPLAY_DIGITS_MAX 8 /* Hgsta antal 7-segmentsdisplayer som kan multiplexas. */
+
+#define DISPLAY_REFRESH_HZ 500      /* Antal gnger per sekund varje display tnds som default. */
+#define DISPLAY_REFRESH_HZ_MIN 60   /* Lgsta uppdateringsfrekvens utan synligt flimmer. */
+#define DISPLAY_REFRESH_HZ_MAX 1000 /* Hgsta uppdateringsfrekvens. */
 
 /********************************************************************************
 * display_count_direction: Enumeration fr val av upprkningsriktning p
@@ -62,9 +75,14 @@ enum display_count_direction
 };
 
 /********************************************************************************
-* display_init: Initierar hrdvara fr 7-segmentsdisplayer.
+* display_init: Initierar hrdvara fr 7-segmentsdisplayer. Vid felaktigt
+*               angivet antal displayer returneras felkod 1, annars 0.
+*
+*               - cathode_pins: Pinnar fr displayernas katoder, dr den
+*                               mest signifikanta siffran anges frst.
+*               - num_digits  : Antalet displayer (1 - DISPLAY_DIGITS_MAX).
 ********************************************************************************/
-void display_init(void);
+int display_init(const uint8_t* cathode_pins, const uint8_t num_digits);
 
 /********************************************************************************
 * display_reset: terstller 7-segmentsdisplayer till startlget.
@@ -84,6 +102,13 @@ bool display_output_enabled(void);
 ********************************************************************************/
 bool display_count_enabled(void);
 
+/********************************************************************************
+* display_send_state: Skickar 7-segmentsdisplayernas tillstnd (tal, talbas
+*                     samt flaggor) som en binr ram via seriell verfring.
+*                     Seriell verfring mste vara initierad via serial_init.
+********************************************************************************/
+void display_send_state(void);
+
 /********************************************************************************
 * display_enable_output: Stter p 7-segmentsdisplayer.
 ********************************************************************************/
@@ -102,19 +127,21 @@ void display_toggle_output(void);
 /********************************************************************************
 * display_set_number: Stter nytt heltal fr utskrift p 7-segmentsdisplayer.
 *                     Om angivet heltal verstiger maxvrdet som kan skrivas ut
-*                     p tv 7-segmentsdisplayer med aktuell talbas returneras
-*                     felkod 1. Annars returneras heltalet 0 efter att heltalet
-*                     p 7-segmentsdisplayerna har uppdaterats.
+*                     p anslutna 7-segmentsdisplayer med aktuell talbas
+*                     returneras felkod 1. Annars returneras heltalet 0 efter
+*                     att heltalet p 7-segmentsdisplayerna har uppdaterats.
 *
 *                     - new_number: Nytt tal som ska skrivas ut p displayerna.
 ********************************************************************************/
-int display_set_number(const uint8_t new_number);
+int display_set_number(const uint32_t new_number);
 
 /********************************************************************************
 * display_set_radix: Stter ny talbas till 2, 10 eller 16 utskrift av tal p
-*                    7-segmentsdisplayer. Drmed kan tal skrivas ut binrt
-*                    (00 - 11), decimalt (00 - 99) eller hexadecimalt (00 - FF).
-*                    Vid felaktigt angiven talbas returneras felkod 1. Annars
+*                    7-segmentsdisplayer. Drmed kan tal skrivas ut binrt,
+*                    decimalt eller hexadecimalt, exempelvis 00 - 11, 00 - 99
+*                    respektive 00 - FF p tv displayer. Ifall aktuellt tal
+*                    inte ryms med den nya talbasen nollstlls talet. Vid
+*                    felaktigt angiven talbas returneras felkod 1. Annars
 *                    returneras heltalet 0 efter att anvnd talbas har
 *                    uppdaterats.
 *
@@ -123,18 +150,39 @@ int display_set_number(const uint8_t new_number);
 int display_set_radix(const uint8_t new_radix);
 
 /********************************************************************************
-* display_toggle_digit: Skiftar aktiverad 7-segmentsdisplay fr utskrift av
-*                       tiotal och ental, vilket r ndvndigt, d displayerna
-*                       delar p samma pinnar. Enbart en vrdesiffra skrivs
-*                       ut om mjligt, exempelvis 9 i stllet fr 09. Denna 
-*                       funktion br anropas en gng per millisekund fr att 
-*                       ett givet tvsiffrigt tal ska upplevas skrivas ut 
-*                       kontinuerligt.
+* display_toggle_digit: Skiftar tnd 7-segmentsdisplay till nsta display i
+*                       tur, vilket r ndvndigt, d displayerna delar p
+*                       samma pinnar. Inledande nollor slcks, exempelvis
+*                       skrivs 9 i stllet fr 09. Denna funktion ska anropas
+*                       i avbrottsrutinen fr Timer 1, som ger rum en gng
+*                       per skifte.
 ********************************************************************************/
 void display_toggle_digit(void);
 
 /********************************************************************************
-* display_count: Rknar upp eller ned tal p 7-segmentsdisplayer.
+* display_set_refresh_rate: Stter antalet gnger per sekund som varje
+*                           7-segmentsdisplay tnds. Timer 1 stlls in s att
+*                           avbrott sker exakt en gng per skifte, dvs.
+*                           new_refresh_hz gnger antalet displayer per
+*                           sekund. Om angiven frekvens understiger
+*                           DISPLAY_REFRESH_HZ_MIN, vilket hade medfrt
+*                           synligt flimmer, eller verstiger
+*                           DISPLAY_REFRESH_HZ_MAX returneras felkod 1.
+*                           Annars returneras 0.
+*
+*                           - new_refresh_hz: Ny uppdateringsfrekvens i Hz.
+********************************************************************************/
+int display_set_refresh_rate(const uint16_t new_refresh_hz);
+
+/********************************************************************************
+* display_get_refresh_rate: Returnerar antalet gnger per sekund som varje
+*                           7-segmentsdisplay tnds.
+********************************************************************************/
+uint16_t display_get_refresh_rate(void);
+
+/********************************************************************************
+* display_count: Rknar upp eller ned tal p 7-segmentsdisplayer. Anropas frn
+*               huvudloopen via hndelsekn med angiven upprkningshastighet.
 ********************************************************************************/
 void display_count(void);
 
@@ -156,10 +204,10 @@ void display_toggle_count_direction(void);
 * display_set_count: Stller in upp- eller nedrkning av tal som skrivs ut p
 *                    7-segmentsdisplayerna med godtycklig upprkningshastighet.
 *
-*                    - direction     : Upprkningsriktning.
-*                    - count_speed_ms: Upprkningshastighet mtt i ms.
+*                    - direction         : Upprkningsriktning.
+*                    - new_count_speed_ms: Upprkningshastighet mtt i ms.
 ********************************************************************************/
-void display_set_count(const enum display_count_direction direction, uint16_t count_speed_ms);
+void display_set_count(const enum display_count_direction direction, uint16_t new_count_speed_ms);
 
 /********************************************************************************
 * display_enable_count: Aktiverar upp- eller nedrkning av tal som skrivs ut p
@@ -181,4 +229,22 @@ void display_disable_count(void);
 ********************************************************************************/
 void display_toggle_count(void);
 
+/********************************************************************************
+* display_flush_state: Skriver displayernas tillstnd (tal, riktning samt om
+*                      displayer och rkning r p) till EEPROM ifall det har
+*                      frndrats sedan fregende anrop. Skrivningen lggs
+*                      i EEPROM-drivrutinens skrivk och blockerar drmed
+*                      inte. vriga funktioner skriver aldrig till
+*                      EEPROM, utan markerar enbart att tillstndet har
+*                      frndrats, s att avbrottsrutiner aldrig behver vnta
+*                      p EEPROM-minnet. Denna funktion br drmed anropas
+*                      kontinuerligt frn huvudloopen, samt frslagsvis i
+*                      avbrottsrutinen fr Watchdog-timern innan
+*                      systemterstllning sker, fljt av eeprom_flush. Om
+*                      huvudloopen redan str i funktionen returnerar
+*                      anropet frn avbrottsrutinen direkt, varvid enbart
+*                      redan kade skrivningar genomfrs.
+********************************************************************************/
+void display_flush_state(void);
+
 #endif /* DISPLAY_H_ */
\ No newline at end of file
@@ -4,27 +4,61 @@
 ********************************************************************************/
 #include "eeprom.h"
 
+/********************************************************************************
+* eeprom_write: Strukt fr en kad skrivning till EEPROM-minnet.
+********************************************************************************/
+struct eeprom_write
+{
+   uint16_t address; /* Adressen som ska skrivas. */
+   uint8_t data;     /* Datan som ska skrivas. */
+   bool update;      /* Indikerar att skrivningen uteblir om innehllet redan stmmer. */
+};
+
+/* Makrodefinitioner: */
+#define EEPROM_QUEUE_MASK (EEPROM_QUEUE_SIZE - 1) /* Mask fr index i skrivkn. */
+#define EEPROM_MODE_MASK ((1 << EEPM1) | (1 << EEPM0)) /* Mask fr programmeringslge. */
+#define EEPROM_MODE_ERASE_WRITE 0             /* Radering fljt av skrivning (3.4 ms). */
+#define EEPROM_MODE_ERASE_ONLY (1 << EEPM0)   /* Enbart radering (1.8 ms). */
+#define EEPROM_MODE_WRITE_ONLY (1 << EEPM1)   /* Enbart skrivning (1.8 ms). */
+
+/* Statiska funktioner: */
+static int eeprom_write(const uint16_t address,
+                        const uint8_t data,
+                        const bool update);
+static int eeprom_write_async(const uint16_t address,
+                              const uint8_t data,
+                              const bool update);
+static inline int eeprom_peek(const uint16_t address,
+                              uint8_t* data);
+static inline uint8_t eeprom_queue_free(void);
+static inline uint8_t eeprom_get_mode(const uint8_t old_data,
+                                      const uint8_t new_data);
+static inline void eeprom_start_write(const uint16_t address,
+                                      const uint8_t data,
+                                      const uint8_t mode);
+static inline uint16_t eeprom_ring_record_address(const struct eeprom_ring* self,
+                                                  const uint8_t index);
+static inline uint8_t eeprom_ring_next_sequence(const uint8_t sequence);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - queue     : Ringbuffert med kade skrivningar.
+*   - queue_head: Index fr nsta skrivning som ska genomfras.
+*   - queue_tail: Index fr nsta lediga plats i kn.
+*   - stats     : Statistik ver genomfrda samt undvikna skrivningar.
+********************************************************************************/
+static volatile struct eeprom_write queue[EEPROM_QUEUE_SIZE];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static struct eeprom_stats stats;
+
 /********************************************************************************
 * eeprom_write_byte: Skriver en byte bestende av ett osignerat heltal till
 *                    angiven adress i EEPROM-minnet. Vid lyckad skrivning
-*                    returneras 0, annars returneras felkod 1.
-*
-*                    1. Om angiven adress verstiger hgsta adressen i EEPROM-
-*                       minnet sker ingen skrivning och felkod 1 returneras.
-*
-*                    2. Eventuell fregende skrivning avslutas innan den
-*                       nya skrivningen pbrjas.
-*
-*                    3. Angiven adress samt datan som ska skrivas specificeras.
-*
-*                    4. Avbrott inaktiveras temporrt fr att inte avbryta
-*                       eventuell skrivning (EEPROM-skrivningen mste ske
-*                       inom fyra klockcykler fr att lyckas).
+*                    returneras 0, annars returneras felkod 1. Skrivningen
+*                    sker alltid, ven om befintligt innehll redan stmmer.
 *
-*                    5. Skrivningen genomfrs.
-*
-*                    6. Avbrott teraktiveras.
-*                       
 *                    - address: Adressen i EEPROM-minnet som angiven data
 *                               ska lagras p.
 *                    - data   : Datan som ska skrivas.
@@ -32,16 +66,134 @@
 int eeprom_write_byte(const uint16_t address,
                       const uint8_t data)
 {
-   if (address > EEPROM_ADDRESS_MAX) return 1;
-   while (EECR & (1 << EEPE));
-   EEAR = address;
-   EEDR = data;
+   return eeprom_write(address, data, false);
+}
 
-   asm("CLI");
-   EECR |= (1 << EEMPE);
-   EECR |= (1 << EEPE);
-   asm("SEI");
-   return 0;
+/********************************************************************************
+* eeprom_update_byte: Skriver en byte till angiven adress i EEPROM-minnet
+*                     enbart om befintligt innehll skiljer sig frn angiven
+*                     data. Vid lyckad skrivning (eller om ingen skrivning
+*                     behvdes) returneras 0, annars returneras felkod 1.
+*
+*                     - address: Adressen i EEPROM-minnet som angiven data
+*                                ska lagras p.
+*                     - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_update_byte(const uint16_t address,
+                       const uint8_t data)
+{
+   return eeprom_write(address, data, true);
+}
+
+/********************************************************************************
+* eeprom_write_byte_async: Lgger en byte i skrivkn fr skrivning till angiven
+*                          adress i EEPROM-minnet och returnerar direkt. Vid
+*                          lyckad klggning returneras 0, annars felkod 1.
+*
+*                          - address: Adressen i EEPROM-minnet som angiven data
+*                                     ska lagras p.
+*                          - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_write_byte_async(const uint16_t address,
+                            const uint8_t data)
+{
+   return eeprom_write_async(address, data, false);
+}
+
+/********************************************************************************
+* eeprom_update_byte_async: Lgger en byte i skrivkn fr skrivning till
+*                           angiven adress i EEPROM-minnet enbart om
+*                           innehllet p adressen (inklusive tidigare kade
+*                           skrivningar) skiljer sig frn angiven data. Vid
+*                           lyckad klggning (eller om ingen skrivning
+*                           behvdes) returneras 0, annars felkod 1.
+*
+*                           - address: Adressen i EEPROM-minnet som angiven
+*                                      data ska lagras p.
+*                           - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_update_byte_async(const uint16_t address,
+                             const uint8_t data)
+{
+   return eeprom_write_async(address, data, true);
+}
+
+/********************************************************************************
+* eeprom_write_next: Pbrjar nsta kade skrivning till EEPROM-minnet. Nr
+*                    kn r tom inaktiveras avbrott fr EEPROM Ready, som annars
+*                    hade gt rum kontinuerligt. Funktionen frutstter att
+*                    avbrott r inaktiverade samt att ingen skrivning pgr,
+*                    vilket alltid gller i avbrottsrutinen fr EEPROM Ready.
+*
+*                    Eftersom ingen skrivning pgr kan befintligt innehll
+*                    lsas direkt (fyra klockcykler). Kade uppdateringar dr
+*                    innehllet redan stmmer hoppas ver, varefter nsta
+*                    kade skrivning prvas. Annars vljs snabbaste
+*                    programmeringslge utifrn befintligt innehll och
+*                    skrivningen pbrjas. Som mest genomsks hela kn
+*                    (EEPROM_QUEUE_SIZE lsningar) vid ett anrop.
+********************************************************************************/
+void eeprom_write_next(void)
+{
+   while (queue_head != queue_tail)
+   {
+      const uint16_t address = queue[queue_head].address;
+      const uint8_t data = queue[queue_head].data;
+      const bool update = queue[queue_head].update;
+      queue_head = (queue_head + 1) & EEPROM_QUEUE_MASK;
+
+      EEAR = address;
+      EECR |= (1 << EERE);
+      const uint8_t old_data = EEDR;
+
+      if (update && old_data == data)
+      {
+         stats.skipped++;
+      }
+      else
+      {
+         eeprom_start_write(address, data, eeprom_get_mode(old_data, data));
+         return;
+      }
+   }
+
+   EECR &= ~(1 << EERIE);
+   return;
+}
+
+/********************************************************************************
+* eeprom_write_pending: Indikerar ifall kade skrivningar terstr eller om en
+*                       skrivning pgr. I s fall returneras true, annars false.
+********************************************************************************/
+bool eeprom_write_pending(void)
+{
+   return queue_head != queue_tail || (EECR & (1 << EEPE));
+}
+
+/********************************************************************************
+* eeprom_flush: Genomfr samtliga kade skrivningar och vntar tills sista
+*               skrivningen r klar. Varje kad skrivning pbrjas hrifrn
+*               s fort fregende skrivning r klar, vilket gr att
+*               funktionen fungerar ven med avbrott inaktiverade.
+********************************************************************************/
+void eeprom_flush(void)
+{
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      cli();
+
+      if ((EECR & (1 << EEPE)) == 0)
+      {
+         if (queue_head == queue_tail)
+         {
+            SREG = sreg;
+            return;
+         }
+         eeprom_write_next();
+      }
+      SREG = sreg;
+   }
 }
 
 /********************************************************************************
@@ -81,24 +233,46 @@ int eeprom_write_word(const uint16_t address_low,
 *                   1. Om angiven adress verstiger hgsta adressen i EEPROM-
 *                      minnet sker ingen lsning och 0 returneras.
 *
-*                   2. Eventuell fregende skrivning avslutas innan lsningen
-*                      pbrjas.
+*                   2. Avbrott inaktiveras temporrt, s att avbrottsrutinen
+*                      fr EEPROM Ready inte kan pbrja en skrivning under
+*                      lsningen.
 *
-*                   3. Angiven adress som lsning ska ske frn specificeras.
+*                   3. Innehllet hmtas ur skrivkn eller EEPROM-minnet.
+*                      EEPROM-minnet kan inte lsas medan en skrivning
+*                      pgr, varfr avbrottstillstndet d terstlls,
+*                      s att avbrott inte blockeras, tills skrivningen r
+*                      klar.
 *
-*                   4. Lsningen genomfrs frn angiven adress.
-*
-*                   5. Innehllet returneras som ett 8-bitars osignerat heltal.
+*                   4. Innehllet returneras som ett 8-bitars osignerat heltal.
 *
 *                   - address: Adressen i EEPROM-minnet som ska lsas av.
 ********************************************************************************/
 uint8_t eeprom_read_byte(const uint16_t address)
 {
    if (address > EEPROM_ADDRESS_MAX) return 0;
-   while (EECR & (1 << EEPE));
-   EEAR = address;
-   EECR |= (1 << EERE);
-   return EEDR;
+
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      cli();
+      uint8_t data;
+
+      if (eeprom_peek(address, &data) == 0)
+      {
+         SREG = sreg;
+         return data;
+      }
+
+      if ((EECR & (1 << EEPE)) == 0)
+      {
+         EEAR = address;
+         EECR |= (1 << EERE);
+         data = EEDR;
+         SREG = sreg;
+         return data;
+      }
+      SREG = sreg;
+   }
 }
 
 /********************************************************************************
@@ -106,8 +280,8 @@ uint8_t eeprom_read_byte(const uint16_t address)
 *                   EEPROM-minnet och returnerar detta som ett osignerat heltal.
 *                   Vid misslyckad lsning returneras 0.
 *
-*                   1. Om angiven adress verstiger hgsta adressen i EEPROM-
-*                      minnet sker ingen lsning och 0 returneras.
+*                   1. Om angiven adress verstiger nst hgsta adressen i
+*                      EEPROM-minnet sker ingen lsning och 0 returneras.
 *
 *                   2. Respektive byte lses frn EEPROM-minnet en i taget
 *                      och lagras som ett ord (ett 16-bitars tal).
@@ -119,6 +293,496 @@ uint8_t eeprom_read_byte(const uint16_t address)
 ********************************************************************************/
 uint16_t eeprom_read_word(const uint16_t address_low)
 {
-   if (address_low >= EEPROM_ADDRESS_MAX - 1) return 0;
-   return eeprom_read_word(address_low) | (eeprom_read_word(address_low + 1) << 8);
+   if (address_low > EEPROM_ADDRESS_MAX - 1) return 0;
+   return eeprom_read_byte(address_low) | (eeprom_read_byte(address_low + 1) << 8);
+}
+
+/********************************************************************************
+* eeprom_read_block: Lser angivet antal byte med start p angiven adress i
+*                    EEPROM-minnet till angiven destination. Om regionen inte
+*                    ryms i EEPROM-minnet sker ingen lsning och felkod 1
+*                    returneras, annars 0.
+*
+*                    - address: Startadress i EEPROM-minnet.
+*                    - data   : Pekare till destinationen.
+*                    - size   : Antalet byte som ska lsas.
+********************************************************************************/
+int eeprom_read_block(const uint16_t address,
+                      void* data,
+                      const uint16_t size)
+{
+   if ((uint32_t)address + size > EEPROM_ADDRESS_MAX + 1) return 1;
+   uint8_t* destination = (uint8_t*)data;
+
+   for (uint16_t i = 0; i < size; ++i)
+   {
+      destination[i] = eeprom_read_byte(address + i);
+   }
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_update_block: Skriver angivet antal byte frn angiven klla med start
+*                      p angiven adress i EEPROM-minnet, dr enbart byte vars
+*                      innehll skiljer sig skrivs. Skrivningen r blockerande.
+*                      Om regionen inte ryms i EEPROM-minnet sker ingen
+*                      skrivning och felkod 1 returneras, annars 0.
+*
+*                      - address: Startadress i EEPROM-minnet.
+*                      - data   : Pekare till datan som ska skrivas.
+*                      - size   : Antalet byte som ska skrivas.
+********************************************************************************/
+int eeprom_update_block(const uint16_t address,
+                        const void* data,
+                        const uint16_t size)
+{
+   if ((uint32_t)address + size > EEPROM_ADDRESS_MAX + 1) return 1;
+   const uint8_t* source = (const uint8_t*)data;
+
+   for (uint16_t i = 0; i < size; ++i)
+   {
+      eeprom_write(address + i, source[i], true);
+   }
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_update_block_async: Lgger angivet antal byte frn angiven klla i
+*                            skrivkn med start p angiven adress i EEPROM-
+*                            minnet, dr enbart byte vars innehll skiljer sig
+*                            kas. Vid lyckad klggning returneras 0. Om
+*                            regionen inte ryms i EEPROM-minnet eller om kn
+*                            blir full returneras felkod 1, varvid enbart en
+*                            del av blocket kan ha kats.
+*
+*                            - address: Startadress i EEPROM-minnet.
+*                            - data   : Pekare till datan som ska skrivas.
+*                            - size   : Antalet byte som ska skrivas.
+********************************************************************************/
+int eeprom_update_block_async(const uint16_t address,
+                              const void* data,
+                              const uint16_t size)
+{
+   if ((uint32_t)address + size > EEPROM_ADDRESS_MAX + 1) return 1;
+   const uint8_t* source = (const uint8_t*)data;
+
+   for (uint16_t i = 0; i < size; ++i)
+   {
+      if (eeprom_write_async(address + i, source[i], true)) return 1;
+   }
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_get_stats: Kopierar statistiken ver genomfrda samt undvikna
+*                   skrivningar till angiven destination.
+*
+*                   - destination: Pekare till destinationen.
+********************************************************************************/
+void eeprom_get_stats(struct eeprom_stats* destination)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   *destination = stats;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* eeprom_reset_stats: Nollstller statistiken ver genomfrda samt undvikna
+*                     skrivningar.
+********************************************************************************/
+void eeprom_reset_stats(void)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   stats.erase_write = 0;
+   stats.erase_only = 0;
+   stats.write_only = 0;
+   stats.skipped = 0;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* eeprom_ring_init: Initierar ringbuffert fr slitageutjmnad lagring i angiven
+*                   region av EEPROM-minnet och letar upp den senast skrivna
+*                   posten. Vid felaktigt angiven region returneras felkod 1,
+*                   annars 0.
+*
+*                   1. Om antalet platser r frre n tv eller fler n
+*                      EEPROM_RING_RECORDS_MAX, eller om regionen inte ryms i
+*                      EEPROM-minnet, returneras felkod 1.
+*
+*                   2. Sekvensnumret fr den frsta platsen lses. Om platsen
+*                      r oskriven r ringbufferten tom.
+*
+*                   3. Sekvensnumren fr efterfljande platser lses s lnge
+*                      varje sekvensnummer r en upprkning av fregende.
+*                      Den sista platsen innan fljden bryts innehller den
+*                      senast skrivna posten. Enbart ett sekvensnummer per
+*                      plats behver lsas.
+*
+*                   - self       : Pekare till ringbufferten.
+*                   - address    : Startadress fr regionen i EEPROM-minnet.
+*                   - data_size  : Antalet databyte per post.
+*                   - num_records: Antalet platser (2 - EEPROM_RING_RECORDS_MAX).
+********************************************************************************/
+int eeprom_ring_init(struct eeprom_ring* self,
+                     const uint16_t address,
+                     const uint8_t data_size,
+                     const uint8_t num_records)
+{
+   if (num_records < 2 || num_records > EEPROM_RING_RECORDS_MAX) return 1;
+   if ((uint32_t)address + (uint32_t)num_records * (data_size + 1) > 
+       EEPROM_ADDRESS_MAX + 1) return 1;
+
+   self->address = address;
+   self->data_size = data_size;
+   self->num_records = num_records;
+   self->newest = 0;
+   self->sequence = eeprom_read_byte(address);
+
+   if (eeprom_ring_empty(self)) return 0;
+
+   for (uint8_t i = 1; i < num_records; ++i)
+   {
+      const uint8_t sequence = eeprom_read_byte(eeprom_ring_record_address(self, i));
+      if (sequence != eeprom_ring_next_sequence(self->sequence)) break;
+      self->newest = i;
+      self->sequence = sequence;
+   }
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_ring_read: Lser den senast skrivna posten i angiven ringbuffert till
+*                   angiven destination. Ifall ringbufferten r tom sker ingen
+*                   lsning och felkod 1 returneras, annars 0.
+*
+*                   - self: Pekare till ringbufferten.
+*                   - data: Pekare till destinationen (data_size byte).
+********************************************************************************/
+int eeprom_ring_read(const struct eeprom_ring* self,
+                     void* data)
+{
+   if (eeprom_ring_empty(self)) return 1;
+   const uint16_t address = eeprom_ring_record_address(self, self->newest) + 1;
+   uint8_t* destination = (uint8_t*)data;
+
+   for (uint8_t i = 0; i < self->data_size; ++i)
+   {
+      destination[i] = eeprom_read_byte(address + i);
+   }
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_ring_write: Skriver angiven data som en ny post p nsta plats i
+*                    angiven ringbuffert. Vid lyckad skrivning returneras 0,
+*                    annars felkod 1.
+*
+*                    1. Nsta plats samt nsta sekvensnummer berknas. Vid
+*                       tom ringbuffert anvnds frsta platsen och
+*                       sekvensnummer 0.
+*
+*                    2. Om skrivkn saknar plats fr hela posten returneras
+*                       felkod 1 utan att ngot kas.
+*
+*                    3. Datan lggs i skrivkn fr platsen, dr byte som redan
+*                       har samma innehll inte skrivs om. Jmfrelsen med
+*                       platsens befintliga innehll grs nr respektive
+*                       byte str p tur att skrivas (se eeprom_write_next),
+*                       vilket gr att EEPROM-minnet aldrig lses hr och
+*                       att funktionen aldrig vntar p en pgende
+*                       skrivning.
+*
+*                    4. Sekvensnumret kas sist och skrivs drmed sist,
+*                       vilket gr posten giltig.
+*                       Om matningsspnningen frsvinner innan dess ligger
+*                       platsens gamla sekvensnummer kvar, vilket gr att
+*                       fregende post fortfarande hittas som senast skriven.
+*
+*                    - self: Pekare till ringbufferten.
+*                    - data: Pekare till datan som ska skrivas (data_size byte).
+********************************************************************************/
+int eeprom_ring_write(struct eeprom_ring* self,
+                      const void* data)
+{
+   uint8_t index = 0;
+   uint8_t sequence = 0;
+
+   if (!eeprom_ring_empty(self))
+   {
+      index = self->newest + 1 < self->num_records ? self->newest + 1 : 0;
+      sequence = eeprom_ring_next_sequence(self->sequence);
+   }
+
+   const uint16_t address = eeprom_ring_record_address(self, index);
+   const uint8_t* source = (const uint8_t*)data;
+
+   if (eeprom_queue_free() < self->data_size + 1) return 1;
+
+   for (uint8_t i = 0; i < self->data_size; ++i)
+   {
+      if (eeprom_write_async(address + 1 + i, source[i], true)) return 1;
+   }
+
+   if (eeprom_write_byte_async(address, sequence)) return 1;
+   self->newest = index;
+   self->sequence = sequence;
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_ring_record_address: Returnerar adressen till angiven plats i angiven
+*                             ringbuffert, dr sekvensnumret ligger frst.
+*
+*                             - self : Pekare till ringbufferten.
+*                             - index: Platsens index i ringbufferten.
+********************************************************************************/
+static inline uint16_t eeprom_ring_record_address(const struct eeprom_ring* self,
+                                                  const uint8_t index)
+{
+   return self->address + (uint16_t)index * (self->data_size + 1);
+}
+
+/********************************************************************************
+* eeprom_ring_next_sequence: Returnerar sekvensnumret efter angivet
+*                            sekvensnummer. Efter EEPROM_RING_SEQUENCE_MAX
+*                            brjar rkningen om frn 0, vilket gr att
+*                            EEPROM_RING_EMPTY aldrig anvnds fr en skriven post.
+*
+*                            - sequence: Fregende sekvensnummer.
+********************************************************************************/
+static inline uint8_t eeprom_ring_next_sequence(const uint8_t sequence)
+{
+   return sequence >= EEPROM_RING_SEQUENCE_MAX ? 0 : sequence + 1;
+}
+
+/********************************************************************************
+* eeprom_write: Skriver en byte till angiven adress i EEPROM-minnet och
+*               vntar in skrivningen. Vid lyckad skrivning returneras 0,
+*               annars returneras felkod 1.
+*
+*               1. Om angiven adress verstiger hgsta adressen i EEPROM-
+*                  minnet sker ingen skrivning och felkod 1 returneras.
+*
+*               2. Avbrott inaktiveras temporrt fr att inte avbryta
+*                  skrivningen (EEPROM-skrivningen mste ske inom fyra
+*                  klockcykler fr att lyckas) samt fr att avbrottsrutinen
+*                  fr EEPROM Ready inte ska pbrja en kad skrivning
+*                  samtidigt.
+*
+*               3. Eventuell pgende skrivning samt kade skrivningar
+*                  avslutas innan den nya skrivningen pbrjas, s att
+*                  ordningen mellan skrivningarna bibehlls. Kade
+*                  skrivningar pbrjas hrifrn, vilket gr att
+*                  funktionen fungerar ven med avbrott inaktiverade.
+*
+*               4. Befintligt innehll lses. Vid uppdatering sker ingen
+*                  skrivning om innehllet redan stmmer. Annars vljs
+*                  snabbaste programmeringslge utifrn befintligt innehll
+*                  och skrivningen pbrjas.
+*
+*               5. Avbrottstillstndet terstlls till tillstndet innan
+*                  anropet.
+*
+*               - address: Adressen i EEPROM-minnet som angiven data
+*                          ska lagras p.
+*               - data   : Datan som ska skrivas.
+*               - update : Indikerar ifall skrivningen ska utebli om
+*                          befintligt innehll redan stmmer.
+********************************************************************************/
+static int eeprom_write(const uint16_t address,
+                        const uint8_t data,
+                        const bool update)
+{
+   if (address > EEPROM_ADDRESS_MAX) return 1;
+
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      cli();
+
+      if ((EECR & (1 << EEPE)) == 0)
+      {
+         if (queue_head == queue_tail)
+         {
+            EEAR = address;
+            EECR |= (1 << EERE);
+            const uint8_t old_data = EEDR;
+
+            if (update && old_data == data)
+            {
+               stats.skipped++;
+            }
+            else
+            {
+               eeprom_start_write(address, data, eeprom_get_mode(old_data, data));
+            }
+
+            SREG = sreg;
+            return 0;
+         }
+         eeprom_write_next();
+      }
+      SREG = sreg;
+   }
+}
+
+/********************************************************************************
+* eeprom_write_async: Lgger en byte i skrivkn fr skrivning till angiven
+*                     adress i EEPROM-minnet och returnerar direkt. Vid lyckad
+*                     klggning returneras 0, annars felkod 1. EEPROM-minnet
+*                     lses aldrig hr, vilket gr att funktionen aldrig
+*                     behver vnta p en pgende skrivning.
+*
+*                     1. Om angiven adress verstiger hgsta adressen i
+*                        EEPROM-minnet returneras felkod 1.
+*
+*                     2. Avbrott inaktiveras temporrt, s att kn inte kan
+*                        frndras av en avbrottsrutin under klggningen.
+*
+*                     3. Vid uppdatering, dr en tidigare kad skrivning till
+*                        adressen finns, jmfrs angiven data med kad data.
+*                        Om denna redan stmmer kas ingen skrivning. Annars
+*                        grs jmfrelsen mot befintligt innehll frst nr
+*                        skrivningen str p tur (se eeprom_write_next).
+*
+*                     4. Om kn r full returneras felkod 1. Annars lggs
+*                        skrivningen sist i kn och avbrott fr EEPROM Ready
+*                        aktiveras, vilket gr att avbrottsrutinen pbrjar
+*                        skrivningen s fort EEPROM-minnet r redo.
+*
+*                     - address: Adressen i EEPROM-minnet som angiven data
+*                                ska lagras p.
+*                     - data   : Datan som ska skrivas.
+*                     - update : Indikerar ifall skrivningen ska utebli om
+*                                innehllet redan stmmer.
+********************************************************************************/
+static int eeprom_write_async(const uint16_t address,
+                              const uint8_t data,
+                              const bool update)
+{
+   if (address > EEPROM_ADDRESS_MAX) return 1;
+
+   const uint8_t sreg = SREG;
+   cli();
+   uint8_t queued_data;
+
+   if (update && eeprom_peek(address, &queued_data) == 0 && queued_data == data)
+   {
+      stats.skipped++;
+      SREG = sreg;
+      return 0;
+   }
+
+   const uint8_t next = (queue_tail + 1) & EEPROM_QUEUE_MASK;
+
+   if (next == queue_head)
+   {
+      SREG = sreg;
+      return 1;
+   }
+
+   queue[queue_tail].address = address;
+   queue[queue_tail].data = data;
+   queue[queue_tail].update = update;
+   queue_tail = next;
+   EECR |= (1 << EERIE);
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* eeprom_peek: Hmtar datan i den senast kade skrivningen till angiven
+*              adress i EEPROM-minnet, dvs. innehllet som adressen kommer att
+*              ha nr samtliga kade skrivningar r genomfrda. Funktionen
+*              frutstter att avbrott r inaktiverade. Om adressen ligger i
+*              kn returneras 0, annars 1.
+*
+*              - address: Adressen i EEPROM-minnet.
+*              - data   : Pekare till destinationen fr kad data.
+********************************************************************************/
+static inline int eeprom_peek(const uint16_t address,
+                              uint8_t* data)
+{
+   for (uint8_t i = queue_tail; i != queue_head;)
+   {
+      i = (i - 1) & EEPROM_QUEUE_MASK;
+
+      if (queue[i].address == address)
+      {
+         *data = queue[i].data;
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/********************************************************************************
+* eeprom_queue_free: Returnerar antalet lediga platser i skrivkn. En plats
+*                    lmnas alltid oanvnd fr att skilja full k frn tom.
+********************************************************************************/
+static inline uint8_t eeprom_queue_free(void)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   const uint8_t used = (queue_tail - queue_head) & EEPROM_QUEUE_MASK;
+   SREG = sreg;
+   return EEPROM_QUEUE_SIZE - 1 - used;
+}
+
+/********************************************************************************
+* eeprom_get_mode: Returnerar snabbaste programmeringslge fr att ndra
+*                  innehllet i en EEPROM-cell frn befintligt till nytt
+*                  innehll. En radering stter samtliga bitar till ettor
+*                  medan en skrivning enbart kan nollstlla bitar.
+*
+*                  1. Om samtliga bitar ska vara ettor rcker en radering.
+*
+*                  2. Om ingen bit ska g frn nolla till etta rcker en
+*                     skrivning utan fregende radering.
+*
+*                  3. Annars krvs radering fljt av skrivning, vilket tar
+*                     ungefr dubbelt s lng tid.
+*
+*                  - old_data: Befintligt innehll.
+*                  - new_data: Nytt innehll.
+********************************************************************************/
+static inline uint8_t eeprom_get_mode(const uint8_t old_data,
+                                      const uint8_t new_data)
+{
+   if (new_data == 0xFF) return EEPROM_MODE_ERASE_ONLY;
+   if ((old_data & new_data) == new_data) return EEPROM_MODE_WRITE_ONLY;
+   return EEPROM_MODE_ERASE_WRITE;
+}
+
+/********************************************************************************
+* eeprom_start_write: Pbrjar skrivning av en byte till angiven adress i
+*                     EEPROM-minnet med angivet programmeringslge och
+*                     uppdaterar statistiken. Funktionen frutstter att
+*                     avbrott r inaktiverade samt att ingen skrivning pgr,
+*                     vilket krvs fr att programmeringslget ska kunna
+*                     ndras.
+*
+*                     - address: Adressen i EEPROM-minnet.
+*                     - data   : Datan som ska skrivas.
+*                     - mode   : Programmeringslge (bitarna EEPM1 och EEPM0).
+********************************************************************************/
+static inline void eeprom_start_write(const uint16_t address,
+                                      const uint8_t data,
+                                      const uint8_t mode)
+{
+   EEAR = address;
+   EEDR = data;
+   EECR = (EECR & ~EEPROM_MODE_MASK) | mode;
+   EECR |= (1 << EEMPE);
+   EECR |= (1 << EEPE);
+
+   if (mode == EEPROM_MODE_ERASE_ONLY) stats.erase_only++;
+   else if (mode == EEPROM_MODE_WRITE_ONLY) stats.write_only++;
+   else stats.erase_write++;
+   return;
 }
\ No newline at end of file
@@ -1,6 +1,29 @@
 /********************************************************************************
 * eeprom.h: Innehller drivrutiner fr skrivning samt lsning till och frn
 *           EEPROM-minnet.
+*
+*           Frutom blockerande skrivning via eeprom_write_byte kan skrivningar
+*           lggas i en k via eeprom_write_byte_async, som returnerar direkt.
+*           Kn tms en byte i taget av avbrottsrutinen fr EEPROM Ready, dr
+*           funktionen eeprom_write_next ska anropas ssom visas nedan:
+*
+*           ISR (EE_READY_vect)
+*           {
+*              eeprom_write_next();
+*              return;
+*           }
+*
+*           Innan matningsspnningen bryts eller systemet terstlls kan
+*           samtliga kade skrivningar genomfras via eeprom_flush.
+*
+*           Via uppdateringsfunktionerna (eeprom_update_byte,
+*           eeprom_update_block med flera) skrivs enbart byte vars innehll
+*           skiljer sig. Varje skrivning genomfrs dessutom med snabbaste
+*           programmeringslge utifrn befintligt innehll: enbart radering
+*           om samtliga bitar ska vara ettor, enbart skrivning om inga bitar
+*           ska g frn nolla till etta, annars radering fljt av skrivning.
+*           Antalet skrivningar per lge samt antalet undvikna skrivningar
+*           kan lsas av via eeprom_get_stats.
 ********************************************************************************/
 #ifndef EEPROM_H_
 #define EEPROM_H_
@@ -12,6 +35,47 @@
 #define EEPROM_ADDRESS_MIN 0    /* Lgsta adress i EEPROM-minnet. */
 #define EEPROM_ADDRESS_MAX 1023 /* Hgsta adress i EEPROM-minnet. */
 
+#define EEPROM_QUEUE_SIZE 32 /* Kapacitet fr skrivkn (mste vara en tvpotens). */
+
+#define EEPROM_RING_RECORDS_MAX 254 /* Hgsta antal poster i en ringbuffert. */
+#define EEPROM_RING_SEQUENCE_MAX 0xFE /* Hgsta sekvensnummer, drefter brjar rkningen om frn 0. */
+#define EEPROM_RING_EMPTY 0xFF        /* Sekvensnummer fr oskriven post (raderat EEPROM). */
+
+/********************************************************************************
+* eeprom_ring: Strukt fr slitageutjmnad lagring av en post med fast storlek
+*              i EEPROM-minnet. I stllet fr att samma adresser skrivs om vid
+*              varje uppdatering skrivs posten till nsta plats i en ringbuffert
+*              med angivet antal platser, vilket frdelar skrivningarna jmnt
+*              ver regionen och drmed frlnger EEPROM-minnets livslngd lika
+*              mnga gnger.
+*
+*              Varje post bestr av ett sekvensnummer fljt av datan.
+*              Sekvensnumret rknas upp med ett fr varje skriven post, vilket
+*              gr att den senast skrivna posten kan hittas vid start genom att
+*              enbart sekvensnumren lses tills fljden bryts. Sekvensnumret
+*              skrivs sist, s att en post som avbryts under skrivning
+*              inte anvnds.
+********************************************************************************/
+struct eeprom_ring
+{
+   uint16_t address;    /* Startadress fr ringbufferten i EEPROM-minnet. */
+   uint8_t data_size;   /* Antalet databyte per post (exklusive sekvensnummer). */
+   uint8_t num_records; /* Antalet platser i ringbufferten. */
+   uint8_t newest;      /* Index fr den senast skrivna posten. */
+   uint8_t sequence;    /* Sekvensnummer fr den senast skrivna posten. */
+};
+
+/********************************************************************************
+* eeprom_stats: Strukt fr statistik ver skrivningar till EEPROM-minnet.
+********************************************************************************/
+struct eeprom_stats
+{
+   uint32_t erase_write; /* Antal skrivningar med radering fljt av skrivning (3.4 ms). */
+   uint32_t erase_only;  /* Antal skrivningar med enbart radering (1.8 ms). */
+   uint32_t write_only;  /* Antal skrivningar utan radering (1.8 ms). */
+   uint32_t skipped;     /* Antal undvikna skrivningar, dr innehllet redan stmde. */
+};
+
 /********************************************************************************
 * eeprom_write_byte: Skriver en byte bestende av ett osignerat heltal till 
 *                    angiven adress i EEPROM-minnet. Vid lyckad skrivning
@@ -24,6 +88,19 @@
 int eeprom_write_byte(const uint16_t address, 
                       const uint8_t data);
 
+/********************************************************************************
+* eeprom_update_byte: Skriver en byte till angiven adress i EEPROM-minnet
+*                     enbart om befintligt innehll skiljer sig frn angiven
+*                     data. Vid lyckad skrivning (eller om ingen skrivning
+*                     behvdes) returneras 0, annars returneras felkod 1.
+*
+*                     - address: Adressen i EEPROM-minnet som angiven data
+*                                ska lagras p.
+*                     - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_update_byte(const uint16_t address,
+                       const uint8_t data);
+
 /********************************************************************************
 * eeprom_write_word: Skriver tv byte bestende av ett osignerat heltal till
 *                    angiven samt efterfljande adress i EEPROM-minnet. Vid 
@@ -36,10 +113,64 @@ int eeprom_write_byte(const uint16_t address,
 int eeprom_write_word(const uint16_t address_low, 
                       const uint16_t data);
 
+/********************************************************************************
+* eeprom_write_byte_async: Lgger en byte i skrivkn fr skrivning till angiven
+*                          adress i EEPROM-minnet och returnerar direkt utan
+*                          att vnta p skrivningen. Kade skrivningar
+*                          genomfrs i tur och ordning av avbrottsrutinen fr
+*                          EEPROM Ready. Vid lyckad klggning returneras 0.
+*                          Om adressen r felaktig eller kn r full returneras
+*                          felkod 1.
+*
+*                          - address: Adressen i EEPROM-minnet som angiven data
+*                                     ska lagras p.
+*                          - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_write_byte_async(const uint16_t address,
+                            const uint8_t data);
+
+/********************************************************************************
+* eeprom_update_byte_async: Lgger en byte i skrivkn fr skrivning till
+*                           angiven adress i EEPROM-minnet enbart om
+*                           innehllet p adressen (inklusive tidigare kade
+*                           skrivningar) skiljer sig frn angiven data. Vid
+*                           lyckad klggning (eller om ingen skrivning
+*                           behvdes) returneras 0, annars felkod 1.
+*
+*                           - address: Adressen i EEPROM-minnet som angiven
+*                                      data ska lagras p.
+*                           - data   : Datan som ska skrivas.
+********************************************************************************/
+int eeprom_update_byte_async(const uint16_t address,
+                             const uint8_t data);
+
+/********************************************************************************
+* eeprom_write_next: Pbrjar nsta kade skrivning till EEPROM-minnet, dr
+*                    kade uppdateringar vars innehll redan stmmer hoppas
+*                    ver. Nr kn r tom inaktiveras avbrott fr EEPROM
+*                    Ready. Denna funktion ska anropas i avbrottsrutinen fr
+*                    EEPROM Ready (EE_READY_vect).
+********************************************************************************/
+void eeprom_write_next(void);
+
+/********************************************************************************
+* eeprom_write_pending: Indikerar ifall kade skrivningar terstr eller om en
+*                       skrivning pgr. I s fall returneras true, annars false.
+********************************************************************************/
+bool eeprom_write_pending(void);
+
+/********************************************************************************
+* eeprom_flush: Genomfr samtliga kade skrivningar och vntar tills sista
+*               skrivningen r klar. Fungerar ven med avbrott inaktiverade,
+*               exempelvis i en avbrottsrutin innan systemterstllning.
+********************************************************************************/
+void eeprom_flush(void);
+
 /********************************************************************************
 * eeprom_read_byte: Lser en byte p angiven adress i EEPROM-minnet och 
-*                   returnerar detta som ett osignerat heltal. Vid misslyckad
-*                   lsning returneras 0.
+*                   returnerar detta som ett osignerat heltal. Om en skrivning
+*                   till adressen ligger i skrivkn returneras kad data.
+*                   Vid misslyckad lsning returneras 0.
 *
 *                   - address: Adressen i EEPROM-minnet som ska lsas av.
 ********************************************************************************/
@@ -55,4 +186,118 @@ uint8_t eeprom_read_byte(const uint16_t address);
 ********************************************************************************/
 uint16_t eeprom_read_word(const uint16_t address_low);
 
+/********************************************************************************
+* eeprom_read_block: Lser angivet antal byte med start p angiven adress i
+*                    EEPROM-minnet till angiven destination. Om regionen inte
+*                    ryms i EEPROM-minnet sker ingen lsning och felkod 1
+*                    returneras, annars 0.
+*
+*                    - address: Startadress i EEPROM-minnet.
+*                    - data   : Pekare till destinationen.
+*                    - size   : Antalet byte som ska lsas.
+********************************************************************************/
+int eeprom_read_block(const uint16_t address,
+                      void* data,
+                      const uint16_t size);
+
+/********************************************************************************
+* eeprom_update_block: Skriver angivet antal byte frn angiven klla med start
+*                      p angiven adress i EEPROM-minnet, dr enbart byte vars
+*                      innehll skiljer sig skrivs. Skrivningen r blockerande.
+*                      Om regionen inte ryms i EEPROM-minnet sker ingen
+*                      skrivning och felkod 1 returneras, annars 0.
+*
+*                      - address: Startadress i EEPROM-minnet.
+*                      - data   : Pekare till datan som ska skrivas.
+*                      - size   : Antalet byte som ska skrivas.
+********************************************************************************/
+int eeprom_update_block(const uint16_t address,
+                        const void* data,
+                        const uint16_t size);
+
+/********************************************************************************
+* eeprom_update_block_async: Lgger angivet antal byte frn angiven klla i
+*                            skrivkn med start p angiven adress i EEPROM-
+*                            minnet, dr enbart byte vars innehll skiljer sig
+*                            kas. Vid lyckad klggning returneras 0. Om
+*                            regionen inte ryms i EEPROM-minnet eller om kn
+*                            blir full returneras felkod 1, varvid enbart en
+*                            del av blocket kan ha kats.
+*
+*                            - address: Startadress i EEPROM-minnet.
+*                            - data   : Pekare till datan som ska skrivas.
+*                            - size   : Antalet byte som ska skrivas.
+********************************************************************************/
+int eeprom_update_block_async(const uint16_t address,
+                              const void* data,
+                              const uint16_t size);
+
+/********************************************************************************
+* eeprom_get_stats: Kopierar statistiken ver genomfrda samt undvikna
+*                   skrivningar till angiven destination.
+*
+*                   - destination: Pekare till destinationen.
+********************************************************************************/
+void eeprom_get_stats(struct eeprom_stats* destination);
+
+/********************************************************************************
+* eeprom_reset_stats: Nollstller statistiken ver genomfrda samt undvikna
+*                     skrivningar.
+********************************************************************************/
+void eeprom_reset_stats(void);
+
+/********************************************************************************
+* eeprom_ring_init: Initierar ringbuffert fr slitageutjmnad lagring i angiven
+*                   region av EEPROM-minnet och letar upp den senast skrivna
+*                   posten. Regionen upptar num_records * (data_size + 1) byte
+*                   med start p angiven adress. Vid felaktigt angiven region
+*                   returneras felkod 1, annars 0.
+*
+*                   - self       : Pekare till ringbufferten.
+*                   - address    : Startadress fr regionen i EEPROM-minnet.
+*                   - data_size  : Antalet databyte per post.
+*                   - num_records: Antalet platser (2 - EEPROM_RING_RECORDS_MAX).
+********************************************************************************/
+int eeprom_ring_init(struct eeprom_ring* self,
+                     const uint16_t address,
+                     const uint8_t data_size,
+                     const uint8_t num_records);
+
+/********************************************************************************
+* eeprom_ring_empty: Indikerar ifall angiven ringbuffert saknar skrivna poster.
+*
+*                    - self: Pekare till ringbufferten.
+********************************************************************************/
+static inline bool eeprom_ring_empty(const struct eeprom_ring* self)
+{
+   return self->sequence == EEPROM_RING_EMPTY;
+}
+
+/********************************************************************************
+* eeprom_ring_read: Lser den senast skrivna posten i angiven ringbuffert till
+*                   angiven destination. Ifall ringbufferten r tom sker ingen
+*                   lsning och felkod 1 returneras, annars 0.
+*
+*                   - self: Pekare till ringbufferten.
+*                   - data: Pekare till destinationen (data_size byte).
+********************************************************************************/
+int eeprom_ring_read(const struct eeprom_ring* self,
+                     void* data);
+
+/********************************************************************************
+* eeprom_ring_write: Skriver angiven data som en ny post p nsta plats i
+*                    angiven ringbuffert. Byte som redan har samma innehll
+*                    p platsen skrivs inte om. Skrivningen lggs i skrivkn,
+*                    vilket gr att funktionen returnerar direkt utan att
+*                    lsa EEPROM-minnet eller vnta p en pgende skrivning.
+*                    Vid lyckad klggning returneras 0. Om kn saknar plats
+*                    fr hela posten returneras felkod 1 utan att ngot
+*                    kas, varvid skrivningen br gras om senare.
+*
+*                    - self: Pekare till ringbufferten.
+*                    - data: Pekare till datan som ska skrivas (data_size byte).
+********************************************************************************/
+int eeprom_ring_write(struct eeprom_ring* self,
+                      const void* data);
+
 #endif /* EEPROM_H_ */
\ No newline at end of file
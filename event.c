@@ -0,0 +1,188 @@
+/********************************************************************************
+* event.c: Innehller funktionsdefinitioner fr den hndelsestyrda
+*          schemalggaren.
+********************************************************************************/
+#include "event.h"
+
+/* Makrodefinitioner: */
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1) /* Mask fr index i hndelsekn. */
+#define EVENT_CLOCK_SELECT 0x07                 /* Bitar CSn2 - CSn0 fr timerkretsarnas klocka. */
+
+/* Statiska funktioner: */
+static inline uint8_t event_get_sleep_mode(void);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - queue     : Ringbuffert med kade hndelser.
+*   - queue_head: Index fr nsta hndelse som ska kras.
+*   - queue_tail: Index fr nsta lediga plats i kn.
+*   - stats     : Statistik ver hndelsekn.
+********************************************************************************/
+static void (* volatile queue[EVENT_QUEUE_SIZE])(void);
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static struct event_stats stats;
+
+/********************************************************************************
+* event_post: Lgger angiven hndelse sist i hndelsekn. Vid lyckad
+*             tillggning returneras 0, annars returneras felkod 1.
+*
+*             1. Avbrott inaktiveras temporrt, s att anrop frn huvudloopen
+*                inte kan blandas med anrop frn avbrottsrutiner. Eftersom
+*                avbrottsrutiner inte kan avbryta varandra finns drmed
+*                alltid en enda producent t gngen.
+*
+*             2. Om kn r full rknas antalet kastade hndelser upp.
+*
+*             3. Annars skrivs hndelsen till kn innan queue_tail flyttas
+*                fram, s att huvudloopen aldrig lser en halvt tillagd
+*                hndelse. Hgsta antal kade hndelser uppdateras.
+*
+*             - handler: Funktionen som ska anropas nr hndelsen krs.
+********************************************************************************/
+int event_post(void (*handler)(void))
+{
+   const uint8_t sreg = SREG;
+   cli();
+
+   const uint8_t next = (queue_tail + 1) & EVENT_QUEUE_MASK;
+
+   if (next == queue_head)
+   {
+      stats.dropped++;
+      SREG = sreg;
+      return 1;
+   }
+
+   queue[queue_tail] = handler;
+   queue_tail = next;
+
+   const uint8_t used = (queue_tail - queue_head) & EVENT_QUEUE_MASK;
+   if (used > stats.high_water) stats.high_water = used;
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* event_run_next: Kr ldsta hndelsen i hndelsekn. Om en hndelse krdes
+*                 returneras true, annars false. Enbart event_post skriver
+*                 till queue_tail och enbart denna funktion skriver till
+*                 queue_head, dr bda r 8-bitars index. Hndelsen lses
+*                 innan queue_head flyttas fram, vilket gr att avbrott inte
+*                 behver inaktiveras.
+********************************************************************************/
+bool event_run_next(void)
+{
+   if (queue_head == queue_tail) return false;
+
+   void (*handler)(void) = queue[queue_head];
+   queue_head = (queue_head + 1) & EVENT_QUEUE_MASK;
+   handler();
+   return true;
+}
+
+/********************************************************************************
+* event_run: Kr samtliga hndelser i hndelsekn tills kn r tom.
+********************************************************************************/
+void event_run(void)
+{
+   while (event_run_next());
+   return;
+}
+
+/********************************************************************************
+* event_sleep: Frstter processorn i vilolge tills nsta avbrott, frutsatt
+*              att hndelsekn r tom.
+*
+*              1. Avbrott inaktiveras innan hndelsekn kontrolleras. Om
+*                 hndelser ligger i kn teraktiveras avbrott direkt.
+*
+*              2. Annars vljs vilolge, varefter avbrott aktiveras
+*                 omedelbart fre instruktionen SLEEP. Eftersom instruktionen
+*                 efter SEI alltid genomfrs innan vntande avbrott hanteras
+*                 kan ett avbrott mellan kontrollen och vilolget inte g
+*                 frlorat, utan vcker processorn direkt.
+*
+*              3. Efter uppvakning, nr avbrottsrutinen har genomfrts,
+*                 inaktiveras vilolget s att SLEEP inte kan genomfras
+*                 oavsiktligt.
+********************************************************************************/
+void event_sleep(void)
+{
+   cli();
+
+   if (queue_head != queue_tail)
+   {
+      sei();
+      return;
+   }
+
+   set_sleep_mode(event_get_sleep_mode());
+   sleep_enable();
+   sei();
+   sleep_cpu();
+   sleep_disable();
+   return;
+}
+
+/********************************************************************************
+* event_pending: Indikerar ifall hndelser ligger i hndelsekn. I s fall
+*                returneras true, annars false.
+********************************************************************************/
+bool event_pending(void)
+{
+   return queue_head != queue_tail;
+}
+
+/********************************************************************************
+* event_get_stats: Kopierar statistiken ver hndelsekn till angiven
+*                  destination.
+*
+*                  - destination: Pekare till destinationen.
+********************************************************************************/
+void event_get_stats(struct event_stats* destination)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   *destination = stats;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* event_reset_stats: Nollstller statistiken ver hndelsekn.
+********************************************************************************/
+void event_reset_stats(void)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   stats.high_water = 0;
+   stats.dropped = 0;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* event_get_sleep_mode: Returnerar lgsta vilolge som inte stoppar ngon
+*                       aktiv krets. Power-save vljs enbart nr Timer 2
+*                       drivs av asynkron klocka (AS2 i ASSR) och varken
+*                       Timer 0, Timer 1, USART, AD-omvandlaren eller
+*                       EEPROM-minnet anvnds, eftersom dessa krver
+*                       I/O-klockan, som stngs av i Power-save. Med synkron
+*                       klocka, som p Arduino Uno dr kristallens pinnar
+*                       anvnds av systemklockan, stannar ven Timer 2 i
+*                       Power-save, varfr Idle d vljs.
+********************************************************************************/
+static inline uint8_t event_get_sleep_mode(void)
+{
+   if (!(ASSR & (1 << AS2)) ||
+       (TCCR0B & EVENT_CLOCK_SELECT) || (TCCR1B & EVENT_CLOCK_SELECT) ||
+       (UCSR0B & ((1 << RXEN0) | (1 << TXEN0))) || (ADCSRA & (1 << ADEN)) ||
+       (EECR & ((1 << EEPE) | (1 << EERIE))))
+   {
+      return SLEEP_MODE_IDLE;
+   }
+   return SLEEP_MODE_PWR_SAVE;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/********************************************************************************
+* event.h: Innehller en kooperativ, hndelsestyrd schemalggare, dr arbete
+*          flyttas ut ur avbrottsrutinerna till huvudloopen.
+*
+*          Avbrottsrutiner lgger enbart en hndelse, dvs. en pekare till
+*          funktionen som ska genomfra arbetet, i en k av fast storlek via
+*          event_post, exempelvis:
+*
+*          ISR (PCINT0_vect)
+*          {
+*             event_post(display_toggle_count);
+*             return;
+*          }
+*
+*          Huvudloopen kr sedan kade hndelser i den ordning de lades till
+*          via event_run. Varje hndelse krs till slut innan nsta pbrjas,
+*          vilket gr att hndelser aldrig avbryter varandra, medan
+*          avbrottsrutiner fortfarande kan avbryta en hndelse som krs:
+*
+*          while (1)
+*          {
+*             event_run();
+*             wdt_reset();
+*             event_sleep();
+*          }
+*
+*          Hndelser br drmed vara korta, s att vriga hndelser inte
+*          frdrjs. Om kn r full kastas hndelsen, vilket rknas i
+*          statistiken som hmtas via event_get_stats.
+*
+*          Nr inget arbete terstr frstts processorn i vilolge via
+*          event_sleep tills nsta avbrott. Vilolget vljs utefter vilka
+*          kretsar som r aktiva:
+*
+*          Vilolge      Villkor                          Uppvakningstid
+*          Idle          Ngon krets krver I/O-klockan,  6 klockcykler
+*                        eller Timer 2 har synkron klocka
+*          Power-save    Timer 2 med asynkron klocka      Oscillatorns starttid
+*                        (AS2) samt PCI-avbrott           enligt skringarna
+*
+*          I Power-save stngs I/O-klockan av. Timer 2 fortstter d enbart
+*          att rkna med asynkron klocka frn en extern kristall p 32.768
+*          kHz, vilket krver att AS2 i ASSR r ettstlld. Arduino Uno
+*          saknar en sdan kristall, varfr Timer 2 dr har synkron klocka
+*          och Idle alltid vljs. Med asynkron klocka frdrjs efterfljande
+*          tick av oscillatorns starttid, men gr inte frlorade.
+********************************************************************************/
+#ifndef EVENT_H_
+#define EVENT_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include <avr/sleep.h>
+
+/* Makrodefinitioner: */
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 16 /* Kapacitet fr hndelsekn (tvpotens, hgst 256). */
+#endif
+
+/********************************************************************************
+* event_stats: Strukt fr statistik ver hndelsekn.
+********************************************************************************/
+struct event_stats
+{
+   uint8_t high_water; /* Hgsta antal hndelser som samtidigt legat i kn. */
+   uint32_t dropped;   /* Antal hndelser som kastats p grund av full k. */
+};
+
+/********************************************************************************
+* event_post: Lgger angiven hndelse sist i hndelsekn, s att den krs frn
+*             huvudloopen. Vid lyckad tillggning returneras 0. Om kn r
+*             full kastas hndelsen och felkod 1 returneras. Funktionen kan
+*             anropas bde frn avbrottsrutiner och frn huvudloopen.
+*
+*             - handler: Funktionen som ska anropas nr hndelsen krs.
+********************************************************************************/
+int event_post(void (*handler)(void));
+
+/********************************************************************************
+* event_run_next: Kr ldsta hndelsen i hndelsekn. Om en hndelse krdes
+*                 returneras true, annars false. Ska enbart anropas frn
+*                 huvudloopen.
+********************************************************************************/
+bool event_run_next(void);
+
+/********************************************************************************
+* event_run: Kr samtliga hndelser i hndelsekn, inklusive hndelser som
+*            lggs till under tiden, tills kn r tom. Ska anropas
+*            kontinuerligt frn huvudloopen.
+********************************************************************************/
+void event_run(void);
+
+/********************************************************************************
+* event_sleep: Frstter processorn i vilolge tills nsta avbrott, frutsatt
+*              att hndelsekn r tom. Om en hndelse lggs till strax fre
+*              anropet sker inget vilolge, s att hndelsen inte frdrjs.
+*              Ska anropas sist i huvudloopen.
+********************************************************************************/
+void event_sleep(void);
+
+/********************************************************************************
+* event_pending: Indikerar ifall hndelser ligger i hndelsekn. I s fall
+*                returneras true, annars false.
+********************************************************************************/
+bool event_pending(void);
+
+/********************************************************************************
+* event_get_stats: Kopierar statistiken ver hndelsekn till angiven
+*                  destination.
+*
+*                  - destination: Pekare till destinationen.
+********************************************************************************/
+void event_get_stats(struct event_stats* destination);
+
+/********************************************************************************
+* event_reset_stats: Nollstller statistiken ver hndelsekn.
+********************************************************************************/
+void event_reset_stats(void);
+
+#endif /* EVENT_H_ */
\ No newline at end of file
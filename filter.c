@@ -0,0 +1,180 @@
+/********************************************************************************
+* filter.c: Innehller funktionsdefinitioner fr digitala filter via strukten
+*           filter.
+********************************************************************************/
+#include "filter.h"
+
+/* Statiska funktioner: */
+static inline uint8_t filter_get_shift(const uint8_t length);
+static void filter_fill(struct filter* self,
+                        const uint16_t value);
+static uint16_t filter_get_median(const struct filter* self);
+
+/********************************************************************************
+* filter_init: Initierar angivet filter. Vid ogiltig parameter fr valt filter
+*              returneras felkod 1, annars 0.
+*
+*              1. Parametern kontrolleras. Glidande medelvrde krver en
+*                 tvpotens, s att division erstts av skiftning. Median
+*                 krver ett udda antal, s att ett mittersta vrde finns.
+*
+*              2. Valt filter lagras, varefter filtret tms s att nsta
+*                 vrde fyller filtret.
+*
+*              - self     : Pekare till filtret som ska initieras.
+*              - type     : Valt filter.
+*              - parameter: Antal vrden (glidande medelvrde samt median)
+*                           eller skiftning (EMA). Ignoreras fr FILTER_NONE.
+********************************************************************************/
+int filter_init(struct filter* self,
+                const enum filter_type type,
+                const uint8_t parameter)
+{
+   uint8_t length = 1;
+   uint8_t shift = 0;
+
+   if (type == FILTER_MOVING_AVERAGE)
+   {
+      shift = filter_get_shift(parameter);
+      if (shift == 0 || parameter > FILTER_WINDOW_SIZE) return 1;
+      length = parameter;
+   }
+   else if (type == FILTER_EMA)
+   {
+      if (parameter == 0 || parameter > FILTER_EMA_SHIFT_MAX) return 1;
+      shift = parameter;
+   }
+   else if (type == FILTER_MEDIAN)
+   {
+      if (parameter < 3 || parameter > FILTER_MEDIAN_MAX || (parameter & 1) == 0) return 1;
+      length = parameter;
+   }
+   else if (type != FILTER_NONE)
+   {
+      return 1;
+   }
+
+   self->type = type;
+   self->length = length;
+   self->shift = shift;
+   filter_reset(self);
+   return 0;
+}
+
+/********************************************************************************
+* filter_put: Matar in ett nytt vrde i angivet filter och returnerar
+*             filtrerat vrde, avrundat till nrmaste heltal.
+*
+*             1. Frsta vrdet efter initiering fyller hela filtret.
+*
+*             2. Vid glidande medelvrde erstter nytt vrde ldsta vrdet i
+*                fnstret, dr den lpande summan uppdateras med skillnaden.
+*                Medelvrdet berknas sedan via skiftning.
+*
+*             3. Vid EMA lagras medelvrdet skalat med 2^skiftning, vilket
+*                gr att sm frndringar inte avrundas bort:
+*
+*                sum = sum - sum / 2^skiftning + value
+*
+*                Divisionen avrundas till nrmaste heltal, precis som
+*                utsignalen. Vid avrundning nedt skulle utsignalen efter
+*                en minskning stanna ett steg ver insignalen.
+*
+*             4. Vid median lagras nytt vrde i fnstret, varefter mittersta
+*                vrdet i fnstret returneras.
+*
+*             - self : Pekare till filtret.
+*             - value: Nytt vrde.
+********************************************************************************/
+uint16_t filter_put(struct filter* self,
+                    const uint16_t value)
+{
+   if (self->type == FILTER_NONE) return value;
+
+   if (!self->primed)
+   {
+      filter_fill(self, value);
+      return value;
+   }
+
+   if (self->type == FILTER_EMA)
+   {
+      self->sum = self->sum - ((self->sum + (1UL << (self->shift - 1))) >> self->shift) + value;
+   }
+   else
+   {
+      const uint16_t oldest = self->window[self->index];
+      self->window[self->index] = value;
+      if (++self->index >= self->length) self->index = 0;
+
+      if (self->type == FILTER_MEDIAN) return filter_get_median(self);
+      self->sum = self->sum - oldest + value;
+   }
+
+   return (uint16_t)((self->sum + (1UL << (self->shift - 1))) >> self->shift);
+}
+
+/********************************************************************************
+* filter_get_shift: Returnerar antalet steg som motsvarar division med angivet
+*                   antal vrden. Om antalet inte r en tvpotens strre n 1
+*                   returneras 0.
+*
+*                   - length: Antal vrden.
+********************************************************************************/
+static inline uint8_t filter_get_shift(const uint8_t length)
+{
+   if (length < 2 || (length & (length - 1))) return 0;
+   uint8_t shift = 0;
+   while ((1 << shift) < length) shift++;
+   return shift;
+}
+
+/********************************************************************************
+* filter_fill: Fyller angivet filter med angivet vrde, s att utsignalen
+*              startar frn frsta vrdet.
+*
+*              - self : Pekare till filtret.
+*              - value: Vrdet som filtret ska fyllas med.
+********************************************************************************/
+static void filter_fill(struct filter* self,
+                        const uint16_t value)
+{
+   for (uint8_t i = 0; i < self->length; ++i)
+   {
+      self->window[i] = value;
+   }
+
+   if (self->type == FILTER_EMA) self->sum = (uint32_t)value << self->shift;
+   else self->sum = (uint32_t)value * self->length;
+
+   self->index = 0;
+   self->primed = true;
+   return;
+}
+
+/********************************************************************************
+* filter_get_median: Returnerar medianen av vrdena i angivet filters fnster.
+*                    Vrdena kopieras och sorteras via insttningssortering,
+*                    vilket r snabbast fr s f vrden.
+*
+*                    - self: Pekare till filtret.
+********************************************************************************/
+static uint16_t filter_get_median(const struct filter* self)
+{
+   uint16_t sorted[FILTER_MEDIAN_MAX];
+
+   for (uint8_t i = 0; i < self->length; ++i)
+   {
+      const uint16_t value = self->window[i];
+      uint8_t j = i;
+
+      while (j > 0 && sorted[j - 1] > value)
+      {
+         sorted[j] = sorted[j - 1];
+         j--;
+      }
+      sorted[j] = value;
+   }
+
+   return sorted[self->length / 2];
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+/********************************************************************************
+* filter.h: Innehller digitala filter fr strmmande mtvrden via strukten
+*           filter, exempelvis resultat frn AD-omvandlaren. Varje nytt vrde
+*           matas in via filter_put, som returnerar filtrerat vrde direkt.
+*
+*           Fljande filter finns, dr samtliga arbetar med heltal och fasta
+*           buffertar utan dynamisk minnesallokering:
+*
+*           Filter                 Parameter             Arbete per vrde
+*           FILTER_MOVING_AVERAGE  Antal vrden 2, 4, 8  Konstant (lpande
+*                                                        summa)
+*           FILTER_EMA             Skiftning 1 - 8, dvs. Konstant
+*                                  alfa = 1 / 2^skift
+*           FILTER_MEDIAN          Antal vrden 3, 5, 7  Sortering av fnstret
+*
+*           Glidande medelvrde och median dmpar brus lika mycket fr varje
+*           vrde i fnstret, dr median dessutom tar bort enstaka spikar
+*           helt. Exponentiellt medelvrde (EMA) krver minst minne, men
+*           ger lngre insvngning fr stora skiftningar.
+*
+*           Frsta vrdet efter initiering fyller hela filtret, s att
+*           utsignalen inte startar frn noll.
+********************************************************************************/
+#ifndef FILTER_H_
+#define FILTER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#define FILTER_WINDOW_SIZE 8    /* Hgsta antal vrden i fnstret (glidande medelvrde). */
+#define FILTER_MEDIAN_MAX 7     /* Hgsta antal vrden fr median (udda). */
+#define FILTER_EMA_SHIFT_MAX 8  /* Hgsta skiftning fr exponentiellt medelvrde. */
+
+/********************************************************************************
+* filter_type: Enumeration fr val av filter.
+********************************************************************************/
+enum filter_type
+{
+   FILTER_NONE,           /* Ingen filtrering, vrden passerar ofrndrade. */
+   FILTER_MOVING_AVERAGE, /* Glidande medelvrde via lpande summa. */
+   FILTER_EMA,            /* Exponentiellt glidande medelvrde. */
+   FILTER_MEDIAN          /* Median av de senaste vrdena. */
+};
+
+/********************************************************************************
+* filter: Strukt fr implementering av digitala filter.
+********************************************************************************/
+struct filter
+{
+   uint16_t window[FILTER_WINDOW_SIZE]; /* Senaste vrden (glidande medelvrde samt median). */
+   uint32_t sum;                        /* Lpande summa respektive skalat medelvrde (EMA). */
+   uint8_t type;                        /* Valt filter (enum filter_type). */
+   uint8_t length;                      /* Antal vrden i fnstret. */
+   uint8_t shift;                       /* Skiftning fr medelvrden. */
+   uint8_t index;                       /* Index fr ldsta vrdet i fnstret. */
+   bool primed;                         /* Indikerar ifall filtret har fyllts. */
+};
+
+/********************************************************************************
+* filter_init: Initierar angivet filter. Vid ogiltig parameter fr valt filter
+*              returneras felkod 1 och filtret lmnas ofrndrat, annars 0.
+*
+*              - self     : Pekare till filtret som ska initieras.
+*              - type     : Valt filter.
+*              - parameter: Antal vrden (glidande medelvrde samt median)
+*                           eller skiftning (EMA). Ignoreras fr FILTER_NONE.
+********************************************************************************/
+int filter_init(struct filter* self,
+                const enum filter_type type,
+                const uint8_t parameter);
+
+/********************************************************************************
+* filter_clear: Nollstller angivet filter, vilket d inte filtrerar.
+*
+*               - self: Pekare till filtret som ska nollstllas.
+********************************************************************************/
+static inline void filter_clear(struct filter* self)
+{
+   self->type = FILTER_NONE;
+   self->length = 0;
+   self->shift = 0;
+   self->sum = 0;
+   self->index = 0;
+   self->primed = false;
+   return;
+}
+
+/********************************************************************************
+* filter_reset: Tmmer angivet filter men behller valt filter, s att nsta
+*               vrde fyller filtret p nytt.
+*
+*               - self: Pekare till filtret som ska tmmas.
+********************************************************************************/
+static inline void filter_reset(struct filter* self)
+{
+   self->primed = false;
+   return;
+}
+
+/********************************************************************************
+* filter_put: Matar in ett nytt vrde i angivet filter och returnerar
+*             filtrerat vrde, avrundat till nrmaste heltal.
+*
+*             - self : Pekare till filtret.
+*             - value: Nytt vrde.
+********************************************************************************/
+uint16_t filter_put(struct filter* self,
+                    const uint16_t value);
+
+#endif /* FILTER_H_ */
\ No newline at end of file
@@ -5,8 +5,13 @@
 #include "wdt.h"
 #include "display.h"
 #include "button.h"
+#include "eeprom.h"
+#include "serial.h"
+#include "command.h"
+#include "event.h"
+#include "adc.h"
 
 extern struct button button1, button2, button3;
-extern struct timer timer0;
+extern struct timer_soft debounce_timer;
 
 #endif /* HEADER_H_ */
\ No newline at end of file
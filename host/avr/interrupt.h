@@ -0,0 +1,23 @@
+/********************************************************************************
+* interrupt.h: Erstter avr-libc:s <avr/interrupt.h> vid kompilering fr
+*              vrddatorn. Avbrottsrutiner definieras som vanliga funktioner
+*              med vektorns namn, vilka anropas av simulatorn (se
+*              host/sim.h) nr motsvarande avbrott ger rum.
+********************************************************************************/
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+/* Inkluderingsdirektiv: */
+#include "sim.h"
+
+/* Makrodefinitioner: */
+#define ISR(vector, ...) void vector(void); void vector(void)
+#define sei() sim_sei()
+#define cli() sim_cli()
+#define reti() return
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
\ No newline at end of file
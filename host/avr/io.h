@@ -0,0 +1,394 @@
+/********************************************************************************
+* io.h: Erstter avr-libc:s <avr/io.h> vid kompilering fr vrddatorn.
+*       Samtliga register fr ATmega328P som anvnds av drivrutinerna
+*       mappas till simulatorns registerfil (se host/sim.h), medan
+*       bitnummer definieras som i avr-libc.
+********************************************************************************/
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+/* Inkluderingsdirektiv: */
+#include "sim.h"
+
+/* Inline-assembler, exempelvis asm("WDR"), genomfrs av simulatorn: */
+#define asm(instruction) sim_asm(instruction)
+
+/* Delade 32-bitars vrden lses och skrivs byte fr byte (se misc.h): */
+#define SHARED_READ_U32(source) sim_read_u32(source)
+#define SHARED_WRITE_U32(destination, value) sim_write_u32((destination), (value))
+
+/* Makrodefinitioner fr register: */
+#define SIM_IO8(id) (*sim_io8(id))
+#define SIM_IO16(id) (*sim_io16(id))
+#define SIM_STROBE(id) (*sim_io_strobe(id))
+
+#define PINB SIM_IO8(SIM_PINB)
+#define DDRB SIM_IO8(SIM_DDRB)
+#define PORTB SIM_IO8(SIM_PORTB)
+#define PINC SIM_IO8(SIM_PINC)
+#define DDRC SIM_IO8(SIM_DDRC)
+#define PORTC SIM_IO8(SIM_PORTC)
+#define PIND SIM_IO8(SIM_PIND)
+#define DDRD SIM_IO8(SIM_DDRD)
+#define PORTD SIM_IO8(SIM_PORTD)
+#define TIFR0 SIM_STROBE(SIM_TIFR0)
+#define TIFR1 SIM_STROBE(SIM_TIFR1)
+#define TIFR2 SIM_STROBE(SIM_TIFR2)
+#define PCIFR SIM_STROBE(SIM_PCIFR)
+#define EIFR SIM_STROBE(SIM_EIFR)
+#define EIMSK SIM_IO8(SIM_EIMSK)
+#define GPIOR0 SIM_IO8(SIM_GPIOR0)
+#define EECR SIM_IO8(SIM_EECR)
+#define EEDR SIM_IO8(SIM_EEDR)
+#define EEAR SIM_IO16(SIM_EEAR)
+#define GTCCR SIM_IO8(SIM_GTCCR)
+#define TCCR0A SIM_IO8(SIM_TCCR0A)
+#define TCCR0B SIM_IO8(SIM_TCCR0B)
+#define TCNT0 SIM_IO8(SIM_TCNT0)
+#define OCR0A SIM_IO8(SIM_OCR0A)
+#define OCR0B SIM_IO8(SIM_OCR0B)
+#define GPIOR1 SIM_IO8(SIM_GPIOR1)
+#define GPIOR2 SIM_IO8(SIM_GPIOR2)
+#define ACSR SIM_IO8(SIM_ACSR)
+#define SMCR SIM_IO8(SIM_SMCR)
+#define MCUSR SIM_IO8(SIM_MCUSR)
+#define MCUCR SIM_IO8(SIM_MCUCR)
+#define SREG SIM_IO8(SIM_SREG)
+#define WDTCSR SIM_STROBE(SIM_WDTCSR)
+#define CLKPR SIM_IO8(SIM_CLKPR)
+#define PRR SIM_IO8(SIM_PRR)
+#define PCICR SIM_IO8(SIM_PCICR)
+#define EICRA SIM_IO8(SIM_EICRA)
+#define PCMSK0 SIM_IO8(SIM_PCMSK0)
+#define PCMSK1 SIM_IO8(SIM_PCMSK1)
+#define PCMSK2 SIM_IO8(SIM_PCMSK2)
+#define TIMSK0 SIM_IO8(SIM_TIMSK0)
+#define TIMSK1 SIM_IO8(SIM_TIMSK1)
+#define TIMSK2 SIM_IO8(SIM_TIMSK2)
+#define ADC SIM_IO16(SIM_ADC)
+#define ADCW ADC
+#define ADCSRA SIM_STROBE(SIM_ADCSRA)
+#define ADCSRB SIM_IO8(SIM_ADCSRB)
+#define ADMUX SIM_IO8(SIM_ADMUX)
+#define DIDR0 SIM_IO8(SIM_DIDR0)
+#define DIDR1 SIM_IO8(SIM_DIDR1)
+#define TCCR1A SIM_IO8(SIM_TCCR1A)
+#define TCCR1B SIM_IO8(SIM_TCCR1B)
+#define TCCR1C SIM_IO8(SIM_TCCR1C)
+#define TCNT1 SIM_IO16(SIM_TCNT1)
+#define ICR1 SIM_IO16(SIM_ICR1)
+#define OCR1A SIM_IO16(SIM_OCR1A)
+#define OCR1B SIM_IO16(SIM_OCR1B)
+#define TCCR2A SIM_IO8(SIM_TCCR2A)
+#define TCCR2B SIM_IO8(SIM_TCCR2B)
+#define TCNT2 SIM_IO8(SIM_TCNT2)
+#define OCR2A SIM_IO8(SIM_OCR2A)
+#define OCR2B SIM_IO8(SIM_OCR2B)
+#define ASSR SIM_IO8(SIM_ASSR)
+#define UCSR0A SIM_IO8(SIM_UCSR0A)
+#define UCSR0B SIM_IO8(SIM_UCSR0B)
+#define UCSR0C SIM_IO8(SIM_UCSR0C)
+#define UBRR0 SIM_IO16(SIM_UBRR0)
+#define UDR0 SIM_STROBE(SIM_UDR0)
+
+/* I/O-portar: */
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+#define PINB6 6
+#define PINB7 7
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDB6 6
+#define DDB7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTB6 6
+#define PORTB7 7
+#define PINC0 0
+#define PINC1 1
+#define PINC2 2
+#define PINC3 3
+#define PINC4 4
+#define PINC5 5
+#define PINC6 6
+#define DDC0 0
+#define DDC1 1
+#define DDC2 2
+#define DDC3 3
+#define DDC4 4
+#define DDC5 5
+#define DDC6 6
+#define PORTC0 0
+#define PORTC1 1
+#define PORTC2 2
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+#define PORTC6 6
+#define PIND0 0
+#define PIND1 1
+#define PIND2 2
+#define PIND3 3
+#define PIND4 4
+#define PIND5 5
+#define PIND6 6
+#define PIND7 7
+#define DDD0 0
+#define DDD1 1
+#define DDD2 2
+#define DDD3 3
+#define DDD4 4
+#define DDD5 5
+#define DDD6 6
+#define DDD7 7
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+
+/* Timer 0: */
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define FOC0B 6
+#define FOC0A 7
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+
+/* Timer 1: */
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define ICNC1 7
+#define FOC1B 6
+#define FOC1A 7
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+
+/* Timer 2: */
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define FOC2B 6
+#define FOC2A 7
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define TCR2BUB 0
+#define TCR2AUB 1
+#define OCR2BUB 2
+#define OCR2AUB 3
+#define TCN2UB 4
+#define AS2 5
+#define EXCLK 6
+
+/* Gemensamt fr timerkretsarna: */
+#define PSRSYNC 0
+#define PSRASY 1
+#define TSM 7
+
+/* Externa avbrott samt PCI-avbrott: */
+#define INTF0 0
+#define INTF1 1
+#define INT0 0
+#define INT1 1
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+#define PCINT6 6
+#define PCINT7 7
+#define PCINT8 0
+#define PCINT9 1
+#define PCINT10 2
+#define PCINT11 3
+#define PCINT12 4
+#define PCINT13 5
+#define PCINT14 6
+#define PCINT16 0
+#define PCINT17 1
+#define PCINT18 2
+#define PCINT19 3
+#define PCINT20 4
+#define PCINT21 5
+#define PCINT22 6
+#define PCINT23 7
+
+/* EEPROM: */
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define EEPM0 4
+#define EEPM1 5
+#define E2END 0x3FF
+
+/* Vilolge, terstllning samt strmsparande: */
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define IVCE 0
+#define IVSEL 1
+#define PUD 4
+#define BODSE 5
+#define BODS 6
+#define CLKPS0 0
+#define CLKPS1 1
+#define CLKPS2 2
+#define CLKPS3 3
+#define CLKPCE 7
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+
+/* Statusregistret: */
+#define SREG_C 0
+#define SREG_Z 1
+#define SREG_N 2
+#define SREG_V 3
+#define SREG_S 4
+#define SREG_H 5
+#define SREG_T 6
+#define SREG_I 7
+
+/* Watchdog-timern: */
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDIF 7
+
+/* AD-omvandlaren: */
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define ACME 6
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define ADC0D 0
+#define ADC1D 1
+#define ADC2D 2
+#define ADC3D 3
+#define ADC4D 4
+#define ADC5D 5
+
+/* USART: */
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXB80 0
+#define RXB80 1
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCPOL0 0
+#define UCSZ00 1
+#define UCSZ01 2
+#define USBS0 3
+#define UPM00 4
+#define UPM01 5
+#define UMSEL00 6
+#define UMSEL01 7
+
+/* Minnesstorlekar: */
+#define RAMEND 0x8FF
+#define FLASHEND 0x7FFF
+
+#endif /* HOST_AVR_IO_H_ */
\ No newline at end of file
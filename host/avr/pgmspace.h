@@ -0,0 +1,28 @@
+/********************************************************************************
+* pgmspace.h: Erstter avr-libc:s <avr/pgmspace.h> vid kompilering fr
+*             vrddatorn, dr programminnet och arbetsminnet r samma
+*             adressrymd. Data placerad via PROGMEM lses drmed direkt.
+********************************************************************************/
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
\ No newline at end of file
@@ -0,0 +1,29 @@
+/********************************************************************************
+* sleep.h: Erstter avr-libc:s <avr/sleep.h> vid kompilering fr
+*          vrddatorn. Instruktionen SLEEP genomfrs av simulatorn (se
+*          host/sim.h), som lter tiden g tills ett avbrott vcker
+*          processorn i valt vilolge.
+********************************************************************************/
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+/* Inkluderingsdirektiv: */
+#include <avr/io.h>
+
+/* Makrodefinitioner: */
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE ((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY ((1 << SM1) | (1 << SM2))
+#define SLEEP_MODE_EXT_STANDBY ((1 << SM0) | (1 << SM1) | (1 << SM2))
+
+#define set_sleep_mode(mode) \
+   (SMCR = (uint8_t)((SMCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode)))
+#define sleep_enable() (SMCR |= (1 << SE))
+#define sleep_disable() (SMCR &= (uint8_t)~(1 << SE))
+#define sleep_cpu() sim_sleep()
+#define sleep_mode() do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+#define sleep_bod_disable()
+
+#endif /* HOST_AVR_SLEEP_H_ */
\ No newline at end of file
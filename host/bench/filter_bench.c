@@ -0,0 +1,272 @@
+/********************************************************************************
+* filter_bench.c: Mter arbetet per vrde fr samtliga filter i filter.h med
+*                 samtliga tilltna parametrar, vilket r det arbete som
+*                 avbrottsrutinen fr AD-omvandlaren utfr fr varje lagrat
+*                 resultat nr kanalen filtreras.
+*
+*                 Varje filter matas med brusiga vrden kring mitten av
+*                 AD-omvandlarens omrde, dr utsignalen fr glidande
+*                 medelvrde och median jmfrs med en referens berknad
+*                 utifrn de senaste insignalerna.
+*
+*                 Fr varje filter skrivs vrddatorns tid per vrde ut,
+*                 liksom en uppskattning av antalet klockcykler p AVR.
+*                 Uppskattningen bygger p antalet operationer per vrde:
+*                 skiftsteg fr 32-bitarstal, vilket r en slinga p AVR
+*                 som saknar skiftning flera steg, samt fr median antalet
+*                 vrden och flyttar i insttningssorteringen. Antalet
+*                 flyttar r lika med antalet par i fnstret som ligger i
+*                 fel ordning, vilket rknas ut efter varje vrde. Hgsta
+*                 antalet r n * (n - 1) / 2 fr n vrden. Klockcyklerna
+*                 per operation r uppskattade utifrn instruktionerna och
+*                 inte uppmtta.
+*
+*                 Fr varje filter skrivs ven en uppskattning av andelen
+*                 av processortiden i vrsta fall ut, vid hgsta
+*                 samplingsfrekvens som AD-omvandlaren tillter fr
+*                 filtret, dvs. ADC_MEDIAN_MAX_HZ fr median av fler n
+*                 ADC_MEDIAN_FAST_MAX vrden och annars ADC_TRIGGER_HZ_MAX.
+*                 Andelen bygger p de uppskattade klockcyklerna och
+*                 kontrolleras drfr inte. Mtningen misslyckas enbart vid
+*                 avvikande utsignal.
+********************************************************************************/
+#include "adc.h"
+#include "filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Makrodefinitioner: */
+#define FILTER_BENCH_VALUES 4096    /* Antal pseudoslumpade insignaler. */
+#define FILTER_BENCH_ROUNDS 200     /* Antal varv ver samtliga insignaler per tidmtning. */
+#define FILTER_BENCH_REPEATS 5      /* Antal upprepningar, dr kortaste tiden anvnds. */
+#define FILTER_BENCH_NOISE 32       /* Brusets bredd i steg kring mitten. */
+
+#define FILTER_BENCH_AVR_CALL_CYCLES 24   /* Anrop, prolog, epilog samt val av filter. */
+#define FILTER_BENCH_AVR_WINDOW_CYCLES 24 /* ldsta vrdet, nytt vrde samt index i fnstret. */
+#define FILTER_BENCH_AVR_SUM_CYCLES 28    /* Lsning och lagring av summan, tv 32-bitarsoperationer samt avrundning. */
+#define FILTER_BENCH_AVR_BIT_CYCLES 6     /* Skiftning av ett 32-bitarstal ett steg, inklusive slinga. */
+#define FILTER_BENCH_AVR_SORT_CYCLES 24   /* Anrop av filter_get_median samt hmtning av medianen. */
+#define FILTER_BENCH_AVR_ITEM_CYCLES 14   /* Per vrde i insttningssorteringen. */
+#define FILTER_BENCH_AVR_MOVE_CYCLES 16   /* Per flytt i insttningssorteringen. */
+
+/********************************************************************************
+* filter_case: Strukt fr ett filter med parameter som mts.
+********************************************************************************/
+struct filter_case
+{
+   enum filter_type type; /* Valt filter. */
+   uint8_t parameter;     /* Antal vrden eller skiftning (EMA). */
+   const char* name;      /* Filtrets namn i utskriften. */
+};
+
+/* Statiska variabler: */
+static const struct filter_case cases[] =
+{
+   { FILTER_NONE, 0, "ingen" },
+   { FILTER_MOVING_AVERAGE, 2, "medelvarde 2" },
+   { FILTER_MOVING_AVERAGE, 4, "medelvarde 4" },
+   { FILTER_MOVING_AVERAGE, 8, "medelvarde 8" },
+   { FILTER_EMA, 1, "EMA skift 1" },
+   { FILTER_EMA, 4, "EMA skift 4" },
+   { FILTER_EMA, 8, "EMA skift 8" },
+   { FILTER_MEDIAN, 3, "median 3" },
+   { FILTER_MEDIAN, 5, "median 5" },
+   { FILTER_MEDIAN, 7, "median 7" }
+};
+static uint16_t values[FILTER_BENCH_VALUES];
+
+/********************************************************************************
+* compare_u16: Jmfrelsefunktion fr qsort.
+********************************************************************************/
+static int compare_u16(const void* a,
+                       const void* b)
+{
+   return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+/********************************************************************************
+* reference: Returnerar frvntad utsignal fr glidande medelvrde samt
+*            median utifrn de senaste insignalerna, dr insignaler fre
+*            den frsta erstts av den frsta.
+*
+*            - c    : Filtret.
+*            - index: Index fr senaste insignalen.
+********************************************************************************/
+static uint16_t reference(const struct filter_case* c,
+                          const uint32_t index)
+{
+   uint16_t window[FILTER_WINDOW_SIZE];
+   uint32_t sum = 0;
+
+   for (uint8_t i = 0; i < c->parameter; ++i)
+   {
+      window[i] = index >= i ? values[index - i] : values[0];
+      sum += window[i];
+   }
+
+   if (c->type == FILTER_MEDIAN)
+   {
+      qsort(window, c->parameter, sizeof(window[0]), compare_u16);
+      return window[c->parameter / 2];
+   }
+   return (uint16_t)((sum + c->parameter / 2) / c->parameter);
+}
+
+/********************************************************************************
+* moves: Returnerar antalet flyttar vid insttningssortering av fnstret i
+*        angivet filter, dvs. antalet par som ligger i fel ordning.
+*
+*        - filter: Pekare till filtret.
+********************************************************************************/
+static uint32_t moves(const struct filter* filter)
+{
+   uint32_t count = 0;
+
+   for (uint8_t i = 1; i < filter->length; ++i)
+   {
+      for (uint8_t k = 0; k < i; ++k)
+      {
+         if (filter->window[k] > filter->window[i]) count++;
+      }
+   }
+   return count;
+}
+
+/********************************************************************************
+* avr_cycles: Returnerar uppskattat antal klockcykler p AVR fr ett vrde
+*             genom angivet filter med angivet antal flyttar (median).
+*
+*             - c         : Filtret.
+*             - move_count: Antal flyttar i insttningssorteringen.
+********************************************************************************/
+static double avr_cycles(const struct filter_case* c,
+                         const double move_count)
+{
+   double cycles = FILTER_BENCH_AVR_CALL_CYCLES;
+
+   if (c->type == FILTER_MOVING_AVERAGE)
+   {
+      uint8_t shift = 0;
+      while ((1 << shift) < c->parameter) shift++;
+      cycles += FILTER_BENCH_AVR_WINDOW_CYCLES + FILTER_BENCH_AVR_SUM_CYCLES +
+                shift * FILTER_BENCH_AVR_BIT_CYCLES;
+   }
+   else if (c->type == FILTER_EMA)
+   {
+      cycles += FILTER_BENCH_AVR_SUM_CYCLES + 2 * c->parameter * FILTER_BENCH_AVR_BIT_CYCLES;
+   }
+   else if (c->type == FILTER_MEDIAN)
+   {
+      cycles += FILTER_BENCH_AVR_WINDOW_CYCLES + FILTER_BENCH_AVR_SORT_CYCLES +
+                c->parameter * FILTER_BENCH_AVR_ITEM_CYCLES + move_count * FILTER_BENCH_AVR_MOVE_CYCLES;
+   }
+   return cycles;
+}
+
+/********************************************************************************
+* elapsed_ns: Returnerar tiden i nanosekunder sedan angiven tidpunkt.
+*
+*             - start: Starttidpunkten.
+********************************************************************************/
+static double elapsed_ns(const struct timespec* start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/********************************************************************************
+* time_filter: Returnerar kortaste vrddatortiden per vrde fr angivet
+*              filter.
+*
+*              - c: Filtret.
+********************************************************************************/
+static double time_filter(const struct filter_case* c)
+{
+   struct filter filter;
+   double best = 0;
+
+   for (uint8_t r = 0; r < FILTER_BENCH_REPEATS; ++r)
+   {
+      volatile uint16_t sink = 0;
+      struct timespec start;
+      (void)filter_init(&filter, c->type, c->parameter);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+
+      for (uint32_t j = 0; j < FILTER_BENCH_ROUNDS; ++j)
+      {
+         for (uint32_t i = 0; i < FILTER_BENCH_VALUES; ++i)
+         {
+            sink ^= filter_put(&filter, values[i]);
+         }
+      }
+
+      const double ns = elapsed_ns(&start) / ((double)FILTER_BENCH_ROUNDS * FILTER_BENCH_VALUES);
+      if (r == 0 || ns < best) best = ns;
+      (void)sink;
+   }
+   return best;
+}
+
+/********************************************************************************
+* main: Genomfr mtningen och skriver ut resultatet.
+********************************************************************************/
+int main(void)
+{
+   uint32_t state = 12345;
+   uint32_t failures = 0;
+
+   for (uint32_t i = 0; i < FILTER_BENCH_VALUES; ++i)
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      values[i] = (ADC_RAW_MAX + 1) / 2 - FILTER_BENCH_NOISE / 2 + state % FILTER_BENCH_NOISE;
+   }
+
+   printf("Filter         varddatorn   AVR medel   AVR hogst   hogsta frekvens   andel (uppsk.)\n");
+
+   for (uint8_t n = 0; n < sizeof(cases) / sizeof(cases[0]); ++n)
+   {
+      const struct filter_case* c = &cases[n];
+      struct filter filter;
+      uint64_t move_sum = 0;
+      uint32_t mismatches = 0;
+
+      if (filter_init(&filter, c->type, c->parameter))
+      {
+         fprintf(stderr, "%s: ogiltig parameter\n", c->name);
+         failures++;
+         continue;
+      }
+
+      for (uint32_t i = 0; i < FILTER_BENCH_VALUES; ++i)
+      {
+         const uint16_t output = filter_put(&filter, values[i]);
+         if (c->type == FILTER_MEDIAN) move_sum += moves(&filter);
+
+         if (c->type == FILTER_NONE || c->type == FILTER_EMA) continue;
+         if (output != reference(c, i)) mismatches++;
+      }
+
+      const double worst_moves = c->type == FILTER_MEDIAN ? c->parameter * (c->parameter - 1) / 2.0 : 0;
+      const double average = avr_cycles(c, (double)move_sum / FILTER_BENCH_VALUES);
+      const double worst = avr_cycles(c, worst_moves);
+      const uint16_t rate_hz = c->type == FILTER_MEDIAN && c->parameter > ADC_MEDIAN_FAST_MAX ?
+                               ADC_MEDIAN_MAX_HZ : ADC_TRIGGER_HZ_MAX;
+      const double load = 100.0 * worst * rate_hz / F_CPU;
+
+      printf("%-14s %7.1f ns   %9.0f   %9.0f   %10u Hz   %4.1f %%\n",
+             c->name, time_filter(c), average, worst, rate_hz, load);
+
+      if (mismatches)
+      {
+         fprintf(stderr, "%s: %lu avvikande utsignaler\n", c->name, (unsigned long)mismatches);
+         failures++;
+      }
+   }
+
+   printf("AVR-klockcyklerna och andelen ar uppskattade utifran antalet operationer, ej uppmatta.\n");
+   return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+/********************************************************************************
+* format_bench.c: Jmfr formatering av heltal fre och efter de egna
+*                 formaterarna i serial.c utan sprintf.
+*
+*                 Fre: Talet skrevs med sprintf till en buffert p stacken,
+*                 som sedan skrevs ut via serial_print_string.
+*
+*                 Efter: serial_print_integer skriver siffrorna direkt till
+*                 sndbufferten, dr varje siffra berknas via subtraktion
+*                 av tiopotenser. Algoritmen terges nedan med en buffert
+*                 som destination i stllet fr sndbufferten, eftersom
+*                 klggningen via serial_print_char (registertkomster i
+*                 simulatorn) annars dominerar tiden och r densamma fr
+*                 bda varianterna.
+*
+*                 Frst kontrolleras att bda varianterna ger samma text fr
+*                 samtliga tal, liksom att serial_print_integer ger samma
+*                 text via simulatorns USART fr ett urval. Drefter skrivs
+*                 vrddatorns tid per tal ut, liksom antalet operationer per
+*                 tal efter ndringen: en tiopotens ur programminnet per
+*                 siffra samt en subtraktion per enhet i varje siffra utom
+*                 entalet, utan division. P AVR saknas hrdvarudivision,
+*                 varfr vfprintf dr r betydligt dyrare i frhllande till
+*                 subtraktionerna n p vrddatorn, dr sprintf kan vara
+*                 snabbare. Utifrn antalet operationer skrivs en
+*                 uppskattning av antalet klockcykler p AVR ut, baserad p
+*                 instruktionerna i en iteration (32-bitars jmfrelse,
+*                 subtraktion och hopp) respektive per siffra (fyra LPM fr
+*                 tiopotensen, avslutande jmfrelse samt hantering av
+*                 inledande nollor). Uppskattningen r inte uppmtt och
+*                 exkluderar klggningen. Mtningen misslyckas vid
+*                 avvikande text. Samtliga formaterare kontrolleras
+*                 dessutom av host/tests/serial_format_test.
+********************************************************************************/
+#include "serial.h"
+#include "sim.h"
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Makrodefinitioner: */
+#define FORMAT_BENCH_VALUES 4096 /* Antal pseudoslumpade tal. */
+#define FORMAT_BENCH_ROUNDS 200  /* Antal varv ver samtliga tal per mtning. */
+#define FORMAT_BENCH_REPEATS 5   /* Antal upprepningar, dr kortaste tiden anvnds. */
+#define FORMAT_BENCH_SERIAL 256  /* Antal tal som kontrolleras via USART. */
+#define FORMAT_BENCH_TEXT_MAX 20 /* Buffertens storlek i originalet. */
+#define FORMAT_BENCH_POSITIONS 9 /* Antal tiopotenser som prvas per tal. */
+#define FORMAT_BENCH_AVR_SUBTRACT_CYCLES 12 /* Uppskattade klockcykler per subtraktion. */
+#define FORMAT_BENCH_AVR_POSITION_CYCLES 27 /* Uppskattade klockcykler per tiopotens. */
+
+/* Statiska variabler: */
+static const uint32_t powers_of_ten[] =
+{
+   1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10
+};
+static int32_t values[FORMAT_BENCH_VALUES];
+
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+/********************************************************************************
+* baseline_format: Den ursprungliga formateringen via sprintf.
+*
+*                  - number: Heltalet som ska formateras.
+*                  - s     : Destinationen (FORMAT_BENCH_TEXT_MAX byte).
+********************************************************************************/
+static __attribute__((noinline)) void baseline_format(const int32_t number,
+                                                      char* s)
+{
+   sprintf(s, "%ld", (long)number);
+   return;
+}
+
+/********************************************************************************
+* digits_format: Formatering motsvarande serial_print_fixed samt
+*                serial_print_digits i serial.c utan decimaler.
+*
+*                - number: Heltalet som ska formateras.
+*                - s     : Destinationen (FORMAT_BENCH_TEXT_MAX byte).
+********************************************************************************/
+static __attribute__((noinline)) void digits_format(const int32_t number,
+                                                    char* s)
+{
+   uint32_t magnitude = number < 0 ? 0UL - (uint32_t)number : (uint32_t)number;
+   bool leading_zero = true;
+
+   if (number < 0) *s++ = '-';
+
+   for (uint8_t i = 0; i < sizeof(powers_of_ten) / sizeof(powers_of_ten[0]); ++i)
+   {
+      const uint32_t power = powers_of_ten[i];
+      char digit = '0';
+
+      while (magnitude >= power)
+      {
+         magnitude -= power;
+         digit++;
+      }
+
+      if (digit != '0') leading_zero = false;
+      if (!leading_zero) *s++ = digit;
+   }
+
+   *s++ = '0' + (char)magnitude;
+   *s = '\0';
+   return;
+}
+
+/********************************************************************************
+* elapsed_ns: Returnerar tiden i nanosekunder sedan angiven tidpunkt.
+*
+*             - start: Starttidpunkten.
+********************************************************************************/
+static double elapsed_ns(const struct timespec* start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/********************************************************************************
+* time_format: Returnerar kortaste vrddatortiden per tal fr angiven
+*              formatering.
+*
+*              - format: Formateringen som ska mtas.
+********************************************************************************/
+static double time_format(void (*format)(const int32_t, char*))
+{
+   double best = 0;
+
+   for (uint8_t r = 0; r < FORMAT_BENCH_REPEATS; ++r)
+   {
+      volatile char sink = 0;
+      char s[FORMAT_BENCH_TEXT_MAX];
+      struct timespec start;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+
+      for (uint32_t j = 0; j < FORMAT_BENCH_ROUNDS; ++j)
+      {
+         for (uint32_t i = 0; i < FORMAT_BENCH_VALUES; ++i)
+         {
+            format(values[i], s);
+            sink ^= s[0];
+         }
+      }
+
+      const double ns = elapsed_ns(&start) / ((double)FORMAT_BENCH_ROUNDS * FORMAT_BENCH_VALUES);
+      if (r == 0 || ns < best) best = ns;
+      (void)sink;
+   }
+   return best;
+}
+
+/********************************************************************************
+* check_serial: Kontrollerar att serial_print_integer skriver ut samma text
+*               som sprintf fr de frsta talen. Returnerar antalet
+*               avvikelser.
+********************************************************************************/
+static uint32_t check_serial(void)
+{
+   uint32_t mismatches = 0;
+   const uint32_t frame = sim_usart_frame_cycles();
+   char expected[FORMAT_BENCH_TEXT_MAX], actual[FORMAT_BENCH_TEXT_MAX];
+
+   sim_run(2 * frame);
+   (void)sim_usart_take(actual, sizeof(actual));
+
+   for (uint32_t i = 0; i < FORMAT_BENCH_SERIAL; ++i)
+   {
+      baseline_format(values[i], expected);
+      serial_print_integer(values[i]);
+      while (serial_transmit_pending()) sim_run(frame);
+      sim_run(2 * frame);
+
+      const size_t length = sim_usart_take(actual, sizeof(actual) - 1);
+      actual[length] = '\0';
+      if (strcmp(expected, actual)) mismatches++;
+   }
+   return mismatches;
+}
+
+/********************************************************************************
+* main: Genomfr jmfrelsen och skriver ut resultatet.
+********************************************************************************/
+int main(void)
+{
+   uint32_t state = 12345;
+   uint32_t mismatches = 0;
+   uint64_t subtractions = 0, digits = 0;
+
+   for (uint32_t i = 0; i < FORMAT_BENCH_VALUES; ++i)
+   {
+      char before[FORMAT_BENCH_TEXT_MAX], after[FORMAT_BENCH_TEXT_MAX];
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      /* Blandade storlekar, frn ental till tio siffror: */
+      values[i] = (int32_t)state >> (i % 31);
+
+      baseline_format(values[i], before);
+      digits_format(values[i], after);
+      if (strcmp(before, after)) mismatches++;
+
+      uint32_t magnitude = values[i] < 0 ? 0UL - (uint32_t)values[i] : (uint32_t)values[i];
+      digits++;
+
+      while (magnitude /= 10)
+      {
+         subtractions += magnitude % 10;
+         digits++;
+      }
+   }
+
+   sim_reset();
+   serial_init(1000000);
+   sei();
+   mismatches += check_serial();
+
+   const double before_ns = time_format(baseline_format);
+   const double after_ns = time_format(digits_format);
+
+   printf("Varddatorn, tid per heltal: sprintf %.1f ns, subtraktion %.1f ns\n",
+          before_ns, after_ns);
+   const double subtractions_per_value = (double)subtractions / FORMAT_BENCH_VALUES;
+
+   printf("Efter, per heltal: %.1f siffror, %.1f subtraktioner, ingen division\n",
+          (double)digits / FORMAT_BENCH_VALUES, subtractions_per_value);
+   printf("Uppskattning AVR (efter, ej uppmatt): %.0f klockcykler per heltal exkl. koplacering\n",
+          FORMAT_BENCH_POSITIONS * FORMAT_BENCH_AVR_POSITION_CYCLES +
+          subtractions_per_value * FORMAT_BENCH_AVR_SUBTRACT_CYCLES);
+
+   if (mismatches)
+   {
+      fprintf(stderr, "%lu tal skiljer sig at\n", (unsigned long)mismatches);
+      return 1;
+   }
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+/********************************************************************************
+* frame_bench.c: Jmfr verfring av temperaturmtningar som lsbar text via
+*                tmp36_print_temperature med binra ramar via
+*                tmp36_send_temperature, i 9600 samt 115200 bps.
+*
+*                FRAME_BENCH_SAMPLES mtningar skickas s fort som mjligt i
+*                respektive format, dr sndbufferten vntar p ledig plats.
+*                Simulerad tid frn frsta mtningen till att sista tecknet
+*                har skickats ger antalet mtningar per sekund, vilket ven
+*                inkluderar AD-omvandlingen fr varje mtning. Samtliga
+*                ramar avkodas med strmparsern i host/tools och samtliga
+*                rader kontrolleras mot frvntad text. Mtningen misslyckas
+*                om ngon mtning gr frlorad eller om ramarna inte r
+*                minst FRAME_BENCH_MIN_RATIO gnger mindre n texten.
+********************************************************************************/
+#include "frame_parser.h"
+#include "sim.h"
+#include "tmp36.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define FRAME_BENCH_SAMPLES 50      /* Antal mtningar per format och baud rate. */
+#define FRAME_BENCH_ADC_VALUE 150   /* Simulerat rvrde frn temperatursensorn. */
+#define FRAME_BENCH_MIN_RATIO 5     /* Lgsta kvot mellan byte per mtning som text och ram. */
+#define FRAME_BENCH_UBRR_115200 8   /* UBRR0 fr 115200 bps vid 16 MHz. */
+#define FRAME_BENCH_STREAM_MAX 8192 /* Hgsta antal mottagna byte per mtning. */
+
+/********************************************************************************
+* frame_count: Strukt fr kontroll av avkodade ramar.
+********************************************************************************/
+struct frame_count
+{
+   int16_t expected; /* Frvntad temperatur i hundradels grader. */
+   uint32_t matched; /* Antal ramar med frvntad temperatur. */
+};
+
+/* Statiska variabler: */
+static uint8_t stream[FRAME_BENCH_STREAM_MAX];
+static uint32_t failures = 0;
+
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+/********************************************************************************
+* count_frame: Rknar mottagna temperaturramar med frvntad temperatur.
+*
+*              - frame  : Pekare till ramen.
+*              - context: Pekare till rknaren.
+********************************************************************************/
+static void count_frame(const struct frame* frame,
+                        void* context)
+{
+   struct frame_count* count = context;
+
+   if (frame->type == SERIAL_FRAME_TEMPERATURE && frame->length == 2 &&
+       (int16_t)(frame->payload[0] | frame->payload[1] << 8) == count->expected)
+   {
+      count->matched++;
+   }
+   return;
+}
+
+/********************************************************************************
+* drain: Kr simulatorn tills samtliga tecken har skickats och flyttar dessa
+*        till strmmen. Antalet tecken returneras.
+********************************************************************************/
+static size_t drain(void)
+{
+   const uint32_t frame = sim_usart_frame_cycles();
+   while (serial_transmit_pending()) sim_run(frame);
+   sim_run(2 * frame);
+   return sim_usart_take(stream, sizeof(stream));
+}
+
+/********************************************************************************
+* count_lines: Returnerar antalet frekomster av angiven rad i strmmen.
+*
+*              - length: Antalet byte i strmmen.
+*              - line  : Frvntad rad.
+********************************************************************************/
+static uint32_t count_lines(const size_t length,
+                            const char* line)
+{
+   const size_t line_length = strlen(line);
+   uint32_t count = 0;
+
+   for (size_t i = 0; i + line_length <= length; )
+   {
+      if (!memcmp(stream + i, line, line_length))
+      {
+         count++;
+         i += line_length;
+      }
+      else
+      {
+         i++;
+      }
+   }
+   return count;
+}
+
+/********************************************************************************
+* run: Skickar FRAME_BENCH_SAMPLES mtningar i angivet format, kontrollerar
+*      utfallet och skriver ut resultatet. Antalet byte per mtning returneras.
+*
+*      - sensor: Pekare till temperatursensorn.
+*      - baud  : Aktuell baud rate, fr utskrift.
+*      - binary: Indikerar ifall binra ramar ska skickas.
+********************************************************************************/
+static double run(const struct tmp36* sensor,
+                  const uint32_t baud,
+                  const bool binary)
+{
+   const int16_t centi = tmp36_get_temperature_centi(sensor);
+   (void)drain();
+
+   const uint64_t start = sim_cycles();
+
+   for (uint32_t i = 0; i < FRAME_BENCH_SAMPLES; ++i)
+   {
+      if (binary) tmp36_send_temperature(sensor);
+      else tmp36_print_temperature(sensor);
+   }
+
+   const size_t length = drain();
+   const double seconds = (double)(sim_cycles() - start) / F_CPU;
+   uint32_t received;
+
+   if (binary)
+   {
+      struct frame_count count = { centi, 0 };
+      struct frame_parser parser;
+      frame_parser_init(&parser, count_frame, &count);
+      for (size_t i = 0; i < length; ++i) frame_parser_feed(&parser, stream[i]);
+      received = count.matched;
+   }
+   else
+   {
+      char line[48];
+      snprintf(line, sizeof(line), "Temperature: %d.%02d degrees Celcius.\n\r",
+               centi / 100, centi % 100);
+      received = count_lines(length, line);
+   }
+
+   printf("%6lu bps, %-5s: %4.1f byte/matning, %7.1f matningar/s, %lu av %d mottagna\n",
+          (unsigned long)baud, binary ? "ram" : "text",
+          (double)length / FRAME_BENCH_SAMPLES, FRAME_BENCH_SAMPLES / seconds,
+          (unsigned long)received, FRAME_BENCH_SAMPLES);
+
+   if (received != FRAME_BENCH_SAMPLES) failures++;
+   return (double)length / FRAME_BENCH_SAMPLES;
+}
+
+/********************************************************************************
+* main: Genomfr mtningen i 9600 bps, som tmp36_init vljer, och drefter i
+*       115200 bps. Eftersom serial_init enbart initierar en gng stts UBRR0
+*       direkt fr 115200 bps, vilket ger en avvikelse p -3.5 % som
+*       simulatorn inte pverkas av.
+********************************************************************************/
+int main(void)
+{
+   struct tmp36 sensor;
+
+   sim_reset();
+   sim_adc_set_value(0, FRAME_BENCH_ADC_VALUE);
+   tmp36_init(&sensor, 0);
+   sei();
+
+   const double text_9600 = run(&sensor, 9600, false);
+   const double frame_9600 = run(&sensor, 9600, true);
+
+   UBRR0 = FRAME_BENCH_UBRR_115200;
+   const double text_115200 = run(&sensor, 115200, false);
+   const double frame_115200 = run(&sensor, 115200, true);
+
+   if (text_9600 < FRAME_BENCH_MIN_RATIO * frame_9600 ||
+       text_115200 < FRAME_BENCH_MIN_RATIO * frame_115200)
+   {
+      fprintf(stderr, "ramarna ar inte minst %d ganger mindre an texten\n", FRAME_BENCH_MIN_RATIO);
+      failures++;
+   }
+
+   if (failures)
+   {
+      fprintf(stderr, "frame_bench: %lu fel\n", (unsigned long)failures);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,145 @@
+/********************************************************************************
+* isr_bench.c: Mter avbrottsrutinernas kostnad nr hela programmet (main.c
+*              samt isr.c) krs i simulatorn med knapptryckningar och
+*              kommandon via USART. Fr varje avbrottsvektor skrivs antal
+*              avbrott, genomsnittligt samt hgsta antal klockcykler per
+*              avbrott, hgsta latens samt andel av processortiden ut.
+*
+*              Mtningen misslyckas (returvrde 1) om ngon avbrottsrutin
+*              verskrider ISR_BENCH_BUDGET_CYCLES eller om avbrottens
+*              sammanlagda andel av processortiden verskrider
+*              ISR_BENCH_LOAD_PERCENT, vilka stts via CMake.
+*
+*              Klockcyklerna avser simulatorns tid, dvs. registertkomster,
+*              hopp till och retur frn avbrottsrutinen samt vntan, men
+*              inte vanliga instruktioner. Vrdena utgr drmed en undre
+*              grns, som fngar blockerande vntan och ondiga
+*              registertkomster i avbrottsrutinerna.
+********************************************************************************/
+#include "sim.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#ifndef ISR_BENCH_BUDGET_CYCLES
+#define ISR_BENCH_BUDGET_CYCLES 400 /* Hgsta antal klockcykler per avbrott. */
+#endif
+
+#ifndef ISR_BENCH_LOAD_PERCENT
+#define ISR_BENCH_LOAD_PERCENT 5 /* Hgsta andel av processortiden fr avbrott. */
+#endif
+
+#define ISR_BENCH_DURATION_MS 6000 /* Mtningens lngd i millisekunder. */
+
+/* Programmets main-funktion (main.c kompileras med main=firmware_main): */
+int firmware_main(void);
+
+/********************************************************************************
+* stimulus: Strukt fr en knapptryckning eller ett kommando vid angiven tid.
+********************************************************************************/
+struct stimulus
+{
+   uint32_t time_ms;    /* Tidpunkt mtt i millisekunder. */
+   uint8_t button_pin;  /* Tryckknappens pin p I/O-port B, eller 0 fr kommando. */
+   bool pressed;        /* Indikerar nedtryckt tryckknapp. */
+   const char* command; /* Kommando som skickas via USART. */
+};
+
+/* Statiska variabler: */
+static const struct stimulus stimuli[] =
+{
+   { 500, 5, true, NULL },   { 550, 5, false, NULL },
+   { 1000, 3, true, NULL },  { 1050, 3, false, NULL },
+   { 1500, 0, false, "refresh 1000\r" },
+   { 2000, 0, false, "count up 10\r" },
+   { 2500, 4, true, NULL },  { 2550, 4, false, NULL },
+   { 3000, 0, false, "state\r" },
+   { 4000, 0, false, "number 0x2A\r" },
+   { 5000, 5, true, NULL },  { 5050, 5, false, NULL }
+};
+
+/********************************************************************************
+* apply_stimulus: Genomfr angiven knapptryckning eller skickar angivet
+*                 kommando. Tryckknapparna lses som nedtryckta vid hg niv.
+*
+*                 - context: Pekare till stimulit.
+********************************************************************************/
+static void apply_stimulus(void* context)
+{
+   const struct stimulus* s = (const struct stimulus*)context;
+
+   if (s->command)
+   {
+      sim_usart_inject(s->command, strlen(s->command));
+   }
+   else
+   {
+      sim_set_pin('B', s->button_pin, s->pressed);
+   }
+   return;
+}
+
+/********************************************************************************
+* main: Kr programmet med samtliga stimuli och skriver ut resultatet.
+********************************************************************************/
+int main(void)
+{
+   const uint64_t duration = SIM_CYCLES_FROM_MS(ISR_BENCH_DURATION_MS);
+   uint64_t total_cycles = 0;
+   int result = 0;
+
+   sim_reset();
+   sim_set_pin('B', 3, false);
+   sim_set_pin('B', 4, false);
+   sim_set_pin('B', 5, false);
+
+   for (size_t i = 0; i < sizeof(stimuli) / sizeof(stimuli[0]); ++i)
+   {
+      sim_at(SIM_CYCLES_FROM_MS(stimuli[i].time_ms), apply_stimulus, (void*)&stimuli[i]);
+   }
+
+   const uint64_t start = sim_cycles();
+   const enum sim_exit reason = sim_run_main(firmware_main, duration);
+   const uint64_t elapsed = sim_cycles() - start;
+   const struct sim_stats* stats = sim_get_stats();
+
+   printf("%-14s %8s %8s %8s %8s %7s\n", "ISR", "antal", "medel", "max", "latens", "last %");
+
+   for (uint8_t i = 1; i < SIM_VECTOR_COUNT; ++i)
+   {
+      const struct sim_isr_stats* isr = &stats->isr[i];
+      if (isr->count == 0) continue;
+      total_cycles += isr->cycles;
+
+      printf("%-14s %8lu %8.1f %8lu %8lu %7.3f\n", sim_vector_name((enum sim_vector)i),
+             (unsigned long)isr->count, (double)isr->cycles / isr->count,
+             (unsigned long)isr->worst_cycles, (unsigned long)isr->latency_max,
+             100.0 * (double)isr->cycles / (double)elapsed);
+
+      if (isr->worst_cycles > ISR_BENCH_BUDGET_CYCLES)
+      {
+         fprintf(stderr, "%s: %lu klockcykler overskrider budgeten %u\n",
+                 sim_vector_name((enum sim_vector)i), (unsigned long)isr->worst_cycles,
+                 ISR_BENCH_BUDGET_CYCLES);
+         result = 1;
+      }
+   }
+
+   const double load = 100.0 * (double)total_cycles / (double)elapsed;
+   printf("Total last: %.3f %% av %lu klockcykler (budget %u %%, %u klockcykler per avbrott)\n",
+          load, (unsigned long)elapsed, ISR_BENCH_LOAD_PERCENT, ISR_BENCH_BUDGET_CYCLES);
+
+   if (reason != SIM_EXIT_DEADLINE)
+   {
+      fprintf(stderr, "programmet avslutades i fortid (%d)\n", (int)reason);
+      result = 1;
+   }
+
+   if (load > ISR_BENCH_LOAD_PERCENT)
+   {
+      fprintf(stderr, "avbrottens last %.3f %% overskrider budgeten %u %%\n",
+              load, ISR_BENCH_LOAD_PERCENT);
+      result = 1;
+   }
+   return result;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+/********************************************************************************
+* isr_bench_avr.c: Mter avbrottsrutinernas kostnad i klockcykler nr
+*                  programmet, kompilerat med avr-gcc fr ATmega328P, krs i
+*                  simavr. Till skillnad frn isr_bench, som mter i
+*                  vrddatorns simulator, omfattar mtningen samtliga
+*                  instruktioner i avbrottsrutinerna, inklusive prolog och
+*                  epilog.
+*
+*                  Varje avbrottsvektors RUNNING-signal i simavr ettstlls
+*                  vid hopp till avbrottsrutinen och nollstlls vid RETI,
+*                  vilket ger antal klockcykler per avbrott. Stimuli och
+*                  budgetar fljer isr_bench.
+*
+*                  Byggs enbart om avr-gcc samt simavr hittas av CMake.
+*
+*                  Anvndning: isr_bench_avr <firmware.elf>
+********************************************************************************/
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_interrupts.h>
+#include <simavr/sim_irq.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#ifndef ISR_BENCH_BUDGET_CYCLES
+#define ISR_BENCH_BUDGET_CYCLES 400
+#endif
+
+#ifndef ISR_BENCH_LOAD_PERCENT
+#define ISR_BENCH_LOAD_PERCENT 5
+#endif
+
+#define ISR_BENCH_F_CPU 16000000UL /* Klockfrekvens. */
+#define ISR_BENCH_DURATION_MS 6000 /* Mtningens lngd i millisekunder. */
+#define ISR_BENCH_VECTORS 26       /* Antal avbrottsvektorer i ATmega328P. */
+#define ISR_BENCH_UART_CYCLES (10UL * 16 * 104) /* Klockcykler per tecken vid 9600 kbps. */
+
+/********************************************************************************
+* vector_stats: Strukt fr statistik ver en avbrottsvektor.
+********************************************************************************/
+struct vector_stats
+{
+   uint32_t count;      /* Antal genomfrda avbrottsrutiner. */
+   uint64_t cycles;     /* Sammanlagt antal klockcykler. */
+   uint32_t worst;      /* Hgsta antal klockcykler fr ett avbrott. */
+   avr_cycle_count_t entered; /* Tidpunkt fr hopp till avbrottsrutinen. */
+};
+
+/********************************************************************************
+* stimulus: Strukt fr en knapptryckning eller ett kommando vid angiven tid.
+********************************************************************************/
+struct stimulus
+{
+   uint32_t time_ms;    /* Tidpunkt mtt i millisekunder. */
+   uint8_t button_pin;  /* Tryckknappens pin p I/O-port B, eller 0 fr kommando. */
+   bool pressed;        /* Indikerar nedtryckt tryckknapp. */
+   const char* command; /* Kommando som skickas via USART. */
+};
+
+/* Statiska variabler: */
+static const struct stimulus stimuli[] =
+{
+   { 500, 5, true, NULL },   { 550, 5, false, NULL },
+   { 1000, 3, true, NULL },  { 1050, 3, false, NULL },
+   { 1500, 0, false, "refresh 1000\r" },
+   { 2000, 0, false, "count up 10\r" },
+   { 2500, 4, true, NULL },  { 2550, 4, false, NULL },
+   { 3000, 0, false, "state\r" },
+   { 4000, 0, false, "number 0x2A\r" },
+   { 5000, 5, true, NULL },  { 5050, 5, false, NULL }
+};
+
+static avr_t* avr = NULL;
+static struct vector_stats vectors[ISR_BENCH_VECTORS];
+
+/********************************************************************************
+* vector_running: Anropas av simavr nr en avbrottsrutin pbrjas (value 1)
+*                 eller avslutas via RETI (value 0).
+********************************************************************************/
+static void vector_running(struct avr_irq_t* irq,
+                           uint32_t value,
+                           void* param)
+{
+   struct vector_stats* v = (struct vector_stats*)param;
+   (void)irq;
+
+   if (value)
+   {
+      v->entered = avr->cycle;
+   }
+   else
+   {
+      const uint32_t cycles = (uint32_t)(avr->cycle - v->entered);
+      v->count++;
+      v->cycles += cycles;
+      if (cycles > v->worst) v->worst = cycles;
+   }
+   return;
+}
+
+/********************************************************************************
+* main: Laddar angiven ELF-fil, kr programmet med samtliga stimuli och
+*       skriver ut resultatet.
+********************************************************************************/
+int main(int argc, char** argv)
+{
+   elf_firmware_t firmware;
+   const avr_cycle_count_t duration = ISR_BENCH_F_CPU / 1000 * ISR_BENCH_DURATION_MS;
+   const size_t num_stimuli = sizeof(stimuli) / sizeof(stimuli[0]);
+   size_t next = 0;
+   const char* pending = NULL;
+   avr_cycle_count_t next_char = 0;
+   uint64_t total_cycles = 0;
+   int result = 0;
+
+   if (argc < 2 || elf_read_firmware(argv[1], &firmware))
+   {
+      fprintf(stderr, "anvandning: %s <firmware.elf>\n", argv[0]);
+      return 1;
+   }
+
+   avr = avr_make_mcu_by_name("atmega328p");
+   if (!avr) return 1;
+   avr_init(avr);
+   avr->frequency = ISR_BENCH_F_CPU;
+   avr_load_firmware(avr, &firmware);
+
+   for (uint8_t i = 1; i < ISR_BENCH_VECTORS; ++i)
+   {
+      avr_irq_t* irq = avr_get_interrupt_irq(avr, i);
+      if (irq) avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, vector_running, &vectors[i]);
+   }
+
+   avr_irq_t* uart = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+   for (uint8_t pin = 3; pin <= 5; ++pin)
+   {
+      avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), pin), 0);
+   }
+
+   while (avr->cycle < duration)
+   {
+      const int state = avr_run(avr);
+      if (state == cpu_Done || state == cpu_Crashed)
+      {
+         fprintf(stderr, "programmet avslutades i fortid (%d)\n", state);
+         return 1;
+      }
+
+      if (next < num_stimuli && avr->cycle >= ISR_BENCH_F_CPU / 1000 * stimuli[next].time_ms)
+      {
+         const struct stimulus* s = &stimuli[next++];
+         if (s->command) pending = s->command;
+         else avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), s->button_pin), s->pressed);
+      }
+
+      if (pending && *pending && avr->cycle >= next_char)
+      {
+         avr_raise_irq(uart, (uint8_t)*pending++);
+         next_char = avr->cycle + ISR_BENCH_UART_CYCLES;
+      }
+   }
+
+   printf("%-6s %8s %8s %8s %7s\n", "vektor", "antal", "medel", "max", "last %");
+
+   for (uint8_t i = 1; i < ISR_BENCH_VECTORS; ++i)
+   {
+      const struct vector_stats* v = &vectors[i];
+      if (v->count == 0) continue;
+      total_cycles += v->cycles;
+
+      printf("%-6u %8lu %8.1f %8lu %7.3f\n", i, (unsigned long)v->count,
+             (double)v->cycles / v->count, (unsigned long)v->worst,
+             100.0 * (double)v->cycles / (double)avr->cycle);
+
+      if (v->worst > ISR_BENCH_BUDGET_CYCLES)
+      {
+         fprintf(stderr, "vektor %u: %lu klockcykler overskrider budgeten %u\n",
+                 i, (unsigned long)v->worst, ISR_BENCH_BUDGET_CYCLES);
+         result = 1;
+      }
+   }
+
+   const double load = 100.0 * (double)total_cycles / (double)avr->cycle;
+   printf("Total last: %.3f %% (budget %u %%, %u klockcykler per avbrott)\n",
+          load, ISR_BENCH_LOAD_PERCENT, ISR_BENCH_BUDGET_CYCLES);
+
+   if (load > ISR_BENCH_LOAD_PERCENT)
+   {
+      fprintf(stderr, "avbrottens last %.3f %% overskrider budgeten %u %%\n",
+              load, ISR_BENCH_LOAD_PERCENT);
+      result = 1;
+   }
+
+   avr_terminate(avr);
+   return result;
+}
\ No newline at end of file
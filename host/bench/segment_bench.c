@@ -0,0 +1,227 @@
+/********************************************************************************
+* segment_bench.c: Jmfr multiplexeringen av 7-segmentsdisplayerna fre
+*                  och efter tabellstyrd binrkod med frdig framebuffer.
+*
+*                  Fre: Binrkoden fr aktuell siffra sktes fram via en
+*                  kedja av if-satser vid varje skifte i avbrottsrutinen,
+*                  dr siffran d krver d + 1 jmfrelser. Den ursprungliga
+*                  koden terges nedan som referens.
+*
+*                  Efter: display_toggle_digit skriver en frdig binrkod
+*                  ur framebuffern, som berknas nr talet eller talbasen
+*                  ndras, vilket inte krver ngon jmfrelse.
+*
+*                  Fr samtliga tal i talbas 10 och 16 kontrolleras frst
+*                  att utsignalerna r identiska. Drefter skrivs antalet
+*                  jmfrelser per skifte, simulerade klockcykler per skifte
+*                  (registertkomster, se host/sim.h) samt vrddatorns tid
+*                  per binrkod ut. Katoderna i display.c styrs via pekare
+*                  (led.c), vars tkomster simulatorn inte rknar, s
+*                  klockcyklerna efter ndringen r ngot underskattade.
+*                  Mtningen misslyckas vid avvikande utsignaler.
+********************************************************************************/
+#include "display.h"
+#include "sim.h"
+#include <stdio.h>
+#include <time.h>
+
+/* Makrodefinitioner frn den ursprungliga koden: */
+#define DISPLAY1_CATHODE PORTD7
+#define DISPLAY2_CATHODE PORTC3
+#define DISPLAY1_ON  PORTD &= ~(1 << DISPLAY1_CATHODE)
+#define DISPLAY2_ON  PORTC &= ~(1 << DISPLAY2_CATHODE)
+#define DISPLAY1_OFF PORTD |= (1 << DISPLAY1_CATHODE)
+#define DISPLAY2_OFF PORTC |= (1 << DISPLAY2_CATHODE)
+
+#define SEGMENT_BENCH_ITERATIONS 20000000UL /* Antal binrkoder vid tidmtning. */
+
+/* Statiska variabler: */
+static const uint8_t display_cathodes[] = { D7, C3 };
+static const uint8_t segment_table[16] =
+{
+   0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,
+   0x7F, 0x6F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71
+};
+
+/********************************************************************************
+* baseline_get_binary_code: Den ursprungliga kedjan av if-satser.
+*
+*                           - digit: Heltal vars binrkod ska returneras.
+********************************************************************************/
+static __attribute__((noinline)) uint8_t baseline_get_binary_code(const uint8_t digit)
+{
+   if (digit == 0)       return 0x3F;
+   else if (digit == 1)  return 0x06;
+   else if (digit == 2)  return 0x5B;
+   else if (digit == 3)  return 0x4F;
+   else if (digit == 4)  return 0x66;
+   else if (digit == 5)  return 0x6D;
+   else if (digit == 6)  return 0x7D;
+   else if (digit == 7)  return 0x07;
+   else if (digit == 8)  return 0x7F;
+   else if (digit == 9)  return 0x6F;
+   else if (digit == 10) return 0x77;
+   else if (digit == 11) return 0x7C;
+   else if (digit == 12) return 0x39;
+   else if (digit == 13) return 0x5E;
+   else if (digit == 14) return 0x79;
+   else if (digit == 15) return 0x71;
+   else                  return 0x00;
+}
+
+/********************************************************************************
+* table_get_binary_code: Tabellslagning motsvarande segment_codes i
+*                        display.c.
+*
+*                        - digit: Heltal 0 - 15 vars binrkod ska returneras.
+********************************************************************************/
+static __attribute__((noinline)) uint8_t table_get_binary_code(const uint8_t digit)
+{
+   return segment_table[digit & 0x0F];
+}
+
+/********************************************************************************
+* baseline_toggle_digit: Den ursprungliga skiftningen mellan displayerna
+*                        (utan mjukvarans rkning av avbrottsperioder).
+*
+*                        - digit1      : Tiotalet.
+*                        - digit2      : Entalet.
+*                        - first_digit: Indikerar ifall tiotalet ska tndas.
+********************************************************************************/
+static void baseline_toggle_digit(const uint8_t digit1,
+                                  const uint8_t digit2,
+                                  const bool first_digit)
+{
+   if (first_digit)
+   {
+      DISPLAY2_OFF;
+
+      if (digit1 == 0)
+      {
+         DISPLAY1_OFF;
+      }
+      else
+      {
+         PORTD &= (1 << DISPLAY1_CATHODE);
+         PORTD |= baseline_get_binary_code(digit1);
+         DISPLAY1_ON;
+      }
+   }
+   else
+   {
+      DISPLAY1_OFF;
+      PORTD &= (1 << DISPLAY1_CATHODE);
+      PORTD |= baseline_get_binary_code(digit2);
+      DISPLAY2_ON;
+   }
+   return;
+}
+
+/********************************************************************************
+* visible_segments: Returnerar segmenten som syns p angiven display, dvs.
+*                   segmentpinnarna om displayens katod r lg, annars 0.
+*
+*                   - first_digit: Indikerar tiotalets display.
+********************************************************************************/
+static uint8_t visible_segments(const bool first_digit)
+{
+   const bool lit = first_digit ? !sim_get_pin('D', 7) : !sim_get_pin('C', 3);
+   return lit ? (PORTD & 0x7F) : 0;
+}
+
+/********************************************************************************
+* elapsed_ns: Returnerar tiden i nanosekunder sedan angiven tidpunkt.
+*
+*             - start: Starttidpunkten.
+********************************************************************************/
+static double elapsed_ns(const struct timespec* start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/********************************************************************************
+* main: Genomfr jmfrelsen och skriver ut resultatet.
+********************************************************************************/
+int main(void)
+{
+   static const uint8_t radixes[] = { 10, 16 };
+   uint32_t mismatches = 0;
+
+   sim_reset();
+   display_init(display_cathodes, sizeof(display_cathodes));
+
+   printf("%-6s %12s %12s %14s %14s\n", "talbas", "jamf. fore", "jamf. efter",
+          "cykler fore", "cykler efter");
+
+   for (uint8_t r = 0; r < sizeof(radixes); ++r)
+   {
+      const uint8_t radix = radixes[r];
+      const uint32_t max = (uint32_t)radix * radix - 1;
+      uint64_t compares = 0, cycles_before = 0, cycles_after = 0, steps = 0;
+
+      display_set_radix(radix);
+
+      for (uint32_t n = 0; n <= max; ++n)
+      {
+         const uint8_t digit1 = (uint8_t)(n / radix);
+         const uint8_t digit2 = (uint8_t)(n % radix);
+         uint8_t before[2], after[2];
+
+         for (uint8_t i = 0; i < 2; ++i)
+         {
+            const uint64_t start = sim_cycles();
+            baseline_toggle_digit(digit1, digit2, i == 0);
+            cycles_before += sim_cycles() - start;
+            before[i] = visible_segments(i == 0);
+            if (i == 0 && digit1) compares += digit1 + 1;
+            if (i == 1) compares += digit2 + 1;
+         }
+
+         display_set_number(n);
+
+         for (uint8_t i = 0; i < 2; ++i)
+         {
+            const uint64_t start = sim_cycles();
+            display_toggle_digit();
+            cycles_after += sim_cycles() - start;
+            const bool first_digit = !sim_get_pin('D', 7);
+            after[first_digit ? 0 : 1] = visible_segments(first_digit);
+         }
+
+         if (before[0] != after[0] || before[1] != after[1])
+         {
+            fprintf(stderr, "talbas %u, tal %lu: fore %02X %02X, efter %02X %02X\n",
+                    radix, (unsigned long)n, before[0], before[1], after[0], after[1]);
+            mismatches++;
+         }
+         steps += 2;
+      }
+
+      printf("%-6u %12.2f %12.2f %14.2f %14.2f\n", radix, (double)compares / steps, 0.0,
+             (double)cycles_before / steps, (double)cycles_after / steps);
+   }
+
+   volatile uint8_t sink = 0;
+   struct timespec start;
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (uint32_t i = 0; i < SEGMENT_BENCH_ITERATIONS; ++i) sink ^= baseline_get_binary_code((uint8_t)(i & 0x0F));
+   const double chain_ns = elapsed_ns(&start) / SEGMENT_BENCH_ITERATIONS;
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (uint32_t i = 0; i < SEGMENT_BENCH_ITERATIONS; ++i) sink ^= table_get_binary_code((uint8_t)(i & 0x0F));
+   const double table_ns = elapsed_ns(&start) / SEGMENT_BENCH_ITERATIONS;
+   (void)sink;
+
+   printf("Varddatorn, tid per binarkod (siffra 0 - 15): if-kedja %.2f ns, tabell %.2f ns\n",
+          chain_ns, table_ns);
+
+   if (mismatches)
+   {
+      fprintf(stderr, "%lu tal skiljer sig at\n", (unsigned long)mismatches);
+      return 1;
+   }
+   return 0;
+}
\ No newline at end of file
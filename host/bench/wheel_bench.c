@@ -0,0 +1,185 @@
+/********************************************************************************
+* wheel_bench.c: Mter arbetet per anrop av timer_wheel_tick med 1, 8
+*                respektive 64 aktiva mjukvarutimers, jmfrt med att varje
+*                timer rknas upp och kontrolleras vid varje tick, ssom fr
+*                strukten timer.
+*
+*                Tv fall mts fr varje antal timers:
+*
+*                - Sllan: Periodiska timers med perioder mellan 1000 och
+*                  1063 ms, dr i genomsnitt hgst 0.064 timers lper ut per
+*                  tick.
+*
+*                - Varje tick: Periodiska timers med perioden 1 ms, dr
+*                  samtliga timers lper ut och lggs tillbaka varje tick.
+*
+*                Arbetet mts som antalet timers som timerhjulet gr igenom
+*                per tick, dvs. samtliga timers i aktuellt fack, varav
+*                vissa lper ut och vriga ligger kvar till ett senare varv.
+*                Antalet berknas fre varje tick utifrn tiden d varje
+*                aktiv timer lper ut, vilket ger exakt samma fack som
+*                timer_wheel_tick vljer. Jmfrelsen kontrollerar samtliga
+*                timers vid varje tick.
+*
+*                Vrddatorns tid anvnds inte, d varje tick lser och
+*                skriver SREG, vilket i simulatorn rknar fram samtliga
+*                kringkretsar och kostar ungefr en mikrosekund med stor
+*                variation, medan timerhjulets eget arbete r i storleken
+*                tiotals nanosekunder. Mtningen misslyckas om antalet
+*                anrop av timernas funktioner avviker frn frvntat antal,
+*                om timerhjulet i frsta fallet i genomsnitt gr igenom mer
+*                n 10 % fler timers per tick n antalet timers delat med
+*                TIMER_WHEEL_SLOTS, eller om timerhjulet i andra fallet gr
+*                igenom fler timers n som lper ut. Hgsta antalet under
+*                ett enskilt tick skrivs ocks ut, men begrnsas inte, d
+*                timers vars perioder skiljer sig med en multipel av
+*                TIMER_WHEEL_SLOTS ibland hamnar i samma fack.
+********************************************************************************/
+#include "sim.h"
+#include "timer.h"
+#include <stdio.h>
+
+/* Makrodefinitioner: */
+#define WHEEL_BENCH_TIMERS_MAX 64   /* Hgsta antal timers. */
+#define WHEEL_BENCH_TICKS 64000UL   /* Antal tick per mtning (multipel av 1000 ms). */
+#define WHEEL_BENCH_PERIOD_MS 1000  /* Kortaste period i fallet sllan. */
+#define WHEEL_BENCH_MARGIN 1.1      /* Tillten avvikelse frn jmn frdelning ver facken. */
+
+/********************************************************************************
+* wheel_result: Strukt fr resultatet av en mtning.
+********************************************************************************/
+struct wheel_result
+{
+   double visited; /* Genomsnittligt antal genomgngna timers per tick. */
+   double expired; /* Genomsnittligt antal utlpta timers per tick. */
+   uint32_t most;  /* Hgsta antal genomgngna timers under ett tick. */
+};
+
+/* Statiska variabler: */
+static struct timer_soft timers[WHEEL_BENCH_TIMERS_MAX];
+static uint32_t callbacks = 0;
+static uint32_t failures = 0;
+
+/********************************************************************************
+* timer_expired: Rknar anrop frn utlpta timers.
+********************************************************************************/
+static void timer_expired(void)
+{
+   callbacks++;
+   return;
+}
+
+/********************************************************************************
+* slot_size: Returnerar antalet aktiva timers i facket fr angivet tick.
+*
+*            - num_timers: Antalet timers.
+*            - tick      : Aktuellt tick.
+********************************************************************************/
+static uint32_t slot_size(const uint8_t num_timers,
+                          const uint32_t tick)
+{
+   uint32_t count = 0;
+
+   for (uint8_t i = 0; i < num_timers; ++i)
+   {
+      const struct timer_soft* t = &timers[i];
+      if (t->active && ((t->expires ^ tick) & (TIMER_WHEEL_SLOTS - 1)) == 0) count++;
+   }
+   return count;
+}
+
+/********************************************************************************
+* measure: Kr timerhjulet WHEEL_BENCH_TICKS tick med angivet antal periodiska
+*          timers och returnerar arbetet per tick. Antalet anrop kontrolleras
+*          mot frvntat antal.
+*
+*          - num_timers: Antalet timers.
+*          - base_ms   : Kortaste period, dr timer i har perioden
+*                        base_ms + i, eller 1 fr samtliga timers.
+********************************************************************************/
+static struct wheel_result measure(const uint8_t num_timers,
+                                   const uint32_t base_ms)
+{
+   struct wheel_result result = { 0, 0, 0 };
+   uint32_t expected = 0;
+   uint64_t visited = 0;
+
+   for (uint8_t i = 0; i < num_timers; ++i)
+   {
+      const uint32_t period = base_ms > 1 ? base_ms + i : 1;
+      timer_soft_start(&timers[i], period, true);
+      expected += WHEEL_BENCH_TICKS / period;
+   }
+
+   callbacks = 0;
+
+   for (uint32_t tick = 0; tick < WHEEL_BENCH_TICKS; ++tick)
+   {
+      const uint32_t count = slot_size(num_timers, timer_millis() + 1);
+      visited += count;
+      if (count > result.most) result.most = count;
+      timer_wheel_tick();
+   }
+
+   for (uint8_t i = 0; i < num_timers; ++i)
+   {
+      timer_soft_stop(&timers[i]);
+   }
+
+   if (callbacks != expected)
+   {
+      fprintf(stderr, "%u timers: %lu anrop, forvantat %lu\n", num_timers,
+              (unsigned long)callbacks, (unsigned long)expected);
+      failures++;
+   }
+
+   result.visited = (double)visited / WHEEL_BENCH_TICKS;
+   result.expired = (double)callbacks / WHEEL_BENCH_TICKS;
+   return result;
+}
+
+/********************************************************************************
+* main: Genomfr mtningen och skriver ut resultatet. Timerhjulet drivs genom
+*       att timer_wheel_tick anropas direkt, utan simulerade avbrott.
+********************************************************************************/
+int main(void)
+{
+   static const uint8_t counts[] = { 1, 8, 64 };
+
+   sim_reset();
+   timer_wheel_init(TIMER_SEL_2);
+
+   for (uint8_t i = 0; i < WHEEL_BENCH_TIMERS_MAX; ++i)
+   {
+      timer_soft_init(&timers[i], timer_expired);
+   }
+
+   printf("Timers per tick      sallan: genomgangna (hogst)  utlopta  jamforelse"
+          "   varje tick: genomgangna  utlopta  jamforelse\n");
+
+   for (uint8_t c = 0; c < sizeof(counts); ++c)
+   {
+      const uint8_t n = counts[c];
+      const struct wheel_result rare = measure(n, WHEEL_BENCH_PERIOD_MS);
+      const struct wheel_result every = measure(n, 1);
+      const double rare_limit = WHEEL_BENCH_MARGIN * n / TIMER_WHEEL_SLOTS;
+
+      printf("%2u aktiva timers            %8.3f (%2lu)      %7.3f  %10u              %8.3f  %7.3f  %10u\n",
+             n, rare.visited, (unsigned long)rare.most, rare.expired, n,
+             every.visited, every.expired, n);
+
+      if (rare.visited > rare_limit)
+      {
+         fprintf(stderr, "%u timers: %.3f genomgangna per tick, hogst %.3f forvantat\n",
+                 n, rare.visited, rare_limit);
+         failures++;
+      }
+
+      if (every.visited > every.expired)
+      {
+         fprintf(stderr, "%u timers: fler genomgangna an utlopta timers\n", n);
+         failures++;
+      }
+   }
+   return failures ? 1 : 0;
+}
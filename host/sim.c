@@ -0,0 +1,1794 @@
+/********************************************************************************
+* sim.c: Innehller funktionsdefinitioner fr den simulerade registerfilen
+*        samt modellerna av ATmega328P:s kringkretsar.
+********************************************************************************/
+#include "sim.h"
+#include <avr/io.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define SIM_MARKER 0xA5             /* Markr i den hga byten fr register med sidoeffekter. */
+#define SIM_INTERRUPT_CYCLES 4      /* Klockcykler fr hopp till samt retur frn avbrottsrutin. */
+#define SIM_WAKEUP_CYCLES 16384     /* Oscillatorns starttid (16K CK) efter djupt vilolge. */
+#define SIM_TIMED_SEQUENCE_CYCLES 4 /* Tid fr ndringssekvenser (EEMPE samt WDCE). */
+#define SIM_WDT_OSC_HZ 128000UL     /* Watchdog-timerns oscillator. */
+#define SIM_ASYNC_HZ 32768UL        /* Kristall fr asynkron Timer 2. */
+#define SIM_NOT_PENDING UINT64_MAX  /* Markerar avbrott som inte r vntande. */
+#define SIM_EVENTS_MAX 64           /* Hgsta antal schemalagda hndelser. */
+#define SIM_RX_QUEUE_SIZE 8192      /* Kapacitet fr kn med tecken som ska tas emot. */
+#define SIM_SLEEP_CYCLES_MAX (100 * (uint64_t)F_CPU) /* Vilolge utan vckningsklla (100 s). */
+
+#define SIM_EEPROM_MODE_MASK ((1 << EEPM1) | (1 << EEPM0))        /* Programmeringslge i EECR. */
+#define SIM_EEPROM_ERASE_WRITE_CYCLES SIM_CYCLES_FROM_US(3400) /* Radering och skrivning. */
+#define SIM_EEPROM_SINGLE_CYCLES SIM_CYCLES_FROM_US(1800)      /* Radering eller skrivning. */
+
+/********************************************************************************
+* sim_timer: Strukt fr registren som tillhr en timerkrets.
+********************************************************************************/
+struct sim_timer
+{
+   uint8_t tccra;  /* Kontrollregister A. */
+   uint8_t tccrb;  /* Kontrollregister B. */
+   uint8_t tifr;   /* Flaggregister. */
+   uint8_t timsk;  /* Avbrottsregister. */
+   bool wide;      /* Indikerar 16-bitars timerkrets (Timer 1). */
+   uint8_t prr;    /* Bit i PRR som stnger av timerkretsen. */
+   enum sim_vector vector_compa; /* Avbrottsvektor fr matchning mot OCRnA. */
+   enum sim_vector vector_compb; /* Avbrottsvektor fr matchning mot OCRnB. */
+   enum sim_vector vector_ovf;   /* Avbrottsvektor fr overflow. */
+};
+
+/********************************************************************************
+* sim_event: Strukt fr en schemalagd hndelse.
+********************************************************************************/
+struct sim_event
+{
+   uint64_t cycle;                  /* Tidpunkt fr hndelsen. */
+   void (*function)(void* context); /* Funktionen som ska anropas. */
+   void* context;                   /* Pekare som skickas till funktionen. */
+};
+
+/* Avbrottsrutiner, som saknas (NULL) om de inte har definierats via ISR: */
+#define SIM_WEAK __attribute__((weak))
+extern void INT0_vect(void) SIM_WEAK;
+extern void INT1_vect(void) SIM_WEAK;
+extern void PCINT0_vect(void) SIM_WEAK;
+extern void PCINT1_vect(void) SIM_WEAK;
+extern void PCINT2_vect(void) SIM_WEAK;
+extern void WDT_vect(void) SIM_WEAK;
+extern void TIMER2_COMPA_vect(void) SIM_WEAK;
+extern void TIMER2_COMPB_vect(void) SIM_WEAK;
+extern void TIMER2_OVF_vect(void) SIM_WEAK;
+extern void TIMER1_CAPT_vect(void) SIM_WEAK;
+extern void TIMER1_COMPA_vect(void) SIM_WEAK;
+extern void TIMER1_COMPB_vect(void) SIM_WEAK;
+extern void TIMER1_OVF_vect(void) SIM_WEAK;
+extern void TIMER0_COMPA_vect(void) SIM_WEAK;
+extern void TIMER0_COMPB_vect(void) SIM_WEAK;
+extern void TIMER0_OVF_vect(void) SIM_WEAK;
+extern void SPI_STC_vect(void) SIM_WEAK;
+extern void USART_RX_vect(void) SIM_WEAK;
+extern void USART_UDRE_vect(void) SIM_WEAK;
+extern void USART_TX_vect(void) SIM_WEAK;
+extern void ADC_vect(void) SIM_WEAK;
+extern void EE_READY_vect(void) SIM_WEAK;
+
+/* Statiska funktioner: */
+static void sim_fault(const char* format, ...);
+static void sim_init(void);
+static void sim_sync(void);
+static void sim_tick(uint64_t cycles);
+static void sim_advance(const uint32_t cycles);
+static void sim_dispatch(void);
+static void sim_interrupt(const enum sim_vector vector);
+static bool sim_vector_pending(const enum sim_vector vector);
+static bool sim_vector_wakes(const enum sim_vector vector,
+                             const uint8_t mode);
+static void sim_set_flag(const enum sim_strobe_id id,
+                         const uint8_t bit,
+                         const enum sim_vector vector);
+static void sim_write8(const enum sim_io8_id id,
+                       const uint8_t old_value,
+                       uint8_t value);
+static void sim_write16(const enum sim_io16_id id);
+static void sim_write_strobe(const enum sim_strobe_id id,
+                             const uint8_t value);
+static void sim_read_strobe(const enum sim_strobe_id id);
+static void sim_timer_advance(const uint8_t index,
+                              const uint32_t cycles);
+static void sim_eeprom_write_control(const uint8_t old_value,
+                                     uint8_t value);
+static void sim_eeprom_advance(void);
+static void sim_usart_write(const uint8_t data);
+static uint8_t sim_usart_read(void);
+static void sim_usart_advance(void);
+static void sim_adc_write_control(const uint8_t value);
+static void sim_adc_start(const uint8_t half_clocks);
+static void sim_adc_trigger(const uint8_t source);
+static void sim_adc_advance(void);
+static void sim_wdt_write_control(const uint8_t value);
+static void sim_wdt_advance(void);
+static void sim_pins_update(const uint8_t port);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - io8, io16, strobe: Registerfilen, vars adresser lmnas ut till
+*                        drivrutinerna.
+*   - shadow8, shadow16: Senast knda vrden, fr upptckt av skrivningar.
+*   - strobe_value     : Aktuellt vrde fr register med sidoeffekter.
+*   - strobe_prefill   : Vrdet som lmnades ut vid senaste tkomst.
+*   - strobe_armed     : Indikerar tkomst som nnu inte har behandlats.
+*   - now              : Antal klockcykler sedan terstllning.
+*   - initialized      : Indikerar ifall simulatorn har initierats.
+*   - asleep           : Indikerar ifall processorn r i vilolge.
+*   - sleep_mode       : Aktuellt vilolge (bitarna SM2:0 i SMCR).
+*   - pending_since    : Tidpunkt d respektive avbrott blev vntande, dvs.
+*                        flaggat och aktiverat, eller SIM_NOT_PENDING.
+*   - exit_env         : terhoppspunkt fr sim_run_main.
+*   - deadline         : Tidpunkt d sim_run_main avslutas.
+*   - stats            : Statistik.
+********************************************************************************/
+static volatile uint8_t io8[SIM_IO8_COUNT];
+static volatile uint16_t io16[SIM_IO16_COUNT];
+static volatile uint16_t strobe[SIM_STROBE_COUNT];
+static uint8_t shadow8[SIM_IO8_COUNT];
+static uint16_t shadow16[SIM_IO16_COUNT];
+static uint8_t strobe_value[SIM_STROBE_COUNT];
+static uint8_t strobe_prefill[SIM_STROBE_COUNT];
+static bool strobe_armed[SIM_STROBE_COUNT];
+static uint64_t now = 0;
+static bool initialized = false;
+static bool asleep = false;
+static uint8_t sleep_mode = 0;
+static uint64_t pending_since[SIM_VECTOR_COUNT];
+static jmp_buf* exit_env = NULL;
+static uint64_t deadline = 0;
+static struct sim_stats stats;
+
+/* Hndelser: */
+static struct sim_event events[SIM_EVENTS_MAX];
+static uint8_t num_events = 0;
+
+/* I/O-portar: */
+static const uint8_t pin_regs[3] = { SIM_PINB, SIM_PINC, SIM_PIND };
+static const uint8_t ddr_regs[3] = { SIM_DDRB, SIM_DDRC, SIM_DDRD };
+static const uint8_t port_regs[3] = { SIM_PORTB, SIM_PORTC, SIM_PORTD };
+static const uint8_t pcmsk_regs[3] = { SIM_PCMSK0, SIM_PCMSK1, SIM_PCMSK2 };
+static uint8_t pin_driven[3];
+static uint8_t pin_level[3];
+
+/* Timerkretsar: */
+static const struct sim_timer timers[3] =
+{
+   { SIM_TCCR0A, SIM_TCCR0B, SIM_TIFR0, SIM_TIMSK0, false, PRTIM0,
+     SIM_VECTOR_TIMER0_COMPA, SIM_VECTOR_TIMER0_COMPB, SIM_VECTOR_TIMER0_OVF },
+   { SIM_TCCR1A, SIM_TCCR1B, SIM_TIFR1, SIM_TIMSK1, true, PRTIM1,
+     SIM_VECTOR_TIMER1_COMPA, SIM_VECTOR_TIMER1_COMPB, SIM_VECTOR_TIMER1_OVF },
+   { SIM_TCCR2A, SIM_TCCR2B, SIM_TIFR2, SIM_TIMSK2, false, PRTIM2,
+     SIM_VECTOR_TIMER2_COMPA, SIM_VECTOR_TIMER2_COMPB, SIM_VECTOR_TIMER2_OVF }
+};
+
+static const uint16_t prescalers_sync[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16_t prescalers_async[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+/* EEPROM: */
+static uint8_t eeprom[SIM_EEPROM_SIZE];
+static uint32_t eeprom_erases[SIM_EEPROM_SIZE];
+static uint32_t eeprom_writes[SIM_EEPROM_SIZE];
+static bool eeprom_busy = false;
+static uint64_t eeprom_done = 0;
+static uint64_t eeprom_mpe_at = 0;
+static uint16_t eeprom_address = 0;
+static uint8_t eeprom_data = 0;
+static uint8_t eeprom_mode = 0;
+
+/* USART: */
+static bool tx_full = false;
+static uint8_t tx_data = 0;
+static bool tx_shifting = false;
+static uint8_t tx_shift = 0;
+static uint64_t tx_done = 0;
+static uint8_t tx_log[SIM_USART_LOG_SIZE];
+static size_t tx_log_head = 0;
+static size_t tx_log_count = 0;
+static uint8_t rx_fifo[2];
+static uint8_t rx_count = 0;
+static uint8_t rx_last = 0;
+static uint8_t rx_queue[SIM_RX_QUEUE_SIZE];
+static size_t rx_queue_head = 0;
+static size_t rx_queue_count = 0;
+static uint64_t rx_arrival = 0;
+
+/* AD-omvandlaren: */
+static sim_adc_source adc_sources[SIM_ADC_CHANNELS];
+static void* adc_contexts[SIM_ADC_CHANNELS];
+static uint16_t adc_values[SIM_ADC_CHANNELS];
+static bool adc_converting = false;
+static bool adc_first = false;
+static uint64_t adc_done = 0;
+static uint8_t adc_channel = 0;
+static uint16_t adc_result = 0;
+static uint8_t adc_last_channel = 0;
+
+/* Watchdog-timern: */
+static uint64_t wdt_start = 0;
+static bool wdt_change_enabled = false;
+static uint64_t wdt_change_at = 0;
+
+/* Namn p avbrottsvektorerna: */
+static const char* const vector_names[SIM_VECTOR_COUNT] =
+{
+   "RESET", "INT0", "INT1", "PCINT0", "PCINT1", "PCINT2", "WDT",
+   "TIMER2_COMPA", "TIMER2_COMPB", "TIMER2_OVF", "TIMER1_CAPT",
+   "TIMER1_COMPA", "TIMER1_COMPB", "TIMER1_OVF", "TIMER0_COMPA",
+   "TIMER0_COMPB", "TIMER0_OVF", "SPI_STC", "USART_RX", "USART_UDRE",
+   "USART_TX", "ADC", "EE_READY"
+};
+
+/********************************************************************************
+* sim_io8: Returnerar adressen till angivet 8-bitars register efter att
+*          tidigare skrivningar har behandlats och klockan har rknats fram.
+*
+*          - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint8_t* sim_io8(const enum sim_io8_id id)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   sim_tick(SIM_ACCESS_CYCLES);
+   return &io8[id];
+}
+
+/********************************************************************************
+* sim_io16: Returnerar adressen till angivet 16-bitars register efter att
+*           tidigare skrivningar har behandlats och klockan har rknats fram.
+*
+*           - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint16_t* sim_io16(const enum sim_io16_id id)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   sim_tick(SIM_ACCESS_CYCLES);
+   return &io16[id];
+}
+
+/********************************************************************************
+* sim_io_strobe: Returnerar adressen till angivet register med sidoeffekter
+*                vid skrivning. Aktuellt vrde lggs i den lga byten och
+*                markren i den hga byten, varefter tkomsten behandlas
+*                vid nsta anrop till simulatorn.
+*
+*                - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint16_t* sim_io_strobe(const enum sim_strobe_id id)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   sim_tick(SIM_ACCESS_CYCLES);
+
+   if (id == SIM_UDR0) strobe_value[id] = rx_count ? rx_fifo[0] : rx_last;
+   strobe_prefill[id] = strobe_value[id];
+   strobe[id] = (uint16_t)(SIM_MARKER << 8) | strobe_value[id];
+   strobe_armed[id] = true;
+   return &strobe[id];
+}
+
+/********************************************************************************
+* sim_cli: Inaktiverar avbrott globalt (cli).
+********************************************************************************/
+void sim_cli(void)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   io8[SIM_SREG] &= ~(1 << SREG_I);
+   shadow8[SIM_SREG] = io8[SIM_SREG];
+   sim_tick(1);
+   return;
+}
+
+/********************************************************************************
+* sim_sei: Aktiverar avbrott globalt (sei). Precis som i hrdvaran genomfrs
+*          vntande avbrott frst efter nsta instruktion, dvs. vid nsta
+*          anrop till simulatorn. Instruktionens klockcykel rknas fram
+*          fr samtliga kringkretsar, s att timerkretsarna inte slpar
+*          efter klockan.
+********************************************************************************/
+void sim_sei(void)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   io8[SIM_SREG] |= (1 << SREG_I);
+   shadow8[SIM_SREG] = io8[SIM_SREG];
+   sim_advance(1);
+   return;
+}
+
+/********************************************************************************
+* sim_asm: Genomfr angiven instruktion i inline-assembler.
+*
+*          - instruction: Instruktionen som text, exempelvis "WDR".
+********************************************************************************/
+void sim_asm(const char* instruction)
+{
+   if (!initialized) sim_init();
+
+   if (!strcmp(instruction, "WDR") || !strcmp(instruction, "wdr"))
+   {
+      sim_sync();
+      wdt_start = now;
+      sim_tick(1);
+   }
+   else if (!strcmp(instruction, "SLEEP") || !strcmp(instruction, "sleep"))
+   {
+      sim_sleep();
+   }
+   else if (!strcmp(instruction, "SEI") || !strcmp(instruction, "sei"))
+   {
+      sim_sei();
+   }
+   else if (!strcmp(instruction, "CLI") || !strcmp(instruction, "cli"))
+   {
+      sim_cli();
+   }
+   else if (!strcmp(instruction, "NOP") || !strcmp(instruction, "nop"))
+   {
+      sim_sync();
+      sim_tick(1);
+   }
+   else
+   {
+      sim_fault("instruktionen %s stods inte", instruction);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_read_u32: Lser ett 32-bitars vrde byte fr byte, med en
+*               instruktionsgrns fre varje byte.
+*
+*               - source: Pekare till vrdet.
+********************************************************************************/
+uint32_t sim_read_u32(const volatile uint32_t* source)
+{
+   const volatile uint8_t* bytes = (const volatile uint8_t*)source;
+   uint32_t value = 0;
+
+   for (uint8_t i = 0; i < sizeof(*source); ++i)
+   {
+      sim_delay_cycles(1);
+      value |= (uint32_t)bytes[i] << (8 * i);
+   }
+   return value;
+}
+
+/********************************************************************************
+* sim_write_u32: Skriver ett 32-bitars vrde byte fr byte, med en
+*                instruktionsgrns fre varje byte.
+*
+*                - destination: Pekare till vrdet.
+*                - value      : Vrdet som ska skrivas.
+********************************************************************************/
+void sim_write_u32(volatile uint32_t* destination,
+                   const uint32_t value)
+{
+   volatile uint8_t* bytes = (volatile uint8_t*)destination;
+
+   for (uint8_t i = 0; i < sizeof(*destination); ++i)
+   {
+      sim_delay_cycles(1);
+      bytes[i] = (uint8_t)(value >> (8 * i));
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_sleep: Frstter processorn i vilolge enligt SMCR, frutsatt att SE
+*            r satt. Tiden gr tills ett aktiverat avbrott som kan vcka
+*            processorn i valt vilolge ger rum, varefter avbrottet
+*            genomfrs efter uppvakningstiden. I vilolgen dr
+*            huvudoscillatorn stngs av tillkommer oscillatorns starttid.
+********************************************************************************/
+void sim_sleep(void)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   if ((io8[SIM_SMCR] & (1 << SE)) == 0)
+   {
+      sim_tick(1);
+      return;
+   }
+
+   const uint64_t start = now;
+   bool woken = false;
+   sleep_mode = (io8[SIM_SMCR] >> SM0) & 0x07;
+   asleep = true;
+   stats.sleeps++;
+
+   while (!woken)
+   {
+      for (uint8_t i = 1; i < SIM_VECTOR_COUNT && !woken; ++i)
+      {
+         woken = sim_vector_pending((enum sim_vector)i) &&
+                 sim_vector_wakes((enum sim_vector)i, sleep_mode);
+      }
+
+      if (!woken)
+      {
+         if (!exit_env && !num_events && now - start > SIM_SLEEP_CYCLES_MAX)
+         {
+            sim_fault("processorn sover utan vackningskalla");
+         }
+         sim_tick(SIM_SLICE_CYCLES);
+      }
+   }
+
+   asleep = false;
+   stats.sleep_cycles += now - start;
+
+   if (sleep_mode == 2 || sleep_mode == 3)
+   {
+      sim_tick(SIM_WAKEUP_CYCLES);
+   }
+   sim_tick(SIM_INTERRUPT_CYCLES);
+   return;
+}
+
+/********************************************************************************
+* sim_delay_cycles: Lter angivet antal klockcykler passera, dr avbrott
+*                   genomfrs som vanligt.
+*
+*                   - cycles: Antal klockcykler.
+********************************************************************************/
+void sim_delay_cycles(const uint64_t cycles)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   sim_tick(cycles);
+   return;
+}
+
+/********************************************************************************
+* sim_reset: terstller registerfilen samt samtliga kringkretsar till
+*            lget efter pslag. EEPROM-minnets innehll behlls.
+********************************************************************************/
+void sim_reset(void)
+{
+   if (!initialized)
+   {
+      initialized = true;
+      memset(eeprom, 0xFF, sizeof(eeprom));
+   }
+
+   memset((void*)io8, 0, sizeof(io8));
+   memset((void*)io16, 0, sizeof(io16));
+   memset((void*)strobe, 0, sizeof(strobe));
+   memset(strobe_value, 0, sizeof(strobe_value));
+   memset(strobe_armed, 0, sizeof(strobe_armed));
+   memset(pending_since, 0xFF, sizeof(pending_since));
+   memset(&stats, 0, sizeof(stats));
+   memset(pin_driven, 0, sizeof(pin_driven));
+   memset(pin_level, 0, sizeof(pin_level));
+   memset(adc_sources, 0, sizeof(adc_sources));
+   memset(adc_values, 0, sizeof(adc_values));
+
+   io8[SIM_MCUSR] = (1 << PORF);
+   io8[SIM_UCSR0A] = (1 << UDRE0);
+   io8[SIM_UCSR0C] = (1 << UCSZ01) | (1 << UCSZ00);
+
+   memcpy(shadow8, (const void*)io8, sizeof(shadow8));
+   memcpy(shadow16, (const void*)io16, sizeof(shadow16));
+
+   now = 0;
+   asleep = false;
+   sleep_mode = 0;
+   num_events = 0;
+
+   eeprom_busy = false;
+   tx_full = false;
+   tx_shifting = false;
+   tx_log_head = 0;
+   tx_log_count = 0;
+   rx_count = 0;
+   rx_last = 0;
+   rx_queue_head = 0;
+   rx_queue_count = 0;
+   adc_converting = false;
+   adc_last_channel = 0;
+   wdt_start = 0;
+   wdt_change_enabled = false;
+   return;
+}
+
+/********************************************************************************
+* sim_cycles: Returnerar antalet klockcykler sedan senaste terstllning.
+********************************************************************************/
+uint64_t sim_cycles(void)
+{
+   return now;
+}
+
+/********************************************************************************
+* sim_run: Lter klockan rknas fram till angivet antal klockcykler efter
+*          aktuell tidpunkt, dr avbrott genomfrs om globala avbrott r
+*          aktiverade. Till skillnad frn sim_delay_cycles ingr tiden fr
+*          avbrottsrutinerna i angivet antal klockcykler.
+*
+*          - cycles: Antal klockcykler.
+********************************************************************************/
+void sim_run(const uint64_t cycles)
+{
+   if (!initialized) sim_init();
+   sim_sync();
+   const uint64_t end = now + cycles;
+
+   while (now < end)
+   {
+      const uint64_t remaining = end - now;
+      sim_tick(remaining > SIM_SLICE_CYCLES ? SIM_SLICE_CYCLES : remaining);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_run_main: Kr angiven main-funktion tills den returnerar, angivet
+*               antal klockcykler har passerat eller Watchdog-timern
+*               terstller systemet. Vid tidsgrns eller terstllning
+*               avbryts krningen via longjmp frn simulatorn, ven mitt i
+*               en avbrottsrutin.
+*
+*               - entry : Programmets main-funktion.
+*               - cycles: Hgsta antal klockcykler att kra.
+********************************************************************************/
+enum sim_exit sim_run_main(int (*entry)(void),
+                           const uint64_t cycles)
+{
+   jmp_buf env;
+   volatile enum sim_exit result = SIM_EXIT_RETURN;
+
+   if (!initialized) sim_init();
+   deadline = now + cycles;
+   exit_env = &env;
+
+   const int code = setjmp(env);
+
+   if (code == 0)
+   {
+      (void)entry();
+   }
+   else
+   {
+      result = (enum sim_exit)(code - 1);
+   }
+
+   exit_env = NULL;
+   asleep = false;
+   memset(strobe_armed, 0, sizeof(strobe_armed));
+   return result;
+}
+
+/********************************************************************************
+* sim_at: Schemalgger angiven funktion att anropas vid angiven tidpunkt.
+*         Hndelserna hlls sorterade efter tidpunkt. Vid full k returneras
+*         felkod 1, annars 0.
+*
+*         - cycle   : Tidpunkten mtt i klockcykler sedan terstllning.
+*         - function: Funktionen som ska anropas.
+*         - context : Godtycklig pekare som skickas till funktionen.
+********************************************************************************/
+int sim_at(const uint64_t cycle,
+           void (*function)(void* context),
+           void* context)
+{
+   if (num_events >= SIM_EVENTS_MAX) return 1;
+   uint8_t i = num_events++;
+
+   while (i > 0 && events[i - 1].cycle > cycle)
+   {
+      events[i] = events[i - 1];
+      i--;
+   }
+
+   events[i].cycle = cycle;
+   events[i].function = function;
+   events[i].context = context;
+   return 0;
+}
+
+/********************************************************************************
+* sim_set_pin: Driver angiven pin externt till angiven niv.
+*
+*              - port : I/O-porten ('B', 'C' eller 'D').
+*              - bit  : Pinnens nummer 0 - 7 p I/O-porten.
+*              - level: Nivn som pinnen ska drivas till.
+********************************************************************************/
+void sim_set_pin(const char port,
+                 const uint8_t bit,
+                 const bool level)
+{
+   const uint8_t index = (uint8_t)(port - 'B');
+   if (index > 2 || bit > 7) sim_fault("ogiltig pin %c%u", port, bit);
+   if (!initialized) sim_init();
+   sim_sync();
+
+   pin_driven[index] |= (1 << bit);
+   if (level) pin_level[index] |= (1 << bit);
+   else pin_level[index] &= ~(1 << bit);
+
+   sim_pins_update(index);
+   return;
+}
+
+/********************************************************************************
+* sim_release_pin: Slutar driva angiven pin externt.
+*
+*                  - port: I/O-porten ('B', 'C' eller 'D').
+*                  - bit : Pinnens nummer 0 - 7 p I/O-porten.
+********************************************************************************/
+void sim_release_pin(const char port,
+                     const uint8_t bit)
+{
+   const uint8_t index = (uint8_t)(port - 'B');
+   if (index > 2 || bit > 7) sim_fault("ogiltig pin %c%u", port, bit);
+   if (!initialized) sim_init();
+   sim_sync();
+
+   pin_driven[index] &= ~(1 << bit);
+   sim_pins_update(index);
+   return;
+}
+
+/********************************************************************************
+* sim_get_pin: Returnerar aktuell niv p angiven pin.
+*
+*              - port: I/O-porten ('B', 'C' eller 'D').
+*              - bit : Pinnens nummer 0 - 7 p I/O-porten.
+********************************************************************************/
+bool sim_get_pin(const char port,
+                 const uint8_t bit)
+{
+   const uint8_t index = (uint8_t)(port - 'B');
+   if (index > 2 || bit > 7) sim_fault("ogiltig pin %c%u", port, bit);
+   if (!initialized) sim_init();
+   sim_sync();
+   return io8[pin_regs[index]] & (1 << bit);
+}
+
+/********************************************************************************
+* sim_usart_inject: Lgger angivna tecken i kn fr mottagning via USART.
+*                   Om kn var tom anlnder frsta tecknet en ramtid senare.
+*
+*                   - data  : Pekare till tecknen.
+*                   - length: Antalet tecken.
+********************************************************************************/
+void sim_usart_inject(const void* data,
+                      const size_t length)
+{
+   const uint8_t* bytes = (const uint8_t*)data;
+   if (!initialized) sim_init();
+   sim_sync();
+
+   for (size_t i = 0; i < length; ++i)
+   {
+      if (rx_queue_count >= SIM_RX_QUEUE_SIZE) sim_fault("kon for mottagning ar full");
+      if (rx_queue_count == 0) rx_arrival = now + sim_usart_frame_cycles();
+      rx_queue[(rx_queue_head + rx_queue_count++) % SIM_RX_QUEUE_SIZE] = bytes[i];
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_usart_take: Flyttar skickade tecken frn loggen till angiven
+*                 destination och returnerar antalet flyttade tecken.
+*
+*                 - destination: Pekare till destinationen.
+*                 - capacity   : Hgsta antal tecken att flytta.
+********************************************************************************/
+size_t sim_usart_take(void* destination,
+                      const size_t capacity)
+{
+   uint8_t* bytes = (uint8_t*)destination;
+   size_t count = 0;
+
+   while (count < capacity && tx_log_count > 0)
+   {
+      bytes[count++] = tx_log[tx_log_head];
+      tx_log_head = (tx_log_head + 1) % SIM_USART_LOG_SIZE;
+      tx_log_count--;
+   }
+   return count;
+}
+
+/********************************************************************************
+* sim_usart_frame_cycles: Returnerar antalet klockcykler per tecken, dvs.
+*                         startbit, databitar, eventuell paritetsbit samt
+*                         stoppbitar gnger tiden per bit enligt UBRR0 och
+*                         U2X0.
+********************************************************************************/
+uint32_t sim_usart_frame_cycles(void)
+{
+   const uint8_t c = io8[SIM_UCSR0C];
+   const uint8_t size = (uint8_t)(5 + ((c >> UCSZ00) & 0x03) +
+                                  ((io8[SIM_UCSR0B] & (1 << UCSZ02)) ? 4 : 0));
+   const uint8_t bits = (uint8_t)(1 + (size > 9 ? 9 : size) +
+                                  ((c & (1 << UPM01)) ? 1 : 0) +
+                                  ((c & (1 << USBS0)) ? 2 : 1));
+   const uint32_t divider = (io8[SIM_UCSR0A] & (1 << U2X0)) ? 8 : 16;
+   return bits * divider * ((uint32_t)(io16[SIM_UBRR0] & 0x0FFF) + 1);
+}
+
+/********************************************************************************
+* sim_adc_set_source: Vljer funktion fr skriptade vrden p angiven kanal.
+*
+*                     - channel: Kanalen 0 - 15.
+*                     - source : Funktionen, eller NULL fr konstant vrde.
+*                     - context: Godtycklig pekare som skickas till funktionen.
+********************************************************************************/
+void sim_adc_set_source(const uint8_t channel,
+                        const sim_adc_source source,
+                        void* context)
+{
+   if (channel >= SIM_ADC_CHANNELS) sim_fault("ogiltig kanal %u", channel);
+   if (!initialized) sim_init();
+   adc_sources[channel] = source;
+   adc_contexts[channel] = context;
+   return;
+}
+
+/********************************************************************************
+* sim_adc_set_value: Stter ett konstant vrde p angiven kanal.
+*
+*                    - channel: Kanalen 0 - 15.
+*                    - value  : Vrdet mellan 0 - 1023.
+********************************************************************************/
+void sim_adc_set_value(const uint8_t channel,
+                       const uint16_t value)
+{
+   if (channel >= SIM_ADC_CHANNELS) sim_fault("ogiltig kanal %u", channel);
+   if (!initialized) sim_init();
+   adc_sources[channel] = NULL;
+   adc_values[channel] = value & 0x3FF;
+   return;
+}
+
+/********************************************************************************
+* sim_adc_last_channel: Returnerar kanalen fr senast genomfrd omvandling.
+********************************************************************************/
+uint8_t sim_adc_last_channel(void)
+{
+   return adc_last_channel;
+}
+
+/********************************************************************************
+* sim_eeprom: Returnerar en pekare till EEPROM-minnets innehll.
+********************************************************************************/
+uint8_t* sim_eeprom(void)
+{
+   if (!initialized) sim_init();
+   return eeprom;
+}
+
+/********************************************************************************
+* sim_eeprom_erases: Returnerar antalet raderingar av angiven cell.
+*
+*                    - address: Cellens adress.
+********************************************************************************/
+uint32_t sim_eeprom_erases(const uint16_t address)
+{
+   return address < SIM_EEPROM_SIZE ? eeprom_erases[address] : 0;
+}
+
+/********************************************************************************
+* sim_eeprom_writes: Returnerar antalet skrivningar till angiven cell.
+*
+*                    - address: Cellens adress.
+********************************************************************************/
+uint32_t sim_eeprom_writes(const uint16_t address)
+{
+   return address < SIM_EEPROM_SIZE ? eeprom_writes[address] : 0;
+}
+
+/********************************************************************************
+* sim_eeprom_clear_wear: Nollstller antalet raderingar och skrivningar.
+********************************************************************************/
+void sim_eeprom_clear_wear(void)
+{
+   memset(eeprom_erases, 0, sizeof(eeprom_erases));
+   memset(eeprom_writes, 0, sizeof(eeprom_writes));
+   return;
+}
+
+/********************************************************************************
+* sim_get_stats: Returnerar en pekare till simulatorns statistik.
+********************************************************************************/
+const struct sim_stats* sim_get_stats(void)
+{
+   return &stats;
+}
+
+/********************************************************************************
+* sim_clear_stats: Nollstller simulatorns statistik.
+********************************************************************************/
+void sim_clear_stats(void)
+{
+   memset(&stats, 0, sizeof(stats));
+   return;
+}
+
+/********************************************************************************
+* sim_vector_name: Returnerar namnet p angiven avbrottsvektor.
+*
+*                  - vector: Avbrottsvektorn.
+********************************************************************************/
+const char* sim_vector_name(const enum sim_vector vector)
+{
+   return vector < SIM_VECTOR_COUNT ? vector_names[vector] : "?";
+}
+
+/********************************************************************************
+* sim_fault: Skriver ut angivet felmeddelande och avbryter programmet, vilket
+*            motsvarar en otillten situation i hrdvaran.
+*
+*            - format: Formatstrng enligt printf.
+********************************************************************************/
+static void sim_fault(const char* format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   fprintf(stderr, "sim: vid cykel %llu: ", (unsigned long long)now);
+   vfprintf(stderr, format, args);
+   fprintf(stderr, "\n");
+   va_end(args);
+   abort();
+}
+
+/********************************************************************************
+* sim_init: Initierar simulatorn vid frsta anvndning.
+********************************************************************************/
+static void sim_init(void)
+{
+   sim_reset();
+   return;
+}
+
+/********************************************************************************
+* sim_sync: Behandlar skrivningar sedan fregende anrop. Register som
+*           skiljer sig frn skuggkopian har skrivits av drivrutinerna,
+*           antingen direkt eller via pekare, medan register med
+*           sidoeffekter behandlas utefter markren.
+********************************************************************************/
+static void sim_sync(void)
+{
+   for (uint8_t i = 0; i < SIM_STROBE_COUNT; ++i)
+   {
+      if (!strobe_armed[i]) continue;
+      strobe_armed[i] = false;
+      const uint16_t value = strobe[i];
+
+      if ((value >> 8) == SIM_MARKER && (uint8_t)value == strobe_prefill[i])
+      {
+         sim_read_strobe((enum sim_strobe_id)i);
+      }
+      else
+      {
+         sim_write_strobe((enum sim_strobe_id)i, (uint8_t)value);
+      }
+   }
+
+   for (uint8_t i = 0; i < SIM_IO8_COUNT; ++i)
+   {
+      if (io8[i] != shadow8[i])
+      {
+         const uint8_t old_value = shadow8[i];
+         shadow8[i] = io8[i];
+         sim_write8((enum sim_io8_id)i, old_value, io8[i]);
+      }
+   }
+
+   for (uint8_t i = 0; i < SIM_IO16_COUNT; ++i)
+   {
+      if (io16[i] != shadow16[i])
+      {
+         shadow16[i] = io16[i];
+         sim_write16((enum sim_io16_id)i);
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_tick: Lter angivet antal klockcykler passera i steg om hgst
+*           SIM_SLICE_CYCLES. Efter varje steg anropas schemalagda hndelser,
+*           tidsgrnsen fr sim_run_main kontrolleras och vntande avbrott
+*           genomfrs.
+*
+*           - cycles: Antal klockcykler.
+********************************************************************************/
+static void sim_tick(uint64_t cycles)
+{
+   while (cycles > 0)
+   {
+      const uint32_t step = cycles > SIM_SLICE_CYCLES ? SIM_SLICE_CYCLES : (uint32_t)cycles;
+      sim_advance(step);
+      cycles -= step;
+
+      while (num_events > 0 && events[0].cycle <= now)
+      {
+         const struct sim_event event = events[0];
+         memmove(events, events + 1, (size_t)(--num_events) * sizeof(events[0]));
+         event.function(event.context);
+      }
+
+      if (exit_env && now >= deadline) longjmp(*exit_env, SIM_EXIT_DEADLINE + 1);
+      sim_dispatch();
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_advance: Rknar fram klockan samt samtliga kringkretsar angivet antal
+*              klockcykler. I/O-klockan stoppas i samtliga vilolgen frutom
+*              Idle, medan Timer 2 fortstter vid asynkron klocka.
+*
+*              - cycles: Antal klockcykler, hgst SIM_SLICE_CYCLES.
+********************************************************************************/
+static void sim_advance(const uint32_t cycles)
+{
+   const bool io_clock = !asleep || sleep_mode == 0;
+
+   for (uint8_t i = 0; i < 3; ++i)
+   {
+      if (io_clock || (i == 2 && (io8[SIM_ASSR] & (1 << AS2))))
+      {
+         sim_timer_advance(i, cycles);
+      }
+   }
+
+   now += cycles;
+
+   sim_eeprom_advance();
+   if (io_clock) sim_usart_advance();
+   if (io_clock || sleep_mode == 1) sim_adc_advance();
+   sim_wdt_advance();
+   return;
+}
+
+/********************************************************************************
+* sim_dispatch: Genomfr vntande avbrott i prioritetsordning s lnge
+*               globala avbrott r aktiverade och processorn r vaken.
+*               Frst uppdateras tidpunkten d respektive avbrott blev
+*               vntande, s att latensen ven omfattar tid med avbrott
+*               inaktiverade eller under andra avbrottsrutiner.
+********************************************************************************/
+static void sim_dispatch(void)
+{
+   for (uint8_t i = 1; i < SIM_VECTOR_COUNT; ++i)
+   {
+      if (!sim_vector_pending((enum sim_vector)i)) pending_since[i] = SIM_NOT_PENDING;
+      else if (pending_since[i] == SIM_NOT_PENDING) pending_since[i] = now;
+   }
+
+   while (!asleep && (io8[SIM_SREG] & (1 << SREG_I)))
+   {
+      uint8_t vector = 1;
+      while (vector < SIM_VECTOR_COUNT && !sim_vector_pending((enum sim_vector)vector)) vector++;
+      if (vector >= SIM_VECTOR_COUNT) return;
+      sim_interrupt((enum sim_vector)vector);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_interrupt: Genomfr angivet avbrott. Avbrottsflaggan kvitteras och
+*                globala avbrott inaktiveras, varefter avbrottsrutinen
+*                anropas. Efter retur behandlas rutinens skrivningar och
+*                globala avbrott teraktiveras (RETI). Saknas avbrottsrutin
+*                avbryts simuleringen, eftersom mikrodatorn d terstlls.
+*
+*                - vector: Avbrottsvektorn som ska genomfras.
+********************************************************************************/
+static void sim_interrupt(const enum sim_vector vector)
+{
+   static void (*const routines[SIM_VECTOR_COUNT])(void) =
+   {
+      NULL, INT0_vect, INT1_vect, PCINT0_vect, PCINT1_vect, PCINT2_vect,
+      WDT_vect, TIMER2_COMPA_vect, TIMER2_COMPB_vect, TIMER2_OVF_vect,
+      TIMER1_CAPT_vect, TIMER1_COMPA_vect, TIMER1_COMPB_vect,
+      TIMER1_OVF_vect, TIMER0_COMPA_vect, TIMER0_COMPB_vect,
+      TIMER0_OVF_vect, SPI_STC_vect, USART_RX_vect, USART_UDRE_vect,
+      USART_TX_vect, ADC_vect, EE_READY_vect
+   };
+
+   if (!routines[vector])
+   {
+      sim_fault("avbrott %s saknar avbrottsrutin", vector_names[vector]);
+   }
+
+   switch (vector)
+   {
+      case SIM_VECTOR_INT0: strobe_value[SIM_EIFR] &= ~(1 << INTF0); break;
+      case SIM_VECTOR_INT1: strobe_value[SIM_EIFR] &= ~(1 << INTF1); break;
+      case SIM_VECTOR_PCINT0: strobe_value[SIM_PCIFR] &= ~(1 << PCIF0); break;
+      case SIM_VECTOR_PCINT1: strobe_value[SIM_PCIFR] &= ~(1 << PCIF1); break;
+      case SIM_VECTOR_PCINT2: strobe_value[SIM_PCIFR] &= ~(1 << PCIF2); break;
+      case SIM_VECTOR_WDT:
+         strobe_value[SIM_WDTCSR] &= ~(1 << WDIF);
+         if (strobe_value[SIM_WDTCSR] & (1 << WDE)) strobe_value[SIM_WDTCSR] &= ~(1 << WDIE);
+         break;
+      case SIM_VECTOR_TIMER2_COMPA: strobe_value[SIM_TIFR2] &= ~(1 << OCF2A); break;
+      case SIM_VECTOR_TIMER2_COMPB: strobe_value[SIM_TIFR2] &= ~(1 << OCF2B); break;
+      case SIM_VECTOR_TIMER2_OVF: strobe_value[SIM_TIFR2] &= ~(1 << TOV2); break;
+      case SIM_VECTOR_TIMER1_CAPT: strobe_value[SIM_TIFR1] &= ~(1 << ICF1); break;
+      case SIM_VECTOR_TIMER1_COMPA: strobe_value[SIM_TIFR1] &= ~(1 << OCF1A); break;
+      case SIM_VECTOR_TIMER1_COMPB: strobe_value[SIM_TIFR1] &= ~(1 << OCF1B); break;
+      case SIM_VECTOR_TIMER1_OVF: strobe_value[SIM_TIFR1] &= ~(1 << TOV1); break;
+      case SIM_VECTOR_TIMER0_COMPA: strobe_value[SIM_TIFR0] &= ~(1 << OCF0A); break;
+      case SIM_VECTOR_TIMER0_COMPB: strobe_value[SIM_TIFR0] &= ~(1 << OCF0B); break;
+      case SIM_VECTOR_TIMER0_OVF: strobe_value[SIM_TIFR0] &= ~(1 << TOV0); break;
+      case SIM_VECTOR_USART_TX:
+         io8[SIM_UCSR0A] &= ~(1 << TXC0);
+         shadow8[SIM_UCSR0A] = io8[SIM_UCSR0A];
+         break;
+      case SIM_VECTOR_ADC: strobe_value[SIM_ADCSRA] &= ~(1 << ADIF); break;
+      default: break;
+   }
+
+   struct sim_isr_stats* isr = &stats.isr[vector];
+   const uint64_t latency = pending_since[vector] == SIM_NOT_PENDING ? 0 : now - pending_since[vector];
+   const uint64_t start = now;
+
+   io8[SIM_SREG] &= ~(1 << SREG_I);
+   shadow8[SIM_SREG] = io8[SIM_SREG];
+   sim_tick(SIM_INTERRUPT_CYCLES);
+
+   routines[vector]();
+
+   sim_sync();
+   sim_tick(SIM_INTERRUPT_CYCLES);
+   io8[SIM_SREG] |= (1 << SREG_I);
+   shadow8[SIM_SREG] = io8[SIM_SREG];
+
+   const uint64_t cycles = now - start;
+   isr->count++;
+   isr->cycles += cycles;
+   if (cycles > isr->worst_cycles) isr->worst_cycles = (uint32_t)cycles;
+   if (latency > isr->latency_max) isr->latency_max = (uint32_t)latency;
+   pending_since[vector] = SIM_NOT_PENDING;
+   return;
+}
+
+/********************************************************************************
+* sim_vector_pending: Indikerar ifall angivet avbrott r aktiverat och dess
+*                     avbrottsflagga eller villkor r uppfyllt.
+*
+*                     - vector: Avbrottsvektorn som ska kontrolleras.
+********************************************************************************/
+static bool sim_vector_pending(const enum sim_vector vector)
+{
+   const uint8_t pcifr = strobe_value[SIM_PCIFR] & io8[SIM_PCICR];
+   const uint8_t tifr0 = strobe_value[SIM_TIFR0] & io8[SIM_TIMSK0];
+   const uint8_t tifr1 = strobe_value[SIM_TIFR1] & io8[SIM_TIMSK1];
+   const uint8_t tifr2 = strobe_value[SIM_TIFR2] & io8[SIM_TIMSK2];
+   const uint8_t ucsr0a = io8[SIM_UCSR0A];
+   const uint8_t ucsr0b = io8[SIM_UCSR0B];
+
+   switch (vector)
+   {
+      case SIM_VECTOR_INT0: return strobe_value[SIM_EIFR] & io8[SIM_EIMSK] & (1 << INTF0);
+      case SIM_VECTOR_INT1: return strobe_value[SIM_EIFR] & io8[SIM_EIMSK] & (1 << INTF1);
+      case SIM_VECTOR_PCINT0: return pcifr & (1 << PCIF0);
+      case SIM_VECTOR_PCINT1: return pcifr & (1 << PCIF1);
+      case SIM_VECTOR_PCINT2: return pcifr & (1 << PCIF2);
+      case SIM_VECTOR_WDT:
+         return (strobe_value[SIM_WDTCSR] & ((1 << WDIF) | (1 << WDIE))) == ((1 << WDIF) | (1 << WDIE));
+      case SIM_VECTOR_TIMER2_COMPA: return tifr2 & (1 << OCF2A);
+      case SIM_VECTOR_TIMER2_COMPB: return tifr2 & (1 << OCF2B);
+      case SIM_VECTOR_TIMER2_OVF: return tifr2 & (1 << TOV2);
+      case SIM_VECTOR_TIMER1_CAPT: return tifr1 & (1 << ICF1);
+      case SIM_VECTOR_TIMER1_COMPA: return tifr1 & (1 << OCF1A);
+      case SIM_VECTOR_TIMER1_COMPB: return tifr1 & (1 << OCF1B);
+      case SIM_VECTOR_TIMER1_OVF: return tifr1 & (1 << TOV1);
+      case SIM_VECTOR_TIMER0_COMPA: return tifr0 & (1 << OCF0A);
+      case SIM_VECTOR_TIMER0_COMPB: return tifr0 & (1 << OCF0B);
+      case SIM_VECTOR_TIMER0_OVF: return tifr0 & (1 << TOV0);
+      case SIM_VECTOR_USART_RX: return (ucsr0a & (1 << RXC0)) && (ucsr0b & (1 << RXCIE0));
+      case SIM_VECTOR_USART_UDRE: return (ucsr0a & (1 << UDRE0)) && (ucsr0b & (1 << UDRIE0));
+      case SIM_VECTOR_USART_TX: return (ucsr0a & (1 << TXC0)) && (ucsr0b & (1 << TXCIE0));
+      case SIM_VECTOR_ADC:
+         return (strobe_value[SIM_ADCSRA] & ((1 << ADIF) | (1 << ADIE))) == ((1 << ADIF) | (1 << ADIE));
+      case SIM_VECTOR_EE_READY:
+         return (io8[SIM_EECR] & ((1 << EERIE) | (1 << EEPE))) == (1 << EERIE);
+      default: return false;
+   }
+}
+
+/********************************************************************************
+* sim_vector_wakes: Indikerar ifall angivet avbrott kan vcka processorn i
+*                   angivet vilolge. Externa avbrott, PCI-avbrott samt
+*                   Watchdog-timern vcker processorn i samtliga vilolgen,
+*                   Timer 2 enbart vid asynkron klocka i Power-save och
+*                   Extended Standby, AD-omvandlaren och EEPROM-minnet i
+*                   ADC Noise Reduction, medan Idle vcks av samtliga avbrott.
+*
+*                   - vector: Avbrottsvektorn.
+*                   - mode  : Vilolget (bitarna SM2:0 i SMCR).
+********************************************************************************/
+static bool sim_vector_wakes(const enum sim_vector vector,
+                             const uint8_t mode)
+{
+   if (mode == 0) return true;
+
+   switch (vector)
+   {
+      case SIM_VECTOR_INT0: case SIM_VECTOR_INT1:
+      case SIM_VECTOR_PCINT0: case SIM_VECTOR_PCINT1: case SIM_VECTOR_PCINT2:
+      case SIM_VECTOR_WDT:
+         return true;
+      case SIM_VECTOR_TIMER2_COMPA: case SIM_VECTOR_TIMER2_COMPB: case SIM_VECTOR_TIMER2_OVF:
+         return (mode == 1 || mode == 3 || mode == 7) && (io8[SIM_ASSR] & (1 << AS2));
+      case SIM_VECTOR_ADC: case SIM_VECTOR_EE_READY:
+         return mode == 1;
+      default:
+         return false;
+   }
+}
+
+/********************************************************************************
+* sim_set_flag: Ettstller angiven avbrottsflagga. Om avbrottet drmed blir
+*               vntande lagras tidpunkten fr mtning av latens. Automatisk
+*               start av AD-omvandlaren sker vid stigande flank p vald
+*               flagga.
+*
+*               - id    : Flaggregistret.
+*               - bit   : Flaggans bit.
+*               - vector: Motsvarande avbrottsvektor.
+********************************************************************************/
+static void sim_set_flag(const enum sim_strobe_id id,
+                         const uint8_t bit,
+                         const enum sim_vector vector)
+{
+   if (strobe_value[id] & (1 << bit)) return;
+   strobe_value[id] |= (1 << bit);
+   if (pending_since[vector] == SIM_NOT_PENDING && sim_vector_pending(vector)) pending_since[vector] = now;
+
+   if (id == SIM_TIFR0 && bit == OCF0A) sim_adc_trigger(3);
+   else if (id == SIM_TIFR0 && bit == TOV0) sim_adc_trigger(4);
+   else if (id == SIM_TIFR1 && bit == OCF1B) sim_adc_trigger(5);
+   else if (id == SIM_TIFR1 && bit == TOV1) sim_adc_trigger(6);
+   return;
+}
+
+/********************************************************************************
+* sim_write8: Behandlar en skrivning till angivet 8-bitars register.
+*
+*             - id       : Registret som har skrivits.
+*             - old_value: Registrets vrde fre skrivningen.
+*             - value    : Skrivet vrde.
+********************************************************************************/
+static void sim_write8(const enum sim_io8_id id,
+                       const uint8_t old_value,
+                       uint8_t value)
+{
+   switch (id)
+   {
+      case SIM_PINB: case SIM_PINC: case SIM_PIND:
+      {
+         const uint8_t index = (uint8_t)((id - SIM_PINB) / 3);
+         io8[port_regs[index]] ^= value;
+         shadow8[port_regs[index]] = io8[port_regs[index]];
+         io8[id] = old_value;
+         shadow8[id] = old_value;
+         sim_pins_update(index);
+         break;
+      }
+      case SIM_DDRB: case SIM_PORTB: sim_pins_update(0); break;
+      case SIM_DDRC: case SIM_PORTC: sim_pins_update(1); break;
+      case SIM_DDRD: case SIM_PORTD: sim_pins_update(2); break;
+      case SIM_EECR: sim_eeprom_write_control(old_value, value); break;
+      case SIM_EEDR:
+         if (eeprom_busy) stats.eeprom_busy_changes++;
+         break;
+      case SIM_SREG:
+         break;
+      case SIM_UCSR0A:
+         value = (uint8_t)((old_value & ~((1 << U2X0) | (1 << MPCM0))) |
+                           (value & ((1 << U2X0) | (1 << MPCM0))));
+         if (io8[id] & (1 << TXC0)) value &= ~(1 << TXC0);
+         io8[id] = value;
+         shadow8[id] = value;
+         break;
+      case SIM_UCSR0B:
+         if ((value & (1 << TXEN0)) == 0)
+         {
+            tx_full = false;
+            tx_shifting = false;
+         }
+         if ((value & (1 << RXEN0)) == 0) rx_count = 0;
+         break;
+      case SIM_ASSR:
+         value = (uint8_t)(value & ((1 << AS2) | (1 << EXCLK)));
+         io8[id] = value;
+         shadow8[id] = value;
+         break;
+      default:
+         break;
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_write16: Behandlar en skrivning till angivet 16-bitars register.
+*
+*              - id: Registret som har skrivits.
+********************************************************************************/
+static void sim_write16(const enum sim_io16_id id)
+{
+   if (id == SIM_EEAR && eeprom_busy) stats.eeprom_busy_changes++;
+   return;
+}
+
+/********************************************************************************
+* sim_write_strobe: Behandlar en skrivning till angivet register med
+*                   sidoeffekter. I flaggregistren nollstlls flaggor dr
+*                   en etta skrivs.
+*
+*                   - id   : Registret som har skrivits.
+*                   - value: Skrivet vrde.
+********************************************************************************/
+static void sim_write_strobe(const enum sim_strobe_id id,
+                             const uint8_t value)
+{
+   switch (id)
+   {
+      case SIM_TIFR0: case SIM_TIFR1: case SIM_TIFR2: case SIM_PCIFR: case SIM_EIFR:
+         strobe_value[id] &= ~value;
+         break;
+      case SIM_ADCSRA: sim_adc_write_control(value); break;
+      case SIM_WDTCSR: sim_wdt_write_control(value); break;
+      case SIM_UDR0: sim_usart_write(value); break;
+      default: break;
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_read_strobe: Behandlar en lsning av angivet register med
+*                  sidoeffekter, dr lsning av UDR0 hmtar mottaget tecken.
+*
+*                  - id: Registret som har lsts.
+********************************************************************************/
+static void sim_read_strobe(const enum sim_strobe_id id)
+{
+   if (id == SIM_UDR0) (void)sim_usart_read();
+   return;
+}
+
+/********************************************************************************
+* sim_timer_advance: Rknar fram angiven timerkrets angivet antal
+*                    klockcykler. Prescalern r gemensam och frigende, s
+*                    att timerns rknare kar nr klockan passerar en jmn
+*                    multipel av prescalern. Vid asynkron Timer 2 rknas
+*                    i stllet perioder av 32.768 kHz-kristallen.
+*
+*                    Flaggan fr matchning ettstlls i timerklockan efter
+*                    att rknaren har ntt OCRnx, dvs. samtidigt som rknaren
+*                    nollstlls i CTC Mode. Overflow sker vid vergng frn
+*                    hgsta vrdet till noll.
+*
+*                    - index : Timerkretsen 0 - 2.
+*                    - cycles: Antal klockcykler.
+********************************************************************************/
+static void sim_timer_advance(const uint8_t index,
+                              const uint32_t cycles)
+{
+   const struct sim_timer* timer = &timers[index];
+   const uint8_t cs = io8[timer->tccrb] & 0x07;
+   const bool async = index == 2 && (io8[SIM_ASSR] & (1 << AS2));
+   const uint32_t prescaler = index == 2 ? prescalers_async[cs] : prescalers_sync[cs];
+
+   if (prescaler == 0 || (io8[SIM_PRR] & (1 << timer->prr))) return;
+
+   uint64_t ticks;
+
+   if (async)
+   {
+      const uint64_t end = (now + cycles) * SIM_ASYNC_HZ / F_CPU;
+      ticks = end / prescaler - (now * SIM_ASYNC_HZ / F_CPU) / prescaler;
+   }
+   else
+   {
+      ticks = (now + cycles) / prescaler - now / prescaler;
+   }
+   if (ticks == 0) return;
+
+   const uint8_t wgm = (uint8_t)((io8[timer->tccra] & 0x03) | ((io8[timer->tccrb] >> 1) & 0x0C));
+   const uint16_t max = timer->wide ? 0xFFFF : 0xFF;
+   const uint16_t ocra = timer->wide ? io16[SIM_OCR1A] : io8[timer->tifr == SIM_TIFR0 ? SIM_OCR0A : SIM_OCR2A];
+   const uint16_t ocrb = timer->wide ? io16[SIM_OCR1B] : io8[timer->tifr == SIM_TIFR0 ? SIM_OCR0B : SIM_OCR2B];
+   uint16_t top = max;
+   bool tov_at_top = false;
+
+   if (timer->wide)
+   {
+      if (wgm == 4) top = ocra;
+      else if (wgm == 12) top = io16[SIM_ICR1];
+      else if (wgm == 5) top = 0xFF, tov_at_top = true;
+      else if (wgm == 6) top = 0x1FF, tov_at_top = true;
+      else if (wgm == 7) top = 0x3FF, tov_at_top = true;
+      else if (wgm == 14) top = io16[SIM_ICR1], tov_at_top = true;
+      else if (wgm == 15) top = ocra, tov_at_top = true;
+   }
+   else
+   {
+      if (wgm == 2) top = ocra;
+      else if (wgm == 7) top = ocra, tov_at_top = true;
+   }
+
+   uint16_t count = timer->wide ? io16[SIM_TCNT1] : io8[index == 0 ? SIM_TCNT0 : SIM_TCNT2];
+
+   for (uint64_t i = 0; i < ticks; ++i)
+   {
+      if (count == ocra) sim_set_flag((enum sim_strobe_id)timer->tifr, 1, timer->vector_compa);
+      if (count == ocrb) sim_set_flag((enum sim_strobe_id)timer->tifr, 2, timer->vector_compb);
+      if (timer->wide && wgm == 12 && count == top) sim_set_flag(SIM_TIFR1, ICF1, SIM_VECTOR_TIMER1_CAPT);
+
+      if (count == top)
+      {
+         if (top == max || tov_at_top) sim_set_flag((enum sim_strobe_id)timer->tifr, 0, timer->vector_ovf);
+         count = 0;
+      }
+      else if (count == max)
+      {
+         sim_set_flag((enum sim_strobe_id)timer->tifr, 0, timer->vector_ovf);
+         count = 0;
+      }
+      else
+      {
+         count++;
+      }
+   }
+
+   if (timer->wide)
+   {
+      io16[SIM_TCNT1] = count;
+      shadow16[SIM_TCNT1] = count;
+   }
+   else
+   {
+      const uint8_t reg = index == 0 ? SIM_TCNT0 : SIM_TCNT2;
+      io8[reg] = (uint8_t)count;
+      shadow8[reg] = (uint8_t)count;
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_eeprom_write_control: Behandlar en skrivning till EECR.
+*
+*                           1. Programmeringslget kan inte ndras under
+*                              pgende skrivning.
+*
+*                           2. EERE lser adressen i EEAR till EEDR, vilket
+*                              ignoreras under pgende skrivning.
+*
+*                           3. EEMPE ppnar ett fnster p fyra klockcykler,
+*                              inom vilket EEPE startar en skrivning av EEDR
+*                              till adressen i EEAR. Annars, eller under
+*                              pgende skrivning, ignoreras EEPE.
+*
+*                           - old_value: Registrets vrde fre skrivningen.
+*                           - value    : Skrivet vrde.
+********************************************************************************/
+static void sim_eeprom_write_control(const uint8_t old_value,
+                                     uint8_t value)
+{
+   if (eeprom_busy && ((old_value ^ value) & SIM_EEPROM_MODE_MASK))
+   {
+      stats.eeprom_busy_changes++;
+      value = (uint8_t)((value & ~SIM_EEPROM_MODE_MASK) | (old_value & SIM_EEPROM_MODE_MASK));
+   }
+
+   if (value & (1 << EERE))
+   {
+      if (eeprom_busy)
+      {
+         stats.eeprom_busy_reads++;
+      }
+      else
+      {
+         io8[SIM_EEDR] = eeprom[io16[SIM_EEAR] & (SIM_EEPROM_SIZE - 1)];
+         shadow8[SIM_EEDR] = io8[SIM_EEDR];
+         stats.eeprom_reads++;
+      }
+      value &= ~(1 << EERE);
+   }
+
+   if ((value & (1 << EEMPE)) && !(old_value & (1 << EEMPE))) eeprom_mpe_at = now;
+
+   if ((value & (1 << EEPE)) && !(old_value & (1 << EEPE)))
+   {
+      if (eeprom_busy)
+      {
+         stats.eeprom_busy_writes++;
+      }
+      else if (!(value & (1 << EEMPE)) || now - eeprom_mpe_at > SIM_TIMED_SEQUENCE_CYCLES)
+      {
+         stats.eeprom_ignored_writes++;
+         value &= ~(1 << EEPE);
+      }
+      else
+      {
+         eeprom_busy = true;
+         eeprom_address = io16[SIM_EEAR] & (SIM_EEPROM_SIZE - 1);
+         eeprom_data = io8[SIM_EEDR];
+         eeprom_mode = (uint8_t)((value & SIM_EEPROM_MODE_MASK) >> EEPM0);
+         eeprom_done = now + (eeprom_mode == 0 ? SIM_EEPROM_ERASE_WRITE_CYCLES : SIM_EEPROM_SINGLE_CYCLES);
+         value &= ~(1 << EEMPE);
+         stats.eeprom_writes++;
+      }
+   }
+
+   if (eeprom_busy) value |= (1 << EEPE);
+   else value &= ~(1 << EEPE);
+
+   io8[SIM_EECR] = value;
+   shadow8[SIM_EECR] = value;
+   return;
+}
+
+/********************************************************************************
+* sim_eeprom_advance: Slutfr pgende skrivning till EEPROM-minnet nr
+*                     programmeringstiden har passerat, dr radering stter
+*                     samtliga bitar och skrivning enbart kan nollstlla bitar.
+*                     EEMPE nollstlls fyra klockcykler efter att den sattes.
+********************************************************************************/
+static void sim_eeprom_advance(void)
+{
+   if ((io8[SIM_EECR] & (1 << EEMPE)) && now - eeprom_mpe_at > SIM_TIMED_SEQUENCE_CYCLES)
+   {
+      io8[SIM_EECR] &= ~(1 << EEMPE);
+      shadow8[SIM_EECR] = io8[SIM_EECR];
+   }
+
+   if (!eeprom_busy || now < eeprom_done) return;
+
+   if (eeprom_mode != 2)
+   {
+      eeprom[eeprom_address] = 0xFF;
+      eeprom_erases[eeprom_address]++;
+   }
+
+   if (eeprom_mode != 1)
+   {
+      eeprom[eeprom_address] &= eeprom_data;
+      eeprom_writes[eeprom_address]++;
+   }
+
+   eeprom_busy = false;
+   io8[SIM_EECR] &= ~(1 << EEPE);
+   shadow8[SIM_EECR] = io8[SIM_EECR];
+   if (sim_vector_pending(SIM_VECTOR_EE_READY)) pending_since[SIM_VECTOR_EE_READY] = now;
+   return;
+}
+
+/********************************************************************************
+* sim_usart_write: Behandlar en skrivning till UDR0. Tecknet lggs i
+*                  dataregistret, varifrn det flyttas direkt till
+*                  skiftregistret om detta r ledigt. Skrivning till fullt
+*                  dataregister rknas som frlorat tecken.
+*
+*                  - data: Skrivet tecken.
+********************************************************************************/
+static void sim_usart_write(const uint8_t data)
+{
+   if ((io8[SIM_UCSR0B] & (1 << TXEN0)) == 0) return;
+
+   if (tx_full)
+   {
+      stats.usart_tx_lost++;
+      return;
+   }
+
+   tx_full = true;
+   tx_data = data;
+   io8[SIM_UCSR0A] &= ~(1 << UDRE0);
+   shadow8[SIM_UCSR0A] = io8[SIM_UCSR0A];
+   sim_usart_advance();
+   return;
+}
+
+/********************************************************************************
+* sim_usart_read: Hmtar ldsta mottagna tecknet ur mottagningsbufferten,
+*                 varvid Data OverRun nollstlls.
+********************************************************************************/
+static uint8_t sim_usart_read(void)
+{
+   if (rx_count > 0)
+   {
+      rx_last = rx_fifo[0];
+      rx_fifo[0] = rx_fifo[1];
+      rx_count--;
+   }
+
+   io8[SIM_UCSR0A] &= ~(1 << DOR0);
+   if (rx_count == 0) io8[SIM_UCSR0A] &= ~(1 << RXC0);
+   shadow8[SIM_UCSR0A] = io8[SIM_UCSR0A];
+   return rx_last;
+}
+
+/********************************************************************************
+* sim_usart_advance: Rknar fram sndning och mottagning via USART.
+*
+*                    1. Nr skiftregistret r klart loggas tecknet, varefter
+*                       nsta tecken i dataregistret flyttas till
+*                       skiftregistret. Saknas nsta tecken ettstlls TXC0.
+*
+*                    2. Tecken i kn fr mottagning anlnder en ramtid i
+*                       taget till mottagningsbufferten om tv tecken. Om
+*                       bufferten r full frloras tecknet och DOR0 stts.
+********************************************************************************/
+static void sim_usart_advance(void)
+{
+   uint8_t ucsr0a = io8[SIM_UCSR0A];
+
+   if (tx_shifting && now >= tx_done)
+   {
+      tx_log[(tx_log_head + tx_log_count) % SIM_USART_LOG_SIZE] = tx_shift;
+      if (tx_log_count < SIM_USART_LOG_SIZE) tx_log_count++;
+      else tx_log_head = (tx_log_head + 1) % SIM_USART_LOG_SIZE;
+      tx_shifting = false;
+      if (!tx_full) ucsr0a |= (1 << TXC0);
+   }
+
+   if (tx_full && !tx_shifting)
+   {
+      tx_shift = tx_data;
+      tx_shifting = true;
+      tx_full = false;
+      tx_done = now + sim_usart_frame_cycles();
+   }
+
+   if (tx_full) ucsr0a &= ~(1 << UDRE0);
+   else ucsr0a |= (1 << UDRE0);
+
+   if (rx_queue_count > 0 && now >= rx_arrival && (io8[SIM_UCSR0B] & (1 << RXEN0)))
+   {
+      const uint8_t data = rx_queue[rx_queue_head];
+      rx_queue_head = (rx_queue_head + 1) % SIM_RX_QUEUE_SIZE;
+      rx_queue_count--;
+      rx_arrival += sim_usart_frame_cycles();
+
+      if (rx_count < 2)
+      {
+         rx_fifo[rx_count++] = data;
+      }
+      else
+      {
+         ucsr0a |= (1 << DOR0);
+         stats.usart_rx_overruns++;
+      }
+   }
+
+   if (rx_count > 0) ucsr0a |= (1 << RXC0);
+   io8[SIM_UCSR0A] = ucsr0a;
+   shadow8[SIM_UCSR0A] = ucsr0a;
+   return;
+}
+
+/********************************************************************************
+* sim_adc_write_control: Behandlar en skrivning till ADCSRA.
+*
+*                        1. ADIF nollstlls om en etta skrivs, medan ADSC
+*                           frblir satt under pgende omvandling.
+*
+*                        2. Nr ADEN nollstlls avbryts pgende omvandling.
+*                           Frsta omvandlingen efter att ADEN har satts tar
+*                           25 ADC-klockcykler i stllet fr 13.
+*
+*                        3. ADSC startar en omvandling om ingen pgr.
+*
+*                        - value: Skrivet vrde.
+********************************************************************************/
+static void sim_adc_write_control(const uint8_t value)
+{
+   const uint8_t old_value = strobe_value[SIM_ADCSRA];
+   uint8_t control = value & ~((1 << ADIF) | (1 << ADSC));
+
+   if ((old_value & (1 << ADIF)) && !(value & (1 << ADIF))) control |= (1 << ADIF);
+   if (!(control & (1 << ADEN))) adc_converting = false;
+   if (!(old_value & (1 << ADEN)) && (control & (1 << ADEN))) adc_first = true;
+
+   strobe_value[SIM_ADCSRA] = control;
+
+   if ((value & (1 << ADSC)) && (control & (1 << ADEN)) && !adc_converting)
+   {
+      sim_adc_start(adc_first ? 50 : 26);
+   }
+
+   if (adc_converting) strobe_value[SIM_ADCSRA] |= (1 << ADSC);
+   return;
+}
+
+/********************************************************************************
+* sim_adc_start: Startar en omvandling av kanalen som r vald i ADMUX, dr
+*                kanalen lses och insignalen samplas vid start.
+*
+*                - half_clocks: Omvandlingstiden i halva ADC-klockcykler.
+********************************************************************************/
+static void sim_adc_start(const uint8_t half_clocks)
+{
+   static const uint8_t prescalers[8] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+   const uint32_t prescaler = prescalers[strobe_value[SIM_ADCSRA] & 0x07];
+
+   adc_channel = io8[SIM_ADMUX] & 0x0F;
+   adc_result = adc_sources[adc_channel] ?
+                adc_sources[adc_channel](adc_channel, now, adc_contexts[adc_channel]) & 0x3FF :
+                adc_values[adc_channel];
+   adc_converting = true;
+   adc_first = false;
+   adc_done = now + (half_clocks * prescaler) / 2;
+   strobe_value[SIM_ADCSRA] |= (1 << ADSC);
+   return;
+}
+
+/********************************************************************************
+* sim_adc_trigger: Startar en omvandling vid stigande flank p angiven
+*                  klla fr automatisk start (bitarna ADTS2:0), frutsatt
+*                  att automatisk start r vald. Pgr redan en omvandling
+*                  ignoreras flanken.
+*
+*                  - source: Kllan fr automatisk start.
+********************************************************************************/
+static void sim_adc_trigger(const uint8_t source)
+{
+   const uint8_t control = strobe_value[SIM_ADCSRA];
+   if (!(control & (1 << ADEN)) || !(control & (1 << ADATE))) return;
+   if ((io8[SIM_ADCSRB] & 0x07) != source) return;
+
+   if (adc_converting)
+   {
+      stats.adc_ignored_triggers++;
+      return;
+   }
+   sim_adc_start(adc_first ? 50 : 27);
+   return;
+}
+
+/********************************************************************************
+* sim_adc_advance: Slutfr pgende omvandling nr omvandlingstiden har
+*                  passerat. Resultatet lagras i ADC (vnsterjusterat om
+*                  ADLAR r satt) och ADIF ettstlls. I Free Running Mode
+*                  startas nsta omvandling direkt.
+********************************************************************************/
+static void sim_adc_advance(void)
+{
+   if (!adc_converting || now < adc_done) return;
+
+   adc_converting = false;
+   adc_last_channel = adc_channel;
+   io16[SIM_ADC] = (io8[SIM_ADMUX] & (1 << ADLAR)) ? (uint16_t)(adc_result << 6) : adc_result;
+   shadow16[SIM_ADC] = io16[SIM_ADC];
+   strobe_value[SIM_ADCSRA] &= ~(1 << ADSC);
+   stats.adc_conversions++;
+
+   sim_set_flag(SIM_ADCSRA, ADIF, SIM_VECTOR_ADC);
+
+   if ((strobe_value[SIM_ADCSRA] & (1 << ADATE)) && (io8[SIM_ADCSRB] & 0x07) == 0)
+   {
+      sim_adc_start(26);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_wdt_write_control: Behandlar en skrivning till WDTCSR.
+*
+*                        1. WDIF nollstlls om en etta skrivs.
+*
+*                        2. Om WDCE och WDE skrivs samtidigt ppnas ett
+*                           fnster p fyra klockcykler, inom vilket WDE
+*                           samt prescalern kan ndras fritt.
+*
+*                        3. Utanfr fnstret kan WDIE ndras och WDE sttas,
+*                           men inte nollstllas, medan prescalern behlls.
+*                           WDE frblir satt s lnge WDRF r satt i MCUSR.
+*
+*                        - value: Skrivet vrde.
+********************************************************************************/
+static void sim_wdt_write_control(const uint8_t value)
+{
+   const uint8_t prescaler_mask = (1 << WDP3) | (1 << WDP2) | (1 << WDP1) | (1 << WDP0);
+   const uint8_t old_value = strobe_value[SIM_WDTCSR];
+   uint8_t control = old_value & ~(1 << WDIF);
+
+   if (value & (1 << WDIF)) control &= ~(1 << WDIF);
+   else control |= old_value & (1 << WDIF);
+
+   control = (uint8_t)((control & ~(1 << WDIE)) | (value & (1 << WDIE)));
+
+   if ((value & (1 << WDCE)) && (value & (1 << WDE)))
+   {
+      wdt_change_enabled = true;
+      wdt_change_at = now;
+      control |= (1 << WDE);
+   }
+   else if (wdt_change_enabled && now - wdt_change_at <= SIM_TIMED_SEQUENCE_CYCLES)
+   {
+      control = (uint8_t)((control & ~(prescaler_mask | (1 << WDE))) |
+                          (value & (prescaler_mask | (1 << WDE))));
+      wdt_change_enabled = false;
+   }
+   else
+   {
+      control |= value & (1 << WDE);
+      wdt_change_enabled = false;
+   }
+
+   if (io8[SIM_MCUSR] & (1 << WDRF)) control |= (1 << WDE);
+   if ((control ^ old_value) & (prescaler_mask | (1 << WDE) | (1 << WDIE))) wdt_start = now;
+   strobe_value[SIM_WDTCSR] = control;
+   return;
+}
+
+/********************************************************************************
+* sim_wdt_advance: Rknar fram Watchdog-timern. Vid timeout ettstlls WDIF om
+*                  WDIE r satt, annars terstlls systemet om WDE r satt.
+*                  Om WDIF redan r satt vid timeout med bde WDIE och WDE
+*                  satta terstlls systemet, eftersom avbrottet inte har
+*                  hunnit genomfras.
+********************************************************************************/
+static void sim_wdt_advance(void)
+{
+   const uint8_t control = strobe_value[SIM_WDTCSR];
+   if (!(control & ((1 << WDE) | (1 << WDIE)))) return;
+
+   const uint8_t prescaler = (uint8_t)((control & 0x07) | ((control >> WDP3) & 0x01) << 3);
+   const uint64_t timeout = ((uint64_t)2048 << prescaler) * F_CPU / SIM_WDT_OSC_HZ;
+   if (now - wdt_start < timeout) return;
+   wdt_start = now;
+
+   if ((control & (1 << WDIE)) && !((control & (1 << WDE)) && (control & (1 << WDIF))))
+   {
+      sim_set_flag(SIM_WDTCSR, WDIF, SIM_VECTOR_WDT);
+   }
+   else if (control & (1 << WDE))
+   {
+      stats.wdt_resets++;
+      io8[SIM_MCUSR] |= (1 << WDRF);
+      shadow8[SIM_MCUSR] = io8[SIM_MCUSR];
+      if (exit_env) longjmp(*exit_env, SIM_EXIT_WATCHDOG + 1);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_pins_update: Berknar niverna p angiven I/O-port. Utgngar fljer
+*                  PORTx, externt drivna ingngar fljer omvrlden och
+*                  vriga ingngar fljer pull-up-motstndet. ndrade niver
+*                  p pinnar vars PCI-avbrott r aktiverade i PCMSKn
+*                  ettstller motsvarande flagga i PCIFR.
+*
+*                  - port: I/O-porten 0 - 2 (B, C, D).
+********************************************************************************/
+static void sim_pins_update(const uint8_t port)
+{
+   const uint8_t ddr = io8[ddr_regs[port]];
+   const uint8_t output = io8[port_regs[port]];
+   const uint8_t input = (uint8_t)((pin_driven[port] & pin_level[port]) | (~pin_driven[port] & output));
+   const uint8_t level = (uint8_t)((ddr & output) | (~ddr & input));
+   const uint8_t changed = level ^ io8[pin_regs[port]];
+
+   io8[pin_regs[port]] = level;
+   shadow8[pin_regs[port]] = level;
+
+   if (changed & io8[pcmsk_regs[port]])
+   {
+      sim_set_flag(SIM_PCIFR, port, (enum sim_vector)(SIM_VECTOR_PCINT0 + port));
+   }
+   return;
+}
\ No newline at end of file
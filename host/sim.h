@@ -0,0 +1,446 @@
+/********************************************************************************
+* sim.h: Innehller en simulerad registerfil samt enkla modeller av
+*        ATmega328P:s kringkretsar, s att drivrutinerna kan kompileras och
+*        testas ofrndrade med gcc p en vanlig dator (vrddatorn).
+*
+*        Registren i <avr/io.h> (se host/avr/io.h) erstts av anrop till
+*        sim_io8, sim_io16 samt sim_io_strobe, som returnerar adressen till
+*        respektive register i registerfilen. Varje tkomst rknar fram den
+*        simulerade klockan SIM_ACCESS_CYCLES klockcykler, s att exempelvis
+*        vntan p att en EEPROM-skrivning blir klar fortskrider. Skrivningar
+*        upptcks vid nsta tkomst genom jmfrelse mot en skuggkopia av
+*        registerfilen, varefter motsvarande kringkrets uppdateras.
+*
+*        Register vars skrivningar har sidoeffekter ven nr vrdet r
+*        ofrndrat (flaggregister dr en etta nollstller flaggan,
+*        dataregistret UDR0, ADCSRA samt WDTCSR) lagras som 16-bitars flt
+*        med en markr i den hga byten. Om markren finns kvar vid nsta
+*        tkomst och vrdet r ofrndrat tolkas tkomsten som en lsning,
+*        annars som en skrivning. En ls-modifiera-skriv som inte ndrar
+*        ngon bit, exempelvis ADCSRA |= (1 << ADIF) nr ADIF redan r
+*        satt, gr drmed inte att skilja frn en lsning.
+*
+*        Fljande modeller finns:
+*
+*        Krets     Modell
+*        Timer 0-2 Prescaler, Normal Mode samt CTC Mode, flaggor fr
+*                  matchning samt overflow. Timer 2 kan klockas asynkront
+*                  frn en 32.768 kHz-kristall (ASSR).
+*        EEPROM    1024 byte med tidsstyrd skrivning (3.4 ms radering och
+*                  skrivning, 1.8 ms radering eller skrivning), rkning av
+*                  raderingar och skrivningar per cell samt rkning av
+*                  otilltna tkomster under pgende skrivning.
+*        USART     Sndning och mottagning i takt med vald baud rate,
+*                  dubbelbuffrat dataregister vid sndning, tv byte
+*                  mottagningsbuffert med Data OverRun samt logg ver
+*                  skickade tecken.
+*        ADC       Omvandlingstid utefter prescaler, skriptade vrden per
+*                  kanal samt automatisk start vid matchning mot OCR0A.
+*        WDT       Timeout, avbrott samt systemterstllning, dr WDE samt
+*                  prescalern krver tidsbegrnsad ndringssekvens.
+*        I/O-portar Utsignaler, pull-up, externt drivna insignaler samt
+*                  PCI-avbrott.
+*        Vilolge  Idle, ADC Noise Reduction, Power-down, Power-save samt
+*                  Standby, dr I/O-klockan stoppas i djupa vilolgen.
+*
+*        Avbrottsrutiner deklareras via ISR-makrot som vanliga funktioner,
+*        vilka anropas av simulatorn i prioritetsordning nr globala avbrott
+*        r aktiverade. Tid i simulatorn avser enbart registertkomster,
+*        vntan samt vilolge, inte exekvering av vanliga instruktioner,
+*        vilket gr att cykeltider i simulatorn utgr en undre grns.
+********************************************************************************/
+#ifndef SIM_H_
+#define SIM_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Makrodefinitioner: */
+#ifndef F_CPU
+#define F_CPU 16000000UL /* 16 MHz. */
+#endif
+
+#define SIM_ACCESS_CYCLES 2     /* Klockcykler per registertkomst (LDS/STS). */
+#define SIM_SLICE_CYCLES 16     /* Hgsta antal klockcykler mellan kontroll av avbrott. */
+#define SIM_EEPROM_SIZE 1024    /* Storlek p EEPROM-minnet i byte. */
+#define SIM_ADC_CHANNELS 16     /* Antal kanaler i AD-omvandlarens multiplexer. */
+#define SIM_USART_LOG_SIZE 65536 /* Kapacitet fr loggen ver skickade tecken. */
+
+#define SIM_CYCLES_FROM_US(us) ((uint64_t)(us) * (F_CPU / 1000000UL))   /* Mikrosekunder till klockcykler. */
+#define SIM_CYCLES_FROM_MS(ms) ((uint64_t)(ms) * (F_CPU / 1000UL))      /* Millisekunder till klockcykler. */
+
+/********************************************************************************
+* sim_io8_id: Enumeration fr 8-bitars register i registerfilen.
+********************************************************************************/
+enum sim_io8_id
+{
+   SIM_PINB, SIM_DDRB, SIM_PORTB,
+   SIM_PINC, SIM_DDRC, SIM_PORTC,
+   SIM_PIND, SIM_DDRD, SIM_PORTD,
+   SIM_EIMSK, SIM_GPIOR0, SIM_EECR, SIM_EEDR, SIM_GTCCR,
+   SIM_TCCR0A, SIM_TCCR0B, SIM_TCNT0, SIM_OCR0A, SIM_OCR0B,
+   SIM_GPIOR1, SIM_GPIOR2, SIM_ACSR, SIM_SMCR, SIM_MCUSR, SIM_MCUCR, SIM_SREG,
+   SIM_CLKPR, SIM_PRR, SIM_PCICR, SIM_EICRA, SIM_PCMSK0, SIM_PCMSK1, SIM_PCMSK2,
+   SIM_TIMSK0, SIM_TIMSK1, SIM_TIMSK2,
+   SIM_ADCSRB, SIM_ADMUX, SIM_DIDR0, SIM_DIDR1,
+   SIM_TCCR1A, SIM_TCCR1B, SIM_TCCR1C,
+   SIM_TCCR2A, SIM_TCCR2B, SIM_TCNT2, SIM_OCR2A, SIM_OCR2B, SIM_ASSR,
+   SIM_UCSR0A, SIM_UCSR0B, SIM_UCSR0C,
+   SIM_IO8_COUNT
+};
+
+/********************************************************************************
+* sim_io16_id: Enumeration fr 16-bitars register i registerfilen.
+********************************************************************************/
+enum sim_io16_id
+{
+   SIM_EEAR, SIM_ADC, SIM_TCNT1, SIM_ICR1, SIM_OCR1A, SIM_OCR1B, SIM_UBRR0,
+   SIM_IO16_COUNT
+};
+
+/********************************************************************************
+* sim_strobe_id: Enumeration fr register dr varje skrivning har
+*                sidoeffekter, oavsett skrivet vrde.
+********************************************************************************/
+enum sim_strobe_id
+{
+   SIM_TIFR0, SIM_TIFR1, SIM_TIFR2, SIM_PCIFR, SIM_EIFR,
+   SIM_ADCSRA, SIM_WDTCSR, SIM_UDR0,
+   SIM_STROBE_COUNT
+};
+
+/********************************************************************************
+* sim_vector: Enumeration fr avbrottsvektorer i prioritetsordning, dr
+*             lgre nummer har hgre prioritet.
+********************************************************************************/
+enum sim_vector
+{
+   SIM_VECTOR_INT0 = 1,      /* Externt avbrott INT0. */
+   SIM_VECTOR_INT1,          /* Externt avbrott INT1. */
+   SIM_VECTOR_PCINT0,        /* PCI-avbrott p I/O-port B. */
+   SIM_VECTOR_PCINT1,        /* PCI-avbrott p I/O-port C. */
+   SIM_VECTOR_PCINT2,        /* PCI-avbrott p I/O-port D. */
+   SIM_VECTOR_WDT,           /* Timeout fr Watchdog-timern. */
+   SIM_VECTOR_TIMER2_COMPA,  /* Matchning mot OCR2A. */
+   SIM_VECTOR_TIMER2_COMPB,  /* Matchning mot OCR2B. */
+   SIM_VECTOR_TIMER2_OVF,    /* Overflow fr Timer 2. */
+   SIM_VECTOR_TIMER1_CAPT,   /* Input Capture fr Timer 1. */
+   SIM_VECTOR_TIMER1_COMPA,  /* Matchning mot OCR1A. */
+   SIM_VECTOR_TIMER1_COMPB,  /* Matchning mot OCR1B. */
+   SIM_VECTOR_TIMER1_OVF,    /* Overflow fr Timer 1. */
+   SIM_VECTOR_TIMER0_COMPA,  /* Matchning mot OCR0A. */
+   SIM_VECTOR_TIMER0_COMPB,  /* Matchning mot OCR0B. */
+   SIM_VECTOR_TIMER0_OVF,    /* Overflow fr Timer 0. */
+   SIM_VECTOR_SPI_STC,       /* SPI-verfring klar. */
+   SIM_VECTOR_USART_RX,      /* Tecken mottaget via USART. */
+   SIM_VECTOR_USART_UDRE,    /* Dataregistret fr USART tomt. */
+   SIM_VECTOR_USART_TX,      /* Sndning via USART klar. */
+   SIM_VECTOR_ADC,           /* AD-omvandling klar. */
+   SIM_VECTOR_EE_READY,      /* EEPROM-minnet redo. */
+   SIM_VECTOR_COUNT
+};
+
+/********************************************************************************
+* sim_exit: Enumeration fr orsaken till att sim_run_main avslutades.
+********************************************************************************/
+enum sim_exit
+{
+   SIM_EXIT_RETURN,   /* Programmets main-funktion returnerade. */
+   SIM_EXIT_DEADLINE, /* Angivet antal klockcykler har passerat. */
+   SIM_EXIT_WATCHDOG  /* Watchdog-timern terstllde systemet. */
+};
+
+/********************************************************************************
+* sim_isr_stats: Strukt fr statistik ver en avbrottsvektor.
+********************************************************************************/
+struct sim_isr_stats
+{
+   uint32_t count;        /* Antal genomfrda avbrottsrutiner. */
+   uint64_t cycles;       /* Totalt antal simulerade klockcykler i rutinen. */
+   uint32_t worst_cycles; /* Hgsta antal simulerade klockcykler i rutinen. */
+   uint32_t latency_max;  /* Lngsta tid frn flagga till anrop i klockcykler. */
+};
+
+/********************************************************************************
+* sim_stats: Strukt fr statistik samt otilltna tkomster som simulatorn
+*            har upptckt.
+********************************************************************************/
+struct sim_stats
+{
+   struct sim_isr_stats isr[SIM_VECTOR_COUNT]; /* Statistik per avbrottsvektor. */
+   uint64_t sleep_cycles;           /* Antal klockcykler i vilolge. */
+   uint32_t sleeps;                 /* Antal gnger processorn har gtt i vilolge. */
+   uint32_t eeprom_reads;           /* Antal lsningar av EEPROM-minnet. */
+   uint32_t eeprom_writes;          /* Antal pbrjade skrivningar till EEPROM-minnet. */
+   uint32_t eeprom_busy_reads;      /* Lsningar medan skrivning pgr (ignoreras). */
+   uint32_t eeprom_busy_writes;     /* Skrivningar medan skrivning pgr (ignoreras). */
+   uint32_t eeprom_busy_changes;    /* ndringar av EEAR, EEDR eller EEPM under skrivning. */
+   uint32_t eeprom_ignored_writes;  /* EEPE utan EEMPE inom fyra klockcykler. */
+   uint32_t usart_tx_lost;          /* Tecken skrivna till fullt dataregister. */
+   uint32_t usart_rx_overruns;      /* Mottagna tecken frlorade via Data OverRun. */
+   uint32_t adc_conversions;        /* Antal genomfrda AD-omvandlingar. */
+   uint32_t adc_ignored_triggers;   /* Automatiska starter under pgende omvandling. */
+   uint32_t wdt_resets;             /* Systemterstllningar via Watchdog-timern. */
+};
+
+/********************************************************************************
+* sim_adc_source: Funktionspekare fr skriptade vrden till AD-omvandlaren.
+*                 Vrdet mellan 0 - 1023 returneras fr angiven kanal vid
+*                 angiven tidpunkt mtt i klockcykler.
+********************************************************************************/
+typedef uint16_t (*sim_adc_source)(uint8_t channel, uint64_t cycle, void* context);
+
+/********************************************************************************
+* sim_io8: Returnerar adressen till angivet 8-bitars register efter att
+*          tidigare skrivningar har behandlats och klockan har rknats fram.
+*
+*          - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint8_t* sim_io8(const enum sim_io8_id id);
+
+/********************************************************************************
+* sim_io16: Returnerar adressen till angivet 16-bitars register efter att
+*           tidigare skrivningar har behandlats och klockan har rknats fram.
+*
+*           - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint16_t* sim_io16(const enum sim_io16_id id);
+
+/********************************************************************************
+* sim_io_strobe: Returnerar adressen till angivet register med sidoeffekter
+*                vid skrivning, dr registrets vrde ligger i den lga byten
+*                och en markr i den hga byten.
+*
+*                - id: Registret som ska anvndas.
+********************************************************************************/
+volatile uint16_t* sim_io_strobe(const enum sim_strobe_id id);
+
+/********************************************************************************
+* sim_cli: Inaktiverar avbrott globalt (cli).
+********************************************************************************/
+void sim_cli(void);
+
+/********************************************************************************
+* sim_sei: Aktiverar avbrott globalt (sei).
+********************************************************************************/
+void sim_sei(void);
+
+/********************************************************************************
+* sim_asm: Genomfr angiven instruktion i inline-assembler. Instruktionerna
+*          WDR, SLEEP, NOP, SEI samt CLI stds.
+*
+*          - instruction: Instruktionen som text, exempelvis "WDR".
+********************************************************************************/
+void sim_asm(const char* instruction);
+
+/********************************************************************************
+* sim_read_u32: Lser ett 32-bitars vrde byte fr byte, med en
+*               instruktionsgrns fre varje byte, dr vntande avbrott
+*               genomfrs om avbrott r aktiverade. Motsvarar de fyra
+*               LDS-instruktionerna p AVR och anvnds fr delade vrden
+*               via SHARED_READ_U32 i misc.h.
+*
+*               - source: Pekare till vrdet.
+********************************************************************************/
+uint32_t sim_read_u32(const volatile uint32_t* source);
+
+/********************************************************************************
+* sim_write_u32: Skriver ett 32-bitars vrde byte fr byte, med en
+*                instruktionsgrns fre varje byte (fyra STS-instruktioner
+*                p AVR). Anvnds via SHARED_WRITE_U32 i misc.h.
+*
+*                - destination: Pekare till vrdet.
+*                - value      : Vrdet som ska skrivas.
+********************************************************************************/
+void sim_write_u32(volatile uint32_t* destination,
+                   const uint32_t value);
+
+/********************************************************************************
+* sim_sleep: Frstter processorn i vilolge enligt SMCR, frutsatt att
+*            SE r satt, tills ett avbrott som kan vcka processorn i valt
+*            vilolge ger rum (instruktionen SLEEP).
+********************************************************************************/
+void sim_sleep(void);
+
+/********************************************************************************
+* sim_delay_cycles: Lter angivet antal klockcykler passera, dr avbrott
+*                   genomfrs som vanligt (_delay_ms samt _delay_us).
+*
+*                   - cycles: Antal klockcykler.
+********************************************************************************/
+void sim_delay_cycles(const uint64_t cycles);
+
+/********************************************************************************
+* sim_reset: terstller registerfilen samt samtliga kringkretsar till
+*            lget efter pslag. EEPROM-minnets innehll behlls, medan
+*            klockan, schemalagda hndelser samt statistiken nollstlls.
+********************************************************************************/
+void sim_reset(void);
+
+/********************************************************************************
+* sim_cycles: Returnerar antalet klockcykler sedan senaste terstllning.
+********************************************************************************/
+uint64_t sim_cycles(void);
+
+/********************************************************************************
+* sim_run: Lter angivet antal klockcykler passera, dr avbrott genomfrs
+*          om globala avbrott r aktiverade. Tiden fr avbrottsrutinerna
+*          ingr, till skillnad frn sim_delay_cycles dr avbrott frlnger
+*          frdrjningen precis som i hrdvaran.
+*
+*          - cycles: Antal klockcykler.
+********************************************************************************/
+void sim_run(const uint64_t cycles);
+
+/********************************************************************************
+* sim_run_main: Kr angiven main-funktion tills den returnerar, angivet
+*               antal klockcykler har passerat eller Watchdog-timern
+*               terstller systemet. Orsaken returneras.
+*
+*               - entry : Programmets main-funktion.
+*               - cycles: Hgsta antal klockcykler att kra.
+********************************************************************************/
+enum sim_exit sim_run_main(int (*entry)(void),
+                           const uint64_t cycles);
+
+/********************************************************************************
+* sim_at: Schemalgger angiven funktion att anropas vid angiven tidpunkt,
+*         exempelvis fr att trycka ned en knapp eller skicka tecken till
+*         mikrodatorn. Funktionen anropas utanfr avbrottsrutinerna,
+*         som om den vore omvrlden. Vid full k returneras 1, annars 0.
+*
+*         - cycle   : Tidpunkten mtt i klockcykler sedan terstllning.
+*         - function: Funktionen som ska anropas.
+*         - context : Godtycklig pekare som skickas till funktionen.
+********************************************************************************/
+int sim_at(const uint64_t cycle,
+           void (*function)(void* context),
+           void* context);
+
+/********************************************************************************
+* sim_set_pin: Driver angiven pin externt till angiven niv, vilket kan ge
+*              upphov till PCI-avbrott.
+*
+*              - port : I/O-porten ('B', 'C' eller 'D').
+*              - bit  : Pinnens nummer 0 - 7 p I/O-porten.
+*              - level: Nivn som pinnen ska drivas till.
+********************************************************************************/
+void sim_set_pin(const char port,
+                 const uint8_t bit,
+                 const bool level);
+
+/********************************************************************************
+* sim_release_pin: Slutar driva angiven pin externt, s att nivn avgrs av
+*                  mikrodatorn (utsignal eller pull-up).
+*
+*                  - port: I/O-porten ('B', 'C' eller 'D').
+*                  - bit : Pinnens nummer 0 - 7 p I/O-porten.
+********************************************************************************/
+void sim_release_pin(const char port,
+                     const uint8_t bit);
+
+/********************************************************************************
+* sim_get_pin: Returnerar aktuell niv p angiven pin.
+*
+*              - port: I/O-porten ('B', 'C' eller 'D').
+*              - bit : Pinnens nummer 0 - 7 p I/O-porten.
+********************************************************************************/
+bool sim_get_pin(const char port,
+                 const uint8_t bit);
+
+/********************************************************************************
+* sim_usart_inject: Lgger angivna tecken i kn fr mottagning via USART.
+*                   Tecknen anlnder ett i taget i takt med vald baud rate.
+*
+*                   - data  : Pekare till tecknen.
+*                   - length: Antalet tecken.
+********************************************************************************/
+void sim_usart_inject(const void* data,
+                      const size_t length);
+
+/********************************************************************************
+* sim_usart_take: Flyttar skickade tecken frn loggen till angiven
+*                 destination och returnerar antalet flyttade tecken.
+*
+*                 - destination: Pekare till destinationen.
+*                 - capacity   : Hgsta antal tecken att flytta.
+********************************************************************************/
+size_t sim_usart_take(void* destination,
+                      const size_t capacity);
+
+/********************************************************************************
+* sim_usart_frame_cycles: Returnerar antalet klockcykler per tecken utefter
+*                         aktuell baud rate samt ramformat.
+********************************************************************************/
+uint32_t sim_usart_frame_cycles(void);
+
+/********************************************************************************
+* sim_adc_set_source: Vljer funktion fr skriptade vrden p angiven kanal.
+*
+*                     - channel: Kanalen 0 - 15.
+*                     - source : Funktionen, eller NULL fr konstant vrde.
+*                     - context: Godtycklig pekare som skickas till funktionen.
+********************************************************************************/
+void sim_adc_set_source(const uint8_t channel,
+                        const sim_adc_source source,
+                        void* context);
+
+/********************************************************************************
+* sim_adc_set_value: Stter ett konstant vrde p angiven kanal.
+*
+*                    - channel: Kanalen 0 - 15.
+*                    - value  : Vrdet mellan 0 - 1023.
+********************************************************************************/
+void sim_adc_set_value(const uint8_t channel,
+                       const uint16_t value);
+
+/********************************************************************************
+* sim_adc_last_channel: Returnerar kanalen fr senast genomfrd omvandling.
+********************************************************************************/
+uint8_t sim_adc_last_channel(void);
+
+/********************************************************************************
+* sim_eeprom: Returnerar en pekare till EEPROM-minnets innehll, exempelvis
+*             fr att frbereda eller kontrollera innehllet i tester.
+********************************************************************************/
+uint8_t* sim_eeprom(void);
+
+/********************************************************************************
+* sim_eeprom_erases: Returnerar antalet raderingar av angiven cell.
+*
+*                    - address: Cellens adress.
+********************************************************************************/
+uint32_t sim_eeprom_erases(const uint16_t address);
+
+/********************************************************************************
+* sim_eeprom_writes: Returnerar antalet skrivningar till angiven cell.
+*
+*                    - address: Cellens adress.
+********************************************************************************/
+uint32_t sim_eeprom_writes(const uint16_t address);
+
+/********************************************************************************
+* sim_eeprom_clear_wear: Nollstller antalet raderingar och skrivningar.
+********************************************************************************/
+void sim_eeprom_clear_wear(void);
+
+/********************************************************************************
+* sim_get_stats: Returnerar en pekare till simulatorns statistik.
+********************************************************************************/
+const struct sim_stats* sim_get_stats(void);
+
+/********************************************************************************
+* sim_clear_stats: Nollstller simulatorns statistik.
+********************************************************************************/
+void sim_clear_stats(void);
+
+/********************************************************************************
+* sim_vector_name: Returnerar namnet p angiven avbrottsvektor.
+*
+*                  - vector: Avbrottsvektorn.
+********************************************************************************/
+const char* sim_vector_name(const enum sim_vector vector);
+
+#endif /* SIM_H_ */
\ No newline at end of file
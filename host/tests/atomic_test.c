@@ -0,0 +1,300 @@
+/********************************************************************************
+* atomic_test.c: Kontrollerar att 32-bitars variabler som delas mellan
+*                avbrottsrutiner och huvudprogrammet lses och skrivs
+*                atomrt, genom att avbrott frn Timer 0 injiceras var
+*                ATOMIC_TEST_PERIOD_US:e mikrosekund under hela testet.
+*
+*                P AVR lses och skrivs en 32-bitars variabel med fyra
+*                instruktioner, en per byte, och ett avbrott kan intrffa
+*                mellan dessa. P vrddatorn r motsvarande tkomst en enda
+*                instruktion, varfr delade vrden i drivrutinerna lses
+*                och skrivs via SHARED_READ_U32 samt SHARED_WRITE_U32 (se
+*                misc.h), vilka i simulatorn terger byte fr byte-tkomsten
+*                med en instruktionsgrns, dr vntande avbrott krs, fre
+*                varje byte. Samtliga delar nedan kr drmed drivrutinernas
+*                egna funktioner med avbrott mellan byten.
+*
+*                1. Avbrottsrutinen skriver mnster dr samtliga byte r
+*                   lika. Huvudprogrammet lser frst via sim_read_u32 utan
+*                   skydd, vilket ska ge snderrivna vrden och drmed visar
+*                   att avbrotten verkligen injiceras mellan byten, drefter
+*                   via atomic_read_u32, vilket inte fr ge ngra.
+*
+*                2. Motsvarande fr skrivning via sim_write_u32 respektive
+*                   atomic_write_u32, dr avbrottsrutinen kontrollerar att
+*                   samtliga byte r lika.
+*
+*                3. Huvudprogrammet pollar timer_elapsed med varierande
+*                   intervall fr en timer vars rknare uppdateras i
+*                   avbrottsrutinen och lses byte fr byte av
+*                   timer_elapsed. Varje avbrott ska d antingen ha
+*                   rknats i en utlpt period, ha rknats ver max_count
+*                   (vilket timer_elapsed avsiktligt kastar vid
+*                   nollstllningen) eller finnas kvar i rknaren, utan
+*                   att ngot avbrott tappas eller rknas dubbelt.
+*
+*                   Drefter stts rknaren till 0xFF med max_count ver
+*                   255, varefter timer_elapsed anropas med en frdrjning
+*                   som stegas s att nsta avbrott, dr rknaren slr om
+*                   till 0x100, infaller vid varje instruktionsgrns i
+*                   timer_elapsed. Timern fr d aldrig ha lpt ut, vilket
+*                   en snderriven lsning som 0x1FF annars skulle ge.
+*
+*                4. Initieringsrutinerna fr inte aktivera avbrott globalt,
+*                   och de skyddade sektionerna ska terstlla I-flaggan
+*                   till tidigare vrde i stllet fr att alltid aktivera
+*                   avbrott.
+********************************************************************************/
+#include "button.h"
+#include "check.h"
+#include "sim.h"
+#include "timer.h"
+#include "wdt.h"
+#include <avr/interrupt.h>
+
+/* Makrodefinitioner: */
+#define ATOMIC_TEST_PERIOD_US 4         /* Tid mellan injicerade avbrott. */
+#define ATOMIC_TEST_ITERATIONS 100000UL /* Antal tkomster per variant. */
+#define ATOMIC_TEST_MAX_COUNT 2         /* Avbrottsperioder per utlpt timer i del 3. */
+#define ATOMIC_TEST_MAX_COUNT_CARRY 300 /* Motsvarande vid omslag till andra byten. */
+#define ATOMIC_TEST_CARRY_SWEEP 80      /* Antal stegade frdrjningar vid omslaget. */
+#define ATOMIC_TEST_POLL_MAX 200        /* Hgsta antal klockcykler mellan pollningar. */
+#define ATOMIC_TEST_JITTER 7            /* Varierande frdrjning fre varje tkomst i del 1-2. */
+
+/********************************************************************************
+* atomic_mode: Aktuell del av testet, som styr avbrottsrutinen.
+********************************************************************************/
+enum atomic_mode
+{
+   ATOMIC_MODE_READ,   /* Avbrottsrutinen skriver mnster. */
+   ATOMIC_MODE_WRITE,  /* Avbrottsrutinen kontrollerar mnster. */
+   ATOMIC_MODE_ELAPSED /* Avbrottsrutinen rknar enbart. */
+};
+
+/* Statiska variabler: */
+static struct timer isr_timer;
+static volatile uint32_t shared = 0;
+static volatile enum atomic_mode mode = ATOMIC_MODE_READ;
+static volatile uint32_t isr_count = 0;
+static volatile uint32_t isr_tears = 0;
+static volatile uint32_t isr_overshoot = 0;
+static uint8_t pattern = 0;
+
+ISR (TIMER0_COMPA_vect)
+{
+   timer_count(&isr_timer);
+   isr_count++;
+   if (isr_timer.counter > isr_timer.max_count) isr_overshoot++;
+
+   if (mode == ATOMIC_MODE_READ)
+   {
+      pattern++;
+      shared = pattern * 0x01010101UL;
+   }
+   else if (mode == ATOMIC_MODE_WRITE)
+   {
+      const uint32_t value = shared;
+      if (value != (value & 0xFF) * 0x01010101UL) isr_tears++;
+   }
+   return;
+}
+
+/********************************************************************************
+* check_read: Lser den delade variabeln ATOMIC_TEST_ITERATIONS gnger och
+*             returnerar antalet snderrivna vrden.
+*
+*             - atomic: Indikerar ifall atomic_read_u32 ska anvndas i
+*                       stllet fr oskyddad lsning.
+********************************************************************************/
+static uint32_t check_read(const bool atomic)
+{
+   uint32_t tears = 0;
+   mode = ATOMIC_MODE_READ;
+
+   for (uint32_t i = 0; i < ATOMIC_TEST_ITERATIONS; ++i)
+   {
+      sim_delay_cycles(i % ATOMIC_TEST_JITTER);
+      const uint32_t value = atomic ? atomic_read_u32(&shared) : sim_read_u32(&shared);
+      if (value != (value & 0xFF) * 0x01010101UL) tears++;
+   }
+   return tears;
+}
+
+/********************************************************************************
+* check_write: Skriver den delade variabeln ATOMIC_TEST_ITERATIONS gnger och
+*              returnerar antalet snderrivna vrden som avbrottsrutinen sg.
+*
+*              - atomic: Indikerar ifall atomic_write_u32 ska anvndas i
+*                        stllet fr oskyddad skrivning.
+********************************************************************************/
+static uint32_t check_write(const bool atomic)
+{
+   isr_tears = 0;
+   mode = ATOMIC_MODE_WRITE;
+
+   for (uint32_t i = 0; i < ATOMIC_TEST_ITERATIONS; ++i)
+   {
+      const uint32_t value = (uint8_t)i * 0x01010101UL;
+      sim_delay_cycles(i % ATOMIC_TEST_JITTER);
+      if (atomic) atomic_write_u32(&shared, value);
+      else sim_write_u32(&shared, value);
+   }
+
+   cli();
+   const uint32_t tears = isr_tears;
+   sei();
+   return tears;
+}
+
+/********************************************************************************
+* check_elapsed: Pollar timern ATOMIC_TEST_ITERATIONS gnger via
+*                timer_elapsed och returnerar antalet avbrott som varken
+*                rknats i en utlpt period, rknats ver max_count eller
+*                finns kvar i rknaren. Ett negativt tal innebr att avbrott
+*                har rknats dubbelt.
+*
+*                - max_count: Antal avbrottsperioder per utlpt timer.
+********************************************************************************/
+static int32_t check_elapsed(const uint32_t max_count)
+{
+   uint32_t expired = 0;
+   mode = ATOMIC_MODE_ELAPSED;
+
+   cli();
+   isr_count = 0;
+   isr_overshoot = 0;
+   timer_set_max_count(&isr_timer, max_count);
+   timer_reset_counter(&isr_timer);
+   sei();
+
+   for (uint32_t i = 0; i < ATOMIC_TEST_ITERATIONS; ++i)
+   {
+      sim_delay_cycles(i % ATOMIC_TEST_POLL_MAX);
+      if (timer_elapsed(&isr_timer)) expired++;
+   }
+
+   cli();
+   const uint32_t counted = isr_count;
+   const uint32_t overshoot = isr_overshoot;
+   const uint32_t remaining = timer_get_counter(&isr_timer);
+   sei();
+
+   printf("timer_elapsed, max_count %lu: %lu utlopta perioder, %lu avbrott over max_count\n",
+          (unsigned long)max_count, (unsigned long)expired, (unsigned long)overshoot);
+   return (int32_t)(counted - (expired * max_count + overshoot + remaining));
+}
+
+/********************************************************************************
+* check_carry: Anropar timer_elapsed nr rknaren slr om frn 0xFF till
+*              0x100, med avbrottet vid varje instruktionsgrns i tur och
+*              ordning, och returnerar antalet felaktiga utfall.
+********************************************************************************/
+static uint32_t check_carry(void)
+{
+   uint32_t failures = 0;
+   mode = ATOMIC_MODE_ELAPSED;
+   timer_set_max_count(&isr_timer, ATOMIC_TEST_MAX_COUNT_CARRY);
+
+   for (uint8_t delay = 0; delay < ATOMIC_TEST_CARRY_SWEEP; ++delay)
+   {
+      const uint32_t previous = isr_count;
+      while (isr_count == previous) sim_delay_cycles(1);
+
+      cli();
+      isr_timer.counter = 0xFF;
+      const uint32_t start = isr_count;
+      sei();
+
+      sim_delay_cycles(delay);
+      const bool elapsed = timer_elapsed(&isr_timer);
+      while (isr_count == start) sim_delay_cycles(1);
+
+      cli();
+      if (elapsed || isr_timer.counter != 0xFF + (isr_count - start)) failures++;
+      sei();
+   }
+   return failures;
+}
+
+/********************************************************************************
+* check_no_sei: Kontrollerar att initieringsrutinerna inte aktiverar avbrott
+*               globalt samt att de skyddade sektionerna terstller
+*               I-flaggan till tidigare vrde.
+********************************************************************************/
+static void check_no_sei(void)
+{
+   struct timer timer;
+   struct button button;
+   volatile uint32_t value = 0;
+
+   sim_reset();
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   timer_init_us(&timer, TIMER_SEL_1, 1000);
+   timer_enable_interrupt(&timer);
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   timer_wheel_init(TIMER_SEL_2);
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   button_init(&button, 13);
+   button_enable_interrupt(&button);
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   wdt_init(WDT_TIMEOUT_1024_MS);
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   atomic_write_u32(&value, atomic_read_u32(&value) + 1);
+   CHECK(!(SREG & (1 << SREG_I)) && value == 1);
+   (void)timer_elapsed(&timer);
+   CHECK(!(SREG & (1 << SREG_I)));
+
+   sei();
+   atomic_write_u32(&value, atomic_read_u32(&value) + 1);
+   CHECK((SREG & (1 << SREG_I)) && value == 2);
+   (void)timer_elapsed(&timer);
+   CHECK(SREG & (1 << SREG_I));
+   cli();
+   return;
+}
+
+/********************************************************************************
+* main: Genomfr samtliga delar av testet.
+********************************************************************************/
+int main(void)
+{
+   check_no_sei();
+
+   sim_reset();
+   timer_init_us(&isr_timer, TIMER_SEL_0, ATOMIC_TEST_PERIOD_US);
+   timer_set_max_count(&isr_timer, ATOMIC_TEST_MAX_COUNT);
+   timer_enable_interrupt(&isr_timer);
+   sei();
+
+   const uint32_t read_bare = check_read(false);
+   const uint32_t read_atomic = check_read(true);
+   const uint32_t write_bare = check_write(false);
+   const uint32_t write_atomic = check_write(true);
+   const int32_t lost = check_elapsed(ATOMIC_TEST_MAX_COUNT);
+   const uint32_t carry = check_carry();
+
+   printf("%lu avbrott injicerade, %lu atkomster per variant\n",
+          (unsigned long)sim_get_stats()->isr[SIM_VECTOR_TIMER0_COMPA].count,
+          (unsigned long)ATOMIC_TEST_ITERATIONS);
+   printf("Lasning:      %6lu sonderrivna utan skydd, %lu med skydd\n",
+          (unsigned long)read_bare, (unsigned long)read_atomic);
+   printf("Skrivning:    %6lu sonderrivna utan skydd, %lu med skydd\n",
+          (unsigned long)write_bare, (unsigned long)write_atomic);
+   printf("timer_elapsed: %ld tappade avbrott, %lu fel vid omslag till andra byten\n",
+          (long)lost, (unsigned long)carry);
+
+   /* Negativa kontroller, som visar att avbrotten injiceras mellan byten: */
+   CHECK(read_bare > 0);
+   CHECK(write_bare > 0);
+
+   CHECK(read_atomic == 0);
+   CHECK(write_atomic == 0);
+   CHECK(lost == 0);
+   CHECK(carry == 0);
+   return check_result("atomic_test");
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+/********************************************************************************
+* check.h: Innehller enkla makron fr tester som krs p vrddatorn.
+*          Misslyckade kontroller skrivs ut med fil och radnummer, varefter
+*          testet fortstter. Testets returvrde frn main stts via
+*          check_result, som returnerar 1 om ngon kontroll misslyckades.
+********************************************************************************/
+#ifndef CHECK_H_
+#define CHECK_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Antal misslyckade kontroller: */
+static unsigned check_failures = 0;
+
+/********************************************************************************
+* CHECK: Kontrollerar att angivet villkor r sant.
+*
+*        - condition: Villkoret som ska kontrolleras.
+********************************************************************************/
+#define CHECK(condition) \
+   check_assert((condition), #condition, __FILE__, __LINE__)
+
+/********************************************************************************
+* CHECK_RANGE: Kontrollerar att angivet vrde ligger inom angivet intervall,
+*              dr vrdet och grnserna skrivs ut vid fel.
+*
+*              - value: Vrdet som ska kontrolleras.
+*              - min  : Lgsta tilltna vrde.
+*              - max  : Hgsta tilltna vrde.
+********************************************************************************/
+#define CHECK_RANGE(value, min, max) \
+   check_range((double)(value), (double)(min), (double)(max), #value, __FILE__, __LINE__)
+
+/********************************************************************************
+* check_assert: Registrerar utfallet av en kontroll.
+*
+*               - ok        : Indikerar ifall kontrollen lyckades.
+*               - expression: Kontrollerat villkor i textform.
+*               - file      : Filen dr kontrollen genomfrdes.
+*               - line      : Radnumret dr kontrollen genomfrdes.
+********************************************************************************/
+static inline void check_assert(const bool ok,
+                                const char* expression,
+                                const char* file,
+                                const int line)
+{
+   if (!ok)
+   {
+      fprintf(stderr, "%s:%d: kontroll misslyckades: %s\n", file, line, expression);
+      check_failures++;
+   }
+   return;
+}
+
+/********************************************************************************
+* check_range: Registrerar utfallet av en intervallkontroll.
+*
+*              - value     : Kontrollerat vrde.
+*              - min       : Lgsta tilltna vrde.
+*              - max       : Hgsta tilltna vrde.
+*              - expression: Kontrollerat vrde i textform.
+*              - file      : Filen dr kontrollen genomfrdes.
+*              - line      : Radnumret dr kontrollen genomfrdes.
+********************************************************************************/
+static inline void check_range(const double value,
+                               const double min,
+                               const double max,
+                               const char* expression,
+                               const char* file,
+                               const int line)
+{
+   if (value < min || value > max)
+   {
+      fprintf(stderr, "%s:%d: %s = %g ligger utanfor [%g, %g]\n",
+              file, line, expression, value, min, max);
+      check_failures++;
+   }
+   return;
+}
+
+/********************************************************************************
+* check_result: Skriver ut antalet misslyckade kontroller och returnerar 1
+*               om ngon kontroll misslyckades, annars 0.
+*
+*               - name: Testets namn.
+********************************************************************************/
+static inline int check_result(const char* name)
+{
+   if (check_failures)
+   {
+      fprintf(stderr, "%s: %u kontroller misslyckades\n", name, check_failures);
+      return 1;
+   }
+   printf("%s: OK\n", name);
+   return 0;
+}
+
+#endif /* CHECK_H_ */
\ No newline at end of file
@@ -0,0 +1,174 @@
+/********************************************************************************
+* command_test.c: Kr hela programmet (main.c samt isr.c) i simulatorn och
+*                 skickar en fljd av kommandon via USART, dr svaret p
+*                 varje kommando kontrolleras. Tillstndet efter kommandona
+*                 fr rkning kontrolleras via kommandot state, vars binra
+*                 ram avkodas med strmparsern i host/tools.
+********************************************************************************/
+#include "check.h"
+#include "frame_parser.h"
+#include "sim.h"
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define COMMAND_TEST_REPLY_MS 50   /* Tid efter kommandot d svaret lses av. */
+#define COMMAND_TEST_OUTPUT_MAX 64 /* Hgsta antal byte per svar. */
+
+/********************************************************************************
+* command_step: Strukt fr ett kommando i fljden samt dess svar.
+********************************************************************************/
+struct command_step
+{
+   uint16_t time_ms;                        /* Tidpunkt d kommandot skickas. */
+   const char* command;                     /* Kommandot inklusive radslut. */
+   const char* expected;                    /* Frvntat svar, NULL fr state. */
+   uint8_t output[COMMAND_TEST_OUTPUT_MAX]; /* Mottaget svar. */
+   size_t length;                           /* Antalet byte i svaret. */
+};
+
+/********************************************************************************
+* state_reply: Strukt fr svaret p kommandot state.
+********************************************************************************/
+struct state_reply
+{
+   struct frame frame; /* Mottagen ram. */
+   uint8_t frames;     /* Antalet mottagna ramar. */
+};
+
+/* Programmets main-funktion (main.c kompileras med main=firmware_main): */
+int firmware_main(void);
+
+/* Statiska variabler: */
+static struct command_step steps[] =
+{
+   {  100, "number 5\r",          "OK\n\r",    { 0 }, 0 },
+   {  200, "count off\r",         "OK\n\r",    { 0 }, 0 },
+   {  300, "state\r",             NULL,        { 0 }, 0 },
+   {  400, "count up 10\r",       "OK\n\r",    { 0 }, 0 },
+   {  900, "state\r",             NULL,        { 0 }, 0 },
+   { 1000, "count down 20\r",     "OK\n\r",    { 0 }, 0 },
+   { 1500, "state\r",             NULL,        { 0 }, 0 },
+   { 1600, "count down 0\r",      "ERROR\n\r", { 0 }, 0 },
+   { 1700, "count sideways 10\r", "ERROR\n\r", { 0 }, 0 },
+   { 1800, "count up 70000\r",    "ERROR\n\r", { 0 }, 0 },
+   { 1900, "count off\r",         "OK\n\r",    { 0 }, 0 },
+   { 2000, "state\r",             NULL,        { 0 }, 0 },
+};
+
+/********************************************************************************
+* send_command: Tmmer tidigare utskrifter och skickar angivet kommando till
+*               programmet via USART.
+*
+*               - context: Pekare till steget.
+********************************************************************************/
+static void send_command(void* context)
+{
+   const struct command_step* step = context;
+   uint8_t discard[COMMAND_TEST_OUTPUT_MAX];
+
+   while (sim_usart_take(discard, sizeof(discard)));
+   sim_usart_inject(step->command, strlen(step->command));
+   return;
+}
+
+/********************************************************************************
+* take_reply: Flyttar svaret p angivet steg frn USART.
+*
+*             - context: Pekare till steget.
+********************************************************************************/
+static void take_reply(void* context)
+{
+   struct command_step* step = context;
+   step->length = sim_usart_take(step->output, sizeof(step->output));
+   return;
+}
+
+/********************************************************************************
+* store_frame: Lagrar mottagen ram i angivet svar.
+*
+*              - frame  : Pekare till ramen.
+*              - context: Pekare till svaret.
+********************************************************************************/
+static void store_frame(const struct frame* frame,
+                        void* context)
+{
+   struct state_reply* reply = context;
+   reply->frame = *frame;
+   reply->frames++;
+   return;
+}
+
+/********************************************************************************
+* check_state: Kontrollerar svaret p kommandot state i angivet steg och
+*              returnerar talet p displayerna. Svaret ska best av exakt en
+*              ram med displayernas tillstnd fljt av OK.
+*
+*              - step : Pekare till steget.
+*              - count: Indikerar ifall rkning frvntas vara aktiverad.
+*              - up   : Indikerar ifall upprkning frvntas.
+********************************************************************************/
+static uint32_t check_state(const struct command_step* step,
+                            const bool count,
+                            const bool up)
+{
+   struct frame_parser parser;
+   struct state_reply reply = { .frames = 0 };
+   frame_parser_init(&parser, store_frame, &reply);
+
+   for (size_t i = 0; i < step->length; ++i)
+   {
+      frame_parser_feed(&parser, step->output[i]);
+   }
+
+   CHECK(reply.frames == 1);
+   CHECK(parser.skipped == strlen("OK\n\r"));
+   CHECK(step->length >= 4 && !memcmp(step->output + step->length - 4, "OK\n\r", 4));
+   if (reply.frames != 1 || reply.frame.type != SERIAL_FRAME_DISPLAY_STATE) return 0;
+
+   const uint8_t* p = reply.frame.payload;
+   CHECK(!!(p[5] & SERIAL_DISPLAY_COUNT_ENABLED) == count);
+   if (count) CHECK(!!(p[5] & SERIAL_DISPLAY_COUNT_UP) == up);
+   return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/********************************************************************************
+* main: Kr programmet med samtliga kommandon och kontrollerar svaren.
+*       Kommandot count up 10 ska aktivera rkning var 10:e ms, vilket ger
+*       ungefr 50 steg fram till nsta state 500 ms senare.
+********************************************************************************/
+int main(void)
+{
+   const size_t num_steps = sizeof(steps) / sizeof(steps[0]);
+   sim_reset();
+
+   for (size_t i = 0; i < num_steps; ++i)
+   {
+      const uint64_t cycle = SIM_CYCLES_FROM_MS(steps[i].time_ms);
+      CHECK(sim_at(cycle, send_command, &steps[i]) == 0);
+      CHECK(sim_at(cycle + SIM_CYCLES_FROM_MS(COMMAND_TEST_REPLY_MS), take_reply, &steps[i]) == 0);
+   }
+
+   CHECK(sim_run_main(firmware_main, SIM_CYCLES_FROM_MS(2100)) == SIM_EXIT_DEADLINE);
+
+   for (size_t i = 0; i < num_steps; ++i)
+   {
+      const struct command_step* step = &steps[i];
+      if (step->expected == NULL) continue;
+      const bool ok = step->length == strlen(step->expected) &&
+                      !memcmp(step->output, step->expected, step->length);
+      if (!ok) fprintf(stderr, "kommando %.*s gav fel svar\n",
+                       (int)strlen(step->command) - 1, step->command);
+      CHECK(ok);
+   }
+
+   const uint32_t stopped = check_state(&steps[2], false, true);
+   const uint32_t counted_up = check_state(&steps[4], true, true);
+   const uint32_t counted_down = check_state(&steps[6], true, false);
+   (void)check_state(&steps[11], false, false);
+
+   CHECK(stopped == 5);
+   CHECK_RANGE(counted_up, stopped + 45, stopped + 50);
+   CHECK(counted_down < counted_up + 10);
+   CHECK(sim_get_stats()->usart_rx_overruns == 0);
+   return check_result("command_test");
+}
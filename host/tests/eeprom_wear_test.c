@@ -0,0 +1,322 @@
+/********************************************************************************
+* eeprom_wear_test.c: Rknar raderingar och skrivningar per cell i EEPROM nr
+*                     talet p displayerna rknas upp, samt kontrollerar att
+*                     sparat tillstnd lses in efter omstart samt att
+*                     skrivning till ringbufferten inte vntar p EEPROM-
+*                     minnet.
+*
+*                     Slitaget mts genom att display_count samt
+*                     display_flush_state anropas WEAR_STEPS gnger, varvid
+*                     skrivkn tms via avbrottsrutinen fr EEPROM Ready
+*                     mellan varje steg. Jmfrelsen grs mot en fast
+*                     adress, dr tillstndet skrivs om p samma plats vid
+*                     varje frndring, vilket motsvarar lagringen innan
+*                     ringbufferten infrdes.
+*
+*                     En cykelnoggrann simulering av ett helt r tar fr
+*                     lng tid, men ringbufferten slits periodiskt, varfr
+*                     slitaget per cell skalas linjrt frn WEAR_STEPS
+*                     steg till ett rs rkning med en frndring per
+*                     sekund dygnet runt (upprkningshastigheten 1000 ms),
+*                     vilket r vrsta fallet vid normal anvndning. Med
+*                     en livslngd p 100 000 raderingar/skrivningar per
+*                     cell ger detta omkring fyra mnaders kontinuerlig
+*                     rkning med ringbufferten, jmfrt med drygt ett
+*                     dygn utan. Testet kontrollerar att slitaget frdelas
+*                     jmnt ver samtliga platser, dvs. att ringbufferten
+*                     minskar slitaget per cell med en faktor motsvarande
+*                     antalet platser.
+*
+*                     Slutligen kontrolleras att avbrottsrutinen fr
+*                     Watchdog-timern, som anropar display_flush_state
+*                     precis som i isr.c, inte lgger en andra post i
+*                     ringbufferten nr den avbryter huvudloopen mitt i
+*                     display_flush_state. Tidpunkten fr timeout flyttas
+*                     en klockcykel i taget tills avbrottet intrffar medan
+*                     huvudloopen kar en post.
+********************************************************************************/
+#include "check.h"
+#include "display.h"
+#include "eeprom.h"
+#include "sim.h"
+#include "wdt.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define WEAR_STATE 100           /* Motsvarar EEPROM_STATE i display.c. */
+#define WEAR_STATE_RECORDS 100   /* Motsvarar EEPROM_STATE_RECORDS i display.c. */
+#define WEAR_STATE_SIZE 8        /* Storleken p struct display_state i display.c. */
+#define WEAR_BASELINE 0          /* Fast adress fr jmfrelsen. */
+#define WEAR_QUEUE_RING 10       /* Ringbuffert fr kontroll av klggningen. */
+#define WEAR_QUEUE_CYCLES 200    /* Hgsta antal klockcykler fr klggning av en post. */
+#define WEAR_STEPS 400UL         /* Antal simulerade frndringar (fyra varv). */
+#define WEAR_START 37            /* Talet innan upprkningen. */
+#define WEAR_SECONDS_PER_YEAR 31536000UL /* En frndring per sekund under ett r. */
+#define WEAR_ENDURANCE 100000UL  /* Garanterat antal raderingar/skrivningar per cell. */
+#define WEAR_WDT_CYCLES SIM_CYCLES_FROM_MS(16) /* Watchdog-timerns kortaste timeout. */
+#define WEAR_WDT_ATTEMPTS 2000   /* Hgsta antal frsk att avbryta huvudloopen. */
+
+/* Statiska variabler: */
+static const uint8_t display_cathodes[] = { D7, C3 };
+static volatile bool in_main_flush = false;
+static volatile uint32_t wdt_hits = 0;
+
+ISR (EE_READY_vect)
+{
+   eeprom_write_next();
+   return;
+}
+
+/********************************************************************************
+* ISR (WDT_vect): Som i isr.c, dr talet frst rknas upp, vilket motsvarar
+*                 en frndring frn en annan avbrottsrutin strax innan
+*                 timeout. Avbrott efter att huvudloopen har brjat ka en
+*                 post rknas.
+********************************************************************************/
+ISR (WDT_vect)
+{
+   if (in_main_flush && eeprom_write_pending()) wdt_hits++;
+   display_count();
+   display_flush_state();
+   eeprom_flush();
+   return;
+}
+
+/********************************************************************************
+* wait_eeprom: Kr simulatorn tills skrivkn r tom och pgende skrivning
+*              r genomfrd.
+********************************************************************************/
+static void wait_eeprom(void)
+{
+   while (eeprom_write_pending() || (EECR & (1 << EEPE)))
+   {
+      sim_run(SIM_CYCLES_FROM_US(500));
+   }
+   return;
+}
+
+/********************************************************************************
+* max_wear: Returnerar hgsta antal raderingar eller skrivningar fr en cell
+*           i angiven region.
+*
+*           - address: Regionens startadress.
+*           - size   : Regionens storlek i byte.
+********************************************************************************/
+static uint32_t max_wear(const uint16_t address,
+                         const uint16_t size)
+{
+   uint32_t max = 0;
+
+   for (uint16_t i = address; i < address + size; ++i)
+   {
+      const uint32_t erases = sim_eeprom_erases(i);
+      const uint32_t writes = sim_eeprom_writes(i);
+      if (erases > max) max = erases;
+      if (writes > max) max = writes;
+   }
+   return max;
+}
+
+/********************************************************************************
+* newest_number: Lser talet i den senast skrivna posten i ringbufferten,
+*                lagrat med minst signifikanta byte frst.
+*
+*                - direction: Pekare till variabel fr upprkningsriktningen.
+********************************************************************************/
+static uint32_t newest_number(uint8_t* direction)
+{
+   struct eeprom_ring ring;
+   uint8_t data[WEAR_STATE_SIZE] = { 0 };
+
+   CHECK(eeprom_ring_init(&ring, WEAR_STATE, WEAR_STATE_SIZE, WEAR_STATE_RECORDS) == 0);
+   CHECK(eeprom_ring_read(&ring, data) == 0);
+   *direction = data[6];
+   return (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+          (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+/********************************************************************************
+* test_baseline: Skriver om tillstndet p en fast adress vid varje
+*                frndring och returnerar hgsta slitaget per cell.
+********************************************************************************/
+static uint32_t test_baseline(void)
+{
+   uint8_t data[WEAR_STATE_SIZE] = { 0, 0, 0, 0, 0, 1, 1, 0 };
+   sim_eeprom_clear_wear();
+
+   for (uint32_t i = 0; i < WEAR_STEPS; ++i)
+   {
+      data[0] = (uint8_t)(i % 100);
+      CHECK(eeprom_update_block_async(WEAR_BASELINE, data, sizeof(data)) == 0);
+      wait_eeprom();
+   }
+   return max_wear(WEAR_BASELINE, WEAR_STATE_SIZE);
+}
+
+/********************************************************************************
+* test_ring: Rknar upp talet p displayerna med skrivning via
+*            ringbufferten vid varje frndring och returnerar hgsta
+*            slitaget per cell. Drefter kontrolleras att det senaste
+*            talet har sparats.
+********************************************************************************/
+static uint32_t test_ring(void)
+{
+   uint8_t direction = 0;
+
+   CHECK(display_init(display_cathodes, sizeof(display_cathodes)) == 0);
+   CHECK(display_set_number(WEAR_START) == 0);
+   display_flush_state();
+   wait_eeprom();
+   sim_eeprom_clear_wear();
+
+   for (uint32_t i = 0; i < WEAR_STEPS; ++i)
+   {
+      display_count();
+      display_flush_state();
+      wait_eeprom();
+   }
+
+   CHECK(newest_number(&direction) == (WEAR_START + WEAR_STEPS) % 100);
+   CHECK(direction == 1);
+   return max_wear(WEAR_STATE, WEAR_STATE_RECORDS * (WEAR_STATE_SIZE + 1));
+}
+
+/********************************************************************************
+* test_restart: Kontrollerar att sparat tillstnd lses in efter omstart
+*               utan att skrivas om, samt att en post med ett tal som inte
+*               ryms p displayerna erstts med starttillstndet.
+********************************************************************************/
+static void test_restart(void)
+{
+   struct eeprom_ring ring;
+   uint8_t direction = 0;
+
+   sim_eeprom_clear_wear();
+   CHECK(display_init(display_cathodes, sizeof(display_cathodes)) == 0);
+   wait_eeprom();
+   CHECK(max_wear(WEAR_STATE, WEAR_STATE_RECORDS * (WEAR_STATE_SIZE + 1)) == 0);
+   CHECK(newest_number(&direction) == (WEAR_START + WEAR_STEPS) % 100);
+
+   CHECK(eeprom_ring_init(&ring, WEAR_STATE, WEAR_STATE_SIZE, WEAR_STATE_RECORDS) == 0);
+   const uint16_t address = WEAR_STATE + (uint16_t)ring.newest * (WEAR_STATE_SIZE + 1) + 1;
+   sim_eeprom()[address] = 0xE8; /* 1000, vilket inte ryms p tv displayer. */
+   sim_eeprom()[address + 1] = 0x03;
+
+   CHECK(display_init(display_cathodes, sizeof(display_cathodes)) == 0);
+   wait_eeprom();
+   CHECK(newest_number(&direction) == 0);
+   CHECK(direction == 1);
+   return;
+}
+
+/********************************************************************************
+* test_queue: Kontrollerar att en post lggs i skrivkn medan en skrivning
+*             pgr utan att EEPROM-minnet lses eller att funktionen vntar
+*             in skrivningen, samt att bda posterna skrivs.
+********************************************************************************/
+static void test_queue(void)
+{
+   struct eeprom_ring ring;
+   const uint8_t first[WEAR_STATE_SIZE] = { 1, 2, 3, 4, 5, 6, 7, 0 };
+   const uint8_t second[WEAR_STATE_SIZE] = { 8, 7, 6, 5, 4, 3, 2, 0 };
+   uint8_t data[WEAR_STATE_SIZE] = { 0 };
+   const uint32_t busy_reads = sim_get_stats()->eeprom_busy_reads;
+
+   CHECK(eeprom_ring_init(&ring, WEAR_QUEUE_RING, WEAR_STATE_SIZE, 2) == 0);
+   CHECK(eeprom_ring_write(&ring, first) == 0);
+   sim_run(SIM_CYCLES_FROM_US(100));
+   CHECK(EECR & (1 << EEPE));
+
+   const uint64_t start = sim_cycles();
+   CHECK(eeprom_ring_write(&ring, second) == 0);
+   CHECK(sim_cycles() - start < WEAR_QUEUE_CYCLES);
+   CHECK(sim_get_stats()->eeprom_busy_reads == busy_reads);
+
+   wait_eeprom();
+   CHECK(eeprom_ring_init(&ring, WEAR_QUEUE_RING, WEAR_STATE_SIZE, 2) == 0);
+   CHECK(eeprom_ring_read(&ring, data) == 0);
+   CHECK(memcmp(data, second, sizeof(data)) == 0);
+   CHECK(sim_get_stats()->eeprom_busy_reads == busy_reads);
+   return;
+}
+
+/********************************************************************************
+* test_watchdog_flush: Kontrollerar att ett avbrott frn Watchdog-timern
+*                      under huvudloopens display_flush_state inte lgger en
+*                      andra post p samma plats i ringbufferten, utan att
+*                      frndringen i stllet sparas som en egen post vid
+*                      nsta anrop frn huvudloopen.
+********************************************************************************/
+static void test_watchdog_flush(void)
+{
+   struct eeprom_ring ring;
+   uint8_t direction = 0;
+
+   CHECK(display_init(display_cathodes, sizeof(display_cathodes)) == 0);
+   wait_eeprom();
+
+   for (uint32_t offset = 0; offset < WEAR_WDT_ATTEMPTS && !wdt_hits; ++offset)
+   {
+      /* Frndringar som fregende frsks avbrott lmnade osparade: */
+      display_flush_state();
+      wait_eeprom();
+
+      CHECK(eeprom_ring_init(&ring, WEAR_STATE, WEAR_STATE_SIZE, WEAR_STATE_RECORDS) == 0);
+      const uint8_t newest = ring.newest;
+      const uint32_t number = newest_number(&direction);
+
+      display_count();
+      wdt_init(WDT_TIMEOUT_16_MS);
+      wdt_enable_interrupt();
+      sim_delay_cycles(WEAR_WDT_CYCLES - offset);
+
+      in_main_flush = true;
+      display_flush_state();
+      in_main_flush = false;
+      wdt_clear();
+      wait_eeprom();
+
+      if (wdt_hits)
+      {
+         printf("Watchdog-avbrott under display_flush_state %lu klockcykler fore timeout\n",
+                (unsigned long)offset);
+         display_flush_state();
+         wait_eeprom();
+         CHECK(eeprom_ring_init(&ring, WEAR_STATE, WEAR_STATE_SIZE, WEAR_STATE_RECORDS) == 0);
+         CHECK(ring.newest == (newest + 2) % WEAR_STATE_RECORDS);
+         CHECK(newest_number(&direction) == (number + 2) % 100);
+      }
+   }
+
+   CHECK(wdt_hits == 1);
+   return;
+}
+
+/********************************************************************************
+* main: Genomfr mtningen och kontrollerna samt skriver ut slitaget.
+********************************************************************************/
+int main(void)
+{
+   sim_reset();
+   sei();
+
+   const uint32_t baseline = test_baseline();
+   const uint32_t ring = test_ring();
+   const double scale = (double)WEAR_SECONDS_PER_YEAR / WEAR_STEPS;
+
+   printf("%-12s %12s %14s %12s\n", "lagring", "max/cell", "max/cell/ar", "livslangd");
+   printf("%-12s %12lu %14.0f %9.1f dg\n", "fast adress", (unsigned long)baseline,
+          baseline * scale, WEAR_ENDURANCE / (baseline * scale) * 365.0);
+   printf("%-12s %12lu %14.0f %9.1f dg\n", "ringbuffert", (unsigned long)ring,
+          ring * scale, WEAR_ENDURANCE / (ring * scale) * 365.0);
+
+   CHECK(baseline == WEAR_STEPS);
+   CHECK(ring > 0);
+   CHECK(ring <= WEAR_STEPS / WEAR_STATE_RECORDS);
+
+   test_restart();
+   test_queue();
+   test_watchdog_flush();
+   return check_result("eeprom_wear_test");
+}
\ No newline at end of file
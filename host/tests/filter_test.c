@@ -0,0 +1,332 @@
+/********************************************************************************
+* filter_test.c: Kontrollerar filtren i filter.h samt filtrering av samplerns
+*                resultat via adc_set_filter.
+*
+*                1. Steg- och spiksvar fr glidande medelvrde, EMA samt
+*                   median jmfrs med frvntade utsignaler, dr frsta
+*                   vrdet i varje fljd fyller filtret.
+*
+*                2. Frsta vrdet efter initiering samt efter filter_reset
+*                   ska fylla hela filtret, s att utsignalen inte startar
+*                   frn noll.
+*
+*                3. filter_init ska avvisa ogiltiga parametrar och d lmna
+*                   filtret ofrndrat.
+*
+*                4. Tv kanaler omvandlas av samplern med skriptade vrden,
+*                   dr A1 filtreras med median av tre vrden och innehller
+*                   enstaka spikar, medan A3 filtreras med glidande
+*                   medelvrde av fyra vrden och innehller ett steg.
+*                   Spikarna ska tas bort helt och steget ska flja
+*                   medelvrdets insvngning.
+********************************************************************************/
+#include "adc.h"
+#include "check.h"
+#include "filter.h"
+#include "sim.h"
+#include <avr/interrupt.h>
+
+/* Makrodefinitioner: */
+#define FILTER_TEST_LOW 100        /* Grundniv fr steg och spikar. */
+#define FILTER_TEST_HIGH 500       /* Niv efter steg samt spikarnas niv. */
+#define FILTER_TEST_SPIKE_PERIOD 7 /* Antal omvandlingar mellan spikarna p A1. */
+#define FILTER_TEST_STEP_AT 10     /* Omvandling dr steget p A3 intrffar. */
+#define FILTER_TEST_EMA_STEPS 40   /* Hgsta antal vrden fr EMA att n ny niv. */
+#define FILTER_TEST_STEP_LAST 4    /* Index fr sista frvntade vrdet i stegsvaret p A3. */
+
+ISR (ADC_vect)
+{
+   adc_sample_next();
+   return;
+}
+
+/********************************************************************************
+* check_sequence: Initierar ett filter, matar in angivna vrden och
+*                 kontrollerar varje utsignal mot frvntat vrde.
+*
+*                 - type     : Valt filter.
+*                 - parameter: Filtrets parameter.
+*                 - input    : Insignaler, dr den frsta fyller filtret.
+*                 - expected : Frvntade utsignaler.
+*                 - count    : Antal vrden.
+********************************************************************************/
+static void check_sequence(const enum filter_type type,
+                           const uint8_t parameter,
+                           const uint16_t* input,
+                           const uint16_t* expected,
+                           const uint8_t count)
+{
+   struct filter filter;
+   CHECK(filter_init(&filter, type, parameter) == 0);
+
+   for (uint8_t i = 0; i < count; ++i)
+   {
+      const uint16_t output = filter_put(&filter, input[i]);
+      if (output != expected[i])
+      {
+         printf("filter %u/%u, varde %u: %u, forvantat %u\n", type, parameter, i,
+                output, expected[i]);
+      }
+      CHECK(output == expected[i]);
+   }
+   return;
+}
+
+/********************************************************************************
+* test_moving_average: Kontrollerar steg- och spiksvar fr glidande
+*                      medelvrde av fyra vrden, dr steget nr ny niv
+*                      efter fyra vrden och spiken sprids ut som en
+*                      fjrdedel ver fyra vrden.
+********************************************************************************/
+static void test_moving_average(void)
+{
+   static const uint16_t step_in[] = { 100, 100, 500, 500, 500, 500, 500 };
+   static const uint16_t step_out[] = { 100, 100, 200, 300, 400, 500, 500 };
+   static const uint16_t spike_in[] = { 100, 100, 500, 100, 100, 100, 100, 100 };
+   static const uint16_t spike_out[] = { 100, 100, 200, 200, 200, 200, 100, 100 };
+
+   check_sequence(FILTER_MOVING_AVERAGE, 4, step_in, step_out, sizeof(step_in) / sizeof(step_in[0]));
+   check_sequence(FILTER_MOVING_AVERAGE, 4, spike_in, spike_out, sizeof(spike_in) / sizeof(spike_in[0]));
+   return;
+}
+
+/********************************************************************************
+* test_ema: Kontrollerar steg- och spiksvar fr EMA med skiftning 2, dvs.
+*           alfa = 1 / 4. Frsta vrdet efter steget respektive spiken ska
+*           flytta utsignalen en fjrdedel av skillnaden, varefter
+*           utsignalen ska nrma sig ny niv utan att passera den och n
+*           den inom FILTER_TEST_EMA_STEPS vrden, i bda riktningarna.
+********************************************************************************/
+static void test_ema(void)
+{
+   struct filter filter;
+   uint16_t previous;
+   uint8_t steps = 0;
+
+   CHECK(filter_init(&filter, FILTER_EMA, 2) == 0);
+   CHECK(filter_put(&filter, FILTER_TEST_LOW) == FILTER_TEST_LOW);
+   previous = filter_put(&filter, FILTER_TEST_HIGH);
+   CHECK(previous == FILTER_TEST_LOW + (FILTER_TEST_HIGH - FILTER_TEST_LOW) / 4);
+
+   while (previous != FILTER_TEST_HIGH && steps++ < FILTER_TEST_EMA_STEPS)
+   {
+      const uint16_t output = filter_put(&filter, FILTER_TEST_HIGH);
+      CHECK(output >= previous && output <= FILTER_TEST_HIGH);
+      previous = output;
+   }
+   CHECK(previous == FILTER_TEST_HIGH);
+
+   CHECK(filter_init(&filter, FILTER_EMA, 2) == 0);
+   CHECK(filter_put(&filter, FILTER_TEST_LOW) == FILTER_TEST_LOW);
+   previous = filter_put(&filter, FILTER_TEST_HIGH);
+   CHECK(previous == FILTER_TEST_LOW + (FILTER_TEST_HIGH - FILTER_TEST_LOW) / 4);
+   steps = 0;
+
+   while (previous != FILTER_TEST_LOW && steps++ < FILTER_TEST_EMA_STEPS)
+   {
+      const uint16_t output = filter_put(&filter, FILTER_TEST_LOW);
+      CHECK(output <= previous && output >= FILTER_TEST_LOW);
+      previous = output;
+   }
+   CHECK(previous == FILTER_TEST_LOW);
+   return;
+}
+
+/********************************************************************************
+* test_median: Kontrollerar att median av tre vrden tar bort enstaka spikar
+*              helt och fljer ett steg efter tv vrden, samt att median av
+*              fem vrden ven tar bort tv spikar i fljd.
+********************************************************************************/
+static void test_median(void)
+{
+   static const uint16_t spike_in[] = { 100, 100, 500, 100, 100, 0, 100, 100 };
+   static const uint16_t spike_out[] = { 100, 100, 100, 100, 100, 100, 100, 100 };
+   static const uint16_t step_in[] = { 100, 100, 500, 500, 500 };
+   static const uint16_t step_out[] = { 100, 100, 100, 500, 500 };
+   static const uint16_t double_in[] = { 100, 100, 500, 500, 100, 100, 100 };
+   static const uint16_t double_out[] = { 100, 100, 100, 100, 100, 100, 100 };
+
+   check_sequence(FILTER_MEDIAN, 3, spike_in, spike_out, sizeof(spike_in) / sizeof(spike_in[0]));
+   check_sequence(FILTER_MEDIAN, 3, step_in, step_out, sizeof(step_in) / sizeof(step_in[0]));
+   check_sequence(FILTER_MEDIAN, 5, double_in, double_out, sizeof(double_in) / sizeof(double_in[0]));
+   return;
+}
+
+/********************************************************************************
+* test_priming: Kontrollerar att frsta vrdet efter initiering fyller hela
+*               filtret fr samtliga filter med strsta fnstret, samt att
+*               filter_reset gr att nsta vrde fyller filtret p nytt.
+********************************************************************************/
+static void test_priming(void)
+{
+   static const enum filter_type types[] = { FILTER_NONE, FILTER_MOVING_AVERAGE, FILTER_EMA, FILTER_MEDIAN };
+   static const uint8_t parameters[] = { 0, FILTER_WINDOW_SIZE, FILTER_EMA_SHIFT_MAX, FILTER_MEDIAN_MAX };
+   struct filter filter;
+
+   for (uint8_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+   {
+      CHECK(filter_init(&filter, types[i], parameters[i]) == 0);
+      CHECK(filter_put(&filter, 700) == 700);
+      CHECK(filter_put(&filter, 700) == 700);
+
+      filter_reset(&filter);
+      CHECK(filter_put(&filter, 50) == 50);
+      CHECK(filter_put(&filter, 50) == 50);
+   }
+   return;
+}
+
+/********************************************************************************
+* test_init: Kontrollerar att filter_init godtar samtliga tilltna
+*            parametrar, avvisar ogiltiga parametrar samt lmnar filtret
+*            ofrndrat vid felkod.
+********************************************************************************/
+static void test_init(void)
+{
+   struct filter filter;
+
+   CHECK(filter_init(&filter, FILTER_NONE, 0) == 0);
+   CHECK(filter_init(&filter, FILTER_NONE, 99) == 0);
+
+   for (uint8_t parameter = 0; parameter <= 2 * FILTER_WINDOW_SIZE; ++parameter)
+   {
+      const bool valid = parameter == 2 || parameter == 4 || parameter == 8;
+      CHECK(filter_init(&filter, FILTER_MOVING_AVERAGE, parameter) == (valid ? 0 : 1));
+   }
+
+   for (uint8_t parameter = 0; parameter <= 2 * FILTER_EMA_SHIFT_MAX; ++parameter)
+   {
+      const bool valid = parameter >= 1 && parameter <= FILTER_EMA_SHIFT_MAX;
+      CHECK(filter_init(&filter, FILTER_EMA, parameter) == (valid ? 0 : 1));
+   }
+
+   for (uint8_t parameter = 0; parameter <= 2 * FILTER_MEDIAN_MAX; ++parameter)
+   {
+      const bool valid = parameter == 3 || parameter == 5 || parameter == 7;
+      CHECK(filter_init(&filter, FILTER_MEDIAN, parameter) == (valid ? 0 : 1));
+   }
+
+   CHECK(filter_init(&filter, (enum filter_type)(FILTER_MEDIAN + 1), 3) == 1);
+
+   CHECK(filter_init(&filter, FILTER_MOVING_AVERAGE, 4) == 0);
+   CHECK(filter_put(&filter, 200) == 200);
+   CHECK(filter_init(&filter, FILTER_MEDIAN, 4) == 1);
+   CHECK(filter_init(&filter, FILTER_EMA, 0) == 1);
+   CHECK(filter.type == FILTER_MOVING_AVERAGE && filter.length == 4 && filter.primed);
+   CHECK(filter_put(&filter, 600) == 300);
+   return;
+}
+
+/********************************************************************************
+* spike_source: Returnerar FILTER_TEST_LOW, med en spike till
+*               FILTER_TEST_HIGH var FILTER_TEST_SPIKE_PERIOD:e omvandling
+*               utom den frsta.
+*
+*               - channel: Kanalen (anvnds ej).
+*               - cycle  : Tidpunkten (anvnds ej).
+*               - context: Pekare till antalet omvandlingar av kanalen.
+********************************************************************************/
+static uint16_t spike_source(uint8_t channel,
+                             uint64_t cycle,
+                             void* context)
+{
+   uint32_t* count = context;
+   const uint32_t n = (*count)++;
+   (void)channel;
+   (void)cycle;
+   return n && n % FILTER_TEST_SPIKE_PERIOD == 0 ? FILTER_TEST_HIGH : FILTER_TEST_LOW;
+}
+
+/********************************************************************************
+* step_source: Returnerar FILTER_TEST_LOW fre omvandling FILTER_TEST_STEP_AT
+*              och FILTER_TEST_HIGH drefter.
+*
+*              - channel: Kanalen (anvnds ej).
+*              - cycle  : Tidpunkten (anvnds ej).
+*              - context: Pekare till antalet omvandlingar av kanalen.
+********************************************************************************/
+static uint16_t step_source(uint8_t channel,
+                            uint64_t cycle,
+                            void* context)
+{
+   uint32_t* count = context;
+   (void)channel;
+   (void)cycle;
+   return (*count)++ < FILTER_TEST_STEP_AT ? FILTER_TEST_LOW : FILTER_TEST_HIGH;
+}
+
+/********************************************************************************
+* test_adc_filter: Kontrollerar filtrering av samplerns resultat via
+*                  adc_set_filter, dr spikarna p A1 ska tas bort helt och
+*                  steget p A3 ska ge glidande medelvrdets insvngning,
+*                  oavsett vilken omvandling som frst fyller filtren.
+********************************************************************************/
+static void test_adc_filter(void)
+{
+   static const uint16_t step_out[] = { 100, 200, 300, 400, 500 };
+   uint32_t spike_count = 0;
+   uint32_t step_count = 0;
+   uint32_t spikes = 0;
+   uint8_t step_index = 0;
+   uint32_t a1_results = 0;
+   uint32_t a3_results = 0;
+   uint16_t sample;
+
+   sim_reset();
+   sim_adc_set_source(1, spike_source, &spike_count);
+   sim_adc_set_source(3, step_source, &step_count);
+
+   CHECK(adc_set_filter(A1, FILTER_MEDIAN, 3) == 0);
+   CHECK(adc_set_filter(A3, FILTER_MOVING_AVERAGE, 4) == 0);
+   CHECK(adc_set_filter(A3, FILTER_MOVING_AVERAGE, 3) == 1);
+   CHECK(adc_set_filter(6, FILTER_EMA, 2) == 1);
+   CHECK(adc_sampler_init((1 << 1) | (1 << 3)) == 0);
+   sei();
+
+   while (step_count < 2 * FILTER_TEST_STEP_AT || spike_count < 4 * FILTER_TEST_SPIKE_PERIOD)
+   {
+      sim_run(SIM_CYCLES_FROM_US(500));
+
+      while (adc_read_sample(A1, &sample) == 0)
+      {
+         if (sample != FILTER_TEST_LOW) spikes++;
+         a1_results++;
+      }
+
+      while (adc_read_sample(A3, &sample) == 0)
+      {
+         if (step_index < FILTER_TEST_STEP_LAST && sample == step_out[step_index + 1]) step_index++;
+         CHECK(sample == step_out[step_index]);
+         a3_results++;
+      }
+   }
+
+   adc_sampler_stop();
+   cli();
+
+   printf("A1: %lu resultat, %lu spikar kvar; A3: %lu resultat, steg %u av %u\n",
+          (unsigned long)a1_results, (unsigned long)spikes, (unsigned long)a3_results,
+          step_index, FILTER_TEST_STEP_LAST);
+
+   CHECK(adc_get_overruns() == 0);
+   CHECK(a1_results > 0 && spikes == 0);
+   CHECK(step_index == FILTER_TEST_STEP_LAST);
+
+   CHECK(adc_set_filter(A1, FILTER_NONE, 0) == 0);
+   CHECK(adc_set_filter(A3, FILTER_NONE, 0) == 0);
+   return;
+}
+
+/********************************************************************************
+* main: Kr samtliga tester.
+********************************************************************************/
+int main(void)
+{
+   test_moving_average();
+   test_ema();
+   test_median();
+   test_priming();
+   test_init();
+   test_adc_filter();
+   return check_result("filter_test");
+}
\ No newline at end of file
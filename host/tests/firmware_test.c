@@ -0,0 +1,49 @@
+/********************************************************************************
+* firmware_test.c: Kr hela programmet (main.c samt isr.c) i simulatorn och
+*                  kontrollerar att det startar, svarar p kommandon via
+*                  USART och krs utan att Watchdog-timern terstller
+*                  systemet.
+********************************************************************************/
+#include "check.h"
+#include "sim.h"
+#include <string.h>
+
+/* Programmets main-funktion (main.c kompileras med main=firmware_main): */
+int firmware_main(void);
+
+/********************************************************************************
+* send_command: Skickar ett kommando till programmet via USART.
+*
+*               - context: Pekare till kommandot.
+********************************************************************************/
+static void send_command(void* context)
+{
+   const char* command = (const char*)context;
+   sim_usart_inject(command, strlen(command));
+   return;
+}
+
+/********************************************************************************
+* main: Kr programmet i tre sekunder med ett kommando efter en sekund.
+********************************************************************************/
+int main(void)
+{
+   static char command[] = "number 42\r";
+   char output[256] = { 0 };
+
+   sim_reset();
+   CHECK(sim_at(SIM_CYCLES_FROM_MS(1000), send_command, command) == 0);
+   CHECK(sim_run_main(firmware_main, SIM_CYCLES_FROM_MS(3000)) == SIM_EXIT_DEADLINE);
+   (void)sim_usart_take(output, sizeof(output) - 1);
+
+   const struct sim_stats* stats = sim_get_stats();
+   CHECK(strstr(output, "OK") != NULL);
+   CHECK(stats->wdt_resets == 0);
+   CHECK(stats->usart_rx_overruns == 0);
+   CHECK(stats->usart_tx_lost == 0);
+   CHECK(stats->eeprom_busy_reads == 0);
+   CHECK(stats->eeprom_ignored_writes == 0);
+   CHECK(stats->sleeps > 0);
+   CHECK_RANGE(stats->isr[SIM_VECTOR_TIMER2_COMPA].count, 2990, 3010);
+   return check_result("firmware_test");
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+# float_check: Kontrollerar att programmet inte länkar in någon funktion
+# som räknar med flyttal, vilket på AVR skulle dra in mjukvaruflyttal
+# (__addsf3, __mulsf3, __fixsfsi med flera) från libgcc.
+#
+# Samtliga funktioner i programmets och drivrutinernas objektfiler som
+# innehåller flyttalsinstruktioner listas, varefter länkkartan
+# för firmware_test, som länkas med --gc-sections, visar vilka av dessa
+# som ingår i programmet. Funktionerna som finns kvar i drivrutinerna
+# skrivs ut, men enbart länkade funktioner ger fel. Inline-funktionerna med
+# flyttal i adc.h och tmp36.h instansieras enbart i objektfiler som anropar
+# dem och kontrolleras därmed på samma sätt.
+#
+# Fördröjningarna i misc.c anropar _delay_ms respektive _delay_us med
+# konstanter, vilka avr-libc beräknar vid kompilering, medan motsvarande
+# funktioner för värddatorn (host/util/delay.h) räknar med flyttal vid
+# körning. Dessa undantas därför.
+#
+# På x86-64 räknas omvandlingar (cvt*), skalär och packad aritmetik med
+# enkel eller dubbel precision (addsd, mulps med flera), jämförelser
+# (ucomisd, comiss) samt x87-instruktioner som flyttal. Registren %xmm
+# används även för heltal, exempelvis vid vektorisering och nollställning
+# av strukter med optimering (pxor, movups), och räknas därför inte.
+#
+# Parametrar: OBJDUMP, MAP (länkkartan) samt OBJECTS (objektfilerna).
+cmake_minimum_required(VERSION 3.13)
+
+set(HOST_ONLY _delay_ms _delay_us delay_ms delay_us delay_ms_ptr delay_us_ptr)
+set(FLOAT_OPCODES "v?cvt[a-z0-9]+|v?(add|sub|mul|div|sqrt|min|max|round)[sp][sd]|v?u?comis[sd]|f(ld|st|i?add|i?sub|i?mul|i?div)[a-z]*")
+
+file(READ ${MAP} map)
+string(FIND "${map}" "Linker script and memory map" start)
+if(start LESS 0)
+   message(FATAL_ERROR "float_check: ${MAP} saknar minneskarta")
+endif()
+string(SUBSTRING "${map}" ${start} -1 map)
+
+set(found 0)
+set(linked "")
+
+foreach(object ${OBJECTS})
+   get_filename_component(name ${object} NAME)
+   if(name MATCHES "^sim\\.c\\.")
+      continue()
+   endif()
+
+   execute_process(COMMAND ${OBJDUMP} -d --no-show-raw-insn ${object}
+      OUTPUT_VARIABLE listing RESULT_VARIABLE result)
+   if(NOT result EQUAL 0)
+      message(FATAL_ERROR "float_check: ${OBJDUMP} misslyckades for ${object}")
+   endif()
+
+   string(REPLACE ";" "," listing "${listing}")
+   string(REPLACE "\n" ";" lines "${listing}")
+   set(function "")
+   set(functions "")
+
+   foreach(line ${lines})
+      if(line MATCHES "^[0-9a-f]+ <([^>]+)>:$")
+         set(function ${CMAKE_MATCH_1})
+      elseif(line MATCHES ":\t(${FLOAT_OPCODES})[ \t]" AND function AND NOT function IN_LIST HOST_ONLY)
+         list(APPEND functions ${function})
+      endif()
+   endforeach()
+
+   list(REMOVE_DUPLICATES functions)
+   foreach(function ${functions})
+      math(EXPR found "${found} + 1")
+      if(map MATCHES "\n \\.text\\.${function}[ \t\r\n]+0x")
+         message("${name}: ${function} lankad")
+         list(APPEND linked ${function})
+      else()
+         message("${name}: ${function} ej lankad")
+      endif()
+   endforeach()
+endforeach()
+
+list(LENGTH linked count)
+message("${found} funktioner med flyttal i drivrutinerna, ${count} lankade i programmet")
+if(count GREATER 0)
+   message(FATAL_ERROR "float_check: programmet lankar flyttal via ${linked}")
+endif()
@@ -0,0 +1,284 @@
+/********************************************************************************
+* frame_test.c: Kontrollerar de binra ramarna frn serial_send_frame mot
+*               strmparsern i host/tools/frame_parser.c.
+*
+*               Ramar av samtliga typer skickas via USART i 1 Mbps, blandade
+*               med lsbar text, och avkodas av parsern. Drefter skadas
+*               strmmen p tre stt: en databyte ndras (felaktig CRC-8),
+*               en ram avkortas, s att nsta ram brjar mitt i den, samt en
+*               lngdbyte ndras till ett fr stort vrde. I samtliga fall
+*               ska enbart den skadade ramen frkastas.
+********************************************************************************/
+#include "check.h"
+#include "frame_parser.h"
+#include "sim.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define FRAME_TEST_STREAM_MAX 256 /* Hgsta antal mottagna byte. */
+#define FRAME_TEST_FRAMES_MAX 16  /* Hgsta antal mottagna ramar. */
+
+/********************************************************************************
+* frame_log: Strukt fr ramar mottagna av parsern.
+********************************************************************************/
+struct frame_log
+{
+   struct frame frames[FRAME_TEST_FRAMES_MAX]; /* Mottagna ramar. */
+   uint8_t count;                              /* Antalet mottagna ramar. */
+};
+
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+/********************************************************************************
+* log_frame: Lagrar mottagen ram i angiven logg.
+*
+*            - frame  : Pekare till ramen.
+*            - context: Pekare till loggen.
+********************************************************************************/
+static void log_frame(const struct frame* frame,
+                      void* context)
+{
+   struct frame_log* log = context;
+   if (log->count < FRAME_TEST_FRAMES_MAX) log->frames[log->count++] = *frame;
+   return;
+}
+
+/********************************************************************************
+* take_stream: Kr simulatorn tills samtliga byte har skickats och flyttar
+*              dessa till angiven destination. Antalet byte returneras.
+*
+*              - destination: Pekare till destinationen.
+********************************************************************************/
+static size_t take_stream(uint8_t* destination)
+{
+   const uint32_t frame = sim_usart_frame_cycles();
+
+   while (serial_transmit_pending()) sim_run(frame);
+   sim_run(2 * frame);
+   return sim_usart_take(destination, FRAME_TEST_STREAM_MAX);
+}
+
+/********************************************************************************
+* parse: Matar in angiven strm i en ny parser och lagrar mottagna ramar.
+*
+*        - parser: Pekare till parsern.
+*        - log   : Pekare till loggen fr mottagna ramar.
+*        - stream: Pekare till strmmen.
+*        - length: Antalet byte i strmmen.
+********************************************************************************/
+static void parse(struct frame_parser* parser,
+                  struct frame_log* log,
+                  const uint8_t* stream,
+                  const size_t length)
+{
+   memset(log, 0, sizeof(*log));
+   frame_parser_init(parser, log_frame, log);
+
+   for (size_t i = 0; i < length; ++i)
+   {
+      frame_parser_feed(parser, stream[i]);
+   }
+   return;
+}
+
+/********************************************************************************
+* find_frame: Returnerar index fr den frsta ramen av angiven typ som brjar
+*             efter angivet index i strmmen, eller -1 om ingen sdan finns.
+*
+*             - stream: Pekare till strmmen.
+*             - length: Antalet byte i strmmen.
+*             - start : Index dr skningen brjar.
+*             - type  : Ramtypen som sks.
+********************************************************************************/
+static int find_frame(const uint8_t* stream,
+                      const size_t length,
+                      const size_t start,
+                      const uint8_t type)
+{
+   for (size_t i = start; i + 1 < length; ++i)
+   {
+      if (stream[i] == SERIAL_FRAME_SYNC && stream[i + 1] == type) return (int)i;
+   }
+   return -1;
+}
+
+/********************************************************************************
+* check_crc: Kontrollerar CRC-8 mot kontrollvrdet fr polynom 0x07.
+********************************************************************************/
+static void check_crc(void)
+{
+   const char* text = "123456789";
+   uint8_t crc = 0;
+
+   for (size_t i = 0; i < strlen(text); ++i)
+   {
+      crc = frame_crc8(crc, (uint8_t)text[i]);
+   }
+   CHECK(crc == 0xF4);
+   return;
+}
+
+/********************************************************************************
+* check_intact: Kontrollerar att samtliga ramar i en oskadad strm avkodas
+*               med korrekt innehll och att texten mellan dem hoppas ver.
+*
+*               - stream: Pekare till strmmen.
+*               - length: Antalet byte i strmmen.
+********************************************************************************/
+static void check_intact(const uint8_t* stream,
+                         const size_t length)
+{
+   struct frame_parser parser;
+   struct frame_log log;
+   parse(&parser, &log, stream, length);
+
+   CHECK(log.count == 5);
+   CHECK(parser.frames == 5);
+   CHECK(parser.crc_errors == 0);
+   CHECK(parser.length_errors == 0);
+   CHECK(parser.skipped == strlen("Start\n\r") + strlen("Mellan\n\r"));
+   if (log.count != 5) return;
+
+   const struct frame* f = log.frames;
+   CHECK(f[0].type == SERIAL_FRAME_TEMPERATURE && f[0].length == 2);
+   CHECK((int16_t)(f[0].payload[0] | f[0].payload[1] << 8) == 2345);
+   CHECK(f[1].type == SERIAL_FRAME_TEMPERATURE);
+   CHECK((int16_t)(f[1].payload[0] | f[1].payload[1] << 8) == -1250);
+   CHECK(f[2].type == SERIAL_FRAME_ADC_RAW && f[2].length == 3);
+   CHECK(f[2].payload[0] == 5 && (f[2].payload[1] | f[2].payload[2] << 8) == 1023);
+   CHECK(f[3].type == SERIAL_FRAME_DISPLAY_STATE && f[3].length == 6);
+   CHECK(f[3].payload[0] == 0x78 && f[3].payload[1] == 0x56 &&
+         f[3].payload[2] == 0x34 && f[3].payload[3] == 0x12);
+   CHECK(f[3].payload[4] == 16);
+   CHECK(f[3].payload[5] == (SERIAL_DISPLAY_OUTPUT_ENABLED | SERIAL_DISPLAY_COUNT_UP));
+   CHECK(f[4].type == SERIAL_FRAME_COUNTERS && f[4].length == 12);
+   CHECK(f[4].payload[0] == 1 && f[4].payload[4] == 2 && f[4].payload[11] == 0xFF);
+   return;
+}
+
+/********************************************************************************
+* check_corrupt: Kontrollerar att en ram med ndrad databyte frkastas medan
+*                efterfljande ramar avkodas.
+*
+*                - stream: Pekare till strmmen.
+*                - length: Antalet byte i strmmen.
+********************************************************************************/
+static void check_corrupt(const uint8_t* stream,
+                          const size_t length)
+{
+   uint8_t copy[FRAME_TEST_STREAM_MAX];
+   struct frame_parser parser;
+   struct frame_log log;
+   const int adc = find_frame(stream, length, 0, SERIAL_FRAME_ADC_RAW);
+
+   CHECK(adc >= 0);
+   if (adc < 0) return;
+   memcpy(copy, stream, length);
+   copy[adc + 3] ^= 0x01;
+   parse(&parser, &log, copy, length);
+
+   CHECK(log.count == 4);
+   CHECK(parser.crc_errors == 1);
+   CHECK(log.count == 4 && log.frames[2].type == SERIAL_FRAME_DISPLAY_STATE);
+   return;
+}
+
+/********************************************************************************
+* check_truncated: Kontrollerar att nsta ram avkodas nr fregende ram
+*                  avkortas, s att nsta ram brjar inom den avkortade ramens
+*                  frvntade lngd.
+*
+*                  - stream: Pekare till strmmen.
+*                  - length: Antalet byte i strmmen.
+********************************************************************************/
+static void check_truncated(const uint8_t* stream,
+                            const size_t length)
+{
+   uint8_t copy[FRAME_TEST_STREAM_MAX];
+   struct frame_parser parser;
+   struct frame_log log;
+   const int display = find_frame(stream, length, 0, SERIAL_FRAME_DISPLAY_STATE);
+   const size_t removed = 4;
+
+   CHECK(display >= 0);
+   if (display < 0) return;
+
+   /* Ta bort de sista fyra byten i ramen med displayernas tillstnd: */
+   const size_t end = (size_t)display + 10;
+   memcpy(copy, stream, end - removed);
+   memcpy(copy + end - removed, stream + end, length - end);
+   parse(&parser, &log, copy, length - removed);
+
+   CHECK(log.count == 4);
+   CHECK(parser.crc_errors == 1);
+   CHECK(log.count == 4 && log.frames[3].type == SERIAL_FRAME_COUNTERS);
+   return;
+}
+
+/********************************************************************************
+* check_length: Kontrollerar att en ram med fr stor lngd frkastas direkt,
+*               s att efterfljande ram avkodas.
+*
+*               - stream: Pekare till strmmen.
+*               - length: Antalet byte i strmmen.
+********************************************************************************/
+static void check_length(const uint8_t* stream,
+                         const size_t length)
+{
+   uint8_t copy[FRAME_TEST_STREAM_MAX];
+   struct frame_parser parser;
+   struct frame_log log;
+   const int first = find_frame(stream, length, 0, SERIAL_FRAME_TEMPERATURE);
+
+   CHECK(first >= 0);
+   if (first < 0) return;
+   memcpy(copy, stream, length);
+   copy[first + 2] = SERIAL_FRAME_PAYLOAD_MAX + 1;
+   parse(&parser, &log, copy, length);
+
+   CHECK(log.count == 4);
+   CHECK(parser.length_errors == 1);
+   CHECK(parser.crc_errors == 0);
+   CHECK(log.count == 4 && log.frames[0].type == SERIAL_FRAME_TEMPERATURE);
+   CHECK(log.count == 4 && log.frames[0].payload[0] == (uint8_t)-1250);
+   return;
+}
+
+/********************************************************************************
+* main: Skickar ramarna och genomfr samtliga kontroller.
+********************************************************************************/
+int main(void)
+{
+   const uint32_t counters[] = { 1, 2, 0xFF000003 };
+   uint8_t stream[FRAME_TEST_STREAM_MAX];
+
+   sim_reset();
+   serial_init(1000000);
+   sei();
+   (void)take_stream(stream);
+
+   serial_print_string("Start\n");
+   serial_send_temperature(2345);
+   serial_send_temperature(-1250);
+   serial_print_string("Mellan\n");
+   serial_send_adc_raw(5, 1023);
+   serial_send_display_state(0x12345678, 16,
+                             SERIAL_DISPLAY_OUTPUT_ENABLED | SERIAL_DISPLAY_COUNT_UP);
+   CHECK(serial_send_counters(counters, 3) == 0);
+   CHECK(serial_send_counters(counters, SERIAL_FRAME_COUNTERS_MAX + 1) == 1);
+
+   const size_t length = take_stream(stream);
+   CHECK(length == 7 + 6 + 6 + 8 + 7 + 10 + 16);
+
+   check_crc();
+   check_intact(stream, length);
+   check_corrupt(stream, length);
+   check_truncated(stream, length);
+   check_length(stream, length);
+   return check_result("frame_test");
+}
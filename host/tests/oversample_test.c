@@ -0,0 +1,165 @@
+/********************************************************************************
+* oversample_test.c: Kontrollerar att versampling via adc_set_oversampling
+*                    ger hgre upplsning vid brusig insignal.
+*
+*                    Insignalen till A0 r ett sant vrde mellan tv
+*                    10-bitarssteg plus normalfrdelat brus med
+*                    standardavvikelsen OVERSAMPLE_NOISE_LSB steg, som
+*                    avrundas till 10 bitar precis som i AD-omvandlaren.
+*                    Det sanna vrdet svepas i OVERSAMPLE_POINTS steg ver
+*                    ett helt 10-bitarssteg, dr OVERSAMPLE_RESULTS resultat
+*                    lses per punkt och antal extra bitar (0 - 3).
+*
+*                    Fr varje antal extra bitar n berknas RMS-felet mellan
+*                    resultatet, delat med 2^n, och det sanna vrdet. Varje
+*                    extra bit ska ungefr halvera felet, vilket ger en
+*                    effektiv upplsning p 10 + log2(fel utan versampling
+*                    / fel med versampling) bitar, som ska vara minst
+*                    10 + n - OVERSAMPLE_BITS_MARGIN. Medelvrdet per punkt
+*                    ska dessutom flja det sanna vrdet, dvs. ka med
+*                    varje punkt, med versampling men inte utan.
+********************************************************************************/
+#include "adc.h"
+#include "check.h"
+#include "sim.h"
+#include <avr/interrupt.h>
+#include <math.h>
+
+/* Makrodefinitioner: */
+#define OVERSAMPLE_BASE 512.0         /* Lgsta sanna vrde i svepet. */
+#define OVERSAMPLE_NOISE_LSB 0.7      /* Brusets standardavvikelse i 10-bitarssteg. */
+#define OVERSAMPLE_POINTS 16          /* Antal sanna vrden ver ett 10-bitarssteg. */
+#define OVERSAMPLE_RESULTS 24         /* Antal lsta resultat per punkt. */
+#define OVERSAMPLE_BITS_MARGIN 0.5    /* Tillten avvikelse frn teoretisk upplsning. */
+
+/* Statiska variabler: */
+static double true_value = OVERSAMPLE_BASE;
+static uint32_t random_state = 12345;
+
+ISR (ADC_vect)
+{
+   adc_sample_next();
+   return;
+}
+
+/********************************************************************************
+* next_uniform: Returnerar nsta pseudoslumpade tal mellan 0 och 1
+*               (xorshift32).
+********************************************************************************/
+static double next_uniform(void)
+{
+   random_state ^= random_state << 13;
+   random_state ^= random_state >> 17;
+   random_state ^= random_state << 5;
+   return random_state / 4294967296.0;
+}
+
+/********************************************************************************
+* noisy_source: Returnerar det sanna vrdet plus normalfrdelat brus,
+*               avrundat till 10 bitar. Bruset approximeras som summan av
+*               tolv likformigt frdelade tal.
+*
+*               - channel: Kanalen (anvnds ej).
+*               - cycle  : Tidpunkten (anvnds ej).
+*               - context: Anvnds ej.
+********************************************************************************/
+static uint16_t noisy_source(uint8_t channel,
+                             uint64_t cycle,
+                             void* context)
+{
+   double noise = -6.0;
+   for (uint8_t i = 0; i < 12; ++i) noise += next_uniform();
+
+   const double value = floor(true_value + noise * OVERSAMPLE_NOISE_LSB + 0.5);
+   (void)channel;
+   (void)cycle;
+   (void)context;
+   return value < 0 ? 0 : value > ADC_RAW_MAX ? ADC_RAW_MAX : (uint16_t)value;
+}
+
+/********************************************************************************
+* read_result: Kr simulatorn tills nsta resultat finns i ringbufferten och
+*              returnerar detta.
+********************************************************************************/
+static uint16_t read_result(void)
+{
+   uint16_t sample;
+   while (adc_read_sample(A0, &sample)) sim_run(SIM_CYCLES_FROM_US(100));
+   return sample;
+}
+
+/********************************************************************************
+* measure: Svepar det sanna vrdet med angivet antal extra bitar och
+*          returnerar RMS-felet mtt i 10-bitarssteg. Antalet punkter vars
+*          medelvrde inte verstiger fregende punkts lagras.
+*
+*          - bits          : Antal extra bitar.
+*          - non_increasing: Pekare till antalet punkter utan kning.
+********************************************************************************/
+static double measure(const uint8_t bits,
+                      uint32_t* non_increasing)
+{
+   const double scale = 1 << bits;
+   double squares = 0, last_mean = 0;
+   *non_increasing = 0;
+
+   CHECK(adc_set_oversampling(A0, bits) == 0);
+
+   for (uint8_t point = 0; point < OVERSAMPLE_POINTS; ++point)
+   {
+      double sum = 0;
+      true_value = OVERSAMPLE_BASE + (point + 0.5) / OVERSAMPLE_POINTS;
+
+      /* Resultat som pbrjades fre bytet av sant vrde kastas: */
+      (void)read_result();
+      (void)read_result();
+
+      for (uint8_t i = 0; i < OVERSAMPLE_RESULTS; ++i)
+      {
+         const double value = read_result() / scale;
+         squares += (value - true_value) * (value - true_value);
+         sum += value;
+      }
+
+      const double mean = sum / OVERSAMPLE_RESULTS;
+      if (point > 0 && mean <= last_mean) (*non_increasing)++;
+      last_mean = mean;
+   }
+   return sqrt(squares / (OVERSAMPLE_POINTS * OVERSAMPLE_RESULTS));
+}
+
+/********************************************************************************
+* main: Genomfr mtningen fr 0 - 3 extra bitar och kontrollerar den
+*       effektiva upplsningen.
+********************************************************************************/
+int main(void)
+{
+   double error[ADC_OVERSAMPLE_BITS_MAX + 1];
+   uint32_t non_increasing[ADC_OVERSAMPLE_BITS_MAX + 1];
+
+   sim_reset();
+   sim_adc_set_source(0, noisy_source, NULL);
+   CHECK(adc_sampler_init(1 << 0) == 0);
+   sei();
+
+   for (uint8_t bits = 0; bits <= ADC_OVERSAMPLE_BITS_MAX; ++bits)
+   {
+      error[bits] = measure(bits, &non_increasing[bits]);
+      const double effective_bits = 10 + log2(error[0] / error[bits]);
+
+      printf("%u extra bitar: RMS-fel %.3f steg, effektivt %.2f bitar, "
+             "%lu av %d punkter utan okning\n",
+             bits, error[bits], effective_bits,
+             (unsigned long)non_increasing[bits], OVERSAMPLE_POINTS - 1);
+      CHECK(effective_bits >= 10 + bits - OVERSAMPLE_BITS_MARGIN);
+   }
+
+   /* Utan versampling ger bruset inget jmnt stigande medelvrde per resultat,
+      medan 13 bitar fljer det sanna vrdet i samtliga punkter. */
+   CHECK(non_increasing[0] > 0);
+   CHECK(non_increasing[ADC_OVERSAMPLE_BITS_MAX] == 0);
+
+   adc_sampler_stop();
+   cli();
+   return check_result("oversample_test");
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+/********************************************************************************
+* serial_format_test.c: Jmfr utskrifterna frn serial_print_integer,
+*                       serial_print_unsigned, serial_print_fixed,
+*                       serial_print_hex samt serial_print_double med
+*                       motsvarande utskrift via snprintf.
+*
+*                       Samtliga tal mellan -FORMAT_EXHAUSTIVE och
+*                       FORMAT_EXHAUSTIVE kontrolleras, liksom tal runt
+*                       varje tiopotens och tvpotens, ytterligheterna
+*                       INT32_MIN, INT32_MAX och UINT32_MAX samt ett jmnt
+*                       urval ver hela 32-bitarsintervallet kompletterat
+*                       med pseudoslumpade tal. Fixtal kontrolleras med 0 - 9
+*                       decimaler, hexadecimala tal med 0 - 8 siffrors
+*                       utfyllnad och flyttal med vrden mellan -1 och 0
+*                       samt decimaler med inledande nolla.
+*
+*                       Utskrifterna skickas via USART i 1 Mbps, s att
+*                       simuleringen gr fort, och lses av via
+*                       sim_usart_take.
+********************************************************************************/
+#include "check.h"
+#include "serial.h"
+#include "sim.h"
+#include <avr/interrupt.h>
+#include <inttypes.h>
+#include <string.h>
+
+/* Makrodefinitioner: */
+#define FORMAT_BAUD_RATE 1000000UL /* Baud rate under testet. */
+#define FORMAT_EXHAUSTIVE 10000L   /* Samtliga tal med lgre belopp kontrolleras. */
+#define FORMAT_SWEEP 10000UL       /* Antal jmnt frdelade tal ver hela intervallet. */
+#define FORMAT_RANDOM 10000UL      /* Antal pseudoslumpade tal. */
+#define FORMAT_TEXT_MAX 32         /* Hgsta antal tecken per utskrift. */
+
+/* Statiska variabler: */
+static uint32_t mismatches = 0;
+static uint32_t checked = 0;
+static uint32_t random_state = 12345;
+
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+/********************************************************************************
+* take_output: Kr simulatorn tills samtliga tecken har skickats och flyttar
+*              dessa till angiven destination som en nollterminerad strng.
+*
+*              - destination: Pekare till destinationen (FORMAT_TEXT_MAX byte).
+********************************************************************************/
+static void take_output(char* destination)
+{
+   const uint32_t frame = sim_usart_frame_cycles();
+
+   while (serial_transmit_pending()) sim_run(frame);
+   sim_run(2 * frame);
+
+   const size_t length = sim_usart_take(destination, FORMAT_TEXT_MAX - 1);
+   destination[length] = '\0';
+   return;
+}
+
+/********************************************************************************
+* compare: Jmfr utskriften med frvntad text och skriver ut de frsta
+*          avvikelserna.
+*
+*          - expected: Frvntad text.
+*          - actual  : Utskriven text.
+********************************************************************************/
+static void compare(const char* expected,
+                    const char* actual)
+{
+   checked++;
+
+   if (strcmp(expected, actual))
+   {
+      if (mismatches < 10) fprintf(stderr, "forvantat \"%s\", fick \"%s\"\n", expected, actual);
+      mismatches++;
+   }
+   return;
+}
+
+/********************************************************************************
+* check_signed: Kontrollerar utskrift av angivet signerat tal som heltal
+*               samt som fixtal med 0 - 9 decimaler.
+*
+*               - number  : Talet som ska kontrolleras.
+*               - decimals: Indikerar ifall fixtal ska kontrolleras.
+********************************************************************************/
+static void check_signed(const int32_t number,
+                         const bool decimals)
+{
+   char expected[FORMAT_TEXT_MAX], actual[FORMAT_TEXT_MAX];
+
+   snprintf(expected, sizeof(expected), "%" PRId32, number);
+   serial_print_integer(number);
+   take_output(actual);
+   compare(expected, actual);
+
+   if (!decimals) return;
+   uint32_t scale = 1;
+
+   for (uint8_t d = 1; d <= 9; ++d)
+   {
+      scale *= 10;
+      const uint32_t magnitude = number < 0 ? 0UL - (uint32_t)number : (uint32_t)number;
+      snprintf(expected, sizeof(expected), "%s%" PRIu32 ".%0*" PRIu32, number < 0 ? "-" : "",
+               magnitude / scale, (int)d, magnitude % scale);
+      serial_print_fixed(number, d);
+      take_output(actual);
+      compare(expected, actual);
+   }
+   return;
+}
+
+/********************************************************************************
+* check_unsigned: Kontrollerar utskrift av angivet osignerat tal i decimal
+*                 samt hexadecimal form.
+*
+*                 - number: Talet som ska kontrolleras.
+*                 - padded: Indikerar ifall samtliga utfyllnader ska
+*                           kontrolleras.
+********************************************************************************/
+static void check_unsigned(const uint32_t number,
+                           const bool padded)
+{
+   char expected[FORMAT_TEXT_MAX], actual[FORMAT_TEXT_MAX];
+
+   snprintf(expected, sizeof(expected), "%" PRIu32, number);
+   serial_print_unsigned(number);
+   take_output(actual);
+   compare(expected, actual);
+
+   for (uint8_t digits = 0; digits <= (padded ? 8 : 0); ++digits)
+   {
+      snprintf(expected, sizeof(expected), "%0*" PRIX32, (int)(digits ? digits : 1), number);
+      serial_print_hex(number, digits);
+      take_output(actual);
+      compare(expected, actual);
+   }
+   return;
+}
+
+/********************************************************************************
+* check_double: Kontrollerar utskrift av angivet antal hundradelar som
+*               flyttal med tv decimaler.
+*
+*               - hundredths: Talet mtt i hundradelar.
+********************************************************************************/
+static void check_double(const int32_t hundredths)
+{
+   char expected[FORMAT_TEXT_MAX], actual[FORMAT_TEXT_MAX];
+   const double number = hundredths / 100.0;
+
+   snprintf(expected, sizeof(expected), "%.2f", number);
+   serial_print_double(number);
+   take_output(actual);
+
+   /* printf skriver ut -0.00 fr negativa tal som avrundas till noll. */
+   compare(strcmp(expected, "-0.00") ? expected : "0.00", actual);
+   return;
+}
+
+/********************************************************************************
+* next_random: Returnerar nsta pseudoslumpade 32-bitars tal (xorshift32).
+********************************************************************************/
+static uint32_t next_random(void)
+{
+   random_state ^= random_state << 13;
+   random_state ^= random_state >> 17;
+   random_state ^= random_state << 5;
+   return random_state;
+}
+
+/********************************************************************************
+* main: Genomfr samtliga jmfrelser.
+********************************************************************************/
+int main(void)
+{
+   sim_reset();
+   serial_init(FORMAT_BAUD_RATE);
+   sei();
+
+   char discard[FORMAT_TEXT_MAX];
+   take_output(discard);
+
+   for (int32_t n = -FORMAT_EXHAUSTIVE; n <= FORMAT_EXHAUSTIVE; ++n)
+   {
+      check_signed(n, n % 7 == 0);
+      if (n >= 0) check_unsigned((uint32_t)n, n < 256);
+   }
+
+   for (uint64_t power = 10; power <= UINT32_MAX; power *= 10)
+   {
+      for (int64_t offset = -2; offset <= 2; ++offset)
+      {
+         const uint64_t value = power + offset;
+         check_unsigned((uint32_t)value, true);
+         if (value <= INT32_MAX)
+         {
+            check_signed((int32_t)value, true);
+            check_signed(-(int32_t)value, true);
+         }
+      }
+   }
+
+   for (uint8_t bit = 0; bit < 32; ++bit)
+   {
+      check_unsigned(1UL << bit, true);
+      check_unsigned((1UL << bit) - 1, true);
+   }
+
+   check_signed(INT32_MIN, true);
+   check_signed(INT32_MIN + 1, true);
+   check_signed(INT32_MAX, true);
+   check_unsigned(UINT32_MAX, true);
+
+   for (uint32_t i = 0; i < FORMAT_SWEEP; ++i)
+   {
+      const uint32_t value = (uint32_t)(((uint64_t)UINT32_MAX * i) / (FORMAT_SWEEP - 1));
+      check_unsigned(value, false);
+      check_signed((int32_t)value, false);
+   }
+
+   for (uint32_t i = 0; i < FORMAT_RANDOM; ++i)
+   {
+      const uint32_t value = next_random();
+      check_unsigned(value, i % 16 == 0);
+      check_signed((int32_t)value, i % 16 == 0);
+   }
+
+   for (int32_t hundredths = -1000; hundredths <= 1000; ++hundredths)
+   {
+      check_double(hundredths);
+   }
+   check_double(2147483647);
+   check_double(-2147483647);
+
+   printf("%lu utskrifter jamforda, %lu avvikelser\n",
+          (unsigned long)checked, (unsigned long)mismatches);
+   CHECK(mismatches == 0);
+   return check_result("serial_format_test");
+}
\ No newline at end of file
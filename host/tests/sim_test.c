@@ -0,0 +1,490 @@
+/********************************************************************************
+* sim_test.c: Kontrollerar simulatorns modeller av kringkretsarna via
+*             drivrutinerna, s att senare tester och mtningar vilar p
+*             korrekta tider: timerhjulets tick, EEPROM-minnets
+*             programmeringstid, ramtiden fr USART, AD-omvandlarens
+*             omvandlingstid, Watchdog-timerns timeout samt vckning ur
+*             vilolge.
+********************************************************************************/
+#include "check.h"
+#include "adc.h"
+#include "button.h"
+#include "eeprom.h"
+#include "event.h"
+#include "serial.h"
+#include "timer.h"
+#include "wdt.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/* Makrodefinitioner: */
+#define SIM_TEST_CHANNEL_STEP 150 /* Avstnd mellan kanalernas vrden i test_adc_channels. */
+
+/* Statiska variabler: */
+static volatile uint32_t pcint_count = 0;
+static volatile uint32_t wdt_count = 0;
+static uint16_t channel_counts[SIM_ADC_CHANNELS];
+
+ISR (TIMER2_COMPA_vect)
+{
+   timer_wheel_tick();
+   return;
+}
+
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+ISR (USART_RX_vect)
+{
+   serial_receive_next();
+   return;
+}
+
+ISR (EE_READY_vect)
+{
+   eeprom_write_next();
+   return;
+}
+
+ISR (PCINT0_vect)
+{
+   pcint_count++;
+   return;
+}
+
+ISR (ADC_vect)
+{
+   adc_sample_next();
+   return;
+}
+
+ISR (WDT_vect)
+{
+   wdt_count++;
+   return;
+}
+
+/********************************************************************************
+* test_timer_wheel: Kontrollerar att timerhjulet tickar en gng per
+*                   millisekund och att timer_micros fljer klockan.
+********************************************************************************/
+static void test_timer_wheel(void)
+{
+   sim_reset();
+   timer_wheel_init(TIMER_SEL_2);
+   sei();
+   sim_run(SIM_CYCLES_FROM_MS(100) + SIM_CYCLES_FROM_US(500));
+
+   CHECK(timer_millis() == 100);
+   CHECK_RANGE(timer_micros(), 100490, 100510);
+   CHECK(sim_get_stats()->isr[SIM_VECTOR_TIMER2_COMPA].count == 100);
+   cli();
+   return;
+}
+
+/********************************************************************************
+* test_eeprom: Kontrollerar skrivning och lsning samt att asynkron
+*              skrivning till raderade celler sker utan radering, dvs.
+*              1.8 ms per byte i stllet fr 3.4 ms.
+********************************************************************************/
+static void test_eeprom(void)
+{
+   sim_reset();
+   sei();
+
+   CHECK(eeprom_write_byte(10, 0x5A) == 0);
+   CHECK(eeprom_read_byte(10) == 0x5A);
+   CHECK(sim_eeprom()[10] == 0x5A);
+
+   const uint8_t data[4] = { 1, 2, 3, 4 };
+   const uint64_t start = sim_cycles();
+   CHECK(eeprom_update_block_async(20, data, sizeof(data)) == 0);
+   while (eeprom_write_pending()) sim_run(SIM_SLICE_CYCLES);
+   while (EECR & (1 << EEPE)) sim_run(SIM_SLICE_CYCLES);
+
+   CHECK_RANGE(sim_cycles() - start, 4 * SIM_CYCLES_FROM_US(1800), 4 * SIM_CYCLES_FROM_US(1900));
+   CHECK(sim_eeprom()[23] == 4);
+   CHECK(sim_eeprom_writes(23) == 1);
+   CHECK(sim_eeprom_erases(23) == 0);
+   CHECK(sim_get_stats()->eeprom_ignored_writes == 0);
+   cli();
+   return;
+}
+
+/********************************************************************************
+* test_usart: Kontrollerar att tecken skickas och tas emot med ramtiden
+*             10 bitar * 16 * (UBRR0 + 1) vid 9600 kbps.
+********************************************************************************/
+static void test_usart(void)
+{
+   char received[16] = { 0 };
+   char character = 0;
+
+   sim_reset();
+   serial_init(9600);
+   sei();
+   sim_run(SIM_CYCLES_FROM_MS(5));
+   (void)sim_usart_take(received, sizeof(received));
+
+   CHECK(sim_usart_frame_cycles() == 10 * 16 * 104);
+
+   const uint64_t start = sim_cycles();
+   serial_print_string("hej");
+   while (sim_usart_take(received, sizeof(received) - 1) == 0) sim_run(SIM_SLICE_CYCLES);
+   CHECK(received[0] == 'h');
+   CHECK_RANGE(sim_cycles() - start, 16640, 16640 + 200);
+
+   sim_run(SIM_CYCLES_FROM_MS(5));
+   CHECK(sim_usart_take(received + 1, sizeof(received) - 2) == 2);
+   CHECK(!strcmp(received, "hej"));
+
+   sim_usart_inject("x", 1);
+   sim_run(16640 + 100);
+   CHECK(serial_read_char(&character) == 0);
+   CHECK(character == 'x');
+   CHECK(sim_get_stats()->usart_rx_overruns == 0);
+   cli();
+   return;
+}
+
+/********************************************************************************
+* test_adc: Kontrollerar omvandlingstiden vid prescaler 128. Eftersom
+*           adc_read stnger av AD-omvandlaren efter varje avlsning rknas
+*           varje omvandling som den frsta, dvs. 25 ADC-klockcykler.
+********************************************************************************/
+static void test_adc(void)
+{
+   struct adc pot;
+
+   sim_reset();
+   sim_adc_set_value(2, 600);
+   adc_init(&pot, 2);
+
+   uint64_t start = sim_cycles();
+   CHECK(adc_read(&pot) == 600);
+   CHECK_RANGE(sim_cycles() - start, 25 * 128, 25 * 128 + 100);
+
+   sim_adc_set_value(2, 123);
+   start = sim_cycles();
+   CHECK(adc_read(&pot) == 123);
+   CHECK_RANGE(sim_cycles() - start, 25 * 128, 25 * 128 + 100);
+   CHECK(sim_adc_last_channel() == 2);
+   return;
+}
+
+/********************************************************************************
+* watchdog_loop: Huvudprogram som aldrig terstller Watchdog-timern.
+********************************************************************************/
+static int watchdog_loop(void)
+{
+   wdt_init(WDT_TIMEOUT_16_MS);
+   wdt_enable_system_reset();
+   for (;;) sim_run(1000);
+   return 0;
+}
+
+/********************************************************************************
+* watchdog_reset_loop: Huvudprogram som terstller Watchdog-timern
+*                      varje millisekund.
+********************************************************************************/
+static int watchdog_reset_loop(void)
+{
+   wdt_init(WDT_TIMEOUT_16_MS);
+   wdt_enable_system_reset();
+   for (;;)
+   {
+      sim_run(SIM_CYCLES_FROM_MS(1));
+      wdt_reset();
+   }
+   return 0;
+}
+
+/********************************************************************************
+* test_watchdog: Kontrollerar att systemterstllning sker 16 ms efter
+*                senaste terstllning av Watchdog-timern.
+********************************************************************************/
+static void test_watchdog(void)
+{
+   sim_reset();
+   CHECK(sim_run_main(watchdog_loop, SIM_CYCLES_FROM_MS(100)) == SIM_EXIT_WATCHDOG);
+   CHECK_RANGE(sim_cycles(), SIM_CYCLES_FROM_MS(16), SIM_CYCLES_FROM_MS(17));
+   CHECK(MCUSR & (1 << WDRF));
+
+   sim_reset();
+   CHECK(sim_run_main(watchdog_reset_loop, SIM_CYCLES_FROM_MS(100)) == SIM_EXIT_DEADLINE);
+   CHECK(sim_get_stats()->wdt_resets == 0);
+   return;
+}
+
+/********************************************************************************
+* test_sleep: Kontrollerar att Timer 2 med synkron klocka inte vcker
+*             processorn ur Power-save, medan Watchdog-timern gr det, samt
+*             att Timer 2 vcker processorn ur Idle.
+********************************************************************************/
+static void test_sleep(void)
+{
+   sim_reset();
+   timer_wheel_init(TIMER_SEL_2);
+   wdt_init(WDT_TIMEOUT_16_MS);
+   wdt_disable_system_reset();
+   wdt_enable_interrupt();
+   sei();
+
+   uint64_t start = sim_cycles();
+   set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+   sleep_enable();
+   sleep_cpu();
+   sleep_disable();
+   CHECK_RANGE(sim_cycles() - start, SIM_CYCLES_FROM_MS(15), SIM_CYCLES_FROM_MS(18));
+   CHECK(wdt_count == 1);
+
+   start = sim_cycles();
+   set_sleep_mode(SLEEP_MODE_IDLE);
+   sleep_enable();
+   sleep_cpu();
+   sleep_disable();
+   CHECK_RANGE(sim_cycles() - start, 0, SIM_CYCLES_FROM_MS(1) + 100);
+   wdt_disable_interrupt();
+   cli();
+   return;
+}
+
+/********************************************************************************
+* test_adc_triggered: Kontrollerar att timerstartad AD-omvandling med angiven
+*                     samplingsfrekvens ger rtt antal omvandlingar utan
+*                     verskridningar nr resultaten lses, samt att en
+*                     avbrottsrutin som frdrjs lngre n periodtiden minus
+*                     omvandlingstiden rknas som en verskridning. Frsta
+*                     omvandlingen tar 25 ADC-klockcykler, varfr
+*                     kontrollen brjar efter en millisekund.
+*
+*                     - rate_hz : Samplingsfrekvens.
+*                     - delay_us: Tid med avbrott inaktiverade frn start av
+*                                 en omvandling, som ska ge en latens mellan
+*                                 periodtiden minus omvandlingstiden och
+*                                 periodtiden.
+********************************************************************************/
+static void test_adc_triggered(const uint16_t rate_hz,
+                               const uint32_t delay_us)
+{
+   uint16_t sample;
+   sim_reset();
+   sim_adc_set_value(0, 321);
+   CHECK(adc_sampler_init_triggered(1 << 0, rate_hz) == 0);
+   sei();
+   sim_run(SIM_CYCLES_FROM_MS(1));
+   while (adc_read_sample(A0, &sample) == 0);
+
+   const uint32_t start = sim_get_stats()->adc_conversions;
+   const uint32_t overruns = adc_get_overruns();
+
+   for (uint16_t i = 0; i < 200; ++i)
+   {
+      sim_run(SIM_CYCLES_FROM_US(500));
+      while (adc_read_sample(A0, &sample) == 0) CHECK(sample == 321);
+   }
+
+   CHECK_RANGE(sim_get_stats()->adc_conversions - start, rate_hz / 10 - 5, rate_hz / 10 + 5);
+   CHECK(adc_get_overruns() == overruns);
+
+   while (ADCSRA & (1 << ADSC)) sim_delay_cycles(1);
+   while (!(ADCSRA & (1 << ADSC))) sim_delay_cycles(1);
+   cli();
+   sim_delay_cycles(SIM_CYCLES_FROM_US(delay_us));
+   sei();
+   sim_run(SIM_CYCLES_FROM_US(500));
+   while (adc_read_sample(A0, &sample) == 0);
+
+   CHECK(adc_get_overruns() == overruns + 1);
+   adc_sampler_stop();
+   cli();
+   return;
+}
+
+/********************************************************************************
+* channel_source: Returnerar kanalens nummer gnger SIM_TEST_CHANNEL_STEP plus
+*                 antalet tidigare omvandlingar av kanalen, s att varje
+*                 resultat visar bde kanal och ordning.
+*
+*                 - channel: Kanalen som omvandlas.
+*                 - cycle  : Tidpunkten (anvnds ej).
+*                 - context: Pekare till antalet omvandlingar av kanalen.
+********************************************************************************/
+static uint16_t channel_source(uint8_t channel,
+                               uint64_t cycle,
+                               void* context)
+{
+   uint16_t* count = context;
+   (void)cycle;
+   return channel * SIM_TEST_CHANNEL_STEP + (*count)++;
+}
+
+/********************************************************************************
+* test_adc_channels: Kontrollerar samplern med tre kanaler, A0, A2 och A5,
+*                    som krs tills varje ringbuffert har skrivits ver.
+*                    Varje ringbuffert ska d enbart innehlla egna kanalens
+*                    resultat, vilka adc_get_samples ska returnera med
+*                    ldsta resultatet frst och senaste sist. Medan
+*                    samplern r igng ska adc_read returnera senaste
+*                    resultatet fr valda kanaler och 0 fr vriga.
+********************************************************************************/
+static void test_adc_channels(void)
+{
+   static const uint8_t pins[] = { A0, A2, A5 };
+   uint16_t samples[ADC_RING_SIZE];
+   struct adc inside;
+   struct adc outside;
+
+   sim_reset();
+   for (uint8_t i = 0; i < sizeof(pins) / sizeof(pins[0]); ++i)
+   {
+      const uint8_t channel = pins[i] - A0;
+      channel_counts[channel] = 0;
+      sim_adc_set_source(channel, channel_source, &channel_counts[channel]);
+   }
+   sim_adc_set_value(1, 999);
+
+   adc_init(&inside, A2);
+   adc_init(&outside, A1);
+   CHECK(adc_sampler_init((1 << 0) | (1 << 2) | (1 << 5)) == 0);
+   sei();
+   sim_run(SIM_CYCLES_FROM_MS(5));
+
+   cli();
+   CHECK(adc_read(&inside) == adc_get_latest(A2));
+   CHECK(adc_read(&outside) == 0);
+   CHECK(adc_get_latest(A1) == 0);
+   sei();
+
+   adc_sampler_stop();
+   sim_run(SIM_CYCLES_FROM_MS(1));
+   cli();
+   CHECK(adc_get_overruns() > 0);
+
+   for (uint8_t i = 0; i < sizeof(pins) / sizeof(pins[0]); ++i)
+   {
+      const uint16_t base = (pins[i] - A0) * SIM_TEST_CHANNEL_STEP;
+      const uint8_t count = adc_get_samples(pins[i], samples);
+      CHECK(count == ADC_RING_SIZE);
+      CHECK(channel_counts[pins[i] - A0] > ADC_RING_SIZE);
+
+      for (uint8_t k = 0; k < count; ++k)
+      {
+         CHECK_RANGE(samples[k], base + 1, base + SIM_TEST_CHANNEL_STEP - 1);
+         if (k > 0) CHECK(samples[k] == samples[k - 1] + 1);
+      }
+      CHECK(samples[count - 1] == adc_get_latest(pins[i]));
+   }
+   return;
+}
+
+/********************************************************************************
+* test_adc_median_cap: Kontrollerar att median av fler n ADC_MEDIAN_FAST_MAX
+*                      vrden enbart tillts fr kanaler som omvandlas av
+*                      samplern med hgst ADC_MEDIAN_MAX_HZ, oavsett om
+*                      filtret vljs fre eller efter start av samplern.
+********************************************************************************/
+static void test_adc_median_cap(void)
+{
+   sim_reset();
+   CHECK(adc_set_filter(A0, FILTER_MEDIAN, 7) == 0);
+   CHECK(adc_sampler_init(1 << 0) == 1);
+   CHECK(adc_sampler_init_triggered(1 << 0, ADC_MEDIAN_MAX_HZ + 1) == 1);
+   CHECK(!adc_sampler_running());
+
+   CHECK(adc_sampler_init_triggered(1 << 0, ADC_MEDIAN_MAX_HZ) == 0);
+   CHECK(adc_set_filter(A0, FILTER_MEDIAN, 5) == 0);
+   adc_sampler_stop();
+
+   CHECK(adc_set_filter(A0, FILTER_MEDIAN, ADC_MEDIAN_FAST_MAX) == 0);
+   CHECK(adc_sampler_init_triggered(1 << 0, ADC_TRIGGER_HZ_MAX) == 0);
+   CHECK(adc_set_filter(A0, FILTER_MEDIAN, 5) == 1);
+   CHECK(adc_set_filter(A0, FILTER_EMA, FILTER_EMA_SHIFT_MAX) == 0);
+   CHECK(adc_set_filter(A1, FILTER_MEDIAN, 7) == 0);
+   adc_sampler_stop();
+
+   CHECK(adc_set_filter(A0, FILTER_NONE, 0) == 0);
+   CHECK(adc_set_filter(A1, FILTER_NONE, 0) == 0);
+   return;
+}
+
+/********************************************************************************
+* test_event_sleep: Kontrollerar att event_sleep vljer Idle nr timerhjulet
+*                   drivs av Timer 2 med synkron klocka, s att nsta tick
+*                   vcker processorn, samt Power-save nr AS2 r ettstlld.
+********************************************************************************/
+static void test_event_sleep(void)
+{
+   sim_reset();
+   timer_wheel_init(TIMER_SEL_2);
+   sei();
+
+   const uint64_t start = sim_cycles();
+   event_sleep();
+   CHECK((SMCR & 0x0E) == SLEEP_MODE_IDLE);
+   CHECK_RANGE(sim_cycles() - start, 0, SIM_CYCLES_FROM_MS(1) + 100);
+
+   wdt_init(WDT_TIMEOUT_16_MS);
+   wdt_disable_system_reset();
+   wdt_enable_interrupt();
+   ASSR |= (1 << AS2);
+   event_sleep();
+   CHECK((SMCR & 0x0E) == SLEEP_MODE_PWR_SAVE);
+   wdt_disable_interrupt();
+   cli();
+   return;
+}
+
+/********************************************************************************
+* test_pins: Kontrollerar pull-up-motstnd och PCI-avbrott via en
+*            tryckknapp p pin 13, vars pin lses hg via pull-up-motstndet
+*            tills den dras lg externt.
+********************************************************************************/
+static void test_pins(void)
+{
+   struct button button;
+
+   sim_reset();
+   button_init(&button, 13);
+   button_enable_interrupt(&button);
+   sei();
+
+   CHECK(sim_get_pin('B', 5));
+   CHECK(button_is_pressed(&button));
+
+   sim_set_pin('B', 5, false);
+   sim_run(100);
+   CHECK(!button_is_pressed(&button));
+   CHECK(pcint_count == 1);
+
+   sim_release_pin('B', 5);
+   sim_run(100);
+   CHECK(button_is_pressed(&button));
+   CHECK(pcint_count == 2);
+   cli();
+   return;
+}
+
+/********************************************************************************
+* main: Kr samtliga tester.
+********************************************************************************/
+int main(void)
+{
+   test_timer_wheel();
+   test_eeprom();
+   test_usart();
+   test_adc();
+   test_watchdog();
+   test_sleep();
+   test_event_sleep();
+   test_adc_triggered(10000, 125);
+   test_adc_triggered(6000, 220);
+   test_adc_triggered(1000, 1050);
+   test_adc_channels();
+   test_adc_median_cap();
+   test_pins();
+   return check_result("sim_test");
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+/********************************************************************************
+* timer_test.c: Kontrollerar berkningen av timerkretsarnas instllningar.
+*
+*               Instllningarna som TIMER_PERIOD berknar vid kompilering
+*               jmfrs med de register som timer_init_us skriver under
+*               krning, fr samtliga timerkretsar och ett stort urval av
+*               tider: samtliga tider upp till TIMER_TEST_EXHAUSTIVE_US,
+*               tider runt varje grns mellan prescalers samt en
+*               geometrisk fljd upp till och ver TIMER_TIME_US_MAX.
+*               Ngra instllningar lagras dessutom som statiska
+*               konstanter, vilket enbart kompilerar om makrot ger
+*               konstanta uttryck.
+*
+*               Drefter krs timerhjulet p samtliga timerkretsar under
+*               TIMER_TEST_DRIFT_MS simulerade millisekunder, dr
+*               timer_micros samt timer_millis lses vid pseudoslumpade
+*               tidpunkter och jmfrs med simulatorns klocka. Tiden fr
+*               aldrig g bakt och fr inte avvika mer n ett steg i
+*               hrdvarurknaren, oavsett hur lnge timerhjulet har krts.
+********************************************************************************/
+#include "check.h"
+#include "sim.h"
+#include "timer.h"
+#include <avr/interrupt.h>
+
+/* Makrodefinitioner: */
+#define TIMER_TEST_EXHAUSTIVE_US 5000UL /* Samtliga kortare tider kontrolleras. */
+#define TIMER_TEST_DRIFT_MS 1000UL      /* Simulerad tid per timerkrets i kontrollen av drift. */
+#define TIMER_TEST_DRIFT_GAP_MAX 4000   /* Hgsta antal klockcykler mellan avlsningarna. */
+
+/* Statiska variabler: */
+static const struct timer_period wheel_period = TIMER_PERIOD(TIMER_SEL_2, 1000);
+static const struct timer_period count_period = TIMER_PERIOD(TIMER_SEL_1, 1000000UL);
+static const struct timer_period long_period = TIMER_PERIOD(TIMER_SEL_0, 1000000UL);
+static uint32_t checked = 0;
+static uint32_t mismatches = 0;
+static uint32_t random_state = 12345;
+
+ISR (TIMER0_COMPA_vect)
+{
+   timer_wheel_tick();
+   return;
+}
+
+ISR (TIMER1_COMPA_vect)
+{
+   timer_wheel_tick();
+   return;
+}
+
+ISR (TIMER2_COMPA_vect)
+{
+   timer_wheel_tick();
+   return;
+}
+
+/********************************************************************************
+* check_period: Jmfr instllningarna frn TIMER_PERIOD med registren efter
+*               timer_init_us fr angiven timerkrets och tid.
+*
+*               - timer_sel: Val av timerkrets.
+*               - time_us  : Tiden mtt i mikrosekunder.
+********************************************************************************/
+static void check_period(const enum timer_sel timer_sel,
+                         const uint32_t time_us)
+{
+   const struct timer_period expected = TIMER_PERIOD(timer_sel, time_us);
+   struct timer timer;
+   uint16_t top;
+   uint8_t clock_select;
+
+   timer_init_us(&timer, timer_sel, time_us);
+
+   if (timer_sel == TIMER_SEL_0)
+   {
+      top = OCR0A + 1;
+      clock_select = TCCR0B & 0x07;
+   }
+   else if (timer_sel == TIMER_SEL_1)
+   {
+      top = OCR1A + 1;
+      clock_select = TCCR1B & 0x07;
+   }
+   else
+   {
+      top = OCR2A + 1;
+      clock_select = TCCR2B & 0x07;
+   }
+
+   checked++;
+
+   if (expected.top != top || expected.clock_select != clock_select ||
+       expected.max_count != timer.max_count)
+   {
+      if (mismatches < 10)
+      {
+         fprintf(stderr, "Timer %d, %lu us: makro %u/%u/%lu, timer_init_us %u/%u/%lu\n",
+                 (int)timer_sel, (unsigned long)time_us, expected.top,
+                 expected.clock_select, (unsigned long)expected.max_count,
+                 top, clock_select, (unsigned long)timer.max_count);
+      }
+      mismatches++;
+   }
+   return;
+}
+
+/********************************************************************************
+* test_constants: Kontrollerar de statiska konstanterna mot knda vrden.
+*                 Timerhjulets tick p 1 ms ger prescaler 64 (CS = 4) och
+*                 250 steg p Timer 2, medan 1 s ger prescaler 256 och
+*                 62500 steg p Timer 1, respektive 62 lika lnga perioder
+*                 med prescaler 1024 p Timer 0.
+********************************************************************************/
+static void test_constants(void)
+{
+   CHECK(wheel_period.max_count == 1);
+   CHECK(wheel_period.top == 250);
+   CHECK(wheel_period.clock_select == 4);
+   CHECK(count_period.max_count == 1);
+   CHECK(count_period.top == 62500);
+   CHECK(count_period.clock_select == 4);
+   CHECK(long_period.max_count == 62);
+   CHECK(long_period.clock_select == 5);
+   CHECK_RANGE(long_period.max_count * long_period.top * 1024UL, 15990000UL, 16010000UL);
+   return;
+}
+
+/********************************************************************************
+* test_runtime: Jmfr TIMER_PERIOD med timer_init_us fr samtliga
+*               timerkretsar.
+********************************************************************************/
+static void test_runtime(void)
+{
+   static const uint8_t shifts[] = { 0, 3, 5, 6, 7, 8, 10 };
+
+   for (enum timer_sel timer_sel = TIMER_SEL_0; timer_sel <= TIMER_SEL_2; ++timer_sel)
+   {
+      const uint8_t bits = timer_sel == TIMER_SEL_1 ? 16 : 8;
+
+      for (uint32_t time_us = 0; time_us <= TIMER_TEST_EXHAUSTIVE_US; ++time_us)
+      {
+         check_period(timer_sel, time_us);
+      }
+
+      for (uint8_t i = 0; i < sizeof(shifts); ++i)
+      {
+         const uint32_t limit_us = ((1UL << (bits + shifts[i])) / TIMER_CYCLES_PER_US);
+         for (uint32_t time_us = limit_us - 2; time_us <= limit_us + 2; ++time_us)
+         {
+            check_period(timer_sel, time_us);
+         }
+      }
+
+      for (uint64_t time_us = TIMER_TEST_EXHAUSTIVE_US; time_us <= TIMER_TIME_US_MAX + 1000ULL;
+           time_us += time_us / 997 + 1)
+      {
+         check_period(timer_sel, (uint32_t)time_us);
+      }
+
+      check_period(timer_sel, TIMER_TIME_US_MAX);
+      check_period(timer_sel, UINT32_MAX);
+   }
+   return;
+}
+
+/********************************************************************************
+* test_drift: Kr timerhjulet p angiven timerkrets och jmfr timer_micros
+*             samt timer_millis med simulatorns klocka vid pseudoslumpade
+*             tidpunkter. Avvikelsen fr vara hgst ett steg i
+*             hrdvarurknaren (4 us fr Timer 0 och Timer 2 vid 16 MHz),
+*             i bda riktningar eftersom hrdvarurknaren startar ngra
+*             klockcykler fre den frsta avlsningen, plus de klockcykler
+*             som sjlva avlsningen tar. timer_millis fr ligga hgst ett
+*             tick efter timer_micros, som rknar med vntande avbrott.
+*
+*             - timer_sel: Val av timerkrets fr timerhjulet.
+*             - step_us  : Tid per steg i hrdvarurknaren, avrundat uppt.
+********************************************************************************/
+static void test_drift(const enum timer_sel timer_sel,
+                       const uint32_t step_us)
+{
+   sim_reset();
+   timer_wheel_init(timer_sel);
+
+   const uint64_t start = sim_cycles();
+   const uint32_t start_us = timer_micros();
+   uint32_t last_us = 0, samples = 0, backwards = 0, millis_errors = 0;
+   int32_t error_min = 0, error_max = 0;
+   sei();
+
+   while (sim_cycles() - start < SIM_CYCLES_FROM_MS(TIMER_TEST_DRIFT_MS))
+   {
+      random_state ^= random_state << 13;
+      random_state ^= random_state >> 17;
+      random_state ^= random_state << 5;
+      sim_run(random_state % TIMER_TEST_DRIFT_GAP_MAX + 1);
+
+      const uint64_t cycles = sim_cycles() - start;
+      cli();
+      const uint32_t micros = timer_micros();
+      const uint32_t millis = timer_millis();
+      sei();
+      const uint32_t us = micros - start_us;
+      const int32_t error = (int32_t)(us - (uint32_t)(cycles / TIMER_CYCLES_PER_US));
+
+      if (us < last_us) backwards++;
+      if (micros / 1000 != millis && micros / 1000 != millis + 1) millis_errors++;
+      if (error < error_min) error_min = error;
+      if (error > error_max) error_max = error;
+      last_us = us;
+      samples++;
+   }
+   cli();
+
+   printf("Timer %d: %lu avlasningar under %lu ms, avvikelse %ld - %ld us\n",
+          (int)timer_sel, (unsigned long)samples, (unsigned long)TIMER_TEST_DRIFT_MS,
+          (long)error_min, (long)error_max);
+   CHECK(backwards == 0);
+   CHECK(millis_errors == 0);
+   CHECK(error_min >= -(int32_t)step_us - 1);
+   CHECK(error_max <= (int32_t)step_us + 1);
+   return;
+}
+
+/********************************************************************************
+* main: Genomfr samtliga kontroller.
+********************************************************************************/
+int main(void)
+{
+   sim_reset();
+   test_constants();
+   test_runtime();
+   test_drift(TIMER_SEL_0, 4);
+   test_drift(TIMER_SEL_1, 1);
+   test_drift(TIMER_SEL_2, 4);
+
+   printf("%lu tider jamforda, %lu avvikelser\n",
+          (unsigned long)checked, (unsigned long)mismatches);
+   CHECK(mismatches == 0);
+   return check_result("timer_test");
+}
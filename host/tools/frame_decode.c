@@ -0,0 +1,65 @@
+/********************************************************************************
+* frame_decode.c: Avkodar binra ramar skickade via serial_send_frame och
+*                 skriver ut dessa i lsbar form, en ram per rad. Datan lses
+*                 frn angiven fil, exempelvis en inspelning av serieporten,
+*                 eller frn standard in om ingen fil anges, exempelvis:
+*
+*                 stty -F /dev/ttyACM0 9600 raw && frame_decode < /dev/ttyACM0
+*
+*                 Byte utanfr ramar, ssom lsbar text, hoppas ver. Vid
+*                 filslut skrivs antalet ramar och fel ut p standard error.
+*                 Programmet returnerar 1 om ngon ram frkastades.
+********************************************************************************/
+#include "frame_parser.h"
+
+/********************************************************************************
+* print_frame: Skriver ut mottagen ram p standard ut.
+*
+*              - frame  : Pekare till ramen.
+*              - context: Anvnds inte.
+********************************************************************************/
+static void print_frame(const struct frame* frame,
+                        void* context)
+{
+   (void)context;
+   frame_print(frame, stdout);
+   fflush(stdout);
+   return;
+}
+
+/********************************************************************************
+* main: Lser samtliga byte frn angiven fil eller standard in och matar in
+*       dessa i parsern.
+********************************************************************************/
+int main(int argc, char** argv)
+{
+   struct frame_parser parser;
+   FILE* input = stdin;
+   int data;
+
+   if (argc > 2)
+   {
+      fprintf(stderr, "Anvandning: %s [fil]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc == 2 && !(input = fopen(argv[1], "rb")))
+   {
+      perror(argv[1]);
+      return 1;
+   }
+
+   frame_parser_init(&parser, print_frame, 0);
+
+   while ((data = fgetc(input)) != EOF)
+   {
+      frame_parser_feed(&parser, (uint8_t)data);
+   }
+
+   if (input != stdin) fclose(input);
+
+   fprintf(stderr, "%lu ramar, %lu CRC-fel, %lu langdfel, %lu byte utanfor ramar\n",
+           (unsigned long)parser.frames, (unsigned long)parser.crc_errors,
+           (unsigned long)parser.length_errors, (unsigned long)parser.skipped);
+   return parser.crc_errors || parser.length_errors ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/********************************************************************************
+* frame_parser.c: Innehller funktionsdefinitioner fr strmparsern av
+*                 binra ramar.
+********************************************************************************/
+#include "frame_parser.h"
+#include <string.h>
+
+/* Statiska funktioner: */
+static bool frame_parser_complete(struct frame_parser* self);
+static uint32_t frame_read_u32(const uint8_t* data);
+
+/********************************************************************************
+* frame_parser_init: Initierar angiven parser.
+*
+*                    - self   : Pekare till parsern.
+*                    - handler: Funktion som anropas med varje mottagen ram.
+*                    - context: Kontext som skickas till funktionen.
+********************************************************************************/
+void frame_parser_init(struct frame_parser* self,
+                       frame_handler handler,
+                       void* context)
+{
+   memset(self, 0, sizeof(*self));
+   self->handler = handler;
+   self->context = context;
+   return;
+}
+
+/********************************************************************************
+* frame_parser_feed: Matar in en mottagen byte och returnerar antalet ramar
+*                    med korrekt CRC-8 som drmed blev kompletta.
+*
+*                    1. Utanfr en ram hoppas samtliga byte utom SYNC ver.
+*
+*                    2. Byten lggs i bufferten. Nr bufferten innehller
+*                       SYNC, TYPE, LEN, LEN databyte samt CRC-8 r ramen
+*                       komplett och kontrolleras. Vid korrekt CRC-8
+*                       anropas parserns funktion med ramen.
+*
+*                    3. Om ramen frkastas, p grund av felaktig CRC-8
+*                       eller fr stor lngd, matas samtliga byte efter dess
+*                       SYNC in p nytt, s att ramar vars brjan redan
+*                       ligger i bufferten hittas.
+*
+*                    - self: Pekare till parsern.
+*                    - data: Mottagen byte.
+********************************************************************************/
+uint8_t frame_parser_feed(struct frame_parser* self,
+                          const uint8_t data)
+{
+   if (self->count == 0 && data != SERIAL_FRAME_SYNC)
+   {
+      self->skipped++;
+      return 0;
+   }
+
+   self->buffer[self->count++] = data;
+
+   if (self->count == 3 && self->buffer[2] > SERIAL_FRAME_PAYLOAD_MAX)
+   {
+      self->length_errors++;
+   }
+   else if (self->count < 4 || self->count < self->buffer[2] + 4)
+   {
+      return 0;
+   }
+   else if (frame_parser_complete(self))
+   {
+      self->count = 0;
+      return 1;
+   }
+
+   uint8_t rest[FRAME_PARSER_SIZE_MAX];
+   const uint8_t rest_count = self->count - 1;
+   uint8_t found = 0;
+
+   memcpy(rest, self->buffer + 1, rest_count);
+   self->count = 0;
+   self->skipped++;
+
+   for (uint8_t i = 0; i < rest_count; ++i)
+   {
+      found += frame_parser_feed(self, rest[i]);
+   }
+   return found;
+}
+
+/********************************************************************************
+* frame_crc8: Uppdaterar angiven kontrollsumma CRC-8 (polynom 0x07) med
+*             angiven byte och returnerar den nya kontrollsumman.
+*
+*             - crc : Kontrollsumman fre angiven byte.
+*             - data: Byten som ska lggas till.
+********************************************************************************/
+uint8_t frame_crc8(uint8_t crc,
+                   const uint8_t data)
+{
+   crc ^= data;
+
+   for (uint8_t i = 0; i < 8; ++i)
+   {
+      crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+   }
+   return crc;
+}
+
+/********************************************************************************
+* frame_print: Skriver ut angiven ram i lsbar form p en rad. Ramar av oknd
+*              typ eller med ovntad lngd skrivs ut byte fr byte.
+*
+*              - frame : Pekare till ramen.
+*              - stream: Strmmen som ramen skrivs ut till.
+********************************************************************************/
+void frame_print(const struct frame* frame,
+                 FILE* stream)
+{
+   const uint8_t* p = frame->payload;
+
+   if (frame->type == SERIAL_FRAME_TEMPERATURE && frame->length == 2)
+   {
+      const int16_t centi = (int16_t)(p[0] | p[1] << 8);
+      fprintf(stream, "temperature %s%d.%02d\n", centi < 0 ? "-" : "",
+              (centi < 0 ? -centi : centi) / 100, (centi < 0 ? -centi : centi) % 100);
+   }
+   else if (frame->type == SERIAL_FRAME_ADC_RAW && frame->length == 3)
+   {
+      fprintf(stream, "adc A%u %u\n", p[0], p[1] | p[2] << 8);
+   }
+   else if (frame->type == SERIAL_FRAME_DISPLAY_STATE && frame->length == 6)
+   {
+      fprintf(stream, "display %lu radix %u output %s count %s %s\n",
+              (unsigned long)frame_read_u32(p), p[4],
+              p[5] & SERIAL_DISPLAY_OUTPUT_ENABLED ? "on" : "off",
+              p[5] & SERIAL_DISPLAY_COUNT_ENABLED ? "on" : "off",
+              p[5] & SERIAL_DISPLAY_COUNT_UP ? "up" : "down");
+   }
+   else if (frame->type == SERIAL_FRAME_COUNTERS && frame->length % 4 == 0)
+   {
+      fprintf(stream, "counters");
+      for (uint8_t i = 0; i < frame->length; i += 4)
+      {
+         fprintf(stream, " %lu", (unsigned long)frame_read_u32(p + i));
+      }
+      fprintf(stream, "\n");
+   }
+   else
+   {
+      fprintf(stream, "type 0x%02X", frame->type);
+      for (uint8_t i = 0; i < frame->length; ++i) fprintf(stream, " %02X", p[i]);
+      fprintf(stream, "\n");
+   }
+   return;
+}
+
+/********************************************************************************
+* frame_parser_complete: Kontrollerar CRC-8 fr den kompletta ramen i
+*                        bufferten. Vid korrekt CRC-8 anropas parserns
+*                        funktion med ramen och true returneras, annars false.
+*
+*                        - self: Pekare till parsern.
+********************************************************************************/
+static bool frame_parser_complete(struct frame_parser* self)
+{
+   const uint8_t length = self->buffer[2];
+   struct frame frame;
+   uint8_t crc = 0;
+
+   for (uint8_t i = 1; i < length + 3; ++i)
+   {
+      crc = frame_crc8(crc, self->buffer[i]);
+   }
+
+   if (crc != self->buffer[length + 3])
+   {
+      self->crc_errors++;
+      return false;
+   }
+
+   frame.type = self->buffer[1];
+   frame.length = length;
+   memcpy(frame.payload, self->buffer + 3, length);
+   self->frames++;
+   if (self->handler) self->handler(&frame, self->context);
+   return true;
+}
+
+/********************************************************************************
+* frame_read_u32: Returnerar ett 32-bitars tal lagrat med minst signifikant
+*                 byte frst.
+*
+*                 - data: Pekare till talets frsta byte.
+********************************************************************************/
+static uint32_t frame_read_u32(const uint8_t* data)
+{
+   return (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+          (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
\ No newline at end of file
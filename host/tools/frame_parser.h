@@ -0,0 +1,100 @@
+/********************************************************************************
+* frame_parser.h: Innehller en strmparser fr binra ramar skickade via
+*                 serial_send_frame (se serial.h), avsedd fr vrddatorn.
+*
+*                 Mottagna byte matas in en i taget via frame_parser_feed,
+*                 som anropar angiven funktion fr varje komplett ram med
+*                 korrekt CRC-8. Byte utanfr ramar, exempelvis lsbar text
+*                 som skickas mellan ramarna, hoppas ver. Vid felaktig
+*                 CRC-8 eller orimlig lngd sks nsta synkroniseringsbyte
+*                 efter den frkastade ramens synkroniseringsbyte, s att en
+*                 ram som fljer direkt efter en skadad ram inte gr
+*                 frlorad.
+********************************************************************************/
+#ifndef FRAME_PARSER_H_
+#define FRAME_PARSER_H_
+
+/* Inkluderingsdirektiv: */
+#include "serial.h"
+#include <stdio.h>
+
+/* Makrodefinitioner: */
+#define FRAME_PARSER_SIZE_MAX (SERIAL_FRAME_PAYLOAD_MAX + 4) /* Hgsta antal byte per ram. */
+
+/********************************************************************************
+* frame: Strukt fr en mottagen ram.
+********************************************************************************/
+struct frame
+{
+   uint8_t type;                              /* Ramens typ (enum serial_frame_type). */
+   uint8_t length;                            /* Antalet databyte. */
+   uint8_t payload[SERIAL_FRAME_PAYLOAD_MAX]; /* Ramens data. */
+};
+
+/********************************************************************************
+* frame_handler: Funktionspekare som anropas med varje mottagen ram samt
+*                angiven kontext.
+********************************************************************************/
+typedef void (*frame_handler)(const struct frame* frame, void* context);
+
+/********************************************************************************
+* frame_parser: Strukt fr strmparser av binra ramar.
+********************************************************************************/
+struct frame_parser
+{
+   uint8_t buffer[FRAME_PARSER_SIZE_MAX]; /* Mottagna byte i aktuell ram, med brjan p SYNC. */
+   uint8_t count;                         /* Antalet byte i bufferten. */
+   frame_handler handler;                 /* Funktion som anropas med varje mottagen ram. */
+   void* context;                         /* Kontext som skickas till funktionen. */
+   uint32_t frames;                       /* Antal mottagna ramar med korrekt CRC-8. */
+   uint32_t crc_errors;                   /* Antal frkastade ramar med felaktig CRC-8. */
+   uint32_t length_errors;                /* Antal frkastade ramar med fr stor lngd. */
+   uint32_t skipped;                      /* Antal byte utanfr ramar. */
+};
+
+/********************************************************************************
+* frame_parser_init: Initierar angiven parser.
+*
+*                    - self   : Pekare till parsern.
+*                    - handler: Funktion som anropas med varje mottagen ram.
+*                    - context: Kontext som skickas till funktionen.
+********************************************************************************/
+void frame_parser_init(struct frame_parser* self,
+                       frame_handler handler,
+                       void* context);
+
+/********************************************************************************
+* frame_parser_feed: Matar in en mottagen byte. Parserns funktion anropas
+*                    fr varje ram med korrekt CRC-8 som drmed blir
+*                    komplett, vilket normalt r hgst en ram, men kan vara
+*                    flera nr en frkastad ram innehll hela ramar.
+*                    Antalet mottagna ramar returneras.
+*
+*                    - self: Pekare till parsern.
+*                    - data: Mottagen byte.
+********************************************************************************/
+uint8_t frame_parser_feed(struct frame_parser* self,
+                          const uint8_t data);
+
+/********************************************************************************
+* frame_crc8: Uppdaterar angiven kontrollsumma CRC-8 (polynom 0x07) med
+*             angiven byte och returnerar den nya kontrollsumman, p samma
+*             stt som serial.c.
+*
+*             - crc : Kontrollsumman fre angiven byte.
+*             - data: Byten som ska lggas till.
+********************************************************************************/
+uint8_t frame_crc8(uint8_t crc,
+                   const uint8_t data);
+
+/********************************************************************************
+* frame_print: Skriver ut angiven ram i lsbar form p en rad, exempelvis
+*              "temperature 23.45".
+*
+*              - frame : Pekare till ramen.
+*              - stream: Strmmen som ramen skrivs ut till.
+********************************************************************************/
+void frame_print(const struct frame* frame,
+                 FILE* stream);
+
+#endif /* FRAME_PARSER_H_ */
\ No newline at end of file
@@ -0,0 +1,36 @@
+/********************************************************************************
+* delay.h: Erstter avr-libc:s <util/delay.h> vid kompilering fr
+*          vrddatorn. Frdrjningen lter motsvarande antal klockcykler
+*          passera i simulatorn (se host/sim.h), dr avbrott genomfrs som
+*          vanligt. Precis som i avr-libc frutstts frdrjningen vara
+*          knd vid kompilering, s att flyttalen berknas av kompilatorn.
+********************************************************************************/
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+/* Inkluderingsdirektiv: */
+#include "sim.h"
+
+/********************************************************************************
+* _delay_ms: Lter angivet antal millisekunder passera.
+*
+*            - delay_time_ms: Frdrjningen mtt i millisekunder.
+********************************************************************************/
+static inline void _delay_ms(const double delay_time_ms)
+{
+   sim_delay_cycles((uint64_t)(delay_time_ms * (F_CPU / 1000UL)));
+   return;
+}
+
+/********************************************************************************
+* _delay_us: Lter angivet antal mikrosekunder passera.
+*
+*            - delay_time_us: Frdrjningen mtt i mikrosekunder.
+********************************************************************************/
+static inline void _delay_us(const double delay_time_us)
+{
+   sim_delay_cycles((uint64_t)(delay_time_us * (F_CPU / 1000000UL)));
+   return;
+}
+
+#endif /* HOST_UTIL_DELAY_H_ */
\ No newline at end of file
@@ -3,43 +3,38 @@
 ********************************************************************************/
 #include "header.h"
 
+/********************************************************************************
+* ISR (PCINT0_vect): Avbrottsrutin som ger rum vid event p tryckknapparnas
+*                    pinnar. PCI-avbrott inaktiveras under avstudsningstiden,
+*                    medan tgrden fr nedtryckt knapp lggs i hndelsekn
+*                    och genomfrs frn huvudloopen.
+********************************************************************************/
 ISR (PCINT0_vect)
 {
 	disable_pin_change_interrupt(IO_PORTB);
-	timer_enable_interrupt(&timer0);
+	timer_soft_start(&debounce_timer, 300, false);
 	
 	if(button_is_pressed(&button1))
 	{
-		display_toggle_count();
+		event_post(display_toggle_count);
 	}
 	if(button_is_pressed(&button2))
 	{
-		display_toggle_count_direction();
+		event_post(display_toggle_count_direction);
 	}
 	if(button_is_pressed(&button3))
 	{
-		display_toggle_output();
+		event_post(display_toggle_output);
 	}
 }
 
-ISR (TIMER0_OVF_vect)
-{
-	timer_count(&timer0);
-	
-	if (timer_elapsed(&timer0))
-	{
-		timer_disable_interrupt(&timer0);
-		enable_pin_change_interrupt(IO_PORTB);
-	}
-	
-}
-
 /********************************************************************************
-* ISR (TIMER1_COMPA_vect): Avbrottsrutin som ger rum vid upprkning till 256 av
-*                          Timer 1 i CTC Mode, vilket sker var 0.128:e
-*                          millisekund nr timern r aktiverad. En gng per
-*                          millisekund togglas talet utskrivet p 
-*                          7-segmentsdisplayerna mellan tiotal och ental.
+* ISR (TIMER1_COMPA_vect): Avbrottsrutin som ger rum vid matchning mot OCR1A
+*                          fr Timer 1 i CTC Mode, vilket sker en gng per
+*                          skifte av siffra nr timern r aktiverad (1 ms
+*                          vid tv displayer och 500 Hz uppdatering). Talet
+*                          utskrivet p 7-segmentsdisplayerna skiftas d
+*                          till nsta siffra.
 ********************************************************************************/
 ISR (TIMER1_COMPA_vect)
    /* Anropa funktion fr att toggla siffra p 7-segmentsdisplayerna hr. */
@@ -49,13 +44,78 @@ ISR (TIMER1_COMPA_vect)
 }
 
 /********************************************************************************
-* ISR (TIMER2_OVF_vect): Avbrottsrutin som ger rum vid upprkning till 256 av
-*                        Timer 2 i Normal Mode, vilket sker var 0.128:e
-*                        millisekund nr timern r aktiverad. En gng per sekund
-*                        inkrementeras talet utskrivet p 7-segmentsdisplayerna.
+* ISR (TIMER2_COMPA_vect): Avbrottsrutin som ger rum vid matchning mot OCR2A
+*                          fr Timer 2 i CTC Mode, vilket sker en gng per
+*                          millisekund. Timerhjulet rknas upp, varvid
+*                          mjukvarutimers som lper ut anropar sina
+*                          funktioner, exempelvis avstudsning av
+*                          tryckknapparna. Upprkning av talet p
+*                          7-segmentsdisplayerna lggs i hndelsekn.
 ********************************************************************************/
-ISR (TIMER2_OVF_vect)
+ISR (TIMER2_COMPA_vect)
 {
-	display_count();
+	timer_wheel_tick();
    return;
 }
+
+/********************************************************************************
+* ISR (WDT_vect): Avbrottsrutin som ger rum nr Watchdog-timern lper ut,
+*                 vilket sker innan systemterstllning. Displayernas
+*                 tillstnd sparas till EEPROM s att frndringar som nnu
+*                 inte har skrivits frn huvudloopen inte gr frlorade.
+*                 Om huvudloopen har stannat mitt i display_flush_state
+*                 skrivs inget nytt tillstnd, s att posten som redan kas
+*                 inte blandas med en ny. Samtliga kade skrivningar
+*                 genomfrs innan terstllning.
+********************************************************************************/
+ISR (WDT_vect)
+{
+	display_flush_state();
+	eeprom_flush();
+	return;
+}
+
+/********************************************************************************
+* ISR (EE_READY_vect): Avbrottsrutin som ger rum nr EEPROM-minnet r redo
+*                      fr nsta skrivning, frutsatt att skrivningar ligger
+*                      i skrivkn. Nsta kade skrivning pbrjas.
+********************************************************************************/
+ISR (EE_READY_vect)
+{
+	eeprom_write_next();
+	return;
+}
+
+
+/********************************************************************************
+* ISR (USART_UDRE_vect): Avbrottsrutin som ger rum nr dataregistret fr
+*                        USART r tomt, frutsatt att tecken ligger i
+*                        sndbufferten. Nsta tecken i sndbufferten skickas.
+********************************************************************************/
+ISR (USART_UDRE_vect)
+{
+	serial_transmit_next();
+	return;
+}
+
+/********************************************************************************
+* ISR (USART_RX_vect): Avbrottsrutin som ger rum nr ett tecken har tagits
+*                      emot via USART. Tecknet lggs i mottagningsbufferten,
+*                      medan kommandon tolkas frn huvudloopen.
+********************************************************************************/
+ISR (USART_RX_vect)
+{
+	serial_receive_next();
+	return;
+}
+
+/********************************************************************************
+* ISR (ADC_vect): Avbrottsrutin som ger rum nr en AD-omvandling r klar,
+*                 frutsatt att samplern r igng. Resultatet lagras i
+*                 kanalens ringbuffert och nsta kanal omvandlas.
+********************************************************************************/
+ISR (ADC_vect)
+{
+	adc_sample_next();
+	return;
+}
\ No newline at end of file
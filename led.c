@@ -15,7 +15,7 @@
 void led_init(struct led* self,
               const uint8_t pin)
 {
-   if (pin >= 0 && pin <= 7)
+   if (pin <= 7)
    {
       self->pin = pin;
       self->ddr = &DDRD;
@@ -6,7 +6,20 @@
 #include "header.h"
 
 struct button button1, button2, button3;
-struct timer timer0;
+struct timer_soft debounce_timer;
+
+static const uint8_t display_cathodes[] = { D7, C3 }; /* Katoder fr tiotal och ental. */
+
+/********************************************************************************
+* debounce_elapsed: Anropas av timerhjulet nr avstudsningstiden efter en
+*                   knapptryckning har lpt ut, varefter PCI-avbrott
+*                   teraktiveras fr tryckknapparna.
+********************************************************************************/
+static void debounce_elapsed(void)
+{
+   enable_pin_change_interrupt(IO_PORTB);
+   return;
+}
 
 /********************************************************************************
 * setup: Initierar systemet enligt fljande:
@@ -17,11 +30,21 @@ struct timer timer0;
 *
 *        2. Initierar 7-segmentsdisplayerna med startvrde 0 och aktiverar
 *           upprkning en gng per sekund.
+*
+*        3. Initierar seriell verfring, s att displayerna kan styras via
+*           kommandon (se command.h).
+*
+*        4. Aktiverar avbrott globalt, frst nr samtliga drivrutiner r
+*           initierade.
+*
+*        Timerhjulet drivs av Timer 2 och anvnds fr avstudsning av
+*        tryckknapparna samt upprkning av 7-segmentsdisplayerna.
 ********************************************************************************/
 static inline void setup(void)
 {
    wdt_init(WDT_TIMEOUT_1024_MS);
    wdt_enable_interrupt();
+   timer_wheel_init(TIMER_SEL_2);
 	
 	button_init(&button1, 11);
 	button_init(&button2, 12);
@@ -31,9 +54,11 @@ static inline void setup(void)
 	button_enable_interrupt(&button2);
    button_enable_interrupt(&button3);
 	
-	timer_init(&timer0, TIMER_SEL_0, 300);
+	timer_soft_init(&debounce_timer, debounce_elapsed);
 	
-	display_init();
+	display_init(display_cathodes, sizeof(display_cathodes));
+   serial_init(9600);
+   sei();
 	
    return;
 }
@@ -41,6 +66,14 @@ static inline void setup(void)
 /********************************************************************************
 * main: Initierar systemet vid start. Upprkning sker sedan kontinuerligt
 *       av talet p 7-segmentsdisplayerna en gng per sekund.
+*
+*       Avbrottsrutinerna lgger enbart arbete i hndelsekn, som krs frn
+*       huvudloopen via event_run. Drefter tolkas mottagna kommandon,
+*       displayernas tillstnd sparas vid frndring och Watchdog-timern
+*       terstlls. Slutligen frstts processorn i vilolge tills nsta
+*       avbrott, vilket sker minst en gng per millisekund via timerhjulet.
+*       Tecken som tas emot strax innan vilolget hanteras drmed senast
+*       vid nsta tick.
 ********************************************************************************/
 int main(void)
 {
@@ -48,7 +81,11 @@ int main(void)
    
    while (1)
    {
+      event_run();
+      command_poll();
+      display_flush_state();
       wdt_reset();
+      event_sleep();
    }
 
    return 0;
@@ -5,12 +5,15 @@
 #ifndef MISC_H_
 #define MISC_H_
 
-/* Klockfrekvens (behvs fr frdrjningsrutiner): */
+/* Klockfrekvens (behvs fr frdrjningsrutiner), kan anges vid kompilering: */
+#ifndef F_CPU
 #define F_CPU 16000000UL /* 16 MHz. */
+#endif
 
 /* Inkluderingsdirektiv: */
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -48,6 +51,17 @@
 #define A4 18 /* PORTC4 / pin A4. */
 #define A5 19 /* PORTC5 / pin A5. */
 
+/* Lsning och skrivning av 32-bitars vrden som delas med avbrottsrutiner.
+   Vid kompilering fr vrddatorn erstts dessa via host/avr/io.h, s att
+   varje byte lses och skrivs fr sig som p AVR: */
+#ifndef SHARED_READ_U32
+#define SHARED_READ_U32(source) (*(source))
+#endif
+
+#ifndef SHARED_WRITE_U32
+#define SHARED_WRITE_U32(destination, value) (*(destination) = (value))
+#endif
+
 /********************************************************************************
 * io_port: Enumeration fr val av I/O-port mellan I/O-portar B, C och D.
 ********************************************************************************/
@@ -87,6 +101,43 @@ void delay_ms_ptr(const volatile uint16_t* delay_time_ms);
 ********************************************************************************/
 void delay_us_ptr(const volatile uint16_t* delay_time_us);
 
+/********************************************************************************
+* atomic_read_u32: Lser ett 32-bitars vrde som delas med avbrottsrutiner.
+*                  Lsningen sker med avbrott inaktiverade, eftersom vrdet
+*                  annars kan frndras mellan lsning av de fyra byterna.
+*                  Fregende avbrottstillstnd terstlls eftert, vilket
+*                  gr att funktionen ven kan anropas frn avbrottsrutiner.
+*
+*                  - source: Pekare till vrdet som ska lsas.
+********************************************************************************/
+static inline uint32_t atomic_read_u32(const volatile uint32_t* source)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   const uint32_t value = SHARED_READ_U32(source);
+   SREG = sreg;
+   return value;
+}
+
+/********************************************************************************
+* atomic_write_u32: Skriver ett 32-bitars vrde som delas med avbrottsrutiner.
+*                   Skrivningen sker med avbrott inaktiverade, s att en
+*                   avbrottsrutin aldrig ser ett halvt skrivet vrde.
+*                   Fregende avbrottstillstnd terstlls eftert.
+*
+*                   - destination: Pekare till vrdet som ska skrivas.
+*                   - value      : Vrdet som ska skrivas.
+********************************************************************************/
+static inline void atomic_write_u32(volatile uint32_t* destination,
+                                    const uint32_t value)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   SHARED_WRITE_U32(destination, value);
+   SREG = sreg;
+   return;
+}
+
 /********************************************************************************
 * enable_pin_change_interrupt: Aktiverar PCI-avbrott p angiven I/O-port.
 *
@@ -4,11 +4,56 @@
 ********************************************************************************/
 #include "serial.h"
 
+/* Makrodefinitioner: */
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1) /* Mask fr index i sndbufferten. */
+#define SERIAL_RX_BUFFER_MASK (SERIAL_RX_BUFFER_SIZE - 1) /* Mask fr index i mottagningsbufferten. */
+#define SERIAL_DECIMAL_DIGITS_MAX 10 /* Hgsta antal decimala siffror i ett 32-bitars tal. */
+
+/* Statiska funktioner: */
+static void serial_print_digits(uint32_t number,
+                                const uint8_t decimals);
+static inline uint8_t serial_crc8(uint8_t crc,
+                                  const uint8_t data);
+static inline void serial_send_byte(const uint8_t data,
+                                    uint8_t* crc);
+
+/********************************************************************************
+* powers_of_ten: Tiopotenser fr omvandling till decimal form, frn hgsta
+*                siffran i ett 32-bitars tal till tiotal. Lagras i
+*                programminnet.
+********************************************************************************/
+static const uint32_t powers_of_ten[SERIAL_DECIMAL_DIGITS_MAX - 1] PROGMEM =
+{
+   1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10
+};
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - tx_buffer: Ringbuffert med tecken som ska skickas.
+*   - tx_head  : Index fr nsta tecken som ska skickas.
+*   - tx_tail  : Index fr nsta lediga plats i sndbufferten.
+*   - rx_buffer: Ringbuffert med mottagna tecken.
+*   - rx_head  : Index fr ldsta mottagna tecknet.
+*   - rx_tail  : Index fr nsta lediga plats i mottagningsbufferten.
+*   - overflow : Beteende nr sndbufferten r full.
+*   - stats    : Statistik ver sndbufferten.
+********************************************************************************/
+static volatile char tx_buffer[SERIAL_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile char rx_buffer[SERIAL_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+static enum serial_overflow overflow = SERIAL_OVERFLOW_BLOCK;
+static struct serial_stats stats;
+
 /********************************************************************************
 * serial_init: Initierar USART fr seriell verfring med angiven baud rate,
 *              dr default stts till 9600 kbps (kilobits/sekund). USART 
 *              konfigureras till asynkron verfring med tta bitar i taget,
-*              utan stoppbit.
+*              utan stoppbit. Bde sndning och mottagning aktiveras, dr
+*              avbrott fr mottagning aktiveras direkt.
 *
 *              - baud_rate_kbps: verfringshastigheten, dvs. antalet bitar som 
 '                                transmitteras per sekund (default = 9600 kbps).
@@ -18,7 +63,7 @@ void serial_init(const uint32_t baud_rate_kbps)
    static bool serial_initialized = false;
    if (serial_initialized) return;
 
-   UCSR0B = (1 << TXEN0);
+   UCSR0B = (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0);
    UCSR0C = (1 << UCSZ00) | (1 << UCSZ01);
 
    if (baud_rate_kbps == 0 || baud_rate_kbps == 9600)
@@ -27,7 +72,7 @@ void serial_init(const uint32_t baud_rate_kbps)
    }
    else
    {
-      UBRR0 = (uint8_t)(F_CPU / (16.0 * baud_rate_kbps) - 1 + 0.5);  
+      UBRR0 = (uint16_t)((F_CPU + 8 * baud_rate_kbps) / (16 * baud_rate_kbps) - 1);
    }
 
    UDR0 = '\r';
@@ -61,9 +106,7 @@ void serial_print_string(const char* s)
 ********************************************************************************/
 void serial_print_integer(const int32_t number)
 {
-   char s[20] = { '\0' };
-   sprintf(s, "%ld", number);
-   serial_print_string(s);
+   serial_print_fixed(number, 0);
    return;
 }
 
@@ -74,46 +117,481 @@ void serial_print_integer(const int32_t number)
 ********************************************************************************/
 void serial_print_unsigned(const uint32_t number)
 {
-   char s[20] = { '\0' };
-   sprintf(s, "%lu", number);
-   serial_print_string(s);
+   serial_print_digits(number, 0);
    return;
 }
 
 /********************************************************************************
-* serial_print_double: Skriver ut ett flyttal med upp till tv decimaler 
-*                      via seriell verfring.
+* serial_print_fixed: Skriver ut ett signerat fixtal via seriell verfring,
+*                     dr angivet antal av talets minst signifikanta siffror
+*                     utgr decimaler. Exempelvis skrivs talet -105 med tv
+*                     decimaler ut som -1.05.
 *
-*                      - number: Flyttalet som ska skrivas ut.
+*                     1. Vid negativt tal skrivs ett minustecken ut och talets
+*                        belopp berknas. Beloppet berknas som ett osignerat
+*                        tal, vilket gr att ven det minsta talet -2147483648
+*                        hanteras korrekt.
+*
+*                     2. Beloppet skrivs ut med decimalpunkt fre angivet
+*                        antal decimaler.
+*
+*                     - number  : Fixtalet som ska skrivas ut.
+*                     - decimals: Antalet decimaler (0 - 9).
 ********************************************************************************/
-void serial_print_double(const double number)
+void serial_print_fixed(const int32_t number,
+                        const uint8_t decimals)
 {
-   const int32_t integer = (int32_t)number;
-   int32_t decimal;
-   char s[20] = { '\0' };
-   
-   if (integer >= 0)
+   if (number < 0)
    {
-      decimal = (int32_t)((number - integer) * 100 + 0.5);
+      serial_print_char('-');
+      serial_print_digits(0UL - (uint32_t)number, decimals);
    }
    else
    {
-      decimal = (int32_t)((integer - number) * 100 + 0.5);
+      serial_print_digits((uint32_t)number, decimals);
+   }
+   return;
+}
+
+/********************************************************************************
+* serial_print_hex: Skriver ut ett osignerat heltal i hexadecimal form via
+*                   seriell verfring, utfyllt med inledande nollor till
+*                   minst angivet antal siffror.
+*
+*                   - number    : Heltalet som ska skrivas ut.
+*                   - min_digits: Minsta antal siffror som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex(const uint32_t number,
+                      const uint8_t min_digits)
+{
+   bool leading_zero = true;
+
+   for (uint8_t i = 8; i > 0; --i)
+   {
+      const uint8_t nibble = (uint8_t)(number >> ((i - 1) * 4)) & 0x0F;
+      if (nibble || i == 1 || i <= min_digits) leading_zero = false;
+
+      if (!leading_zero)
+      {
+         serial_print_char(nibble < 10 ? '0' + nibble : 'A' + nibble - 10);
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* serial_print_double: Skriver ut ett flyttal med tv decimaler via seriell
+*                      verfring. Talet avrundas till nrmaste hundradel och
+*                      skrivs ut som ett fixtal, vilket gr att ven tal mellan
+*                      -1 och 0 samt decimaler med inledande nolla skrivs ut
+*                      korrekt. Talets belopp fr inte verstiga 21474836.47.
+*
+*                      - number: Flyttalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_double(const double number)
+{
+   const int32_t hundredths = (int32_t)(number * 100 + (number < 0 ? -0.5 : 0.5));
+   serial_print_fixed(hundredths, 2);
+   return;
+}
+
+/********************************************************************************
+* serial_send_frame: Skickar en binr ram av angiven typ med angiven data via
+*                    seriell verfring. Om datan verstiger
+*                    SERIAL_FRAME_PAYLOAD_MAX byte skickas ingen ram och
+*                    felkod 1 returneras, annars 0.
+*
+*                    1. Synkroniseringsbyten skickas, vilken inte ingr i
+*                       kontrollsumman.
+*
+*                    2. Ramens typ, lngd samt data skickas, dr
+*                       kontrollsumman uppdateras fr varje skickad byte.
+*
+*                    3. Kontrollsumman skickas sist.
+*
+*                    - type   : Ramens typ.
+*                    - payload: Pekare till datan som ska skickas.
+*                    - length : Antalet databyte.
+********************************************************************************/
+int serial_send_frame(const enum serial_frame_type type,
+                      const void* payload,
+                      const uint8_t length)
+{
+   if (length > SERIAL_FRAME_PAYLOAD_MAX) return 1;
+   const uint8_t* data = (const uint8_t*)payload;
+   uint8_t crc = 0;
+
+   serial_print_char((char)SERIAL_FRAME_SYNC);
+   serial_send_byte((uint8_t)type, &crc);
+   serial_send_byte(length, &crc);
+
+   for (uint8_t i = 0; i < length; ++i)
+   {
+      serial_send_byte(data[i], &crc);
    }
 
-   sprintf(s, "%ld.%ld", integer, decimal);
-   serial_print_string(s);
+   serial_print_char((char)crc);
+   return 0;
+}
+
+/********************************************************************************
+* serial_send_temperature: Skickar en ram innehllande angiven temperatur.
+*
+*                          - temperature_centi: Temperaturen i hundradels
+*                                               grader Celcius.
+********************************************************************************/
+void serial_send_temperature(const int16_t temperature_centi)
+{
+   const uint8_t payload[] =
+   {
+      (uint8_t)(temperature_centi), (uint8_t)(temperature_centi >> 8)
+   };
+
+   serial_send_frame(SERIAL_FRAME_TEMPERATURE, payload, sizeof(payload));
+   return;
+}
+
+/********************************************************************************
+* serial_send_adc_raw: Skickar en ram innehllande angivet rvrde frn
+*                      AD-omvandlaren.
+*
+*                      - pin  : Analog pin som har lsts av.
+*                      - value: Rvrdet mellan 0 - 1023.
+********************************************************************************/
+void serial_send_adc_raw(const uint8_t pin,
+                         const uint16_t value)
+{
+   const uint8_t payload[] = { pin, (uint8_t)(value), (uint8_t)(value >> 8) };
+   serial_send_frame(SERIAL_FRAME_ADC_RAW, payload, sizeof(payload));
+   return;
+}
+
+/********************************************************************************
+* serial_send_display_state: Skickar en ram innehllande 7-segmentsdisplayernas
+*                            tillstnd.
+*
+*                            - number: Talet som visas p displayerna.
+*                            - radix : Talbasen som anvnds.
+*                            - flags : Flaggor SERIAL_DISPLAY_*.
+********************************************************************************/
+void serial_send_display_state(const uint32_t number,
+                               const uint8_t radix,
+                               const uint8_t flags)
+{
+   const uint8_t payload[] =
+   {
+      (uint8_t)(number), (uint8_t)(number >> 8),
+      (uint8_t)(number >> 16), (uint8_t)(number >> 24),
+      radix, flags
+   };
+
+   serial_send_frame(SERIAL_FRAME_DISPLAY_STATE, payload, sizeof(payload));
    return;
 }
 
 /********************************************************************************
-* serial_print_char: Skriver ut ett enskilt tecken via seriell verfring.
+* serial_send_counters: Skickar en ram innehllande angivna rknare. Om
+*                       antalet rknare verstiger SERIAL_FRAME_COUNTERS_MAX
+*                       skickas ingen ram och felkod 1 returneras, annars 0.
+*
+*                       - counters    : Pekare till rknarna.
+*                       - num_counters: Antalet rknare.
+********************************************************************************/
+int serial_send_counters(const uint32_t* counters,
+                         const uint8_t num_counters)
+{
+   if (num_counters > SERIAL_FRAME_COUNTERS_MAX) return 1;
+   uint8_t payload[SERIAL_FRAME_PAYLOAD_MAX];
+
+   for (uint8_t i = 0; i < num_counters; ++i)
+   {
+      payload[i * 4] = (uint8_t)(counters[i]);
+      payload[i * 4 + 1] = (uint8_t)(counters[i] >> 8);
+      payload[i * 4 + 2] = (uint8_t)(counters[i] >> 16);
+      payload[i * 4 + 3] = (uint8_t)(counters[i] >> 24);
+   }
+
+   return serial_send_frame(SERIAL_FRAME_COUNTERS, payload, num_counters * 4);
+}
+
+/********************************************************************************
+* serial_print_char: Lgger ett enskilt tecken i sndbufferten fr seriell
+*                    verfring.
+*
+*                    1. Avbrott inaktiveras temporrt, s att sndbufferten
+*                       inte kan frndras av avbrottsrutinen under
+*                       klggningen.
+*
+*                    2. Om plats finns lggs tecknet sist i sndbufferten,
+*                       hgvattenmrket uppdateras och avbrott fr USART Data
+*                       Register Empty aktiveras, vilket gr att
+*                       avbrottsrutinen skickar tecknet s fort
+*                       dataregistret r tomt.
+*
+*                    3. Om sndbufferten r full och tecken ska kastas rknas
+*                       antalet kastade tecken upp. Annars skickas nsta tecken
+*                       hrifrn s fort dataregistret r tomt, vilket gr att
+*                       funktionen fungerar ven med avbrott inaktiverade.
+*                       Under vntan terstlls avbrottstillstndet.
 *
 *                    - character: Det tecken som ska skrivas ut.
 ********************************************************************************/
 void serial_print_char(const char character)
 {
-   while ((UCSR0A & (1 << UDRE0)) == 0);
-   UDR0 = character;
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      cli();
+      const uint8_t next = (tx_tail + 1) & SERIAL_TX_BUFFER_MASK;
+
+      if (next != tx_head)
+      {
+         tx_buffer[tx_tail] = character;
+         tx_tail = next;
+
+         const uint8_t used = (tx_tail - tx_head) & SERIAL_TX_BUFFER_MASK;
+         if (used > stats.high_water) stats.high_water = used;
+
+         UCSR0B |= (1 << UDRIE0);
+         SREG = sreg;
+         return;
+      }
+
+      if (overflow == SERIAL_OVERFLOW_DROP)
+      {
+         stats.dropped++;
+         SREG = sreg;
+         return;
+      }
+
+      if (UCSR0A & (1 << UDRE0)) serial_transmit_next();
+      SREG = sreg;
+   }
+}
+
+/********************************************************************************
+* serial_transmit_next: Skickar nsta tecken i sndbufferten. Nr bufferten r
+*                       tom inaktiveras avbrott fr USART Data Register Empty,
+*                       som annars hade gt rum kontinuerligt. Funktionen
+*                       frutstter att avbrott r inaktiverade samt att
+*                       dataregistret r tomt, vilket alltid gller i
+*                       avbrottsrutinen fr USART Data Register Empty.
+********************************************************************************/
+void serial_transmit_next(void)
+{
+   if (tx_head == tx_tail)
+   {
+      UCSR0B &= ~(1 << UDRIE0);
+      return;
+   }
+
+   UDR0 = tx_buffer[tx_head];
+   tx_head = (tx_head + 1) & SERIAL_TX_BUFFER_MASK;
+   return;
+}
+
+/********************************************************************************
+* serial_receive_next: Lser mottaget tecken och lgger det i
+*                      mottagningsbufferten. Dataregistret lses alltid, s att
+*                      avbrottet kvitteras. Om mottagningsbufferten r full,
+*                      eller om hrdvarubufferten har verskridits innan
+*                      avlsning, rknas antalet kastade tecken upp. Funktionen
+*                      frutstter att avbrott r inaktiverade, vilket alltid
+*                      gller i avbrottsrutinen fr USART Receive Complete.
+********************************************************************************/
+void serial_receive_next(void)
+{
+   if (UCSR0A & (1 << DOR0)) stats.rx_dropped++;
+   const char character = UDR0;
+   const uint8_t next = (rx_tail + 1) & SERIAL_RX_BUFFER_MASK;
+
+   if (next == rx_head)
+   {
+      stats.rx_dropped++;
+      return;
+   }
+
+   rx_buffer[rx_tail] = character;
+   rx_tail = next;
+   return;
+}
+
+/********************************************************************************
+* serial_read_char: Hmtar ldsta tecknet ur mottagningsbufferten till angiven
+*                   destination. Vid hmtat tecken returneras 0. Om
+*                   mottagningsbufferten r tom returneras 1. Enbart
+*                   avbrottsrutinen skriver till rx_tail och enbart denna
+*                   funktion skriver till rx_head, vilket gr att avbrott
+*                   inte behver inaktiveras.
+*
+*                   - character: Pekare till destinationen.
+********************************************************************************/
+int serial_read_char(char* character)
+{
+   if (rx_head == rx_tail) return 1;
+   *character = rx_buffer[rx_head];
+   rx_head = (rx_head + 1) & SERIAL_RX_BUFFER_MASK;
+   return 0;
+}
+
+/********************************************************************************
+* serial_transmit_pending: Indikerar ifall tecken terstr i sndbufferten.
+*                          I s fall returneras true, annars false.
+********************************************************************************/
+bool serial_transmit_pending(void)
+{
+   return tx_head != tx_tail;
+}
+
+/********************************************************************************
+* serial_flush: Vntar tills samtliga tecken i sndbufferten har skickats.
+*               Varje tecken skickas hrifrn s fort dataregistret r tomt,
+*               vilket gr att funktionen fungerar ven med avbrott
+*               inaktiverade.
+********************************************************************************/
+void serial_flush(void)
+{
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      cli();
+
+      if (tx_head == tx_tail)
+      {
+         SREG = sreg;
+         return;
+      }
+
+      if (UCSR0A & (1 << UDRE0)) serial_transmit_next();
+      SREG = sreg;
+   }
+}
+
+/********************************************************************************
+* serial_set_overflow: Vljer beteende nr sndbufferten r full.
+*
+*                      - new_overflow: Vntan (SERIAL_OVERFLOW_BLOCK) eller
+*                                      kastning (SERIAL_OVERFLOW_DROP).
+********************************************************************************/
+void serial_set_overflow(const enum serial_overflow new_overflow)
+{
+   overflow = new_overflow;
+   return;
+}
+
+/********************************************************************************
+* serial_get_stats: Kopierar statistiken ver sndbufferten till angiven
+*                   destination.
+*
+*                   - destination: Pekare till destinationen.
+********************************************************************************/
+void serial_get_stats(struct serial_stats* destination)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   *destination = stats;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* serial_reset_stats: Nollstller statistiken ver sndbufferten.
+********************************************************************************/
+void serial_reset_stats(void)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   stats.high_water = 0;
+   stats.dropped = 0;
+   stats.rx_dropped = 0;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* serial_print_digits: Skriver ut ett osignerat tal i decimal form, med
+*                      decimalpunkt fre angivet antal decimaler. Siffrorna
+*                      skrivs ut direkt till sndbufferten utan division.
+*
+*                      1. Varje siffra, frn den mest signifikanta, berknas
+*                         genom att motsvarande tiopotens subtraheras s lnge
+*                         talet r strre eller lika med denna. Detta krver
+*                         som mest nio subtraktioner per siffra, vilket r
+*                         betydligt billigare n 32-bitars division p AVR.
+*
+*                      2. Inledande nollor skrivs inte ut, frutom entalet
+*                         samt decimaler, s att exempelvis 5 med tv
+*                         decimaler skrivs ut som 0.05.
+*
+*                      3. Decimalpunkt skrivs ut efter entalet om decimaler
+*                         anvnds.
+*
+*                      4. terstoden efter samtliga subtraktioner utgr den
+*                         minst signifikanta siffran.
+*
+*                      - number  : Talet som ska skrivas ut.
+*                      - decimals: Antalet decimaler (0 - 9).
+********************************************************************************/
+static void serial_print_digits(uint32_t number,
+                                const uint8_t decimals)
+{
+   bool leading_zero = true;
+
+   for (uint8_t i = 0; i < SERIAL_DECIMAL_DIGITS_MAX - 1; ++i)
+   {
+      const uint8_t position = SERIAL_DECIMAL_DIGITS_MAX - 1 - i;
+      const uint32_t power = pgm_read_dword(&powers_of_ten[i]);
+      char digit = '0';
+
+      while (number >= power)
+      {
+         number -= power;
+         digit++;
+      }
+
+      if (digit != '0' || position <= decimals) leading_zero = false;
+
+      if (!leading_zero)
+      {
+         serial_print_char(digit);
+         if (position == decimals) serial_print_char('.');
+      }
+   }
+
+   serial_print_char('0' + (char)number);
+   return;
+}
+
+/********************************************************************************
+* serial_crc8: Uppdaterar angiven kontrollsumma CRC-8 (polynom 0x07) med
+*              angiven byte och returnerar den nya kontrollsumman.
+*
+*              - crc : Kontrollsumman fre angiven byte.
+*              - data: Byten som ska lggas till.
+********************************************************************************/
+static inline uint8_t serial_crc8(uint8_t crc,
+                                  const uint8_t data)
+{
+   crc ^= data;
+
+   for (uint8_t i = 0; i < 8; ++i)
+   {
+      crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+   }
+   return crc;
+}
+
+/********************************************************************************
+* serial_send_byte: Skickar en byte som del av en binr ram och uppdaterar
+*                   ramens kontrollsumma.
+*
+*                   - data: Byten som ska skickas.
+*                   - crc : Pekare till ramens kontrollsumma.
+********************************************************************************/
+static inline void serial_send_byte(const uint8_t data,
+                                    uint8_t* crc)
+{
+   serial_print_char((char)data);
+   *crc = serial_crc8(*crc, data);
    return;
 }
\ No newline at end of file
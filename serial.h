@@ -1,5 +1,45 @@
 /********************************************************************************
 * serial.h: Innehller drivrutiner fr seriell verfring via USART.
+*
+*           Utskrifter lggs i en sndbuffert och returnerar direkt, s lnge
+*           bufferten inte r full. Sndbufferten tms ett tecken i taget av
+*           avbrottsrutinen fr USART Data Register Empty, dr funktionen
+*           serial_transmit_next ska anropas ssom visas nedan:
+*
+*           ISR (USART_UDRE_vect)
+*           {
+*              serial_transmit_next();
+*              return;
+*           }
+*
+*           Mottagna tecken lggs i en mottagningsbuffert av avbrottsrutinen
+*           fr USART Receive Complete, dr funktionen serial_receive_next
+*           ska anropas ssom visas nedan. Mottagna tecken hmtas sedan frn
+*           huvudloopen via serial_read_char.
+*
+*           ISR (USART_RX_vect)
+*           {
+*              serial_receive_next();
+*              return;
+*           }
+*
+*           Nr sndbufferten r full vntar utskriften antingen tills plats
+*           finns (SERIAL_OVERFLOW_BLOCK, default) eller s kastas tecknet
+*           (SERIAL_OVERFLOW_DROP), vilket vljs via serial_set_overflow.
+*
+*           Frutom lsbar text kan mtvrden skickas som kompakta binra
+*           ramar via serial_send_frame, vilket krver ungefr en femtedel
+*           s mnga byte per mtvrde. Varje ram har fljande format:
+*
+*           | SYNC (0xA5) | TYPE | LEN | PAYLOAD (LEN byte) | CRC-8 |
+*
+*           dr CRC-8 (polynom 0x07, startvrde 0) berknas ver TYPE, LEN
+*           samt PAYLOAD. Flerbyteflt i PAYLOAD lagras med minst signifikant
+*           byte frst. En mottagare synkroniserar genom att leta efter
+*           SYNC fljt av en ram med korrekt CRC-8, vilket gr att ramar som
+*           helt eller delvis har kastats vid full sndbuffert frkastas.
+*           Ramar br enbart skickas frn huvudloopen, s att ramar inte
+*           blandas med utskrifter frn avbrottsrutiner.
 ********************************************************************************/
 #ifndef SERIAL_H_
 #define SERIAL_H_
@@ -7,6 +47,53 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 
+/* Makrodefinitioner: */
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 64 /* Kapacitet fr sndbufferten (tvpotens, hgst 256). */
+#endif
+
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 32 /* Kapacitet fr mottagningsbufferten (tvpotens, hgst 256). */
+#endif
+
+#define SERIAL_FRAME_SYNC 0xA5        /* Synkroniseringsbyte i brjan av varje ram. */
+#define SERIAL_FRAME_PAYLOAD_MAX 32   /* Hgsta antal databyte per ram. */
+#define SERIAL_FRAME_COUNTERS_MAX (SERIAL_FRAME_PAYLOAD_MAX / sizeof(uint32_t)) /* Hgsta antal rknare per ram. */
+
+#define SERIAL_DISPLAY_OUTPUT_ENABLED 0x01 /* Flagga fr pslagna displayer. */
+#define SERIAL_DISPLAY_COUNT_ENABLED 0x02  /* Flagga fr aktiverad rkning. */
+#define SERIAL_DISPLAY_COUNT_UP 0x04       /* Flagga fr upprkning (annars nedrkning). */
+
+/********************************************************************************
+* serial_frame_type: Enumeration fr typ av binr ram samt ramens innehll.
+********************************************************************************/
+enum serial_frame_type
+{
+   SERIAL_FRAME_TEMPERATURE = 0x01,   /* Temperatur i hundradels grader Celcius (int16_t). */
+   SERIAL_FRAME_ADC_RAW = 0x02,       /* Analog pin (uint8_t) samt rvrde 0 - 1023 (uint16_t). */
+   SERIAL_FRAME_DISPLAY_STATE = 0x03, /* Tal (uint32_t), talbas (uint8_t) samt flaggor (uint8_t). */
+   SERIAL_FRAME_COUNTERS = 0x04       /* Godtyckligt antal rknare (uint32_t vardera). */
+};
+
+/********************************************************************************
+* serial_overflow: Enumeration fr val av beteende vid full sndbuffert.
+********************************************************************************/
+enum serial_overflow
+{
+   SERIAL_OVERFLOW_BLOCK, /* Vnta tills plats finns i sndbufferten. */
+   SERIAL_OVERFLOW_DROP   /* Kasta tecknet och rkna upp antalet kastade tecken. */
+};
+
+/********************************************************************************
+* serial_stats: Strukt fr statistik ver sndbufferten.
+********************************************************************************/
+struct serial_stats
+{
+   uint8_t high_water;  /* Hgsta antal tecken som samtidigt legat i sndbufferten. */
+   uint32_t dropped;    /* Antal tecken som kastats p grund av full sndbuffert. */
+   uint32_t rx_dropped; /* Antal mottagna tecken som kastats p grund av full buffert. */
+};
+
 /********************************************************************************
 * serial_init: Initierar USART fr seriell verfring med angiven baud rate.
 *
@@ -36,19 +123,158 @@ void serial_print_integer(const int32_t number);
 void serial_print_unsigned(const uint32_t number);
 
 /********************************************************************************
-* serial_print_double: Skriver ut ett flyttal via seriell verfring.
+* serial_print_fixed: Skriver ut ett signerat fixtal via seriell verfring,
+*                     dr angivet antal av talets minst signifikanta siffror
+*                     utgr decimaler. Exempelvis skrivs talet -105 med tv
+*                     decimaler ut som -1.05.
+*
+*                     - number  : Fixtalet som ska skrivas ut.
+*                     - decimals: Antalet decimaler (0 - 9).
+********************************************************************************/
+void serial_print_fixed(const int32_t number,
+                        const uint8_t decimals);
+
+/********************************************************************************
+* serial_print_hex: Skriver ut ett osignerat heltal i hexadecimal form via
+*                   seriell verfring, utfyllt med inledande nollor till
+*                   minst angivet antal siffror.
+*
+*                   - number    : Heltalet som ska skrivas ut.
+*                   - min_digits: Minsta antal siffror som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex(const uint32_t number,
+                      const uint8_t min_digits);
+
+/********************************************************************************
+* serial_print_double: Skriver ut ett flyttal med tv decimaler via seriell
+*                      verfring. Talets belopp fr inte verstiga
+*                      21474836.47.
 *
 *                      - number: Flyttalet som ska skrivas ut.
 ********************************************************************************/
 void serial_print_double(const double number);
 
 /********************************************************************************
-* serial_print_char: Skriver ut ett enskilt tecken via seriell verfring.
+* serial_send_frame: Skickar en binr ram av angiven typ med angiven data via
+*                    seriell verfring. Om datan verstiger
+*                    SERIAL_FRAME_PAYLOAD_MAX byte skickas ingen ram och
+*                    felkod 1 returneras, annars 0.
+*
+*                    - type   : Ramens typ.
+*                    - payload: Pekare till datan som ska skickas.
+*                    - length : Antalet databyte.
+********************************************************************************/
+int serial_send_frame(const enum serial_frame_type type,
+                      const void* payload,
+                      const uint8_t length);
+
+/********************************************************************************
+* serial_send_temperature: Skickar en ram innehllande angiven temperatur.
+*
+*                          - temperature_centi: Temperaturen i hundradels
+*                                               grader Celcius.
+********************************************************************************/
+void serial_send_temperature(const int16_t temperature_centi);
+
+/********************************************************************************
+* serial_send_adc_raw: Skickar en ram innehllande angivet rvrde frn
+*                      AD-omvandlaren.
+*
+*                      - pin  : Analog pin som har lsts av.
+*                      - value: Rvrdet mellan 0 - 1023.
+********************************************************************************/
+void serial_send_adc_raw(const uint8_t pin,
+                         const uint16_t value);
+
+/********************************************************************************
+* serial_send_display_state: Skickar en ram innehllande 7-segmentsdisplayernas
+*                            tillstnd.
+*
+*                            - number: Talet som visas p displayerna.
+*                            - radix : Talbasen som anvnds.
+*                            - flags : Flaggor SERIAL_DISPLAY_*.
+********************************************************************************/
+void serial_send_display_state(const uint32_t number,
+                               const uint8_t radix,
+                               const uint8_t flags);
+
+/********************************************************************************
+* serial_send_counters: Skickar en ram innehllande angivna rknare. Om
+*                       antalet rknare verstiger SERIAL_FRAME_COUNTERS_MAX
+*                       skickas ingen ram och felkod 1 returneras, annars 0.
+*
+*                       - counters    : Pekare till rknarna.
+*                       - num_counters: Antalet rknare.
+********************************************************************************/
+int serial_send_counters(const uint32_t* counters,
+                         const uint8_t num_counters);
+
+/********************************************************************************
+* serial_print_char: Lgger ett enskilt tecken i sndbufferten fr seriell
+*                    verfring.
 *
 *                    - character: Det tecken som ska skrivas ut.
 ********************************************************************************/
 void serial_print_char(const char character);
 
+/********************************************************************************
+* serial_transmit_next: Skickar nsta tecken i sndbufferten. Nr bufferten r
+*                       tom inaktiveras avbrott fr USART Data Register Empty.
+*                       Denna funktion ska anropas i avbrottsrutinen fr
+*                       USART Data Register Empty (USART_UDRE_vect).
+********************************************************************************/
+void serial_transmit_next(void);
+
+/********************************************************************************
+* serial_receive_next: Lser mottaget tecken och lgger det i
+*                      mottagningsbufferten. Denna funktion ska anropas i
+*                      avbrottsrutinen fr USART Receive Complete
+*                      (USART_RX_vect).
+********************************************************************************/
+void serial_receive_next(void);
+
+/********************************************************************************
+* serial_read_char: Hmtar ldsta tecknet ur mottagningsbufferten till angiven
+*                   destination. Vid hmtat tecken returneras 0. Om
+*                   mottagningsbufferten r tom returneras 1.
+*
+*                   - character: Pekare till destinationen.
+********************************************************************************/
+int serial_read_char(char* character);
+
+/********************************************************************************
+* serial_transmit_pending: Indikerar ifall tecken terstr i sndbufferten.
+*                          I s fall returneras true, annars false.
+********************************************************************************/
+bool serial_transmit_pending(void);
+
+/********************************************************************************
+* serial_flush: Vntar tills samtliga tecken i sndbufferten har skickats.
+*               Fungerar ven med avbrott inaktiverade.
+********************************************************************************/
+void serial_flush(void);
+
+/********************************************************************************
+* serial_set_overflow: Vljer beteende nr sndbufferten r full.
+*
+*                      - new_overflow: Vntan (SERIAL_OVERFLOW_BLOCK) eller
+*                                      kastning (SERIAL_OVERFLOW_DROP).
+********************************************************************************/
+void serial_set_overflow(const enum serial_overflow new_overflow);
+
+/********************************************************************************
+* serial_get_stats: Kopierar statistiken ver sndbufferten till angiven
+*                   destination.
+*
+*                   - destination: Pekare till destinationen.
+********************************************************************************/
+void serial_get_stats(struct serial_stats* destination);
+
+/********************************************************************************
+* serial_reset_stats: Nollstller statistiken ver sndbufferten.
+********************************************************************************/
+void serial_reset_stats(void);
+
 /********************************************************************************
 * serial_print_new_line: Stter nsta utskrift till lngst till vnster p 
 *                        nsta rad via utskrift av ett nyradstecken.
@@ -4,12 +4,73 @@
 #include "timer.h"
 
 /* Makrodefinitioner: */
-#define TIME_BETWEEN_INTERRUPTS_MS 0.128 /* Tid mellan varje timergenererat avbrott. */
+#define TIMER_PRESCALERS_MAX 7                  /* Hgsta antal prescalers fr en timerkrets. */
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1) /* Mask fr fack i timerhjulet. */
+#define TIMER_WHEEL_TICK_US 1000                /* Tid per tick i timerhjulet. */
+
+/* Indikerar ifall antalet klockcykler per mikrosekund r en tvpotens (16 MHz),
+   dr tiden per steg i hrdvarurknaren drmed ocks r en tvpotens. */
+#define TIMER_WHEEL_STEP_SHIFT ((TIMER_CYCLES_PER_US & (TIMER_CYCLES_PER_US - 1)) == 0)
+
+/********************************************************************************
+* timer_circuit: Strukt fr en timerkrets hrdvaruegenskaper, dr prescalers
+*                lagras som tvpotenser (exempelvis 3 fr prescaler 8), i
+*                stigande ordning. Index + 1 utgr motsvarande vrde p
+*                bitarna CSn2 - CSn0.
+********************************************************************************/
+struct timer_circuit
+{
+   uint8_t top_bits;                             /* Antal bitar i timerkretsens rknare. */
+   uint8_t num_prescalers;                       /* Antal tillgngliga prescalers. */
+   uint8_t prescaler_shift[TIMER_PRESCALERS_MAX]; /* Prescalers som tvpotenser. */
+};
 
 /* Statiska funktioner: */
 static void timer_init_circuit(struct timer* self);
 static void timer_disable_circuit(struct timer* self);
-static inline uint32_t timer_get_max_count(const double time_ms);
+static void timer_get_period(const enum timer_sel timer_sel,
+                             const uint32_t time_us,
+                             struct timer_period* period);
+static const struct timer_circuit* timer_get_circuit(const enum timer_sel timer_sel);
+static void timer_set_period(struct timer* self,
+                             const struct timer_period* period);
+static inline void timer_wheel_insert(struct timer_soft* self,
+                                      struct timer_soft** slot);
+static inline void timer_wheel_remove(struct timer_soft* self);
+
+/********************************************************************************
+* Statiska variabler:
+*
+*   - circuit_8bit : Egenskaper fr Timer 0 (prescaler 1, 8, 64, 256, 1024).
+*   - circuit_16bit: Egenskaper fr Timer 1 (prescaler 1, 8, 64, 256, 1024).
+*   - circuit_async: Egenskaper fr Timer 2 (prescaler 1, 8, 32, 64, 128,
+*                    256, 1024).
+*
+*   - wheel      : Timerhjulets fack, vart och ett med en lnkad lista av
+*                  mjukvarutimers.
+*   - wheel_timer: Timerkrets som driver timerhjulet.
+*   - wheel_now  : Antalet tick sedan timerhjulet initierades.
+*   - wheel_top  : Antal steg i timerhjulets hrdvarurknare per tick.
+*   - wheel_step_shift : Tid per steg i hrdvarurknaren mtt i mikrosekunder,
+*                        lagrat som tvpotens (exempelvis 2 fr 4 us och -4
+*                        fr 1/16 us), vid TIMER_WHEEL_STEP_SHIFT.
+*   - wheel_us_per_step: Tid per steg i hrdvarurknaren mtt i mikrosekunder,
+*                        lagrat som fixtal med 16 brkbitar, vriga
+*                        klockfrekvenser.
+********************************************************************************/
+static const struct timer_circuit circuit_8bit = { 8, 5, { 0, 3, 6, 8, 10 } };
+static const struct timer_circuit circuit_16bit = { 16, 5, { 0, 3, 6, 8, 10 } };
+static const struct timer_circuit circuit_async = { 8, 7, { 0, 3, 5, 6, 7, 8, 10 } };
+
+static struct timer_soft* wheel[TIMER_WHEEL_SLOTS];
+static struct timer wheel_timer;
+static volatile uint32_t wheel_now = 0;
+static uint16_t wheel_top = 0;
+#if TIMER_WHEEL_STEP_SHIFT
+static int8_t wheel_step_shift = 0;
+#else
+static uint32_t wheel_us_per_step = 0;
+#endif
 
 /********************************************************************************
 * timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
@@ -25,10 +86,42 @@ void timer_init(struct timer* self,
                 const enum timer_sel timer_sel, 
                 const double time_ms)
 {
-   self->counter = 0;
-   self->max_count = timer_get_max_count(time_ms);
+   timer_init_us(self, timer_sel, (uint32_t)(time_ms * 1000 + 0.5));
+   return;
+}
+
+/********************************************************************************
+* timer_init_us: Initierar ny timerkrets med angiven tid mtt i mikrosekunder.
+*
+*                - self     : Pekare till timern som ska initieras.
+*                - timer_sel: Val av timerkrets.
+*                - time_us  : Tiden timern ska sttas p mtt i mikrosekunder.
+********************************************************************************/
+void timer_init_us(struct timer* self,
+                   const enum timer_sel timer_sel,
+                   const uint32_t time_us)
+{
+   struct timer_period period;
+   timer_get_period(timer_sel, time_us, &period);
+   timer_init_period(self, timer_sel, &period);
+   return;
+}
+
+/********************************************************************************
+* timer_init_period: Initierar ny timerkrets med angivna instllningar,
+*                    berknade via TIMER_PERIOD.
+*
+*                    - self     : Pekare till timern som ska initieras.
+*                    - timer_sel: Val av timerkrets.
+*                    - period   : Pekare till timerkretsens instllningar.
+********************************************************************************/
+void timer_init_period(struct timer* self,
+                       const enum timer_sel timer_sel,
+                       const struct timer_period* period)
+{
    self->timer_sel = timer_sel;
    timer_init_circuit(self);
+   timer_set_period(self, period);
    return;
 }
 
@@ -40,7 +133,7 @@ void timer_init(struct timer* self,
 void timer_clear(struct timer* self)
 {
    timer_disable_circuit(self);
-   self->counter = 0;
+   atomic_write_u32(&self->counter, 0);
    self->max_count = 0;
    self->timsk = 0;
    self->timsk_bit = 0;
@@ -73,21 +166,20 @@ void timer_toggle_interrupt(struct timer* self)
 /********************************************************************************
 * timer_elapsed: Indikerar ifall angiven timer har lpt ut genom att returnera
 *                true eller false. Ifall timern har lpt ut nollstlls rknaren
-*                infr nsta upprkning.
+*                infr nsta upprkning. Kontroll samt nollstllning sker med
+*                avbrott inaktiverade, s att rknaren inte kan rknas upp
+*                dremellan eller lsas halvt uppdaterad.
 *
 *                - self: Pekare till timern som ska kontrolleras.
 ********************************************************************************/
 bool timer_elapsed(struct timer* self)
 {
-   if (self->counter >= self->max_count)
-   {
-     self->counter = 0;
-     return true;
-   }
-   else
-   {
-      return false;
-   }
+   const uint8_t sreg = SREG;
+   cli();
+   const bool elapsed = SHARED_READ_U32(&self->counter) >= self->max_count;
+   if (elapsed) SHARED_WRITE_U32(&self->counter, 0);
+   SREG = sreg;
+   return elapsed;
 }
 
 /********************************************************************************
@@ -98,7 +190,7 @@ bool timer_elapsed(struct timer* self)
 void timer_reset(struct timer* self)
 {
    timer_disable_interrupt(self);
-   self->counter = 0;
+   atomic_write_u32(&self->counter, 0);
    return;
 }
 
@@ -111,17 +203,260 @@ void timer_reset(struct timer* self)
 void timer_set_new_time(struct timer* self, 
                         const double time_ms)
 {
-   self->max_count = timer_get_max_count(time_ms);
+   timer_set_new_time_us(self, (uint32_t)(time_ms * 1000 + 0.5));
    return;
 }
 
 /********************************************************************************
-* timer_init_circuit: Initierar angiven timerkrets. Timer 0 samt Timer 2
-*                     initieras i Normal Mode, medan Timer 1 initieras i
-*                     CTC Mode med upprkning till 256. Vid aktiverat avbrott
-*                     p godtycklig initierad timer sker timergenererat avbrott 
-*                     var 0.128:e millisekund. Adresserna till motsvarande
-*                     maskregister som bit fr aktivering av avbrott sparas.
+* timer_set_new_time_us: Stter ny tid p angiven timerkrets mtt i
+*                        mikrosekunder.
+*
+*                        - self   : Pekare till timern vars tid ska uppdateras.
+*                        - time_us: Tiden timern ska sttas p i mikrosekunder.
+********************************************************************************/
+void timer_set_new_time_us(struct timer* self,
+                           const uint32_t time_us)
+{
+   struct timer_period period;
+   timer_get_period(self->timer_sel, time_us, &period);
+   timer_set_period(self, &period);
+   return;
+}
+
+/********************************************************************************
+* timer_set_new_period: Stter nya instllningar, berknade via TIMER_PERIOD,
+*                       p angiven timerkrets.
+*
+*                       - self  : Pekare till timern vars tid ska uppdateras.
+*                       - period: Pekare till timerkretsens instllningar.
+********************************************************************************/
+void timer_set_new_period(struct timer* self,
+                          const struct timer_period* period)
+{
+   timer_set_period(self, period);
+   return;
+}
+
+/********************************************************************************
+* timer_wheel_init: Initierar timerhjulet, som drivs av angiven timerkrets med
+*                   ett tick per millisekund. Avbrott aktiveras direkt.
+*
+*                   - timer_sel: Val av timerkrets fr timerhjulet.
+********************************************************************************/
+void timer_wheel_init(const enum timer_sel timer_sel)
+{
+   const struct timer_period period = TIMER_PERIOD(timer_sel, TIMER_WHEEL_TICK_US);
+   timer_init_period(&wheel_timer, timer_sel, &period);
+   wheel_top = period.top;
+#if TIMER_WHEEL_STEP_SHIFT
+   wheel_step_shift = timer_get_circuit(timer_sel)->prescaler_shift[period.clock_select - 1];
+   for (uint8_t cycles = TIMER_CYCLES_PER_US; cycles > 1; cycles >>= 1) wheel_step_shift--;
+#else
+   wheel_us_per_step = ((uint32_t)TIMER_WHEEL_TICK_US << 16) / wheel_top;
+#endif
+   timer_enable_interrupt(&wheel_timer);
+   return;
+}
+
+/********************************************************************************
+* timer_millis: Returnerar antalet millisekunder sedan timerhjulet initierades.
+*               Vrdet slr runt efter ca 49 dygn.
+********************************************************************************/
+uint32_t timer_millis(void)
+{
+   return atomic_read_u32(&wheel_now);
+}
+
+/********************************************************************************
+* timer_micros: Returnerar antalet mikrosekunder sedan timerhjulet initierades,
+*               med samma upplsning som timerhjulets hrdvarurknare (4 us
+*               vid 16 MHz). Vrdet slr runt efter ca 71 minuter.
+*
+*               1. Antalet tick samt hrdvarurknaren lses med avbrott
+*                  inaktiverade, vilket enbart tar ett ftal instruktioner.
+*
+*               2. Om hrdvarurknaren har nollstllts vid matchning utan att
+*                  avbrottsrutinen har hunnit rkna upp antalet tick, vilket
+*                  indikeras av att avbrottsflaggan r ettstlld medan
+*                  rknaren inte str p sitt hgsta vrde, lggs ett tick
+*                  till. Tiden gr drmed aldrig bakt.
+*
+*               3. Antalet steg i hrdvarurknaren omvandlas till
+*                  mikrosekunder. Vid 16 MHz r tiden per steg en tvpotens
+*                  (4 us fr Timer 0 och Timer 2, 1/16 us fr Timer 1),
+*                  varfr omvandlingen sker via skiftning av 16 bitar i
+*                  stllet fr multiplikation av 32 bitar. Vid vriga
+*                  klockfrekvenser multipliceras med frberknad tid per
+*                  steg, vilket undviker division. Antalet tick
+*                  multipliceras med en konstant, vilket kompilatorn lser
+*                  utan division.
+********************************************************************************/
+uint32_t timer_micros(void)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   uint32_t ticks = wheel_now;
+   uint16_t step;
+   bool pending;
+
+   if (wheel_timer.timer_sel == TIMER_SEL_0)
+   {
+      step = TCNT0;
+      pending = TIFR0 & (1 << OCF0A);
+   }
+   else if (wheel_timer.timer_sel == TIMER_SEL_1)
+   {
+      step = TCNT1;
+      pending = TIFR1 & (1 << OCF1A);
+   }
+   else
+   {
+      step = TCNT2;
+      pending = TIFR2 & (1 << OCF2A);
+   }
+
+   SREG = sreg;
+   if (pending && step < wheel_top - 1) ticks++;
+#if TIMER_WHEEL_STEP_SHIFT
+   step = wheel_step_shift >= 0 ? step << wheel_step_shift : step >> -wheel_step_shift;
+#else
+   step = (uint16_t)((step * wheel_us_per_step) >> 16);
+#endif
+   return ticks * TIMER_WHEEL_TICK_US + step;
+}
+
+/********************************************************************************
+* timer_wheel_tick: Rknar upp timerhjulet och anropar funktionen fr varje
+*                   mjukvarutimer som lper ut.
+*
+*                   1. Aktuellt tick rknas upp och motsvarande fack vljs.
+*
+*                   2. Facket tms genom att dess lista flyttas till en lokal
+*                      lista. Drmed kan funktioner som anropas stoppa eller
+*                      starta godtyckliga timers, ven timers som nnu inte
+*                      har kontrollerats.
+*
+*                   3. Timers i den lokala listan tas ut en i taget. Timers
+*                      som lper ut vid ett senare varv lggs tillbaka i
+*                      facket. Fr vriga timers startas periodiska timers om,
+*                      medan vriga stoppas, varefter timerns funktion anropas.
+********************************************************************************/
+void timer_wheel_tick(void)
+{
+   timer_count(&wheel_timer);
+   if (!timer_elapsed(&wheel_timer)) return;
+
+   const uint32_t now = ++wheel_now;
+   struct timer_soft** slot = &wheel[now & TIMER_WHEEL_MASK];
+   struct timer_soft* pending = *slot;
+
+   *slot = 0;
+   if (pending) pending->pprev = &pending;
+
+   while (pending)
+   {
+      struct timer_soft* self = pending;
+      timer_wheel_remove(self);
+
+      if (self->expires != now)
+      {
+         timer_wheel_insert(self, slot);
+         continue;
+      }
+
+      if (self->period)
+      {
+         self->expires = now + self->period;
+         timer_wheel_insert(self, &wheel[self->expires & TIMER_WHEEL_MASK]);
+      }
+      else
+      {
+         self->active = false;
+      }
+
+      self->callback();
+   }
+   return;
+}
+
+/********************************************************************************
+* timer_soft_init: Initierar angiven mjukvarutimer, som r stoppad tills
+*                  timer_soft_start anropas.
+*
+*                  - self    : Pekare till mjukvarutimern.
+*                  - callback: Funktion som anropas nr timern lper ut.
+********************************************************************************/
+void timer_soft_init(struct timer_soft* self,
+                     void (*callback)(void))
+{
+   self->next = 0;
+   self->pprev = 0;
+   self->expires = 0;
+   self->period = 0;
+   self->callback = callback;
+   self->active = false;
+   return;
+}
+
+/********************************************************************************
+* timer_soft_start: Startar angiven mjukvarutimer med angiven tid mtt i
+*                   millisekunder. Om timern redan r startad tas den frst
+*                   bort ur sitt fack. Tiden omvandlas till det tick d timern
+*                   lper ut, varefter timern placeras i motsvarande fack.
+*                   Avbrott inaktiveras temporrt, s att timerhjulet inte
+*                   frndras av avbrottsrutinen under tiden.
+*
+*                   - self    : Pekare till mjukvarutimern.
+*                   - time_ms : Tiden timern ska sttas p mtt i millisekunder.
+*                   - periodic: Indikerar ifall timern ska startas om
+*                               automatiskt varje gng den lper ut.
+********************************************************************************/
+void timer_soft_start(struct timer_soft* self,
+                      const uint32_t time_ms,
+                      const bool periodic)
+{
+   const uint32_t ticks = time_ms ? time_ms : 1;
+   const uint8_t sreg = SREG;
+   cli();
+
+   if (self->active) timer_wheel_remove(self);
+   self->expires = wheel_now + ticks;
+   self->period = periodic ? ticks : 0;
+   self->active = true;
+   timer_wheel_insert(self, &wheel[self->expires & TIMER_WHEEL_MASK]);
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* timer_soft_stop: Stoppar angiven mjukvarutimer genom att den tas bort ur
+*                  sitt fack i timerhjulet.
+*
+*                  - self: Pekare till mjukvarutimern.
+********************************************************************************/
+void timer_soft_stop(struct timer_soft* self)
+{
+   const uint8_t sreg = SREG;
+   cli();
+
+   if (self->active)
+   {
+      timer_wheel_remove(self);
+      self->active = false;
+   }
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* timer_init_circuit: Initierar angiven timerkrets i CTC Mode, dr avbrott
+*                     sker vid matchning mot OCRnA. Prescaler samt vrde p
+*                     OCRnA stts via timer_set_period. Adresserna till
+*                     motsvarande maskregister som bit fr aktivering av
+*                     avbrott sparas. Globala avbrott lmnas orrda och
+*                     aktiveras av anvndaren nr systemet r initierat.
 *
 *                     - self     : Pekare till timerkretsen som ska initieras.
 ********************************************************************************/
@@ -129,25 +464,22 @@ static void timer_init_circuit(struct timer* self)
 {
    if (self->timer_sel == TIMER_SEL_0)
    {
-      TCCR0B = (1 << CS01);
+      TCCR0A = (1 << WGM01);
       self->timsk = &TIMSK0;
-      self->timsk_bit = TOIE0;
+      self->timsk_bit = OCIE0A;
    }
    else if (self->timer_sel == TIMER_SEL_1)
    {
-      TCCR1B = (1 << CS11) | (1 << WGM12);
-      OCR1A = 256;
+      TCCR1A = 0x00;
       self->timsk = &TIMSK1;
       self->timsk_bit = OCIE1A;
    }
    else if (self->timer_sel == TIMER_SEL_2)
    {
-      TCCR2B = (1 << CS21);
+      TCCR2A = (1 << WGM21);
       self->timsk = &TIMSK2;
-      self->timsk_bit = TOIE2;
+      self->timsk_bit = OCIE2A;
    }
-
-   asm("SEI");
    return;
 }
 
@@ -161,8 +493,10 @@ static void timer_disable_circuit(struct timer* self)
 {
    if (self->timer_sel == TIMER_SEL_0)
    {
+      TCCR0A = 0x00;
       TCCR0B = 0x00;
       TIMSK0 = 0x00;
+      OCR0A = 0x00;
    }
    else if (self->timer_sel == TIMER_SEL_1)
    {
@@ -172,19 +506,144 @@ static void timer_disable_circuit(struct timer* self)
    }
    else if (self->timer_sel == TIMER_SEL_2)
    {
+      TCCR2A = 0x00;
       TCCR2B = 0x00;
       TIMSK2 = 0x00;
+      OCR2A = 0x00;
+   }
+   return;
+}
+
+/********************************************************************************
+* timer_get_period: Berknar prescaler, vrde p OCRnA samt mjukvarumssig
+*                   upprkning s att angiven timer lper ut efter angiven tid,
+*                   med samma aritmetik som TIMER_PERIOD (se timer.h), men
+*                   dr prescalern sks i en loop i stllet fr att varje
+*                   prescaler prvas i tur och ordning via makron.
+*
+*                   1. Tiden omvandlas till antalet klockcykler. Tider
+*                      verstigande TIMER_TIME_US_MAX begrnsas.
+*
+*                   2. Om antalet klockcykler verstiger vad timerkretsen
+*                      klarar av med hgsta prescaler delas tiden upp i lika
+*                      lnga avbrottsperioder, dr antalet perioder
+*                      rknas i mjukvara via timer_count och timer_elapsed.
+*                      Annars sker ett avbrott per angiven tid.
+*
+*                   3. Minsta prescaler vars rknare rymmer avbrottsperioden
+*                      vljs, vilket ger hgst upplsning. Samtliga prescalers
+*                      r tvpotenser, vilket gr att division erstts av
+*                      skiftning.
+*
+*                   - timer_sel: Val av timerkrets.
+*                   - time_us  : Tiden mtt i mikrosekunder.
+*                   - period   : Pekare till destinationen fr instllningarna.
+********************************************************************************/
+static void timer_get_period(const enum timer_sel timer_sel,
+                             const uint32_t time_us,
+                             struct timer_period* period)
+{
+   const struct timer_circuit* circuit = timer_get_circuit(timer_sel);
+   const uint32_t cycles = TIMER_PERIOD_CYCLES(time_us);
+   const uint32_t max_count = TIMER_PERIOD_COUNT(cycles, circuit->top_bits);
+   const uint32_t split = TIMER_PERIOD_SPLIT(cycles, max_count);
+
+   uint8_t index = 0;
+   uint32_t top = split;
+
+   for (; index < circuit->num_prescalers; ++index)
+   {
+      top = TIMER_PERIOD_ROUND(split, circuit->prescaler_shift[index]);
+      if (top <= ((uint32_t)1 << circuit->top_bits)) break;
+   }
+
+   period->max_count = max_count;
+   period->top = (uint16_t)top;
+   period->clock_select = index + 1;
+   return;
+}
+
+/********************************************************************************
+* timer_get_circuit: Returnerar hrdvaruegenskaperna fr angiven timerkrets.
+*
+*                    - timer_sel: Val av timerkrets.
+********************************************************************************/
+static const struct timer_circuit* timer_get_circuit(const enum timer_sel timer_sel)
+{
+   if (timer_sel == TIMER_SEL_1) return &circuit_16bit;
+   else if (timer_sel == TIMER_SEL_2) return &circuit_async;
+   return &circuit_8bit;
+}
+
+/********************************************************************************
+* timer_set_period: Skriver angivna instllningar till angiven timer. Prescaler
+*                   samt OCRnA skrivs med avbrott inaktiverade, dr rknaren
+*                   nollstlls s att nsta avbrott sker efter en hel period.
+*
+*                   - self  : Pekare till timern.
+*                   - period: Pekare till timerkretsens instllningar.
+********************************************************************************/
+static void timer_set_period(struct timer* self,
+                             const struct timer_period* period)
+{
+   const uint8_t sreg = SREG;
+   cli();
+   self->max_count = period->max_count;
+   self->counter = 0;
+
+   if (self->timer_sel == TIMER_SEL_0)
+   {
+      OCR0A = (uint8_t)(period->top - 1);
+      TCNT0 = 0;
+      TCCR0B = period->clock_select;
    }
+   else if (self->timer_sel == TIMER_SEL_1)
+   {
+      OCR1A = (uint16_t)(period->top - 1);
+      TCNT1 = 0;
+      TCCR1B = (1 << WGM12) | period->clock_select;
+   }
+   else if (self->timer_sel == TIMER_SEL_2)
+   {
+      OCR2A = (uint8_t)(period->top - 1);
+      TCNT2 = 0;
+      TCCR2B = period->clock_select;
+   }
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* timer_wheel_insert: Lgger angiven mjukvarutimer frst i angiven lista.
+*                     Funktionen frutstter att avbrott r inaktiverade.
+*
+*                     - self: Pekare till mjukvarutimern.
+*                     - slot: Pekare till listans brjan.
+********************************************************************************/
+static inline void timer_wheel_insert(struct timer_soft* self,
+                                      struct timer_soft** slot)
+{
+   self->next = *slot;
+   if (self->next) self->next->pprev = &self->next;
+   self->pprev = slot;
+   *slot = self;
    return;
 }
 
 /********************************************************************************
-* timer_get_max_count: Returnerar antalet timergenererade avbrott som krvs
-*                      fr angiven tid, avrundad till nrmaste heltal.
+* timer_wheel_remove: Tar bort angiven mjukvarutimer ur listan den ligger i.
+*                     D varje timer har en pekare till fregende lnk sker
+*                     borttagningen utan att listan behver genomskas.
+*                     Funktionen frutstter att avbrott r inaktiverade.
 *
-*                      - time_ms: nskad tid mtt i millisekunder.
+*                     - self: Pekare till mjukvarutimern.
 ********************************************************************************/
-static inline uint32_t timer_get_max_count(const double time_ms)
+static inline void timer_wheel_remove(struct timer_soft* self)
 {
-   return (uint32_t)(time_ms / TIME_BETWEEN_INTERRUPTS_MS + 0.5);
+   *(self->pprev) = self->next;
+   if (self->next) self->next->pprev = self->pprev;
+   self->next = 0;
+   self->pprev = 0;
+   return;
 }
\ No newline at end of file
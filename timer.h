@@ -2,6 +2,41 @@
 * timer.h: Innehller drivrutiner fr interruptbaserade timerkretsar via 
 *          strukten timer samt associerade funktioner. Dessa timerkretsar 
 *          fungerar ocks utmrkt att anvnda som rknare.
+*
+*          Varje timerkrets krs i CTC Mode, dr prescaler samt OCRnA vljs
+*          s att hrdvaran genererar avbrott efter angiven tid. Lngre tider
+*          n timerkretsen klarar av (ca 16 ms fr Timer 0 och Timer 2, ca
+*          4 s fr Timer 1) delas upp i lika lnga avbrottsperioder, som
+*          rknas i mjukvara. Avbrottsrutinen anropar drfr timer_count
+*          fljt av timer_elapsed, som returnerar true nr tiden har lpt ut.
+*
+*          Prescaler, OCRnA samt antalet avbrottsperioder berknas normalt
+*          under krning via timer_init_us. Fr konstanta tider kan dessa i
+*          stllet berknas vid kompilering via makrot TIMER_PERIOD och
+*          skickas till timer_init_period, exempelvis:
+*
+*          static const struct timer_period period = TIMER_PERIOD(TIMER_SEL_0, 500);
+*          timer_init_period(&timer0, TIMER_SEL_0, &period);
+*
+*          Godtyckligt antal mjukvarutimers (strukten timer_soft) kan kras
+*          via ett timerhjul, som drivs av en enda timerkrets med ett tick
+*          per millisekund. Timerhjulet initieras via timer_wheel_init, dr
+*          funktionen timer_wheel_tick ska anropas i motsvarande
+*          avbrottsrutin, exempelvis fr Timer 2:
+*
+*          ISR (TIMER2_COMPA_vect)
+*          {
+*             timer_wheel_tick();
+*             return;
+*          }
+*
+*          Varje mjukvarutimer placeras i ett av TIMER_WHEEL_SLOTS fack
+*          utefter tiden d timern lper ut, vilket gr att start och stopp
+*          sker i konstant tid och att enbart timers i aktuellt fack
+*          behver kontrolleras vid varje tick.
+*
+*          Timerhjulet utgr ven systemets gemensamma tidsbas, dr tiden
+*          sedan start kan lsas via timer_millis samt timer_micros.
 ********************************************************************************/
 #ifndef TIMER_H_
 #define TIMER_H_
@@ -9,6 +44,84 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 
+/* Makrodefinitioner: */
+#define TIMER_CYCLES_PER_US (F_CPU / 1000000UL) /* Antal klockcykler per mikrosekund. */
+#define TIMER_TIME_US_MAX (UINT32_MAX / TIMER_CYCLES_PER_US) /* Hgsta tid i mikrosekunder (268 s vid 16 MHz). */
+#define TIMER_PRESCALER_SHIFT_MAX 10 /* Hgsta prescaler (1024) som tvpotens, samma fr samtliga timerkretsar. */
+#define TIMER_WHEEL_SLOTS 32 /* Antal fack i timerhjulet (mste vara en tvpotens). */
+
+/********************************************************************************
+* TIMER_PERIOD: Berknar instllningar fr angiven timerkrets s att timern
+*               lper ut efter angiven tid mtt i mikrosekunder, i form av en
+*               initierare fr strukten timer_period. Vid konstanta argument
+*               utgr samtliga flt konstanta uttryck, vilket gr att
+*               berkningen sker vid kompilering och att resultatet kan
+*               lagras i en statisk konstant. Resultatet r detsamma som
+*               timer_init_us berknar under krning.
+*
+*               - timer_sel: Val av timerkrets.
+*               - time_us  : Tiden mtt i mikrosekunder.
+********************************************************************************/
+#define TIMER_PERIOD(timer_sel, time_us) \
+{ \
+   TIMER_PERIOD_COUNT(TIMER_PERIOD_CYCLES(time_us), TIMER_PERIOD_BITS(timer_sel)), \
+   TIMER_PERIOD_TOP(timer_sel, TIMER_PERIOD_SPLIT_US(timer_sel, time_us)), \
+   TIMER_PERIOD_CLOCK_SELECT(timer_sel, TIMER_PERIOD_SPLIT_US(timer_sel, time_us)) \
+}
+
+/* Hjlpmakron fr TIMER_PERIOD samt timer_init_us: */
+#define TIMER_PERIOD_BITS(timer_sel) ((timer_sel) == TIMER_SEL_1 ? 16 : 8)
+
+/* Tiden i klockcykler, minst en, dr tider ver TIMER_TIME_US_MAX begrnsas. */
+#define TIMER_PERIOD_CYCLES(time_us) \
+   ((uint32_t)(time_us) == 0 ? 1UL : \
+    ((uint32_t)(time_us) < TIMER_TIME_US_MAX ? (uint32_t)(time_us) : TIMER_TIME_US_MAX) * TIMER_CYCLES_PER_US)
+
+/* Antalet avbrottsperioder, fler n en enbart om hgsta prescaler inte rcker. */
+#define TIMER_PERIOD_COUNT(cycles, bits) \
+   ((cycles) > (1UL << ((bits) + TIMER_PRESCALER_SHIFT_MAX)) ? \
+    (((cycles) - 1) >> ((bits) + TIMER_PRESCALER_SHIFT_MAX)) + 1 : 1UL)
+
+/* Klockcykler per avbrottsperiod, avrundat utan overflow. */
+#define TIMER_PERIOD_SPLIT(cycles, count) \
+   ((count) > 1 ? ((cycles) - ((count) + 1) / 2) / (count) + 1 : (cycles))
+
+#define TIMER_PERIOD_SPLIT_US(timer_sel, time_us) \
+   TIMER_PERIOD_SPLIT(TIMER_PERIOD_CYCLES(time_us), \
+                      TIMER_PERIOD_COUNT(TIMER_PERIOD_CYCLES(time_us), TIMER_PERIOD_BITS(timer_sel)))
+
+/* Antal steg i rknaren med angiven prescaler (tvpotens), avrundat. */
+#define TIMER_PERIOD_ROUND(cycles, shift) (((cycles) + ((1UL << (shift)) >> 1)) >> (shift))
+
+#define TIMER_PERIOD_FITS(cycles, shift, bits) (TIMER_PERIOD_ROUND(cycles, shift) <= (1UL << (bits)))
+
+/* Minsta prescaler vars rknare rymmer perioden: 1, 8, 64, 256 eller 1024 fr
+   Timer 0 och Timer 1 samt 1, 8, 32, 64, 128, 256 eller 1024 fr Timer 2. */
+#define TIMER_PERIOD_TOP(timer_sel, cycles) \
+   ((timer_sel) == TIMER_SEL_2 ? \
+    (TIMER_PERIOD_FITS(cycles, 0, 8) ? TIMER_PERIOD_ROUND(cycles, 0) : \
+     TIMER_PERIOD_FITS(cycles, 3, 8) ? TIMER_PERIOD_ROUND(cycles, 3) : \
+     TIMER_PERIOD_FITS(cycles, 5, 8) ? TIMER_PERIOD_ROUND(cycles, 5) : \
+     TIMER_PERIOD_FITS(cycles, 6, 8) ? TIMER_PERIOD_ROUND(cycles, 6) : \
+     TIMER_PERIOD_FITS(cycles, 7, 8) ? TIMER_PERIOD_ROUND(cycles, 7) : \
+     TIMER_PERIOD_FITS(cycles, 8, 8) ? TIMER_PERIOD_ROUND(cycles, 8) : \
+     TIMER_PERIOD_ROUND(cycles, 10)) : \
+    (TIMER_PERIOD_FITS(cycles, 0, TIMER_PERIOD_BITS(timer_sel)) ? TIMER_PERIOD_ROUND(cycles, 0) : \
+     TIMER_PERIOD_FITS(cycles, 3, TIMER_PERIOD_BITS(timer_sel)) ? TIMER_PERIOD_ROUND(cycles, 3) : \
+     TIMER_PERIOD_FITS(cycles, 6, TIMER_PERIOD_BITS(timer_sel)) ? TIMER_PERIOD_ROUND(cycles, 6) : \
+     TIMER_PERIOD_FITS(cycles, 8, TIMER_PERIOD_BITS(timer_sel)) ? TIMER_PERIOD_ROUND(cycles, 8) : \
+     TIMER_PERIOD_ROUND(cycles, 10)))
+
+#define TIMER_PERIOD_CLOCK_SELECT(timer_sel, cycles) \
+   ((timer_sel) == TIMER_SEL_2 ? \
+    (TIMER_PERIOD_FITS(cycles, 0, 8) ? 1 : TIMER_PERIOD_FITS(cycles, 3, 8) ? 2 : \
+     TIMER_PERIOD_FITS(cycles, 5, 8) ? 3 : TIMER_PERIOD_FITS(cycles, 6, 8) ? 4 : \
+     TIMER_PERIOD_FITS(cycles, 7, 8) ? 5 : TIMER_PERIOD_FITS(cycles, 8, 8) ? 6 : 7) : \
+    (TIMER_PERIOD_FITS(cycles, 0, TIMER_PERIOD_BITS(timer_sel)) ? 1 : \
+     TIMER_PERIOD_FITS(cycles, 3, TIMER_PERIOD_BITS(timer_sel)) ? 2 : \
+     TIMER_PERIOD_FITS(cycles, 6, TIMER_PERIOD_BITS(timer_sel)) ? 3 : \
+     TIMER_PERIOD_FITS(cycles, 8, TIMER_PERIOD_BITS(timer_sel)) ? 4 : 5))
+
 /********************************************************************************
 * timer_sel: Enumeration fr val av timerkrets.
 ********************************************************************************/
@@ -20,19 +133,46 @@ enum timer_sel
    TIMER_SEL_NONE /* Timer ospecificerad. */
 };
 
+/********************************************************************************
+* timer_period: Strukt fr en timerkrets instllningar fr en viss tid,
+*               berknade vid kompilering via TIMER_PERIOD.
+********************************************************************************/
+struct timer_period
+{
+   uint32_t max_count;   /* Antal avbrottsperioder innan timern lper ut. */
+   uint16_t top;         /* Antal steg i rknaren per avbrottsperiod (OCRnA + 1). */
+   uint8_t clock_select; /* Vrde p bitarna CSn2 - CSn0 (prescaler). */
+};
+
 /********************************************************************************
 * timer: Strukt fr implementering av interruptbaserade timerkretsar, som
 *        vid behov kan anvndas som rknare.
 ********************************************************************************/
 struct timer
 {
-   volatile uint32_t counter; /* 32-bitars rknare. */
-   uint32_t max_count;        /* Maxvrde som upprkning ska ske till. */
+   volatile uint32_t counter; /* 32-bitars rknare av avbrottsperioder. */
+   uint32_t max_count;        /* Antal avbrottsperioder innan timern lper ut. */
    volatile uint8_t* timsk;   /* Pekare till maskregister fr aktivering av avbrott. */
    uint8_t timsk_bit;         /* Bit fr aktivering av avbrott i motsvarande maskregister. */
    enum timer_sel timer_sel;  /* Val av timerkrets. */
 };
 
+/********************************************************************************
+* timer_soft: Strukt fr implementering av mjukvarutimers, som krs via
+*             timerhjulet. Nr timern lper ut anropas angiven funktion frn
+*             avbrottsrutinen fr timerhjulets timerkrets. Periodiska timers
+*             startas automatiskt om med samma tid.
+********************************************************************************/
+struct timer_soft
+{
+   struct timer_soft* next;   /* Nsta timer i samma fack. */
+   struct timer_soft** pprev; /* Pekare till fregende lnk, fr borttagning i konstant tid. */
+   uint32_t expires;          /* Tick d timern lper ut. */
+   uint32_t period;           /* Periodtid i tick fr periodisk timer, annars 0. */
+   void (*callback)(void);    /* Funktion som anropas nr timern lper ut. */
+   bool active;               /* Indikerar ifall timern r startad. */
+};
+
 /********************************************************************************
 * timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
 *             Om timern ska anvndas som rknare fr att rkna upp till ett
@@ -47,6 +187,48 @@ void timer_init(struct timer* self,
                 const enum timer_sel timer_sel, 
                 const double time_ms);
 
+/********************************************************************************
+* timer_init_us: Initierar ny timerkrets med angiven tid mtt i mikrosekunder
+*                (hgst TIMER_TIME_US_MAX), vilket inte krver ngra
+*                flyttalsberkningar.
+*
+*                - self     : Pekare till timern som ska initieras.
+*                - timer_sel: Val av timerkrets.
+*                - time_us  : Tiden timern ska sttas p mtt i mikrosekunder.
+********************************************************************************/
+void timer_init_us(struct timer* self,
+                   const enum timer_sel timer_sel,
+                   const uint32_t time_us);
+
+/********************************************************************************
+* timer_init_period: Initierar ny timerkrets med angivna instllningar,
+*                    berknade via TIMER_PERIOD, vilket varken krver
+*                    division eller skning efter prescaler under krning.
+*
+*                    - self     : Pekare till timern som ska initieras.
+*                    - timer_sel: Val av timerkrets.
+*                    - period   : Pekare till timerkretsens instllningar.
+********************************************************************************/
+void timer_init_period(struct timer* self,
+                       const enum timer_sel timer_sel,
+                       const struct timer_period* period);
+
+/********************************************************************************
+* timer_init_ms: Initierar ny timerkrets med angiven tid mtt i millisekunder
+*                (hgst TIMER_TIME_US_MAX / 1000).
+*
+*                - self     : Pekare till timern som ska initieras.
+*                - timer_sel: Val av timerkrets.
+*                - time_ms  : Tiden timern ska sttas p mtt i millisekunder.
+********************************************************************************/
+static inline void timer_init_ms(struct timer* self,
+                                 const enum timer_sel timer_sel,
+                                 const uint32_t time_ms)
+{
+   timer_init_us(self, timer_sel, time_ms * 1000);
+   return;
+}
+
 /********************************************************************************
 * timer_clear: Genomfr total nollstllning av angiven timerkrets.
 *
@@ -56,19 +238,15 @@ void timer_clear(struct timer* self);
 
 /********************************************************************************
 * timer_enable_interrupt: Aktiverar timergenererat avbrott, som ger rum nr
-*                         timern rknar upp till overflow eller specificerat max.
-*
-*                         Timer 0 samt Timer 2 aktiveras i Normal Mode, medan
-*                         Timer 1 aktiveras i CTC Mode med upprkning till 256,
-*                         vilket gr att tiden mellan varje timergenererat
-*                         avbrott r samma oavsett anvnd timerkrets.
+*                         timerns rknare matchar OCRnA, dvs. en gng per
+*                         avbrottsperiod.
 *
 *                         Avbrottsvektorer fr timerkretsarna deklareras nedan:
 *
 *                         Timerkrets     Avbrottsvektor
-*                           Timer 0     TIMER0_OVF_vect
+*                           Timer 0     TIMER0_COMPA_vect
 *                           Timer 1     TIMER1_COMPA_vect
-*                           Timer 2     TIMER2_OVF_vect
+*                           Timer 2     TIMER2_COMPA_vect
 *
 *                         - self: Pekare till timern som timergenererat
 *                                 avbrott ska aktiveras p.
@@ -113,7 +291,8 @@ static inline bool timer_interrupt_enabled(const struct timer* self)
 }
 
 /********************************************************************************
-* timer_count: Rknar upp angiven timer.
+* timer_count: Rknar upp angiven timer. Funktionen frutstter att avbrott
+*              r inaktiverade, vilket alltid gller i avbrottsrutiner.
 *
 *              - self: Pekare till timern som ska rknas upp.
 ********************************************************************************/
@@ -139,10 +318,22 @@ bool timer_elapsed(struct timer* self);
 ********************************************************************************/
 static inline void timer_reset_counter(struct timer* self)
 {
-   self->counter = 0;
+   atomic_write_u32(&self->counter, 0);
    return;
 }
 
+/********************************************************************************
+* timer_get_counter: Returnerar aktuellt antal avbrottsperioder p angiven
+*                    timer. Rknaren lses atomrt, d den rknas upp frn
+*                    avbrottsrutinen.
+*
+*                    - self: Pekare till timern vars rknare ska lsas.
+********************************************************************************/
+static inline uint32_t timer_get_counter(const struct timer* self)
+{
+   return atomic_read_u32(&self->counter);
+}
+
 /********************************************************************************
 * timer_reset: terstller angiven timer till startlget.
 *
@@ -161,7 +352,8 @@ void timer_set_new_time(struct timer* self,
 
 /********************************************************************************
 * timer_set_new_max_count: Stter nytt maxvrde fr upprkning av timern nr
-*                          denna ska anvndas som en rknare.
+*                          denna ska anvndas som en rknare, mtt i antal
+*                          avbrottsperioder.
 *
 *                          - self   : Pekare till timern.
 *                          - max_count: Maxvrde fr upprkningen.
@@ -173,4 +365,108 @@ static inline void timer_set_max_count(struct timer* self,
    return;
 }
 
+/********************************************************************************
+* timer_set_new_time_us: Stter ny tid mtt i mikrosekunder (hgst
+*                        TIMER_TIME_US_MAX) p angiven timerkrets.
+*
+*                        - self   : Pekare till timern vars tid ska uppdateras.
+*                        - time_us: Tiden timern ska sttas p i mikrosekunder.
+********************************************************************************/
+void timer_set_new_time_us(struct timer* self,
+                           const uint32_t time_us);
+
+/********************************************************************************
+* timer_set_new_period: Stter nya instllningar, berknade via TIMER_PERIOD
+*                       fr samma timerkrets, p angiven timer.
+*
+*                       - self  : Pekare till timern vars tid ska uppdateras.
+*                       - period: Pekare till timerkretsens instllningar.
+********************************************************************************/
+void timer_set_new_period(struct timer* self,
+                          const struct timer_period* period);
+
+/********************************************************************************
+* timer_set_new_time_ms: Stter ny tid mtt i millisekunder (hgst
+*                        TIMER_TIME_US_MAX / 1000) p angiven timerkrets.
+*
+*                        - self   : Pekare till timern vars tid ska uppdateras.
+*                        - time_ms: Tiden timern ska sttas p i millisekunder.
+********************************************************************************/
+static inline void timer_set_new_time_ms(struct timer* self,
+                                         const uint32_t time_ms)
+{
+   timer_set_new_time_us(self, time_ms * 1000);
+   return;
+}
+
+/********************************************************************************
+* timer_wheel_init: Initierar timerhjulet, som drivs av angiven timerkrets med
+*                   ett tick per millisekund. Avbrott aktiveras direkt.
+*
+*                   - timer_sel: Val av timerkrets fr timerhjulet.
+********************************************************************************/
+void timer_wheel_init(const enum timer_sel timer_sel);
+
+/********************************************************************************
+* timer_millis: Returnerar antalet millisekunder sedan timerhjulet initierades.
+*               Vrdet slr runt efter ca 49 dygn.
+********************************************************************************/
+uint32_t timer_millis(void);
+
+/********************************************************************************
+* timer_micros: Returnerar antalet mikrosekunder sedan timerhjulet initierades,
+*               genom att antalet tick kombineras med timerhjulets
+*               hrdvarurknare. Vrdet slr runt efter ca 71 minuter, vilket
+*               hanteras genom att tidsskillnader berknas med osignerad
+*               subtraktion.
+********************************************************************************/
+uint32_t timer_micros(void);
+
+/********************************************************************************
+* timer_wheel_tick: Rknar upp timerhjulet och anropar funktionen fr varje
+*                   mjukvarutimer som lper ut. Denna funktion ska anropas i
+*                   avbrottsrutinen fr timerhjulets timerkrets.
+********************************************************************************/
+void timer_wheel_tick(void);
+
+/********************************************************************************
+* timer_soft_init: Initierar angiven mjukvarutimer, som r stoppad tills
+*                  timer_soft_start anropas.
+*
+*                  - self    : Pekare till mjukvarutimern.
+*                  - callback: Funktion som anropas nr timern lper ut.
+********************************************************************************/
+void timer_soft_init(struct timer_soft* self,
+                     void (*callback)(void));
+
+/********************************************************************************
+* timer_soft_start: Startar angiven mjukvarutimer med angiven tid mtt i
+*                   millisekunder. Om timern redan r startad startas den om.
+*
+*                   - self    : Pekare till mjukvarutimern.
+*                   - time_ms : Tiden timern ska sttas p mtt i millisekunder.
+*                   - periodic: Indikerar ifall timern ska startas om
+*                               automatiskt varje gng den lper ut.
+********************************************************************************/
+void timer_soft_start(struct timer_soft* self,
+                      const uint32_t time_ms,
+                      const bool periodic);
+
+/********************************************************************************
+* timer_soft_stop: Stoppar angiven mjukvarutimer.
+*
+*                  - self: Pekare till mjukvarutimern.
+********************************************************************************/
+void timer_soft_stop(struct timer_soft* self);
+
+/********************************************************************************
+* timer_soft_active: Indikerar ifall angiven mjukvarutimer r startad.
+*
+*                    - self: Pekare till mjukvarutimern.
+********************************************************************************/
+static inline bool timer_soft_active(const struct timer_soft* self)
+{
+   return self->active;
+}
+
 #endif /* TIMER_H_ */
\ No newline at end of file
@@ -28,7 +28,7 @@ void tmp36_init(struct tmp36* self,
 void tmp36_print_temperature(const struct tmp36* self)
 {
    serial_print_string("Temperature: ");
-   serial_print_double(tmp36_get_temperature(self));
+   serial_print_fixed(tmp36_get_temperature_centi(self), 2);
    serial_print_string(" degrees Celcius.\n");
    return;
 }
@@ -42,7 +42,20 @@ void tmp36_print_temperature(const struct tmp36* self)
 void tmp36_print_voltage(const struct tmp36* self)
 {
    serial_print_string("Voltage: ");
-   serial_print_double(tmp36_get_input_voltage(self));
+   serial_print_fixed(tmp36_get_input_voltage_mv(self), 3);
    serial_print_string(" V\n.");
    return;
+}
+
+/********************************************************************************
+* tmp36_send_temperature: Skickar aktuell rumstemperatur avlst av
+*                         temperatursensor TMP36 som en binr ram, dr
+*                         temperaturen anges i hundradels grader.
+*
+*                         - self: Pekare till temperatursensor TMP36.
+********************************************************************************/
+void tmp36_send_temperature(const struct tmp36* self)
+{
+   serial_send_temperature(tmp36_get_temperature_centi(self));
+   return;
 }
\ No newline at end of file
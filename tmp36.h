@@ -73,6 +73,33 @@ static inline double tmp36_get_temperature(const struct tmp36* self)
    return 100 * tmp36_get_input_voltage(self) - 50;
 }
 
+/********************************************************************************
+* tmp36_get_input_voltage_mv: Returnerar inspnningen frn angiven
+*                             temperatursensor mtt i millivolt, berknat
+*                             utan flyttal.
+*
+*                             - self: Pekare till temperatursensor TMP36.
+********************************************************************************/
+static inline uint16_t tmp36_get_input_voltage_mv(const struct tmp36* self)
+{
+   return adc_read_mv(&self->adc);
+}
+
+/********************************************************************************
+* tmp36_get_temperature_centi: Returnerar aktuell rumstemperatur i hundradels
+*                              grader Celcius, berknat utan flyttal. Vrdet
+*                              begrnsas till INT16_MAX, vilket motsvarar
+*                              327,67 grader och ligger lngt ver
+*                              sensorns mtomrde (-40 - 125 grader).
+*
+*                              - self: Pekare till temperatursensor TMP36.
+********************************************************************************/
+static inline int16_t tmp36_get_temperature_centi(const struct tmp36* self)
+{
+   const int32_t temperature = adc_get_temperature_centi(&self->adc);
+   return temperature > INT16_MAX ? INT16_MAX : (int16_t)temperature;
+}
+
 /********************************************************************************
 * tmp36_print_temperature: Skriver ut aktuell rumstemperatur avlst av
 *                          temperatursensor TMP36.
@@ -89,4 +116,13 @@ void tmp36_print_temperature(const struct tmp36* self);
 ********************************************************************************/
 void tmp36_print_voltage(const struct tmp36* self);
 
+/********************************************************************************
+* tmp36_send_temperature: Skickar aktuell rumstemperatur avlst av
+*                         temperatursensor TMP36 som en binr ram, se
+*                         serial_send_frame.
+*
+*                         - self: Pekare till temperatursensor TMP36.
+********************************************************************************/
+void tmp36_send_temperature(const struct tmp36* self);
+
 #endif /* TMP36_H_ */
\ No newline at end of file
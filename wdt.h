@@ -33,13 +33,16 @@ enum wdt_timeout
 /********************************************************************************
 * wdt_reset: terstller Watchdog-timern, vilket mste ske kontinuerligt innan
 *            timern lper ut fr att undvika systemterstllning eller avbrott.
+*            Fregende avbrottstillstnd terstlls eftert, s att avbrott
+*            inte aktiveras i frtid, exempelvis under initiering.
 ********************************************************************************/
 static inline void wdt_reset(void)
 {
-   asm("CLI");
+   const uint8_t sreg = SREG;
+   cli();
    asm("WDR");
    MCUSR &= ~(1 << WDRF);
-   asm("SEI");
+   SREG = sreg;
    return;
 }
 
@@ -50,10 +53,11 @@ static inline void wdt_reset(void)
 ********************************************************************************/
 static inline void wdt_init(const enum wdt_timeout timeout_ms)
 {
-   asm("CLI");
+   const uint8_t sreg = SREG;
+   cli();
    WDTCSR = (1 << WDE) | (1 << WDCE);
    WDTCSR = (1 << WDE) | (uint8_t)(timeout_ms);
-   asm("SEI");
+   SREG = sreg;
    WDTCSR &= ~(1 << WDE);
    return;
 }